@@ -54,10 +54,23 @@
  */
 
 #include "MEM_Allocator.h"
-#include <list>
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+/* Elements are spread over this many independently locked lists, so concurrent insertions and
+ * removals rarely wait on each other. */
+#define MEM_CACHE_LIMITER_SHARDS 16
+/* Number of elements re-measured on every insertion. */
+#define MEM_CACHE_LIMITER_UPDATE_SIZES 2
+/* Enforcing limits frees memory down to this fraction below the maximum, so the following
+ * insertions don't have to evict again right away. */
+#define MEM_CACHE_LIMITER_HEADROOM_DIV 32
+
 template<class T> class MEM_CacheLimiter;
 
 #ifndef __MEM_CACHELIMITERC_API_H__
@@ -72,7 +85,15 @@ bool MEM_CacheLimiter_is_disabled(void);
 template<class T> class MEM_CacheLimiterHandle {
  public:
   explicit MEM_CacheLimiterHandle(T *data_, MEM_CacheLimiter<T> *parent_)
-      : data(data_), refcount(0), parent(parent_)
+      : data(data_),
+        refcount(0),
+        shard(0),
+        pos(0),
+        is_evicted(false),
+        is_cancelled(false),
+        size(0),
+        last_used(0),
+        parent(parent_)
   {
   }
 
@@ -106,20 +127,9 @@ template<class T> class MEM_CacheLimiterHandle {
     return !data || !refcount;
   }
 
-  bool destroy_if_possible()
+  T *unmanage()
   {
-    if (can_destroy()) {
-      delete data;
-      data = NULL;
-      unmanage();
-      return true;
-    }
-    return false;
-  }
-
-  void unmanage()
-  {
-    parent->unmanage(this);
+    return parent->unmanage(this);
   }
 
   void touch()
@@ -132,115 +142,186 @@ template<class T> class MEM_CacheLimiterHandle {
 
   T *data;
   int refcount;
+  int shard;
   int pos;
+  /* Removed from the queue by enforcing limits, destroyed after the shards are unlocked. */
+  bool is_evicted;
+  /* Unmanaged before the evicted element was destroyed, its data is not destroyed. */
+  bool is_cancelled;
+  /* Thread destroying the data of the evicted element. */
+  std::thread::id destroying_thread;
+  /* Size of data as last measured. */
+  size_t size;
+  uint64_t last_used;
   MEM_CacheLimiter<T> *parent;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("MEM_CacheLimiterHandle")
 };
 
+/**
+ * Memory in use is accounted on insertion and removal, so checking the limit does not iterate
+ * the elements. Insertion, removal, touching and enforcing limits may happen from multiple
+ * threads. Elements are destroyed without holding any lock of the limiter, so their destructors
+ * can unmanage other elements. Unmanaging an element which is being destroyed waits for its
+ * destructor to finish.
+ */
 template<class T> class MEM_CacheLimiter {
  public:
   typedef size_t (*MEM_CacheLimiter_DataSize_Func)(void *data);
   typedef int (*MEM_CacheLimiter_ItemPriority_Func)(void *item, int default_priority);
   typedef bool (*MEM_CacheLimiter_ItemDestroyable_Func)(void *item);
 
-  MEM_CacheLimiter(MEM_CacheLimiter_DataSize_Func data_size_func) : data_size_func(data_size_func)
+  MEM_CacheLimiter(MEM_CacheLimiter_DataSize_Func data_size_func)
+      : data_size_func(data_size_func),
+        item_priority_func(NULL),
+        item_destroyable_func(NULL),
+        memory_in_use(0),
+        use_counter(0),
+        next_shard(0)
   {
   }
 
   ~MEM_CacheLimiter()
   {
-    int i;
-    for (i = 0; i < queue.size(); i++) {
-      delete queue[i];
+    for (int i = 0; i < MEM_CACHE_LIMITER_SHARDS; i++) {
+      for (int j = 0; j < shards[i].queue.size(); j++) {
+        delete shards[i].queue[j];
+      }
     }
   }
 
   MEM_CacheLimiterHandle<T> *insert(T *elem)
   {
-    queue.push_back(new MEM_CacheLimiterHandle<T>(elem, this));
-    queue.back()->pos = queue.size() - 1;
-    return queue.back();
+    MEM_CacheElementPtr handle = new MEM_CacheLimiterHandle<T>(elem, this);
+    const int shard_index = next_shard++ % MEM_CACHE_LIMITER_SHARDS;
+    Shard &shard = shards[shard_index];
+
+    if (data_size_func) {
+      handle->size = data_size_func(elem->get_data());
+    }
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    handle->shard = shard_index;
+    handle->pos = shard.queue.size();
+    handle->last_used = ++use_counter;
+    shard.queue.push_back(handle);
+    memory_in_use += handle->size;
+
+    update_sizes_locked(shard);
+
+    return handle;
   }
 
-  void unmanage(MEM_CacheLimiterHandle<T> *handle)
+  /**
+   * Stop managing an element and free its handle. Returns the data which is left to the caller,
+   * or NULL when it was destroyed by enforcing limits already.
+   */
+  T *unmanage(MEM_CacheLimiterHandle<T> *handle)
   {
-    int pos = handle->pos;
-    queue[pos] = queue.back();
-    queue[pos]->pos = pos;
-    queue.pop_back();
-    delete handle;
+    Shard &shard = shards[handle->shard];
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    T *data = NULL;
+
+    if (!handle->is_evicted) {
+      data = handle->data;
+      unmanage_locked(handle);
+    }
+    else if (!is_destroying_locked(shard, handle)) {
+      /* Still waiting to be destroyed, the handle is freed by the thread which evicted it. */
+      data = handle->data;
+      handle->data = NULL;
+      handle->is_cancelled = true;
+    }
+    else if (handle->destroying_thread != std::this_thread::get_id()) {
+      /* The handle is freed by the thread destroying it, only compare the address. */
+      shard.destroyed_cond.wait(lock, [&] { return !is_destroying_locked(shard, handle); });
+    }
+    return data;
   }
 
   size_t get_memory_in_use()
   {
-    size_t size = 0;
     if (data_size_func) {
-      int i;
-      for (i = 0; i < queue.size(); i++) {
-        size += data_size_func(queue[i]->get()->get_data());
-      }
-    }
-    else {
-      size = MEM_get_memory_in_use();
+      return memory_in_use;
     }
-    return size;
+    return MEM_get_memory_in_use();
   }
 
-  void enforce_limits()
+  bool is_over_limit()
   {
     size_t max = MEM_CacheLimiter_get_maximum();
-    bool is_disabled = MEM_CacheLimiter_is_disabled();
-    size_t mem_in_use, cur_size;
-
-    if (is_disabled) {
-      return;
-    }
 
-    if (max == 0) {
-      return;
+    if (MEM_CacheLimiter_is_disabled() || max == 0) {
+      return false;
     }
+    return get_memory_in_use() > max;
+  }
 
-    mem_in_use = get_memory_in_use();
+  void enforce_limits()
+  {
+    size_t max = MEM_CacheLimiter_get_maximum();
+    MEM_CacheQueue elements;
+    MEM_CacheQueue evicted;
 
-    if (mem_in_use <= max) {
+    if (!is_over_limit()) {
       return;
     }
 
-    while (!queue.empty() && mem_in_use > max) {
-      MEM_CacheElementPtr elem = get_least_priority_destroyable_element();
+    std::lock_guard<std::mutex> enforce_lock(enforce_mutex);
 
-      if (!elem)
-        break;
-
-      if (data_size_func) {
-        cur_size = data_size_func(elem->get()->get_data());
-      }
-      else {
-        cur_size = mem_in_use;
-      }
+    for (int i = 0; i < MEM_CACHE_LIMITER_SHARDS; i++) {
+      shards[i].mutex.lock();
+    }
 
-      if (elem->destroy_if_possible()) {
+    /* Data could have grown since it was measured, iterating all elements anyway. */
+    for (int i = 0; i < MEM_CACHE_LIMITER_SHARDS; i++) {
+      for (int j = 0; j < shards[i].queue.size(); j++) {
+        MEM_CacheElementPtr elem = shards[i].queue[j];
         if (data_size_func) {
-          mem_in_use -= cur_size;
-        }
-        else {
-          mem_in_use -= cur_size - MEM_get_memory_in_use();
+          update_size_locked(elem);
         }
+        elements.push_back(elem);
       }
     }
+
+    if (get_memory_in_use() > max) {
+      evict_least_priority_elements(
+          elements, max - max / MEM_CACHE_LIMITER_HEADROOM_DIV, evicted);
+    }
+
+    for (int i = 0; i < MEM_CACHE_LIMITER_SHARDS; i++) {
+      shards[i].mutex.unlock();
+    }
+
+    /* Destructors can unmanage elements, which locks their shard. */
+    for (int i = 0; i < evicted.size(); i++) {
+      destroy_evicted(evicted[i]);
+    }
   }
 
   void touch(MEM_CacheLimiterHandle<T> *handle)
   {
-    /* If we're using custom priority callback re-arranging the queue
-     * doesn't make much sense because we'll iterate it all to get
-     * least priority element anyway.
-     */
-    if (item_priority_func == NULL) {
-      queue[handle->pos] = queue.back();
-      queue[handle->pos]->pos = handle->pos;
-      queue.pop_back();
-      queue.push_back(handle);
-      handle->pos = queue.size() - 1;
+    std::lock_guard<std::mutex> lock(shards[handle->shard].mutex);
+    handle->last_used = ++use_counter;
+  }
+
+  /**
+   * Stop managing all elements without destroying their data,
+   * free_func is called on each element before its handle is freed.
+   */
+  void unmanage_all(void (*free_func)(T *elem))
+  {
+    for (int i = 0; i < MEM_CACHE_LIMITER_SHARDS; i++) {
+      std::lock_guard<std::mutex> lock(shards[i].mutex);
+
+      for (int j = 0; j < shards[i].queue.size(); j++) {
+        MEM_CacheElementPtr elem = shards[i].queue[j];
+        memory_in_use -= elem->size;
+        free_func(elem->get());
+        delete elem;
+      }
+      shards[i].queue.clear();
     }
   }
 
@@ -255,9 +336,111 @@ template<class T> class MEM_CacheLimiter {
   }
 
  private:
+  friend class MEM_CacheLimiterHandle<T>;
+
   typedef MEM_CacheLimiterHandle<T> *MEM_CacheElementPtr;
   typedef std::vector<MEM_CacheElementPtr, MEM_Allocator<MEM_CacheElementPtr>> MEM_CacheQueue;
-  typedef typename MEM_CacheQueue::iterator iterator;
+
+  struct Shard {
+    Shard() : update_pos(0)
+    {
+    }
+
+    std::mutex mutex;
+    MEM_CacheQueue queue;
+    /* Next element to re-measure. */
+    int update_pos;
+    /* Evicted elements of this shard whose data is being destroyed. */
+    MEM_CacheQueue destroying;
+    std::condition_variable destroyed_cond;
+  };
+
+  struct DestroyCandidate {
+    int priority;
+    MEM_CacheElementPtr elem;
+  };
+
+  typedef std::vector<DestroyCandidate, MEM_Allocator<DestroyCandidate>> MEM_CacheCandidates;
+
+  static bool compare_last_used(const MEM_CacheElementPtr &a, const MEM_CacheElementPtr &b)
+  {
+    return a->last_used < b->last_used;
+  }
+
+  static bool compare_priority(const DestroyCandidate &a, const DestroyCandidate &b)
+  {
+    return a.priority < b.priority;
+  }
+
+  void remove_locked(MEM_CacheLimiterHandle<T> *handle)
+  {
+    Shard &shard = shards[handle->shard];
+    int pos = handle->pos;
+
+    shard.queue[pos] = shard.queue.back();
+    shard.queue[pos]->pos = pos;
+    shard.queue.pop_back();
+    memory_in_use -= handle->size;
+  }
+
+  void unmanage_locked(MEM_CacheLimiterHandle<T> *handle)
+  {
+    remove_locked(handle);
+    delete handle;
+  }
+
+  /* Destroy the data of an element removed by enforcing limits, unless it was unmanaged since. */
+  void destroy_evicted(MEM_CacheElementPtr elem)
+  {
+    Shard &shard = shards[elem->shard];
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (elem->is_cancelled) {
+        delete elem;
+        return;
+      }
+      elem->destroying_thread = std::this_thread::get_id();
+      shard.destroying.push_back(elem);
+    }
+
+    delete elem->data;
+    elem->data = NULL;
+
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.destroying.erase(std::find(shard.destroying.begin(), shard.destroying.end(), elem));
+    }
+    shard.destroyed_cond.notify_all();
+    delete elem;
+  }
+
+  bool is_destroying_locked(Shard &shard, MEM_CacheLimiterHandle<T> *handle)
+  {
+    return std::find(shard.destroying.begin(), shard.destroying.end(), handle) !=
+           shard.destroying.end();
+  }
+
+  void update_size_locked(MEM_CacheElementPtr elem)
+  {
+    size_t size = data_size_func(elem->get()->get_data());
+
+    memory_in_use += size - elem->size;
+    elem->size = size;
+  }
+
+  /* Data can grow after insertion, re-measure a few elements on every insertion so the memory in
+   * use follows without iterating all of them. */
+  void update_sizes_locked(Shard &shard)
+  {
+    if (!data_size_func) {
+      return;
+    }
+
+    for (int i = 0; i < MEM_CACHE_LIMITER_UPDATE_SIZES; i++) {
+      shard.update_pos = (shard.update_pos + 1) % shard.queue.size();
+      update_size_locked(shard.queue[shard.update_pos]);
+    }
+  }
 
   /* Check whether element can be destroyed when enforcing cache limits */
   bool can_destroy_element(MEM_CacheElementPtr &elem)
@@ -273,52 +456,56 @@ template<class T> class MEM_CacheLimiter {
     return true;
   }
 
-  MEM_CacheElementPtr get_least_priority_destroyable_element(void)
+  /* Remove elements in order of priority until memory in use is within max, priorities are
+   * computed once instead of searching all elements for every removed one. Removed elements are
+   * added to \a evicted, to be destroyed once the shards are unlocked. */
+  void evict_least_priority_elements(MEM_CacheQueue &elements,
+                                     size_t max,
+                                     MEM_CacheQueue &evicted)
   {
-    if (queue.empty())
-      return NULL;
-
-    MEM_CacheElementPtr best_match_elem = NULL;
-
-    if (!item_priority_func) {
-      for (iterator it = queue.begin(); it != queue.end(); it++) {
-        MEM_CacheElementPtr elem = *it;
-        if (!can_destroy_element(elem))
-          continue;
-        best_match_elem = elem;
-        break;
-      }
-    }
-    else {
-      int best_match_priority = 0;
-      int i;
+    MEM_CacheCandidates candidates;
+    int i;
 
-      for (i = 0; i < queue.size(); i++) {
-        MEM_CacheElementPtr elem = queue[i];
+    /* Least recently used first, which also is what the default priority is based on. */
+    std::sort(elements.begin(), elements.end(), compare_last_used);
 
-        if (!can_destroy_element(elem))
-          continue;
+    for (i = 0; i < elements.size(); i++) {
+      MEM_CacheElementPtr elem = elements[i];
+      DestroyCandidate candidate = {0, elem};
 
+      if (!can_destroy_element(elem))
+        continue;
+
+      if (item_priority_func) {
         /* by default 0 means highest priority element */
         /* casting a size type to int is questionable,
            but unlikely to cause problems */
-        int priority = -((int)(queue.size()) - i - 1);
-        priority = item_priority_func(elem->get()->get_data(), priority);
-
-        if (priority < best_match_priority || best_match_elem == NULL) {
-          best_match_priority = priority;
-          best_match_elem = elem;
-        }
+        int priority = -((int)(elements.size()) - i - 1);
+        candidate.priority = item_priority_func(elem->get()->get_data(), priority);
       }
+
+      candidates.push_back(candidate);
     }
 
-    return best_match_elem;
+    /* Keep least recently used first among elements of the same priority. */
+    std::stable_sort(candidates.begin(), candidates.end(), compare_priority);
+
+    for (i = 0; i < candidates.size() && get_memory_in_use() > max; i++) {
+      MEM_CacheElementPtr elem = candidates[i].elem;
+      remove_locked(elem);
+      elem->is_evicted = true;
+      evicted.push_back(elem);
+    }
   }
 
-  MEM_CacheQueue queue;
+  Shard shards[MEM_CACHE_LIMITER_SHARDS];
+  std::mutex enforce_mutex;
   MEM_CacheLimiter_DataSize_Func data_size_func;
   MEM_CacheLimiter_ItemPriority_Func item_priority_func;
   MEM_CacheLimiter_ItemDestroyable_Func item_destroyable_func;
+  std::atomic<size_t> memory_in_use;
+  std::atomic<uint64_t> use_counter;
+  std::atomic<unsigned int> next_shard;
 };
 
 #endif  // __MEM_CACHELIMITER_H__
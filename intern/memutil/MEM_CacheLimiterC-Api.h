@@ -85,11 +85,22 @@ MEM_CacheLimiterHandleC *MEM_CacheLimiter_insert(MEM_CacheLimiterC *This, void *
 /**
  * Free objects until memory constraints are satisfied
  *
+ * Must not run concurrently with unmanaging objects it could free,
+ * inserting, unmanaging and touching objects is thread safe otherwise.
+ *
  * \param This: "This" pointer.
  */
 
 void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This);
 
+/**
+ * Check whether memory in use exceeds the maximum, without iterating managed objects.
+ *
+ * \param This: "This" pointer.
+ */
+
+bool MEM_CacheLimiter_is_over_limit(MEM_CacheLimiterC *This);
+
 /**
  * Unmanage object previously inserted object.
  * Does _not_ delete managed object!
@@ -56,8 +56,6 @@ class MEM_CacheLimiterCClass;
 
 typedef MEM_CacheLimiterHandle<MEM_CacheLimiterHandleCClass> handle_t;
 typedef MEM_CacheLimiter<MEM_CacheLimiterHandleCClass> cache_t;
-typedef std::list<MEM_CacheLimiterHandleCClass *, MEM_Allocator<MEM_CacheLimiterHandleCClass *>>
-    list_t;
 
 class MEM_CacheLimiterCClass {
  public:
@@ -70,7 +68,7 @@ class MEM_CacheLimiterCClass {
 
   handle_t *insert(void *data);
 
-  void destruct(void *data, list_t::iterator it);
+  void destruct(void *data);
 
   cache_t *get_cache()
   {
@@ -81,8 +79,6 @@ class MEM_CacheLimiterCClass {
   MEM_CacheLimiter_Destruct_Func data_destructor;
 
   MEM_CacheLimiter<MEM_CacheLimiterHandleCClass> cache;
-
-  list_t cclass_list;
 };
 
 class MEM_CacheLimiterHandleCClass {
@@ -94,11 +90,6 @@ class MEM_CacheLimiterHandleCClass {
 
   ~MEM_CacheLimiterHandleCClass();
 
-  void set_iter(list_t::iterator it_)
-  {
-    it = it_;
-  }
-
   void set_data(void *data_)
   {
     data = data_;
@@ -112,40 +103,38 @@ class MEM_CacheLimiterHandleCClass {
  private:
   void *data;
   MEM_CacheLimiterCClass *parent;
-  list_t::iterator it;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("MEM_CacheLimiterHandleCClass")
 };
 
 handle_t *MEM_CacheLimiterCClass::insert(void *data)
 {
-  cclass_list.push_back(new MEM_CacheLimiterHandleCClass(data, this));
-  list_t::iterator it = cclass_list.end();
-  --it;
-  cclass_list.back()->set_iter(it);
-
-  return cache.insert(cclass_list.back());
+  return cache.insert(new MEM_CacheLimiterHandleCClass(data, this));
 }
 
-void MEM_CacheLimiterCClass::destruct(void *data, list_t::iterator it)
+void MEM_CacheLimiterCClass::destruct(void *data)
 {
   data_destructor(data);
-  cclass_list.erase(it);
 }
 
 MEM_CacheLimiterHandleCClass::~MEM_CacheLimiterHandleCClass()
 {
   if (data) {
-    parent->destruct(data, it);
+    parent->destruct(data);
   }
 }
 
+static void free_handle_cclass(MEM_CacheLimiterHandleCClass *handle)
+{
+  handle->set_data(NULL);
+
+  delete handle;
+}
+
 MEM_CacheLimiterCClass::~MEM_CacheLimiterCClass()
 {
   // should not happen, but don't leak memory in this case...
-  for (list_t::iterator it = cclass_list.begin(); it != cclass_list.end(); it++) {
-    (*it)->set_data(NULL);
-
-    delete *it;
-  }
+  cache.unmanage_all(free_handle_cclass);
 }
 
 // ----------------------------------------------------------------------
@@ -181,9 +170,17 @@ void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This)
   cast(This)->get_cache()->enforce_limits();
 }
 
+bool MEM_CacheLimiter_is_over_limit(MEM_CacheLimiterC *This)
+{
+  return cast(This)->get_cache()->is_over_limit();
+}
+
 void MEM_CacheLimiter_unmanage(MEM_CacheLimiterHandleC *handle)
 {
-  cast(handle)->unmanage();
+  MEM_CacheLimiterHandleCClass *cclass = cast(handle)->unmanage();
+  if (cclass) {
+    free_handle_cclass(cclass);
+  }
 }
 
 void MEM_CacheLimiter_touch(MEM_CacheLimiterHandleC *handle)
@@ -255,6 +255,11 @@ void openSubdiv_deleteTopologyRefiner(OpenSubdiv_TopologyRefiner *topology_refin
   OBJECT_GUARDED_DELETE(topology_refiner, OpenSubdiv_TopologyRefiner);
 }
 
+void openSubdiv_topologyRefinerRefine(OpenSubdiv_TopologyRefiner *topology_refiner)
+{
+  topology_refiner->impl->refine();
+}
+
 bool openSubdiv_topologyRefinerCompareWithConverter(
     const OpenSubdiv_TopologyRefiner *topology_refiner, const OpenSubdiv_Converter *converter)
 {
@@ -21,7 +21,7 @@
 namespace blender {
 namespace opensubdiv {
 
-TopologyRefinerImpl::TopologyRefinerImpl() : topology_refiner(nullptr)
+TopologyRefinerImpl::TopologyRefinerImpl() : topology_refiner(nullptr), is_refined(false)
 {
 }
 
@@ -30,5 +30,25 @@ TopologyRefinerImpl::~TopologyRefinerImpl()
   delete topology_refiner;
 }
 
+void TopologyRefinerImpl::refine()
+{
+  using OpenSubdiv::Far::TopologyRefiner;
+
+  if (is_refined || topology_refiner == nullptr) {
+    return;
+  }
+  if (settings.is_adaptive) {
+    TopologyRefiner::AdaptiveOptions options(settings.level);
+    options.considerFVarChannels = (topology_refiner->GetNumFVarChannels() != 0);
+    options.useInfSharpPatch = true;
+    topology_refiner->RefineAdaptive(options);
+  }
+  else {
+    TopologyRefiner::UniformOptions options(settings.level);
+    topology_refiner->RefineUniform(options);
+  }
+  is_refined = true;
+}
+
 }  // namespace opensubdiv
 }  // namespace blender
@@ -49,8 +49,17 @@ class TopologyRefinerImpl {
   // Covers options, geometry, and geometry tags.
   bool isEqualToConverter(const OpenSubdiv_Converter *converter) const;
 
+  // Refine the topology for the subdivision level and adaptivity of the settings,
+  // does nothing when it is refined already.
+  //
+  // NOTE: Not thread safe, evaluators only read refined topology refiners.
+  void refine();
+
   OpenSubdiv::Far::TopologyRefiner *topology_refiner;
 
+  // Refinement of the topology_refiner happened.
+  bool is_refined;
+
   // Subdivision settingsa this refiner is created for.
   OpenSubdiv_TopologyRefinerSettings settings;
 
@@ -140,6 +140,11 @@ OpenSubdiv_TopologyRefiner *openSubdiv_createTopologyRefinerFromConverter(
 
 void openSubdiv_deleteTopologyRefiner(OpenSubdiv_TopologyRefiner *topology_refiner);
 
+// Refine topology for the subdivision level and adaptivity the refiner is created
+// for. Creating an evaluator does this when it did not happen yet, evaluators of a
+// refined topology refiner only read it, so they can be created from several threads.
+void openSubdiv_topologyRefinerRefine(OpenSubdiv_TopologyRefiner *topology_refiner);
+
 // Compare given topology refiner with converter. Returns truth if topology
 // refiner matches given converter, false otherwise.
 //
@@ -30,6 +30,10 @@ void openSubdiv_deleteTopologyRefiner(OpenSubdiv_TopologyRefiner * /*topology_re
 {
 }
 
+void openSubdiv_topologyRefinerRefine(OpenSubdiv_TopologyRefiner * /*topology_refiner*/)
+{
+}
+
 bool openSubdiv_topologyRefinerCompareWithConverter(
     const OpenSubdiv_TopologyRefiner * /*topology_refiner*/,
     const OpenSubdiv_Converter * /*converter*/)
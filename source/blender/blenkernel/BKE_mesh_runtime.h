@@ -35,10 +35,12 @@ struct CustomData;
 struct CustomData_MeshMasks;
 struct Depsgraph;
 struct KeyBlock;
+struct MDeformVert;
 struct MLoop;
 struct MLoopTri;
 struct MVertTri;
 struct Mesh;
+struct MeshElemMap;
 struct Object;
 struct Scene;
 
@@ -53,6 +55,64 @@ bool BKE_mesh_runtime_reset_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
 
+const struct MeshElemMap *BKE_mesh_runtime_vert_poly_map_ensure(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_vert_edge_map_ensure(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_edge_poly_map_ensure(struct Mesh *mesh);
+void BKE_mesh_runtime_clear_topology_maps(struct Mesh *mesh);
+
+uint64_t BKE_mesh_runtime_topology_hash_ensure(struct Mesh *mesh);
+bool BKE_mesh_runtime_topology_caches_transfer(struct Mesh *mesh_src, struct Mesh *mesh_dst);
+
+/**
+ * Vertex group weights in compressed sparse row layout. Zero weights are kept, they still
+ * tell whether a vertex is in a group. The order of the weights of each vertex is kept,
+ * dual quaternion blending depends on it.
+ */
+typedef struct MeshDeformWeights {
+  /** Weights of vertex `i` are in the `[offsets[i], offsets[i + 1])` range, `verts_len + 1`. */
+  int *offsets;
+  int *def_nr;
+  float *weights;
+  /** The #Mesh.dvert array this was built from. */
+  const struct MDeformVert *dvert;
+  int verts_len;
+} MeshDeformWeights;
+
+const MeshDeformWeights *BKE_mesh_runtime_deform_weights_ensure(struct Mesh *mesh);
+void BKE_mesh_runtime_clear_deform_weights(struct Mesh *mesh);
+
+/**
+ * Evaluated result of a modifier stack, shared read-only between objects which use the same
+ * mesh with an identical modifier stack. Owned by the (copy-on-write) input mesh.
+ */
+typedef struct MeshEvalShared {
+  struct MeshEvalShared *next;
+  /** Unique for the session, so stale references of objects are never mistaken for it. */
+  unsigned int id;
+  /** Everything the result depends on besides the input mesh, compared byte-wise. */
+  void *key;
+  size_t key_len;
+  int users;
+  /** Set together with the meshes, under the evaluation mutex of the input mesh. */
+  bool is_built;
+  struct Mesh *mesh_final;
+  struct Mesh *mesh_deform;
+} MeshEvalShared;
+
+MeshEvalShared *BKE_mesh_runtime_eval_shared_acquire(struct Mesh *mesh,
+                                                     const void *key,
+                                                     const size_t key_len);
+bool BKE_mesh_runtime_eval_shared_get(struct Mesh *mesh,
+                                      MeshEvalShared *shared,
+                                      struct Mesh **r_mesh_final,
+                                      struct Mesh **r_mesh_deform);
+void BKE_mesh_runtime_eval_shared_store(struct Mesh *mesh,
+                                        MeshEvalShared *shared,
+                                        struct Mesh **r_mesh_final,
+                                        struct Mesh **r_mesh_deform);
+void BKE_mesh_runtime_eval_shared_release(struct Mesh *mesh, const unsigned int id);
+void BKE_mesh_runtime_clear_eval_shared(struct Mesh *mesh);
+
 void BKE_mesh_runtime_verttri_from_looptri(struct MVertTri *r_verttri,
                                            const struct MLoop *mloop,
                                            const struct MLoopTri *looptri,
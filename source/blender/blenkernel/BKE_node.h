@@ -1222,6 +1222,12 @@ void ntreeCompositExecTree(struct Scene *scene,
                            const struct ColorManagedViewSettings *view_settings,
                            const struct ColorManagedDisplaySettings *display_settings,
                            const char *view_name);
+bool ntreeCompositBenchmark(struct Scene *scene,
+                            int iterations,
+                            int width,
+                            int height,
+                            int chunk_size,
+                            const char *filepath);
 void ntreeCompositTagRender(struct Scene *sce);
 void ntreeCompositUpdateRLayers(struct bNodeTree *ntree);
 void ntreeCompositRegisterPass(struct bNodeTree *ntree,
@@ -37,6 +37,7 @@ struct OpenSubdiv_Converter;
 struct OpenSubdiv_Evaluator;
 struct OpenSubdiv_TopologyRefiner;
 struct Subdiv;
+struct SubdivTopologyRefinerCacheEntry;
 
 typedef enum eSubdivVtxBoundaryInterpolation {
   /* Do not interpolate boundaries. */
@@ -179,6 +180,9 @@ typedef struct Subdiv {
    * topology to OpenSubdiv. It can be shared by both evaluator and GL mesh
    * drawer. */
   struct OpenSubdiv_TopologyRefiner *topology_refiner;
+  /* Set when the topology refiner comes from the topology refiner cache, in which case it is
+   * shared with other subdivision surfaces of the same topology and not owned by this one. */
+  struct SubdivTopologyRefinerCacheEntry *topology_refiner_cache_entry;
   /* CPU side evaluator. */
   struct OpenSubdiv_Evaluator *evaluator;
   /* Optional displacement evaluator. */
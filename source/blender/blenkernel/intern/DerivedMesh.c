@@ -32,6 +32,7 @@
 #include "DNA_material_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
@@ -41,6 +42,7 @@
 #include "BLI_linklist.h"
 #include "BLI_math.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_DerivedMesh.h"
@@ -1757,6 +1759,161 @@ static void mesh_runtime_check_normals_valid(const Mesh *mesh)
   BLI_assert(!(mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL));
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Shared Modifier Stack Evaluation
+ *
+ * Linked duplicates with identical modifier stacks evaluate the stack once and share the
+ * result, see #BKE_mesh_runtime_eval_shared_acquire. Only modifiers whose result depends on
+ * nothing but the input mesh, their settings and the few object properties added to the key
+ * are supported, stacks with any other modifier are evaluated per object.
+ * \{ */
+
+typedef struct MeshEvalSharedKey {
+  char *data;
+  size_t len;
+  size_t len_alloc;
+} MeshEvalSharedKey;
+
+static void mesh_eval_shared_key_append(MeshEvalSharedKey *key,
+                                        const void *data,
+                                        const size_t data_len)
+{
+  if (key->len + data_len > key->len_alloc) {
+    key->len_alloc = max_zz((key->len + data_len) * 2, 256);
+    key->data = (key->data != NULL) ? MEM_reallocN(key->data, key->len_alloc) :
+                                      MEM_mallocN(key->len_alloc, __func__);
+  }
+  memcpy(key->data + key->len, data, data_len);
+  key->len += data_len;
+}
+
+/**
+ * Fill in everything the result of the modifier stack depends on besides the input mesh.
+ * \return false when the result can not be shared.
+ */
+static bool mesh_eval_shared_key_build(struct Depsgraph *depsgraph,
+                                       Scene *scene,
+                                       Object *ob,
+                                       const CustomData_MeshMasks *dataMask,
+                                       const bool need_mapping,
+                                       MeshEvalSharedKey *key)
+{
+  const Mesh *mesh_input = ob->data;
+  /* Same as #mesh_calc_modifiers, objects may differ in viewport or render visibility only. */
+  const bool use_render = (DEG_get_mode(depsgraph) == DAG_EVAL_RENDER);
+  const int required_mode = use_render ? eModifierMode_Render : eModifierMode_Realtime;
+  if (ob->mode != OB_MODE_OBJECT || ob->sculpt != NULL || mesh_input->edit_mesh != NULL ||
+      !BLI_listbase_is_empty(&ob->particlesystem)) {
+    return false;
+  }
+  /* Written into the result by #mesh_build_extra_data. */
+  if (DEG_get_eval_flags_for_id(depsgraph, &ob->id) & DAG_EVAL_NEED_SHRINKWRAP_BOUNDARY) {
+    return false;
+  }
+
+  const char need_mapping_key = need_mapping;
+  const short simplify_subsurf = (scene->r.mode & R_SIMPLIFY) ? scene->r.simplify_subsurf : -1;
+  mesh_eval_shared_key_append(key, &required_mode, sizeof(required_mode));
+  mesh_eval_shared_key_append(key, dataMask, sizeof(*dataMask));
+  mesh_eval_shared_key_append(key, &need_mapping_key, sizeof(need_mapping_key));
+  mesh_eval_shared_key_append(key, &simplify_subsurf, sizeof(simplify_subsurf));
+  mesh_eval_shared_key_append(key, &ob->totcol, sizeof(ob->totcol));
+  mesh_eval_shared_key_append(key, &ob->shapenr, sizeof(ob->shapenr));
+  mesh_eval_shared_key_append(key, &ob->shapeflag, sizeof(ob->shapeflag));
+  /* Modifiers refer to vertex groups by name. */
+  LISTBASE_FOREACH (const bDeformGroup *, dg, &ob->defbase) {
+    mesh_eval_shared_key_append(key, dg->name, strlen(dg->name) + 1);
+  }
+
+  VirtualModifierData virtualModifierData;
+  int modifiers_num = 0;
+  for (ModifierData *md = BKE_modifiers_get_virtual_modifierlist(ob, &virtualModifierData);
+       md != NULL;
+       md = md->next) {
+    if (!BKE_modifier_is_enabled(scene, md, required_mode)) {
+      continue;
+    }
+    const ModifierTypeInfo *mti = BKE_modifier_get_info(md->type);
+    /* Settings follow the #ModifierData header, pointers other than the checked ones have to
+     * be excluded since they differ between objects. */
+    size_t settings_len = (size_t)mti->structSize - sizeof(ModifierData);
+    switch (md->type) {
+      case eModifierType_ShapeKey:
+        break;
+      case eModifierType_Subsurf:
+        settings_len = offsetof(SubsurfModifierData, emCache) - sizeof(ModifierData);
+        modifiers_num++;
+        break;
+      case eModifierType_Array: {
+        const ArrayModifierData *amd = (const ArrayModifierData *)md;
+        if (amd->start_cap || amd->end_cap || amd->curve_ob || amd->offset_ob) {
+          return false;
+        }
+        modifiers_num++;
+        break;
+      }
+      case eModifierType_Mirror:
+        if (((const MirrorModifierData *)md)->mirror_ob != NULL) {
+          return false;
+        }
+        modifiers_num++;
+        break;
+      case eModifierType_EdgeSplit:
+      case eModifierType_Solidify:
+      case eModifierType_Triangulate:
+      case eModifierType_Weld:
+        modifiers_num++;
+        break;
+      default:
+        return false;
+    }
+    mesh_eval_shared_key_append(key, &md->type, sizeof(md->type));
+    mesh_eval_shared_key_append(key, md + 1, settings_len);
+  }
+  /* Sharing the result of a stack without generative modifiers is handled by the input mesh
+   * already, see #mesh_calc_modifiers. */
+  return modifiers_num != 0;
+}
+
+static Mesh *mesh_calc_modifiers_shared(struct Depsgraph *depsgraph,
+                                        Scene *scene,
+                                        Object *ob,
+                                        const CustomData_MeshMasks *dataMask,
+                                        const bool need_mapping,
+                                        const MeshEvalSharedKey *key,
+                                        Mesh **r_deform,
+                                        uint *r_eval_shared_id)
+{
+  Mesh *mesh_input = ob->data;
+  MeshEvalShared *shared = BKE_mesh_runtime_eval_shared_acquire(mesh_input, key->data, key->len);
+  Mesh *mesh_final, *mesh_deform;
+
+  if (!BKE_mesh_runtime_eval_shared_get(mesh_input, shared, &mesh_final, &mesh_deform)) {
+    /* No lock is held while evaluating, users of the same stack which run at the same time
+     * each evaluate it and the first stored result is kept. */
+    mesh_calc_modifiers(depsgraph,
+                        scene,
+                        ob,
+                        1,
+                        need_mapping,
+                        dataMask,
+                        -1,
+                        true,
+                        true,
+                        &mesh_deform,
+                        &mesh_final);
+    BLI_assert(mesh_final != mesh_input->runtime.mesh_eval);
+    BKE_mesh_runtime_eval_shared_store(mesh_input, shared, &mesh_final, &mesh_deform);
+  }
+
+  *r_eval_shared_id = shared->id;
+  /* The deformed mesh is owned by the object, give it a copy referencing the shared data. */
+  *r_deform = (mesh_deform != NULL) ? BKE_mesh_copy_for_eval(mesh_deform, true) : NULL;
+  return mesh_final;
+}
+
+/** \} */
+
 static void mesh_build_data(struct Depsgraph *depsgraph,
                             Scene *scene,
                             Object *ob,
@@ -1769,6 +1926,20 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
    * they aren't cleaned up properly on mode switch, causing crashes, e.g T58150. */
   BLI_assert(ob->id.tag & LIB_TAG_COPIED_ON_WRITE);
 
+  /* Keep the previous result alive until the new one is computed, so caches which only depend
+   * on topology can be carried over when it did not change (deform-only modifier stacks).
+   * Meshes with multires CCG are left alone, freeing them reshapes the original mesh. */
+  Mesh *mesh_eval_prev = NULL;
+  if (ob->runtime.is_data_eval_owned && ob->runtime.data_eval != NULL &&
+      GS(ob->runtime.data_eval->name) == ID_ME &&
+      ((Mesh *)ob->runtime.data_eval)->runtime.subdiv_ccg == NULL) {
+    mesh_eval_prev = (Mesh *)ob->runtime.data_eval;
+    ob->runtime.data_eval = NULL;
+  }
+  /* Released once the new result is assigned, so it is kept when the key did not change. */
+  const uint eval_shared_id_prev = ob->runtime.eval_shared_id;
+  ob->runtime.eval_shared_id = 0;
+
   BKE_object_free_derived_caches(ob);
   if (DEG_is_active(depsgraph)) {
     BKE_sculpt_update_object_before_eval(ob);
@@ -1783,28 +1954,61 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
   }
 #endif
 
-  Mesh *mesh_eval = NULL, *mesh_deform_eval = NULL;
-  mesh_calc_modifiers(depsgraph,
-                      scene,
-                      ob,
-                      1,
-                      need_mapping,
-                      dataMask,
-                      -1,
-                      true,
-                      true,
-                      &mesh_deform_eval,
-                      &mesh_eval);
-
-  /* The modifier stack evaluation is storing result in mesh->runtime.mesh_eval, but this result
-   * is not guaranteed to be owned by object.
-   *
-   * Check ownership now, since later on we can not go to a mesh owned by someone else via
-   * object's runtime: this could cause access freed data on depsgraph destruction (mesh who owns
-   * the final result might be freed prior to object). */
   Mesh *mesh = ob->data;
-  const bool is_mesh_eval_owned = (mesh_eval != mesh->runtime.mesh_eval);
+  Mesh *mesh_eval = NULL, *mesh_deform_eval = NULL;
+  uint eval_shared_id = 0;
+  bool is_mesh_eval_owned;
+  MeshEvalSharedKey shared_key = {NULL};
+  if (mesh_eval_shared_key_build(depsgraph, scene, ob, dataMask, need_mapping, &shared_key)) {
+    mesh_eval = mesh_calc_modifiers_shared(depsgraph,
+                                           scene,
+                                           ob,
+                                           dataMask,
+                                           need_mapping,
+                                           &shared_key,
+                                           &mesh_deform_eval,
+                                           &eval_shared_id);
+    is_mesh_eval_owned = false;
+  }
+  else {
+    mesh_calc_modifiers(depsgraph,
+                        scene,
+                        ob,
+                        1,
+                        need_mapping,
+                        dataMask,
+                        -1,
+                        true,
+                        true,
+                        &mesh_deform_eval,
+                        &mesh_eval);
+
+    /* The modifier stack evaluation is storing result in mesh->runtime.mesh_eval, but this
+     * result is not guaranteed to be owned by object.
+     *
+     * Check ownership now, since later on we can not go to a mesh owned by someone else via
+     * object's runtime: this could cause access freed data on depsgraph destruction (mesh who
+     * owns the final result might be freed prior to object). */
+    is_mesh_eval_owned = (mesh_eval != mesh->runtime.mesh_eval);
+  }
+  MEM_SAFE_FREE(shared_key.data);
   BKE_object_eval_assign_data(ob, &mesh_eval->id, is_mesh_eval_owned);
+  ob->runtime.eval_shared_id = eval_shared_id;
+
+  if (eval_shared_id_prev != 0) {
+    BKE_mesh_runtime_eval_shared_release(mesh, eval_shared_id_prev);
+  }
+
+  if (is_mesh_eval_owned) {
+    /* Computed while the data is known to be valid, used by the next evaluation. */
+    BKE_mesh_runtime_topology_hash_ensure(mesh_eval);
+  }
+  if (mesh_eval_prev != NULL) {
+    if (is_mesh_eval_owned) {
+      BKE_mesh_runtime_topology_caches_transfer(mesh_eval_prev, mesh_eval);
+    }
+    BKE_mesh_eval_delete(mesh_eval_prev);
+  }
 
   ob->runtime.mesh_deform_eval = mesh_deform_eval;
   ob->runtime.last_data_mask = *dataMask;
@@ -50,11 +50,16 @@
 #include "BKE_deform.h"
 #include "BKE_editmesh.h"
 #include "BKE_lattice.h"
+#include "BKE_mesh_runtime.h"
 
 #include "DEG_depsgraph_build.h"
 
 #include "CLG_log.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static CLG_LogRef LOG = {"bke.armature_deform"};
 
 /* -------------------------------------------------------------------- */
@@ -258,6 +263,9 @@ typedef struct ArmatureUserdata {
   bPoseChannel **pchan_from_defbase;
   int defbase_len;
 
+  /** Compact weights of the target mesh, only set when the fast path can be used. */
+  const MeshDeformWeights *deform_weights;
+
   float premat[4][4];
   float postmat[4][4];
 
@@ -459,6 +467,214 @@ static void armature_vert_task_editmesh_no_dvert(void *__restrict userdata, Memp
   armature_vert_task_with_dvert(data, BM_elem_index_get(v), NULL);
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Armature Deform Compact Weights
+ *
+ * Fast path for the common case of a mesh skinned by vertex groups only:
+ * the compact weights cached on the mesh (#MeshDeformWeights) are used instead of
+ * #MDeformVert, and bone matrices or dual quaternions are blended four components at a time.
+ * Vertices which need envelopes are handed over to #armature_vert_task.
+ * \{ */
+
+static bool armature_vert_has_deform_weights(const ArmatureUserdata *data, const int i)
+{
+  const MeshDeformWeights *weights = data->deform_weights;
+  for (int j = weights->offsets[i]; j < weights->offsets[i + 1]; j++) {
+    const int index = weights->def_nr[j];
+    if (index < data->defbase_len && data->pchan_from_defbase[index]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void armature_vert_deform_weights_linear(const ArmatureUserdata *data,
+                                                const int i,
+                                                float co[3])
+{
+  const MeshDeformWeights *weights = data->deform_weights;
+  const int *def_nr = weights->def_nr;
+  const float *weight = weights->weights;
+  float contrib = 0.0f;
+
+#ifdef __SSE2__
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  __m128 sum2 = _mm_setzero_ps();
+  __m128 sum3 = _mm_setzero_ps();
+#else
+  float summat[4][4];
+  zero_m4(summat);
+#endif
+
+  for (int j = weights->offsets[i]; j < weights->offsets[i + 1]; j++) {
+    const int index = def_nr[j];
+    const bPoseChannel *pchan;
+    if (index >= data->defbase_len || !(pchan = data->pchan_from_defbase[index]) ||
+        weight[j] == 0.0f) {
+      continue;
+    }
+    const float(*mat)[4] = pchan->chan_mat;
+#ifdef __SSE2__
+    const __m128 w = _mm_set1_ps(weight[j]);
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(w, _mm_loadu_ps(mat[0])));
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(w, _mm_loadu_ps(mat[1])));
+    sum2 = _mm_add_ps(sum2, _mm_mul_ps(w, _mm_loadu_ps(mat[2])));
+    sum3 = _mm_add_ps(sum3, _mm_mul_ps(w, _mm_loadu_ps(mat[3])));
+#else
+    madd_v4_v4fl(summat[0], mat[0], weight[j]);
+    madd_v4_v4fl(summat[1], mat[1], weight[j]);
+    madd_v4_v4fl(summat[2], mat[2], weight[j]);
+    madd_v4_v4fl(summat[3], mat[3], weight[j]);
+#endif
+    contrib += weight[j];
+  }
+
+  /* Same threshold as #armature_vert_task_with_dvert. */
+  if (contrib > 0.0001f) {
+    /* Sum of `weight * (mat * co - co)`, see #pchan_deform_accumulate. */
+    float vec[4];
+#ifdef __SSE2__
+    __m128 r = _mm_add_ps(_mm_mul_ps(sum0, _mm_set1_ps(co[0])),
+                          _mm_mul_ps(sum1, _mm_set1_ps(co[1])));
+    r = _mm_add_ps(r, _mm_add_ps(_mm_mul_ps(sum2, _mm_set1_ps(co[2])), sum3));
+    _mm_storeu_ps(vec, r);
+#else
+    mul_v3_m4v3(vec, summat, co);
+#endif
+    madd_v3_v3fl(vec, co, -contrib);
+    madd_v3_v3fl(co, vec, 1.0f / contrib);
+  }
+}
+
+static void armature_vert_deform_weights_dual_quat(const ArmatureUserdata *data,
+                                                   const int i,
+                                                   float co[3])
+{
+  const MeshDeformWeights *weights = data->deform_weights;
+  const int *def_nr = weights->def_nr;
+  const float *weight = weights->weights;
+  float contrib = 0.0f;
+  DualQuat sumdq;
+
+  memset(&sumdq, 0, sizeof(sumdq));
+
+#ifdef __SSE2__
+  __m128 sum_quat = _mm_setzero_ps();
+  __m128 sum_trans = _mm_setzero_ps();
+  __m128 sum_scale[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+#endif
+
+  for (int j = weights->offsets[i]; j < weights->offsets[i + 1]; j++) {
+    const int index = def_nr[j];
+    const bPoseChannel *pchan;
+    if (index >= data->defbase_len || !(pchan = data->pchan_from_defbase[index]) ||
+        weight[j] == 0.0f) {
+      continue;
+    }
+    const DualQuat *dq = &pchan->runtime.deform_dual_quat;
+#ifdef __SSE2__
+    /* Inlined #add_weighted_dq_dq, keeping the sum in registers. */
+    const __m128 quat = _mm_loadu_ps(dq->quat);
+    __m128 dot = _mm_mul_ps(quat, sum_quat);
+    dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+    dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(1, 0, 3, 2)));
+    /* Make sure we interpolate quaternions in the right direction. */
+    const float w = (_mm_cvtss_f32(dot) < 0.0f) ? -weight[j] : weight[j];
+    const __m128 w4 = _mm_set1_ps(w);
+
+    sum_quat = _mm_add_ps(sum_quat, _mm_mul_ps(w4, quat));
+    sum_trans = _mm_add_ps(sum_trans, _mm_mul_ps(w4, _mm_loadu_ps(dq->trans)));
+
+    if (dq->scale_weight) {
+      /* We don't want negative weights for scaling. */
+      const __m128 ws = _mm_set1_ps(weight[j]);
+      for (int k = 0; k < 4; k++) {
+        sum_scale[k] = _mm_add_ps(sum_scale[k], _mm_mul_ps(ws, _mm_loadu_ps(dq->scale[k])));
+      }
+      sumdq.scale_weight += weight[j];
+    }
+#else
+    add_weighted_dq_dq(&sumdq, dq, weight[j]);
+#endif
+    contrib += weight[j];
+  }
+
+  if (contrib > 0.0001f) {
+#ifdef __SSE2__
+    _mm_storeu_ps(sumdq.quat, sum_quat);
+    _mm_storeu_ps(sumdq.trans, sum_trans);
+    for (int k = 0; k < 4; k++) {
+      _mm_storeu_ps(sumdq.scale[k], sum_scale[k]);
+    }
+#endif
+    normalize_dq(&sumdq, contrib);
+    mul_v3m3_dq(co, NULL, &sumdq);
+  }
+}
+
+static void armature_vert_task_deform_weights(void *__restrict userdata,
+                                              const int i,
+                                              const TaskParallelTLS *__restrict tls)
+{
+  const ArmatureUserdata *data = userdata;
+
+  /* Vertices with groups not matching any bone fall back to envelopes. */
+  if (data->use_envelope && !armature_vert_has_deform_weights(data, i)) {
+    armature_vert_task(userdata, i, tls);
+    return;
+  }
+
+  float *co = data->vert_coords[i];
+
+  mul_m4_v3(data->premat, co);
+  if (data->use_quaternion) {
+    armature_vert_deform_weights_dual_quat(data, i, co);
+  }
+  else {
+    armature_vert_deform_weights_linear(data, i, co);
+  }
+  mul_m4_v3(data->postmat, co);
+}
+
+/**
+ * The compact weights only cover plain vertex group skinning: B-Bones, envelope multiplied
+ * weights, deform matrices and blending with previous coordinates use the generic code.
+ */
+static const MeshDeformWeights *armature_deform_weights_get(const ArmatureUserdata *data,
+                                                            const Object *ob_target,
+                                                            const int vert_coords_len)
+{
+  if (!data->use_dverts || data->vert_deform_mats || data->vert_coords_prev ||
+      data->armature_def_nr != -1 || ob_target->type != OB_MESH) {
+    return NULL;
+  }
+
+  /* Weights are cached on the target object's mesh, only use them when deforming its
+   * vertex groups (directly or through an evaluated copy referencing them). */
+  Mesh *mesh = ob_target->data;
+  const MDeformVert *dverts = data->me_target ? data->me_target->dvert : data->dverts;
+  if (dverts == NULL || dverts != mesh->dvert || vert_coords_len != mesh->totvert) {
+    return NULL;
+  }
+
+  for (int i = 0; i < data->defbase_len; i++) {
+    const bPoseChannel *pchan = data->pchan_from_defbase[i];
+    if (pchan == NULL) {
+      continue;
+    }
+    const Bone *bone = pchan->bone;
+    if ((bone->flag & BONE_MULT_VG_ENV) ||
+        (bone->segments > 1 && pchan->runtime.bbone_segments == bone->segments)) {
+      return NULL;
+    }
+  }
+
+  return BKE_mesh_runtime_deform_weights_ensure(mesh);
+}
+
+/** \} */
+
 static void armature_deform_coords_impl(const Object *ob_arm,
                                         const Object *ob_target,
                                         float (*vert_coords)[3],
@@ -602,10 +818,17 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     }
   }
   else {
+    data.deform_weights = armature_deform_weights_get(&data, ob_target, vert_coords_len);
+
     TaskParallelSettings settings;
     BLI_parallel_range_settings_defaults(&settings);
     settings.min_iter_per_thread = 32;
-    BLI_task_parallel_range(0, vert_coords_len, &data, armature_vert_task, &settings);
+    BLI_task_parallel_range(0,
+                            vert_coords_len,
+                            &data,
+                            data.deform_weights ? armature_vert_task_deform_weights :
+                                                  armature_vert_task,
+                            &settings);
   }
 
   if (pchan_from_defbase) {
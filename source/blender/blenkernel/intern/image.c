@@ -37,6 +37,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
@@ -60,6 +62,7 @@
 #include "DNA_world_types.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_hash.h"
 #include "BLI_math_vector.h"
 #include "BLI_mempool.h"
 #include "BLI_system.h"
@@ -104,7 +107,27 @@
 #include "DNA_view3d_types.h"
 
 static CLG_LogRef LOG = {"bke.image"};
-static ThreadMutex *image_mutex;
+
+/* Images are locked with one of these, picked by the image address, so threads working on
+ * different images rarely wait for each other. Lookups of buffers which are already loaded only
+ * lock for reading, everything changing the image or its cache locks for writing. */
+#define IMAGE_LOCK_SHARDS 64
+static ThreadRWMutex image_locks[IMAGE_LOCK_SHARDS];
+
+BLI_INLINE ThreadRWMutex *image_lock_get(const Image *ima)
+{
+  return &image_locks[BLI_hash_int((uint)((uintptr_t)ima >> 4)) % IMAGE_LOCK_SHARDS];
+}
+
+static void image_lock(const Image *ima)
+{
+  BLI_rw_mutex_lock(image_lock_get(ima), THREAD_LOCK_WRITE);
+}
+
+static void image_unlock(const Image *ima)
+{
+  BLI_rw_mutex_unlock(image_lock_get(ima));
+}
 
 static void image_init(Image *ima, short source, short type);
 static void image_free_packedfiles(Image *ima);
@@ -321,12 +344,16 @@ static struct ImBuf *imagecache_get(Image *image, int index)
 
 void BKE_images_init(void)
 {
-  image_mutex = BLI_mutex_alloc();
+  for (int i = 0; i < IMAGE_LOCK_SHARDS; i++) {
+    BLI_rw_mutex_init(&image_locks[i]);
+  }
 }
 
 void BKE_images_exit(void)
 {
-  BLI_mutex_free(image_mutex);
+  for (int i = 0; i < IMAGE_LOCK_SHARDS; i++) {
+    BLI_rw_mutex_end(&image_locks[i]);
+  }
 }
 
 /* ***************** ALLOC & FREE, DATA MANAGING *************** */
@@ -381,7 +408,7 @@ static void image_free_anims(Image *ima)
 void BKE_image_free_buffers_ex(Image *ima, bool do_lock)
 {
   if (do_lock) {
-    BLI_mutex_lock(image_mutex);
+    image_lock(ima);
   }
   image_free_cached_frames(ima);
 
@@ -399,7 +426,7 @@ void BKE_image_free_buffers_ex(Image *ima, bool do_lock)
   }
 
   if (do_lock) {
-    BLI_mutex_unlock(image_mutex);
+    image_unlock(ima);
   }
 }
 
@@ -520,7 +547,14 @@ void BKE_image_merge(Main *bmain, Image *dest, Image *source)
 {
   /* sanity check */
   if (dest && source && dest != source) {
-    BLI_mutex_lock(image_mutex);
+    ThreadRWMutex *dest_lock = image_lock_get(dest);
+    ThreadRWMutex *source_lock = image_lock_get(source);
+
+    /* Lock in address order, both images may share a lock. */
+    BLI_rw_mutex_lock(MIN2(dest_lock, source_lock), THREAD_LOCK_WRITE);
+    if (dest_lock != source_lock) {
+      BLI_rw_mutex_lock(MAX2(dest_lock, source_lock), THREAD_LOCK_WRITE);
+    }
     if (source->cache != NULL) {
       struct MovieCacheIter *iter;
       iter = IMB_moviecacheIter_new(source->cache);
@@ -532,7 +566,10 @@ void BKE_image_merge(Main *bmain, Image *dest, Image *source)
       }
       IMB_moviecacheIter_free(iter);
     }
-    BLI_mutex_unlock(image_mutex);
+    if (dest_lock != source_lock) {
+      BLI_rw_mutex_unlock(source_lock);
+    }
+    BLI_rw_mutex_unlock(dest_lock);
 
     BKE_id_free(bmain, source);
   }
@@ -1064,7 +1101,7 @@ static uintptr_t image_mem_size(Image *image)
     return 0;
   }
 
-  BLI_mutex_lock(image_mutex);
+  image_lock(image);
   if (image->cache != NULL) {
     struct MovieCacheIter *iter = IMB_moviecacheIter_new(image->cache);
 
@@ -1096,7 +1133,7 @@ static uintptr_t image_mem_size(Image *image)
     }
     IMB_moviecacheIter_free(iter);
   }
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(image);
 
   return size;
 }
@@ -1174,11 +1211,11 @@ static bool imagecache_check_free_anim(ImBuf *ibuf, void *UNUSED(userkey), void
 /* except_frame is weak, only works for seqs without offset... */
 void BKE_image_free_anim_ibufs(Image *ima, int except_frame)
 {
-  BLI_mutex_lock(image_mutex);
+  image_lock(ima);
   if (ima->cache != NULL) {
     IMB_moviecache_cleanup(ima->cache, imagecache_check_free_anim, &except_frame);
   }
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(ima);
 }
 
 void BKE_image_all_free_anim_ibufs(Main *bmain, int cfra)
@@ -3106,7 +3143,7 @@ void BKE_image_ensure_viewer_views(const RenderData *rd, Image *ima, ImageUser *
   }
 
   if (do_reset) {
-    BLI_mutex_lock(image_mutex);
+    image_lock(ima);
 
     image_free_cached_frames(ima);
     BKE_image_free_views(ima);
@@ -3114,7 +3151,7 @@ void BKE_image_ensure_viewer_views(const RenderData *rd, Image *ima, ImageUser *
     /* add new views */
     image_viewer_create_views(rd, ima);
 
-    BLI_mutex_unlock(image_mutex);
+    image_unlock(ima);
   }
 
   BLI_thread_unlock(LOCK_DRAW_IMAGE);
@@ -3374,7 +3411,7 @@ void BKE_image_signal(Main *bmain, Image *ima, ImageUser *iuser, int signal)
     return;
   }
 
-  BLI_mutex_lock(image_mutex);
+  image_lock(ima);
 
   switch (signal) {
     case IMA_SIGNAL_FREE:
@@ -3509,7 +3546,7 @@ void BKE_image_signal(Main *bmain, Image *ima, ImageUser *iuser, int signal)
       break;
   }
 
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(ima);
 
   /* don't use notifiers because they are not 100% sure to succeeded
    * this also makes sure all scenes are accounted for. */
@@ -3973,6 +4010,13 @@ static int imbuf_alpha_flags_for_image(Image *ima)
   return 0;
 }
 
+/* The render result of multilayer images is built from the first file of multiview images,
+ * the passes of the other files are never read when they are deferred. */
+static int image_multilayer_deferred_flag(Image *ima)
+{
+  return (ima->rr != NULL) ? IB_multilayer_deferred : 0;
+}
+
 /* the number of files will vary according to the stereo format */
 static int image_num_files(Image *ima)
 {
@@ -4014,6 +4058,7 @@ static ImBuf *load_sequence_single(
 
   flag = IB_rect | IB_multilayer | IB_metadata;
   flag |= imbuf_alpha_flags_for_image(ima);
+  flag |= image_multilayer_deferred_flag(ima);
 
   /* read ibuf */
   ibuf = IMB_loadiffname(name, flag, ima->colorspace_settings.name);
@@ -4309,6 +4354,7 @@ static ImBuf *load_image_single(Image *ima,
 
     flag = IB_rect | IB_multilayer;
     flag |= imbuf_alpha_flags_for_image(ima);
+    flag |= image_multilayer_deferred_flag(ima);
 
     imapf = BLI_findlink(&ima->packedfiles, view_id);
     if (imapf->packedfile) {
@@ -4324,6 +4370,7 @@ static ImBuf *load_image_single(Image *ima,
 
     flag = IB_rect | IB_multilayer | IB_metadata;
     flag |= imbuf_alpha_flags_for_image(ima);
+    flag |= image_multilayer_deferred_flag(ima);
 
     /* get the correct filepath */
     BKE_image_user_frame_calc(ima, iuser, cfra);
@@ -4801,11 +4848,15 @@ static ImBuf *image_get_cached_ibuf(Image *ima, ImageUser *iuser, int *r_entry,
       ibuf = image_get_cached_ibuf_for_index_entry(ima, index, entry);
 
       if ((ima->type == IMA_TYPE_IMAGE) && ibuf != NULL) {
+        /* Only write when the state changes, image_acquire_loaded_ibuf() relies on this when
+         * looking up tiles which are already tagged under a read lock. */
         ImageTile *tile = BKE_image_get_tile(ima, entry);
-        tile->ok = IMA_OK_LOADED;
+        if (tile->ok != IMA_OK_LOADED) {
+          tile->ok = IMA_OK_LOADED;
+        }
 
         /* iuser->ok is useless for tiled images because iuser->tile changes all the time. */
-        if (iuser != NULL) {
+        if (iuser != NULL && iuser->ok != 1) {
           iuser->ok = 1;
         }
       }
@@ -4967,6 +5018,50 @@ static ImBuf *image_acquire_ibuf(Image *ima, ImageUser *iuser, void **r_lock)
   return ibuf;
 }
 
+/* Check whether finding the cached buffer of a tiled image leaves the image and user unchanged,
+ * which is the case once the tile is tagged as loaded, see image_get_cached_ibuf(). */
+static bool image_tiled_ibuf_is_tagged(Image *ima, ImageUser *iuser)
+{
+  ImageTile *tile;
+
+  if (ima->type != IMA_TYPE_IMAGE) {
+    return true;
+  }
+
+  tile = BKE_image_get_tile_from_iuser(ima, iuser);
+  return tile != NULL && tile->ok == IMA_OK_LOADED && (iuser == NULL || iuser->ok == 1);
+}
+
+/* Get an image buffer which is already loaded, only locking the image for reading, so threads
+ * sampling the same images don't wait for each other. Limited to sources for which finding the
+ * cached buffer doesn't change the image, returns NULL when the buffer is to be loaded or the
+ * image is to be changed, which is left to BKE_image_acquire_ibuf() under the write lock. */
+static ImBuf *image_acquire_loaded_ibuf(Image *ima, ImageUser *iuser)
+{
+  ImBuf *ibuf = NULL;
+  bool tag_time = false;
+
+  if (!ELEM(ima->source, IMA_SRC_FILE, IMA_SRC_GENERATED, IMA_SRC_TILED)) {
+    return NULL;
+  }
+
+  BLI_rw_mutex_lock(image_lock_get(ima), THREAD_LOCK_READ);
+  if (ima->source != IMA_SRC_TILED || image_tiled_ibuf_is_tagged(ima, iuser)) {
+    ibuf = image_get_cached_ibuf(ima, iuser, NULL, NULL);
+    /* Only take the write lock when the time changed, at most once a second. */
+    tag_time = (ibuf != NULL && ima->lastused != (int)PIL_check_seconds_timer_i());
+  }
+  BLI_rw_mutex_unlock(image_lock_get(ima));
+
+  if (tag_time) {
+    image_lock(ima);
+    BKE_image_tag_time(ima);
+    image_unlock(ima);
+  }
+
+  return ibuf;
+}
+
 /* return image buffer for given image and user
  *
  * - will lock render result if image type is render result and lock is not NULL
@@ -4978,11 +5073,25 @@ ImBuf *BKE_image_acquire_ibuf(Image *ima, ImageUser *iuser, void **r_lock)
 {
   ImBuf *ibuf;
 
-  BLI_mutex_lock(image_mutex);
+  if (r_lock) {
+    *r_lock = NULL;
+  }
+
+  /* quick reject tests */
+  if (!image_quick_test(ima, iuser)) {
+    return NULL;
+  }
+
+  ibuf = image_acquire_loaded_ibuf(ima, iuser);
+  if (ibuf != NULL) {
+    return ibuf;
+  }
+
+  image_lock(ima);
 
   ibuf = image_acquire_ibuf(ima, iuser, r_lock);
 
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(ima);
 
   return ibuf;
 }
@@ -5000,10 +5109,9 @@ void BKE_image_release_ibuf(Image *ima, ImBuf *ibuf, void *lock)
     }
   }
 
+  /* Reference counting is atomic, a buffer reaching zero users is not in the cache anymore. */
   if (ibuf) {
-    BLI_mutex_lock(image_mutex);
     IMB_freeImBuf(ibuf);
-    BLI_mutex_unlock(image_mutex);
   }
 }
 
@@ -5017,15 +5125,7 @@ bool BKE_image_has_ibuf(Image *ima, ImageUser *iuser)
     return false;
   }
 
-  BLI_mutex_lock(image_mutex);
-
-  ibuf = image_get_cached_ibuf(ima, iuser, NULL, NULL);
-
-  if (!ibuf) {
-    ibuf = image_acquire_ibuf(ima, iuser, NULL);
-  }
-
-  BLI_mutex_unlock(image_mutex);
+  ibuf = BKE_image_acquire_ibuf(ima, iuser, NULL);
 
   IMB_freeImBuf(ibuf);
 
@@ -5045,27 +5145,28 @@ typedef struct ImagePoolItem {
 typedef struct ImagePool {
   ListBase image_buffers;
   BLI_mempool *memory_pool;
+  /* Pools are shared by threads, image buffers are acquired without holding this. */
+  ThreadMutex mutex;
 } ImagePool;
 
 ImagePool *BKE_image_pool_new(void)
 {
   ImagePool *pool = MEM_callocN(sizeof(ImagePool), "Image Pool");
   pool->memory_pool = BLI_mempool_create(sizeof(ImagePoolItem), 0, 128, BLI_MEMPOOL_NOP);
+  BLI_mutex_init(&pool->mutex);
 
   return pool;
 }
 
 void BKE_image_pool_free(ImagePool *pool)
 {
-  /* Use single lock to dereference all the image buffers. */
-  BLI_mutex_lock(image_mutex);
   for (ImagePoolItem *item = pool->image_buffers.first; item != NULL; item = item->next) {
     if (item->ibuf != NULL) {
       IMB_freeImBuf(item->ibuf);
     }
   }
-  BLI_mutex_unlock(image_mutex);
 
+  BLI_mutex_end(&pool->mutex);
   BLI_mempool_destroy(pool->memory_pool);
   MEM_freeN(pool);
 }
@@ -5109,17 +5210,23 @@ ImBuf *BKE_image_pool_acquire_ibuf(Image *ima, ImageUser *iuser, ImagePool *pool
     return ibuf;
   }
 
-  BLI_mutex_lock(image_mutex);
+  /* Don't hold the pool while loading, other threads may want other images. */
+  ImBuf *acquired_ibuf = BKE_image_acquire_ibuf(ima, iuser, NULL);
+
+  BLI_mutex_lock(&pool->mutex);
 
   ibuf = image_pool_find_item(pool, ima, entry, index, &found);
 
   /* will also create item even in cases image buffer failed to load,
    * prevents trying to load the same buggy file multiple times
    */
-  if (!found) {
+  if (found) {
+    IMB_freeImBuf(acquired_ibuf);
+  }
+  else {
     ImagePoolItem *item;
 
-    ibuf = image_acquire_ibuf(ima, iuser, NULL);
+    ibuf = acquired_ibuf;
 
     item = BLI_mempool_alloc(pool->memory_pool);
     item->image = ima;
@@ -5130,7 +5237,7 @@ ImBuf *BKE_image_pool_acquire_ibuf(Image *ima, ImageUser *iuser, ImagePool *pool
     BLI_addtail(&pool->image_buffers, item);
   }
 
-  BLI_mutex_unlock(image_mutex);
+  BLI_mutex_unlock(&pool->mutex);
 
   return ibuf;
 }
@@ -5533,7 +5640,7 @@ bool BKE_image_is_dirty_writable(Image *image, bool *r_is_writable)
   bool is_dirty = false;
   bool is_writable = false;
 
-  BLI_mutex_lock(image_mutex);
+  image_lock(image);
   if (image->cache != NULL) {
     struct MovieCacheIter *iter = IMB_moviecacheIter_new(image->cache);
 
@@ -5548,7 +5655,7 @@ bool BKE_image_is_dirty_writable(Image *image, bool *r_is_writable)
     }
     IMB_moviecacheIter_free(iter);
   }
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(image);
 
   if (r_is_writable) {
     *r_is_writable = is_writable;
@@ -5562,9 +5669,11 @@ bool BKE_image_is_dirty(Image *image)
   return BKE_image_is_dirty_writable(image, NULL);
 }
 
+/* Also called while painting, users of the pixels can check #ImBuf.changed_counter. */
 void BKE_image_mark_dirty(Image *UNUSED(image), ImBuf *ibuf)
 {
   ibuf->userflags |= IB_BITMAPDIRTY;
+  atomic_add_and_fetch_u(&ibuf->changed_counter, 1);
 }
 
 bool BKE_image_buffer_format_writable(ImBuf *ibuf)
@@ -5577,7 +5686,7 @@ bool BKE_image_buffer_format_writable(ImBuf *ibuf)
 
 void BKE_image_file_format_set(Image *image, int ftype, const ImbFormatOptions *options)
 {
-  BLI_mutex_lock(image_mutex);
+  image_lock(image);
   if (image->cache != NULL) {
     struct MovieCacheIter *iter = IMB_moviecacheIter_new(image->cache);
 
@@ -5589,14 +5698,14 @@ void BKE_image_file_format_set(Image *image, int ftype, const ImbFormatOptions *
     }
     IMB_moviecacheIter_free(iter);
   }
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(image);
 }
 
 bool BKE_image_has_loaded_ibuf(Image *image)
 {
   bool has_loaded_ibuf = false;
 
-  BLI_mutex_lock(image_mutex);
+  image_lock(image);
   if (image->cache != NULL) {
     struct MovieCacheIter *iter = IMB_moviecacheIter_new(image->cache);
 
@@ -5606,7 +5715,7 @@ bool BKE_image_has_loaded_ibuf(Image *image)
     }
     IMB_moviecacheIter_free(iter);
   }
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(image);
 
   return has_loaded_ibuf;
 }
@@ -5619,7 +5728,7 @@ ImBuf *BKE_image_get_ibuf_with_name(Image *image, const char *name)
 {
   ImBuf *ibuf = NULL;
 
-  BLI_mutex_lock(image_mutex);
+  image_lock(image);
   if (image->cache != NULL) {
     struct MovieCacheIter *iter = IMB_moviecacheIter_new(image->cache);
 
@@ -5634,7 +5743,7 @@ ImBuf *BKE_image_get_ibuf_with_name(Image *image, const char *name)
     }
     IMB_moviecacheIter_free(iter);
   }
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(image);
 
   return ibuf;
 }
@@ -5652,7 +5761,7 @@ ImBuf *BKE_image_get_first_ibuf(Image *image)
 {
   ImBuf *ibuf = NULL;
 
-  BLI_mutex_lock(image_mutex);
+  image_lock(image);
   if (image->cache != NULL) {
     struct MovieCacheIter *iter = IMB_moviecacheIter_new(image->cache);
 
@@ -5663,7 +5772,7 @@ ImBuf *BKE_image_get_first_ibuf(Image *image)
     }
     IMB_moviecacheIter_free(iter);
   }
-  BLI_mutex_unlock(image_mutex);
+  image_unlock(image);
 
   return ibuf;
 }
@@ -29,12 +29,15 @@
 #include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 
+#include "BLI_hash.h"
 #include "BLI_math_geom.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_bvhutils.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_mesh_runtime.h"
 #include "BKE_shrinkwrap.h"
 #include "BKE_subdiv_ccg.h"
@@ -70,6 +73,10 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
   runtime->shrinkwrap_data = NULL;
+  runtime->topology_maps = NULL;
+  runtime->deform_weights = NULL;
+  runtime->eval_shared = NULL;
+  runtime->topology_hash = 0;
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
@@ -87,6 +94,7 @@ void BKE_mesh_runtime_clear_cache(Mesh *mesh)
     BKE_id_free(NULL, mesh->runtime.mesh_eval);
     mesh->runtime.mesh_eval = NULL;
   }
+  BKE_mesh_runtime_clear_eval_shared(mesh);
   BKE_mesh_runtime_clear_geometry(mesh);
   BKE_mesh_batch_cache_free(mesh);
   BKE_mesh_runtime_clear_edit_data(mesh);
@@ -238,6 +246,9 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.bvh_cache = NULL;
   }
   MEM_SAFE_FREE(mesh->runtime.looptris.array);
+  BKE_mesh_runtime_clear_topology_maps(mesh);
+  BKE_mesh_runtime_clear_deform_weights(mesh);
+  mesh->runtime.topology_hash = 0;
   /* TODO(sergey): Does this really belong here? */
   if (mesh->runtime.subdiv_ccg != NULL) {
     BKE_subdiv_ccg_destroy(mesh->runtime.subdiv_ccg);
@@ -248,6 +259,688 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Mesh Runtime Topology Maps
+ *
+ * Vertex/edge/poly adjacency maps are expensive to build and only depend on topology,
+ * so they are computed lazily on first request and kept until the geometry is cleared
+ * (see #BKE_mesh_runtime_clear_geometry), which happens on any topology change.
+ * Deform-only modifier stacks keep the topology of their input, so the same maps can be
+ * used for every evaluation.
+ * \{ */
+
+typedef struct MeshTopologyMaps {
+  MeshElemMap *vert_poly_map;
+  int *vert_poly_mem;
+  MeshElemMap *vert_edge_map;
+  int *vert_edge_mem;
+  MeshElemMap *edge_poly_map;
+  int *edge_poly_mem;
+} MeshTopologyMaps;
+
+static ThreadRWMutex topology_maps_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/**
+ * Generic description of an adjacency map: every "slot" (a loop, or an edge end-point)
+ * contributes the item index it belongs to (its poly or edge) to the list of the key
+ * (vertex or edge) it references.
+ */
+typedef struct TopologyMapBuildData {
+  const MPoly *mpoly;
+  const MLoop *mloop;
+  const MEdge *medge;
+  /** Only used for loop based maps, the poly owning each loop. */
+  int *loop_to_poly;
+  bool key_is_edge;
+
+  MeshElemMap *map;
+} TopologyMapBuildData;
+
+BLI_INLINE void topology_map_slot_get(const TopologyMapBuildData *data,
+                                      const int slot,
+                                      int *r_key,
+                                      int *r_item)
+{
+  if (data->loop_to_poly != NULL) {
+    const MLoop *ml = &data->mloop[slot];
+    *r_key = (int)(data->key_is_edge ? ml->e : ml->v);
+    *r_item = data->loop_to_poly[slot];
+  }
+  else {
+    const MEdge *me = &data->medge[slot >> 1];
+    *r_key = (int)((slot & 1) ? me->v2 : me->v1);
+    *r_item = slot >> 1;
+  }
+}
+
+static void topology_map_loop_to_poly_cb(void *__restrict userdata,
+                                         const int poly_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  TopologyMapBuildData *data = userdata;
+  const MPoly *mp = &data->mpoly[poly_index];
+  for (int i = 0; i < mp->totloop; i++) {
+    data->loop_to_poly[mp->loopstart + i] = poly_index;
+  }
+}
+
+static void topology_map_count_cb(void *__restrict userdata,
+                                  const int slot,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  TopologyMapBuildData *data = userdata;
+  int key, item;
+  topology_map_slot_get(data, slot, &key, &item);
+  atomic_add_and_fetch_int32((int32_t *)&data->map[key].count, 1);
+}
+
+static void topology_map_fill_cb(void *__restrict userdata,
+                                 const int slot,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  TopologyMapBuildData *data = userdata;
+  int key, item;
+  topology_map_slot_get(data, slot, &key, &item);
+  MeshElemMap *map_ele = &data->map[key];
+  const int index = atomic_fetch_and_add_int32((int32_t *)&map_ele->count, 1);
+  map_ele->indices[index] = item;
+}
+
+/**
+ * Threads fill each list in arbitrary order, sort them so results match the
+ * single threaded map creation functions from `mesh_mapping.c`.
+ * Lists are short (vertex valence) so insertion sort is the best fit.
+ */
+static void topology_map_sort_cb(void *__restrict userdata,
+                                 const int key,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  TopologyMapBuildData *data = userdata;
+  MeshElemMap *map_ele = &data->map[key];
+  int *indices = map_ele->indices;
+  for (int i = 1; i < map_ele->count; i++) {
+    const int value = indices[i];
+    int j = i;
+    for (; j > 0 && indices[j - 1] > value; j--) {
+      indices[j] = indices[j - 1];
+    }
+    indices[j] = value;
+  }
+}
+
+static void mesh_topology_map_build(TopologyMapBuildData *data,
+                                    const int totkey,
+                                    const int totslot,
+                                    MeshElemMap **r_map,
+                                    int **r_mem)
+{
+  MeshElemMap *map = MEM_callocN(sizeof(*map) * (size_t)max_ii(totkey, 1), __func__);
+  int *indices = MEM_mallocN(sizeof(*indices) * (size_t)max_ii(totslot, 1), __func__);
+
+  data->map = map;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 4096;
+
+  BLI_task_parallel_range(0, totslot, data, topology_map_count_cb, &settings);
+
+  /* Assign indices mem, resetting 'count' for use as index in the fill pass. */
+  int *index_iter = indices;
+  for (int i = 0; i < totkey; i++) {
+    map[i].indices = index_iter;
+    index_iter += map[i].count;
+    map[i].count = 0;
+  }
+
+  BLI_task_parallel_range(0, totslot, data, topology_map_fill_cb, &settings);
+  BLI_task_parallel_range(0, totkey, data, topology_map_sort_cb, &settings);
+
+  *r_map = map;
+  *r_mem = indices;
+}
+
+static void mesh_topology_map_build_from_loops(const Mesh *mesh,
+                                               const bool key_is_edge,
+                                               MeshElemMap **r_map,
+                                               int **r_mem)
+{
+  int *loop_to_poly = MEM_mallocN(sizeof(*loop_to_poly) * (size_t)max_ii(mesh->totloop, 1),
+                                  __func__);
+  TopologyMapBuildData data = {
+      .mpoly = mesh->mpoly,
+      .mloop = mesh->mloop,
+      .loop_to_poly = loop_to_poly,
+      .key_is_edge = key_is_edge,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, mesh->totpoly, &data, topology_map_loop_to_poly_cb, &settings);
+
+  mesh_topology_map_build(
+      &data, key_is_edge ? mesh->totedge : mesh->totvert, mesh->totloop, r_map, r_mem);
+
+  MEM_freeN(loop_to_poly);
+}
+
+static void mesh_topology_map_build_from_edges(const Mesh *mesh,
+                                               MeshElemMap **r_map,
+                                               int **r_mem)
+{
+  TopologyMapBuildData data = {
+      .medge = mesh->medge,
+  };
+  mesh_topology_map_build(&data, mesh->totvert, mesh->totedge * 2, r_map, r_mem);
+}
+
+typedef enum eMeshTopologyMapType {
+  MESH_TOPOLOGY_MAP_VERT_POLY,
+  MESH_TOPOLOGY_MAP_VERT_EDGE,
+  MESH_TOPOLOGY_MAP_EDGE_POLY,
+} eMeshTopologyMapType;
+
+static MeshElemMap **mesh_topology_map_slot(MeshTopologyMaps *maps,
+                                            const eMeshTopologyMapType type,
+                                            int ***r_mem)
+{
+  switch (type) {
+    case MESH_TOPOLOGY_MAP_VERT_POLY:
+      *r_mem = &maps->vert_poly_mem;
+      return &maps->vert_poly_map;
+    case MESH_TOPOLOGY_MAP_VERT_EDGE:
+      *r_mem = &maps->vert_edge_mem;
+      return &maps->vert_edge_map;
+    case MESH_TOPOLOGY_MAP_EDGE_POLY:
+      *r_mem = &maps->edge_poly_mem;
+      return &maps->edge_poly_map;
+  }
+  BLI_assert(0);
+  return NULL;
+}
+
+static const MeshElemMap *mesh_topology_map_ensure(Mesh *mesh, const eMeshTopologyMapType type)
+{
+  MeshElemMap *map = NULL;
+  int **mem_p;
+
+  BLI_rw_mutex_lock(&topology_maps_lock, THREAD_LOCK_READ);
+  if (mesh->runtime.topology_maps != NULL) {
+    map = *mesh_topology_map_slot(mesh->runtime.topology_maps, type, &mem_p);
+  }
+  BLI_rw_mutex_unlock(&topology_maps_lock);
+
+  if (map != NULL) {
+    return map;
+  }
+
+  /* Build without holding the lock, the build itself is multi-threaded and the lock is shared
+   * by all meshes. */
+  MeshElemMap *map_new;
+  int *mem_new;
+  switch (type) {
+    case MESH_TOPOLOGY_MAP_VERT_POLY:
+      mesh_topology_map_build_from_loops(mesh, false, &map_new, &mem_new);
+      break;
+    case MESH_TOPOLOGY_MAP_VERT_EDGE:
+      mesh_topology_map_build_from_edges(mesh, &map_new, &mem_new);
+      break;
+    case MESH_TOPOLOGY_MAP_EDGE_POLY:
+    default:
+      mesh_topology_map_build_from_loops(mesh, true, &map_new, &mem_new);
+      break;
+  }
+
+  BLI_rw_mutex_lock(&topology_maps_lock, THREAD_LOCK_WRITE);
+  if (mesh->runtime.topology_maps == NULL) {
+    mesh->runtime.topology_maps = MEM_callocN(sizeof(MeshTopologyMaps), __func__);
+  }
+  MeshElemMap **map_p = mesh_topology_map_slot(mesh->runtime.topology_maps, type, &mem_p);
+  /* Another thread might have built the map at the same time, keep the first one. */
+  if (*map_p == NULL) {
+    *map_p = map_new;
+    *mem_p = mem_new;
+    map_new = NULL;
+    mem_new = NULL;
+  }
+  map = *map_p;
+  BLI_rw_mutex_unlock(&topology_maps_lock);
+
+  MEM_SAFE_FREE(map_new);
+  MEM_SAFE_FREE(mem_new);
+
+  return map;
+}
+
+/**
+ * Cached version of #BKE_mesh_vert_poly_map_create, owned by the mesh, must not be freed.
+ */
+const MeshElemMap *BKE_mesh_runtime_vert_poly_map_ensure(Mesh *mesh)
+{
+  return mesh_topology_map_ensure(mesh, MESH_TOPOLOGY_MAP_VERT_POLY);
+}
+
+/**
+ * Cached version of #BKE_mesh_vert_edge_map_create, owned by the mesh, must not be freed.
+ */
+const MeshElemMap *BKE_mesh_runtime_vert_edge_map_ensure(Mesh *mesh)
+{
+  return mesh_topology_map_ensure(mesh, MESH_TOPOLOGY_MAP_VERT_EDGE);
+}
+
+/**
+ * Cached version of #BKE_mesh_edge_poly_map_create, owned by the mesh, must not be freed.
+ */
+const MeshElemMap *BKE_mesh_runtime_edge_poly_map_ensure(Mesh *mesh)
+{
+  return mesh_topology_map_ensure(mesh, MESH_TOPOLOGY_MAP_EDGE_POLY);
+}
+
+void BKE_mesh_runtime_clear_topology_maps(Mesh *mesh)
+{
+  MeshTopologyMaps *maps = mesh->runtime.topology_maps;
+  if (maps == NULL) {
+    return;
+  }
+  MEM_SAFE_FREE(maps->vert_poly_map);
+  MEM_SAFE_FREE(maps->vert_poly_mem);
+  MEM_SAFE_FREE(maps->vert_edge_map);
+  MEM_SAFE_FREE(maps->vert_edge_mem);
+  MEM_SAFE_FREE(maps->edge_poly_map);
+  MEM_SAFE_FREE(maps->edge_poly_mem);
+  MEM_freeN(maps);
+  mesh->runtime.topology_maps = NULL;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Runtime Deform Weights
+ *
+ * Deformers which loop over the vertex group weights of every vertex on every frame
+ * (armature) use a compact copy of #Mesh.dvert, which avoids chasing the per-vertex
+ * #MDeformWeight allocations. Weights are edited on the original mesh, so the copy-on-write
+ * update resets the runtime of the evaluated mesh which owns this cache.
+ * \{ */
+
+static ThreadRWMutex deform_weights_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static void deform_weights_fill_cb(void *__restrict userdata,
+                                   const int vert_index,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshDeformWeights *weights = userdata;
+  const MDeformVert *dv = &weights->dvert[vert_index];
+  int *def_nr = weights->def_nr + weights->offsets[vert_index];
+  float *weight = weights->weights + weights->offsets[vert_index];
+
+  /* Zero weights are kept, a vertex in a bone group is not deformed by envelopes. */
+  for (int i = 0; i < dv->totweight; i++) {
+    def_nr[i] = (int)dv->dw[i].def_nr;
+    weight[i] = dv->dw[i].weight;
+  }
+}
+
+static MeshDeformWeights *mesh_deform_weights_build(const Mesh *mesh)
+{
+  MeshDeformWeights *weights = MEM_callocN(sizeof(*weights), __func__);
+  const MDeformVert *dvert = mesh->dvert;
+
+  weights->dvert = dvert;
+  weights->verts_len = mesh->totvert;
+  weights->offsets = MEM_mallocN(sizeof(*weights->offsets) * (size_t)(mesh->totvert + 1),
+                                 __func__);
+
+  int weights_len = 0;
+  for (int i = 0; i < mesh->totvert; i++) {
+    weights->offsets[i] = weights_len;
+    weights_len += dvert[i].totweight;
+  }
+  weights->offsets[mesh->totvert] = weights_len;
+
+  weights->def_nr = MEM_mallocN(sizeof(*weights->def_nr) * (size_t)max_ii(weights_len, 1),
+                                __func__);
+  weights->weights = MEM_mallocN(sizeof(*weights->weights) * (size_t)max_ii(weights_len, 1),
+                                 __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, mesh->totvert, weights, deform_weights_fill_cb, &settings);
+
+  return weights;
+}
+
+static void mesh_deform_weights_free(MeshDeformWeights *weights)
+{
+  MEM_freeN(weights->offsets);
+  MEM_freeN(weights->def_nr);
+  MEM_freeN(weights->weights);
+  MEM_freeN(weights);
+}
+
+BLI_INLINE bool mesh_deform_weights_is_valid(const Mesh *mesh, const MeshDeformWeights *weights)
+{
+  return weights != NULL && weights->dvert == mesh->dvert && weights->verts_len == mesh->totvert;
+}
+
+/**
+ * \return The compact weights of \a mesh, or NULL when it has no vertex groups.
+ * Owned by the mesh, must not be freed.
+ */
+const MeshDeformWeights *BKE_mesh_runtime_deform_weights_ensure(Mesh *mesh)
+{
+  if (mesh->dvert == NULL) {
+    return NULL;
+  }
+
+  MeshDeformWeights *weights;
+
+  BLI_rw_mutex_lock(&deform_weights_lock, THREAD_LOCK_READ);
+  weights = mesh->runtime.deform_weights;
+  BLI_rw_mutex_unlock(&deform_weights_lock);
+
+  if (mesh_deform_weights_is_valid(mesh, weights)) {
+    return weights;
+  }
+
+  /* Build without holding the lock, the build itself is multi-threaded and the lock is shared
+   * by all meshes. */
+  MeshDeformWeights *weights_new = mesh_deform_weights_build(mesh);
+
+  BLI_rw_mutex_lock(&deform_weights_lock, THREAD_LOCK_WRITE);
+  /* Another thread might have built the weights at the same time, keep the first one. */
+  if (!mesh_deform_weights_is_valid(mesh, mesh->runtime.deform_weights)) {
+    /* The #MDeformVert array was re-allocated, all users see the new array. */
+    BKE_mesh_runtime_clear_deform_weights(mesh);
+    mesh->runtime.deform_weights = weights_new;
+    weights_new = NULL;
+  }
+  weights = mesh->runtime.deform_weights;
+  BLI_rw_mutex_unlock(&deform_weights_lock);
+
+  if (weights_new != NULL) {
+    mesh_deform_weights_free(weights_new);
+  }
+
+  return weights;
+}
+
+void BKE_mesh_runtime_clear_deform_weights(Mesh *mesh)
+{
+  if (mesh->runtime.deform_weights != NULL) {
+    mesh_deform_weights_free(mesh->runtime.deform_weights);
+    mesh->runtime.deform_weights = NULL;
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Runtime Topology Caches Reuse
+ *
+ * Deform-only modifier stacks (armature, lattice, shape keys...) produce a new evaluated mesh
+ * on every frame which has the same topology as the previous one. Caches which only depend on
+ * topology can be moved from the previous evaluated mesh instead of being rebuilt.
+ * \{ */
+
+/**
+ * Hash of everything the topology caches depend on: the connectivity, but also the material
+ * indices and hidden state of elements, which are used when building draw index buffers.
+ */
+uint64_t BKE_mesh_runtime_topology_hash_ensure(Mesh *mesh)
+{
+  if (mesh->runtime.topology_hash != 0) {
+    return mesh->runtime.topology_hash;
+  }
+
+  uint64_t hash = BLI_HASH_FNV1A_64_INIT;
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mesh->totvert);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mesh->totedge);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mesh->totloop);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mesh->totpoly);
+
+  const MVert *mv = mesh->mvert;
+  for (int i = 0; i < mesh->totvert; i++, mv++) {
+    hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)(mv->flag & ME_HIDE));
+  }
+  const MEdge *med = mesh->medge;
+  for (int i = 0; i < mesh->totedge; i++, med++) {
+    hash = BLI_hash_fnv1a_64_step(hash, med->v1);
+    hash = BLI_hash_fnv1a_64_step(hash, med->v2);
+    hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)(med->flag & ME_HIDE));
+  }
+  const MLoop *ml = mesh->mloop;
+  for (int i = 0; i < mesh->totloop; i++, ml++) {
+    hash = BLI_hash_fnv1a_64_step(hash, ml->v);
+    hash = BLI_hash_fnv1a_64_step(hash, ml->e);
+  }
+  const MPoly *mp = mesh->mpoly;
+  for (int i = 0; i < mesh->totpoly; i++, mp++) {
+    hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mp->loopstart);
+    hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mp->totloop);
+    hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mp->mat_nr);
+    hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)(mp->flag & ME_HIDE));
+  }
+
+  /* Zero means "not computed". */
+  mesh->runtime.topology_hash = (hash != 0) ? hash : 1;
+  return mesh->runtime.topology_hash;
+}
+
+static bool mesh_has_ngons(const Mesh *mesh)
+{
+  const MPoly *mp = mesh->mpoly;
+  for (int i = 0; i < mesh->totpoly; i++, mp++) {
+    if (mp->totloop > 4) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Move caches which only depend on topology from \a mesh_src to \a mesh_dst
+ * when both meshes have the same topology.
+ *
+ * Triangulation of n-gons depends on vertex positions, so looptris and the draw cache are only
+ * moved for meshes made of triangles and quads. Position dependent draw buffers are discarded,
+ * the index buffers are kept.
+ *
+ * \note Both meshes are expected to be evaluated meshes owned by the caller,
+ * \a mesh_src is usually the result of the previous evaluation and is freed afterwards.
+ * Its topology hash must have been computed when it was created: arrays it references from
+ * the original mesh might have been freed by a copy-on-write update since then,
+ * so only its own runtime data is accessed here.
+ *
+ * \return true when caches were moved.
+ */
+bool BKE_mesh_runtime_topology_caches_transfer(Mesh *mesh_src, Mesh *mesh_dst)
+{
+  if (mesh_src == mesh_dst || mesh_src->edit_mesh != NULL || mesh_dst->edit_mesh != NULL) {
+    return false;
+  }
+  if (mesh_src->runtime.wrapper_type != ME_WRAPPER_TYPE_MDATA ||
+      mesh_dst->runtime.wrapper_type != ME_WRAPPER_TYPE_MDATA) {
+    return false;
+  }
+  if (mesh_src->totvert != mesh_dst->totvert || mesh_src->totedge != mesh_dst->totedge ||
+      mesh_src->totloop != mesh_dst->totloop || mesh_src->totpoly != mesh_dst->totpoly) {
+    return false;
+  }
+  if (mesh_src->runtime.topology_hash == 0 ||
+      mesh_src->runtime.topology_hash != BKE_mesh_runtime_topology_hash_ensure(mesh_dst)) {
+    return false;
+  }
+
+  Mesh_Runtime *runtime_src = &mesh_src->runtime;
+  Mesh_Runtime *runtime_dst = &mesh_dst->runtime;
+
+  if (runtime_dst->topology_maps == NULL) {
+    SWAP(struct MeshTopologyMaps *, runtime_src->topology_maps, runtime_dst->topology_maps);
+  }
+
+  if (mesh_has_ngons(mesh_dst)) {
+    return true;
+  }
+
+  if (runtime_dst->looptris.array == NULL && runtime_src->looptris.array != NULL) {
+    MEM_SAFE_FREE(runtime_dst->looptris.array_wip);
+    runtime_dst->looptris = runtime_src->looptris;
+    memset(&runtime_src->looptris, 0, sizeof(runtime_src->looptris));
+  }
+
+  if (runtime_dst->batch_cache == NULL && runtime_src->batch_cache != NULL) {
+    SWAP(void *, runtime_src->batch_cache, runtime_dst->batch_cache);
+    BKE_mesh_batch_cache_dirty_tag(mesh_dst, BKE_MESH_BATCH_DIRTY_DEFORM);
+  }
+
+  return true;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Runtime Shared Evaluation
+ *
+ * Objects using the same mesh with identical modifier stacks (linked duplicates) evaluate the
+ * stack once, the result is owned by the input mesh and referenced by all of them.
+ * Entries are reference counted, so results of stacks which are not used anymore (after
+ * tweaking the modifiers of one of the objects) are freed.
+ * \{ */
+
+static unsigned int eval_shared_id_next = 0;
+
+static void mesh_eval_shared_free(MeshEvalShared *shared)
+{
+  if (shared->mesh_final != NULL) {
+    BKE_mesh_eval_delete(shared->mesh_final);
+  }
+  if (shared->mesh_deform != NULL) {
+    BKE_mesh_eval_delete(shared->mesh_deform);
+  }
+  MEM_freeN(shared->key);
+  MEM_freeN(shared);
+}
+
+/**
+ * Find or add the shared result for the given key. When it is not built yet the caller
+ * evaluates the modifier stack and stores the result with #BKE_mesh_runtime_eval_shared_store.
+ */
+MeshEvalShared *BKE_mesh_runtime_eval_shared_acquire(Mesh *mesh,
+                                                     const void *key,
+                                                     const size_t key_len)
+{
+  BLI_mutex_lock(mesh->runtime.eval_mutex);
+  MeshEvalShared *shared;
+  for (shared = mesh->runtime.eval_shared; shared != NULL; shared = shared->next) {
+    if (shared->key_len == key_len && memcmp(shared->key, key, key_len) == 0) {
+      break;
+    }
+  }
+  if (shared == NULL) {
+    shared = MEM_callocN(sizeof(*shared), __func__);
+    shared->key = MEM_mallocN(key_len, __func__);
+    memcpy(shared->key, key, key_len);
+    shared->key_len = key_len;
+    shared->id = atomic_add_and_fetch_u(&eval_shared_id_next, 1);
+    shared->next = mesh->runtime.eval_shared;
+    mesh->runtime.eval_shared = shared;
+  }
+  shared->users++;
+  BLI_mutex_unlock(mesh->runtime.eval_mutex);
+  return shared;
+}
+
+/**
+ * \return true and the shared meshes when the result is built already.
+ */
+bool BKE_mesh_runtime_eval_shared_get(Mesh *mesh,
+                                      MeshEvalShared *shared,
+                                      Mesh **r_mesh_final,
+                                      Mesh **r_mesh_deform)
+{
+  BLI_mutex_lock(mesh->runtime.eval_mutex);
+  const bool is_built = shared->is_built;
+  *r_mesh_final = shared->mesh_final;
+  *r_mesh_deform = shared->mesh_deform;
+  BLI_mutex_unlock(mesh->runtime.eval_mutex);
+  return is_built;
+}
+
+/**
+ * Store the result evaluated by the caller. Users evaluate the stack without holding a lock,
+ * since evaluation uses the task scheduler, so another user may have stored its result first:
+ * then the given meshes are freed and the stored ones are returned instead.
+ */
+void BKE_mesh_runtime_eval_shared_store(Mesh *mesh,
+                                        MeshEvalShared *shared,
+                                        Mesh **r_mesh_final,
+                                        Mesh **r_mesh_deform)
+{
+  Mesh *mesh_final_free = NULL, *mesh_deform_free = NULL;
+
+  BLI_mutex_lock(mesh->runtime.eval_mutex);
+  if (!shared->is_built) {
+    shared->mesh_final = *r_mesh_final;
+    shared->mesh_deform = *r_mesh_deform;
+    shared->is_built = true;
+  }
+  else {
+    mesh_final_free = *r_mesh_final;
+    mesh_deform_free = *r_mesh_deform;
+    *r_mesh_final = shared->mesh_final;
+    *r_mesh_deform = shared->mesh_deform;
+  }
+  BLI_mutex_unlock(mesh->runtime.eval_mutex);
+
+  if (mesh_final_free != NULL) {
+    BKE_mesh_eval_delete(mesh_final_free);
+  }
+  if (mesh_deform_free != NULL) {
+    BKE_mesh_eval_delete(mesh_deform_free);
+  }
+}
+
+/**
+ * Release the shared result an object was using. Does nothing when the result is not found,
+ * it was freed with the rest of the runtime data of the mesh then.
+ */
+void BKE_mesh_runtime_eval_shared_release(Mesh *mesh, const unsigned int id)
+{
+  BLI_mutex_lock(mesh->runtime.eval_mutex);
+  MeshEvalShared **shared_p = &mesh->runtime.eval_shared;
+  MeshEvalShared *shared_free = NULL;
+  for (; *shared_p != NULL; shared_p = &(*shared_p)->next) {
+    MeshEvalShared *shared = *shared_p;
+    if (shared->id == id) {
+      if (--shared->users == 0) {
+        *shared_p = shared->next;
+        shared_free = shared;
+      }
+      break;
+    }
+  }
+  BLI_mutex_unlock(mesh->runtime.eval_mutex);
+  if (shared_free != NULL) {
+    mesh_eval_shared_free(shared_free);
+  }
+}
+
+void BKE_mesh_runtime_clear_eval_shared(Mesh *mesh)
+{
+  MeshEvalShared *shared = mesh->runtime.eval_shared;
+  while (shared != NULL) {
+    MeshEvalShared *shared_next = shared->next;
+    mesh_eval_shared_free(shared);
+    shared = shared_next;
+  }
+  mesh->runtime.eval_shared = NULL;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Mesh Batch Cache Callbacks
  * \{ */
@@ -306,6 +306,27 @@ static void *movieclip_convert_multilayer_add_layer(void *ctx_v, const char *UNU
   return ctx_v;
 }
 
+static bool movieclip_is_combined_pass(const char *pass_name, const char *chan_id)
+{
+  return STREQ(pass_name, RE_PASSNAME_COMBINED) || STREQ(chan_id, "RGBA") ||
+         STREQ(chan_id, "RGB");
+}
+
+/* Only read the first combined pass, the other passes are not decoded. */
+static bool movieclip_convert_multilayer_filter_pass(void *found_v,
+                                                     const char *UNUSED(layer_name),
+                                                     const char *pass_name,
+                                                     const char *chan_id,
+                                                     const char *UNUSED(view_name))
+{
+  bool *found = found_v;
+  if (*found) {
+    return false;
+  }
+  *found = movieclip_is_combined_pass(pass_name, chan_id);
+  return *found;
+}
+
 static void movieclip_convert_multilayer_add_pass(void *UNUSED(layer),
                                                   void *ctx_v,
                                                   const char *pass_name,
@@ -322,7 +343,7 @@ static void movieclip_convert_multilayer_add_pass(void *UNUSED(layer),
     MEM_freeN(rect);
     return;
   }
-  if (STREQ(pass_name, RE_PASSNAME_COMBINED) || STREQ(chan_id, "RGBA") || STREQ(chan_id, "RGB")) {
+  if (movieclip_is_combined_pass(pass_name, chan_id)) {
     ctx->combined_pass = rect;
     ctx->num_combined_channels = num_channels;
   }
@@ -346,6 +367,9 @@ void BKE_movieclip_convert_multilayer_ibuf(struct ImBuf *ibuf)
   if (ibuf->ftype != IMB_FTYPE_OPENEXR || ibuf->userdata == NULL) {
     return;
   }
+  bool found = false;
+  IMB_exr_read_passes(ibuf->userdata, movieclip_convert_multilayer_filter_pass, &found);
+
   MultilayerConvertContext ctx;
   ctx.combined_pass = NULL;
   ctx.num_combined_channels = 0;
@@ -399,7 +423,8 @@ static ImBuf *movieclip_load_sequence_file(MovieClip *clip,
     colorspace = clip->colorspace_settings.name;
   }
 
-  loadflag = IB_rect | IB_multilayer | IB_alphamode_detect | IB_metadata;
+  loadflag = IB_rect | IB_multilayer | IB_multilayer_deferred | IB_alphamode_detect |
+             IB_metadata;
 
   /* read ibuf */
   ibuf = IMB_loadiffname(name, loadflag, colorspace);
@@ -4162,6 +4162,7 @@ void BKE_object_runtime_reset_on_copy(Object *object, const int UNUSED(flag))
   Object_Runtime *runtime = &object->runtime;
   runtime->data_eval = NULL;
   runtime->mesh_deform_eval = NULL;
+  runtime->eval_shared_id = 0;
   runtime->curve_cache = NULL;
 }
 
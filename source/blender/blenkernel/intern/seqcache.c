@@ -20,10 +20,15 @@
  * \ingroup bke
  */
 
+#include <ctype.h>
 #include <memory.h>
 #include <stddef.h>
 #include <time.h>
 
+#ifdef __linux__
+#  include <fcntl.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_scene_types.h"
@@ -49,6 +54,14 @@
 #include "BKE_scene.h"
 #include "BKE_sequencer.h"
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
+
 /**
  * Sequencer Cache Design Notes
  * ============================
@@ -81,7 +94,13 @@
  * For each cached non-temp image, image data and supplementary info are written to HDD.
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
- * Zlib compression with user definable level can be used to compress image data(per image)
+ * Image data is compressed per image, codec depends on compression level set in user
+ * preferences: none stores raw pixels which are read directly into the image buffer, low uses
+ * LZO in independent blocks and high uses zlib. Codec is stored in header entry.
+ * Headers of accessed files are kept in memory, so lookups of frames which are not cached don't
+ * touch the disk. Files are indexed by path, directories are only scanned when creating cache
+ * or when files were removed by other means.
+ * When reading image, OS is hinted to read following images of the file ahead.
  * Images are written in order in which they are rendered.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
@@ -94,11 +113,28 @@
 /* <cache type>-<resolution X>x<resolution Y>-<rendersize>%(<view_id>)-<frame no>.dcf */
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
-#define DCACHE_CURRENT_VERSION 1
+#define DCACHE_CURRENT_VERSION 2
+/* Suffix of files which are being written, see #seq_disk_cache_write_file. */
+#define DCACHE_TEMP_SUFFIX ".tmp"
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in imb intern */
+/* Size of uncompressed data of a block for DCACHE_CODEC_LZO. */
+#define DCACHE_LZO_BLOCK_SIZE (1 << 20)
+#define DCACHE_LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+/* Number of images following the read one to hint the OS to read ahead. */
+#define DCACHE_READ_AHEAD 2
+
+/* Codec of image data, stored in the header entry since version 2 of the cache. */
+enum {
+  DCACHE_CODEC_ZLIB = 0,
+  DCACHE_CODEC_NONE = 1,
+  /* Blocks of DCACHE_LZO_BLOCK_SIZE raw bytes, each prefixed by its compressed size as
+   * uint32_t. Blocks which can't be compressed are stored raw. */
+  DCACHE_CODEC_LZO = 2,
+};
 
 typedef struct DiskCacheHeaderEntry {
   unsigned char encoding;
+  unsigned char codec;
   uint64_t frameno;
   uint64_t size_compressed;
   uint64_t size_raw;
@@ -114,6 +150,8 @@ typedef struct SeqDiskCache {
   Main *bmain;
   int64_t timestamp;
   ListBase files;
+  /* Files by path. */
+  GHash *files_hash;
   ThreadMutex read_write_mutex;
   size_t size_total;
 } SeqDiskCache;
@@ -124,6 +162,8 @@ typedef struct DiskCacheFile {
   char dir[FILE_MAXDIR];
   char file[FILE_MAX];
   BLI_stat_t fstat;
+  /* Header read from file, loaded on first access. */
+  DiskCacheHeader *header;
   int cache_type;
   int rectx;
   int recty;
@@ -138,7 +178,8 @@ typedef struct SeqCache {
   ThreadMutex iterator_mutex;
   struct BLI_mempool *keys_pool;
   struct BLI_mempool *items_pool;
-  struct SeqCacheKey *last_key;
+  /* Last key put by each task, tasks link their keys separately. */
+  struct SeqCacheKey *last_key[SEQ_TASK_MAX];
   size_t memory_used;
   SeqDiskCache *disk_cache;
 } SeqCache;
@@ -172,6 +213,22 @@ static char *seq_disk_cache_base_dir(void)
   return U.sequencer_disk_cache_dir;
 }
 
+static int seq_disk_cache_codec(void)
+{
+  switch (U.sequencer_disk_cache_compression) {
+    case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
+      return DCACHE_CODEC_NONE;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
+#ifdef WITH_LZO
+      return DCACHE_CODEC_LZO;
+#else
+      return DCACHE_CODEC_ZLIB;
+#endif
+  }
+
+  return DCACHE_CODEC_ZLIB;
+}
+
 static int seq_disk_cache_compression_level(void)
 {
   switch (U.sequencer_disk_cache_compression) {
@@ -217,9 +274,30 @@ static DiskCacheFile *seq_disk_cache_add_file_to_list(SeqDiskCache *disk_cache,
          &cache_file->start_frame);
   cache_file->start_frame *= DCACHE_IMAGES_PER_FILE;
   BLI_addtail(&disk_cache->files, cache_file);
+  BLI_ghash_insert(disk_cache->files_hash, cache_file->path, cache_file);
   return cache_file;
 }
 
+static void seq_disk_cache_free_file(DiskCacheFile *cache_file)
+{
+  if (cache_file->header) {
+    MEM_freeN(cache_file->header);
+  }
+  MEM_freeN(cache_file);
+}
+
+static void seq_disk_cache_free_files(SeqDiskCache *disk_cache)
+{
+  BLI_ghash_clear(disk_cache->files_hash, NULL, NULL);
+  DiskCacheFile *next_file;
+  for (DiskCacheFile *cache_file = disk_cache->files.first; cache_file; cache_file = next_file) {
+    next_file = cache_file->next;
+    seq_disk_cache_free_file(cache_file);
+  }
+  BLI_listbase_clear(&disk_cache->files);
+  disk_cache->size_total = 0;
+}
+
 static void seq_disk_cache_get_files(SeqDiskCache *disk_cache, char *path)
 {
   struct direntry *filelist, *fl;
@@ -279,8 +357,9 @@ static void seq_disk_cache_delete_file(SeqDiskCache *disk_cache, DiskCacheFile *
 {
   disk_cache->size_total -= file->fstat.st_size;
   BLI_delete(file->path, false, false);
+  BLI_ghash_remove(disk_cache->files_hash, file->path, NULL, NULL);
   BLI_remlink(&disk_cache->files, file);
-  MEM_freeN(file);
+  seq_disk_cache_free_file(file);
 }
 
 static bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache)
@@ -297,7 +376,7 @@ static bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache)
 
     if (BLI_exists(oldest_file->path) == 0) {
       /* File may have been manually deleted during runtime, do re-scan. */
-      BLI_freelistN(&disk_cache->files);
+      seq_disk_cache_free_files(disk_cache);
       seq_disk_cache_get_files(disk_cache, seq_disk_cache_base_dir());
       continue;
     }
@@ -309,17 +388,24 @@ static bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache)
   return true;
 }
 
-static DiskCacheFile *seq_disk_cache_get_file_entry_by_path(SeqDiskCache *disk_cache, char *path)
+/* Paths are compared case insensitively, like the file systems of some platforms do. */
+static unsigned int seq_disk_cache_path_hash(const void *key)
 {
-  DiskCacheFile *cache_file = disk_cache->files.first;
-
-  for (; cache_file; cache_file = cache_file->next) {
-    if (BLI_strcasecmp(cache_file->path, path) == 0) {
-      return cache_file;
-    }
+  unsigned int hash = 5381;
+  for (const unsigned char *c = key; *c; c++) {
+    hash = hash * 33 + (unsigned int)tolower(*c);
   }
+  return hash;
+}
 
-  return NULL;
+static bool seq_disk_cache_path_cmp(const void *a, const void *b)
+{
+  return BLI_strcasecmp(a, b) != 0;
+}
+
+static DiskCacheFile *seq_disk_cache_get_file_entry_by_path(SeqDiskCache *disk_cache, char *path)
+{
+  return BLI_ghash_lookup(disk_cache->files_hash, path);
 }
 
 /* Update file size and timestamp. */
@@ -474,31 +560,189 @@ static void seq_disk_cache_invalidate(Scene *scene,
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
+static void *seq_disk_cache_imbuf_data(ImBuf *ibuf)
+{
+  return ibuf->rect ? (void *)ibuf->rect : (void *)ibuf->rect_float;
+}
+
+static size_t seq_disk_cache_write_raw(void *data, FILE *file, DiskCacheHeaderEntry *header_entry)
+{
+  fseek(file, header_entry->offset, 0);
+  if (fwrite(data, 1, header_entry->size_raw, file) != header_entry->size_raw) {
+    return 0;
+  }
+  return header_entry->size_raw;
+}
+
+static size_t seq_disk_cache_read_raw(void *data, FILE *file, DiskCacheHeaderEntry *header_entry)
+{
+  if (header_entry->size_compressed != header_entry->size_raw) {
+    return 0;
+  }
+  fseek(file, header_entry->offset, 0);
+  return fread(data, 1, header_entry->size_raw, file);
+}
+
+#ifdef WITH_LZO
+static size_t seq_disk_cache_write_lzo(void *data, FILE *file, DiskCacheHeaderEntry *header_entry)
+{
+  unsigned char *in = data;
+  unsigned char *out = MEM_mallocN(DCACHE_LZO_OUT_LEN(DCACHE_LZO_BLOCK_SIZE),
+                                   "seq_disk_cache_lzo_buffer");
+  void *wrkmem = MEM_mallocN(LZO1X_MEM_COMPRESS, "seq_disk_cache_lzo_wrkmem");
+  size_t bytes_written = 0;
+
+  fseek(file, header_entry->offset, 0);
+
+  for (uint64_t in_offset = 0; in_offset < header_entry->size_raw;
+       in_offset += DCACHE_LZO_BLOCK_SIZE) {
+    const lzo_uint in_len = (lzo_uint)MIN2((uint64_t)DCACHE_LZO_BLOCK_SIZE,
+                                           header_entry->size_raw - in_offset);
+    lzo_uint out_len = DCACHE_LZO_OUT_LEN(DCACHE_LZO_BLOCK_SIZE);
+    const unsigned char *block = out;
+
+    int r = lzo1x_1_compress(in + in_offset, in_len, out, &out_len, wrkmem);
+    if (r != LZO_E_OK || out_len >= in_len) {
+      /* Store raw, reader recognizes this by the size. */
+      block = in + in_offset;
+      out_len = in_len;
+    }
+
+    uint32_t block_len = (uint32_t)out_len;
+    if (fwrite(&block_len, sizeof(block_len), 1, file) != 1 ||
+        fwrite(block, 1, out_len, file) != out_len) {
+      bytes_written = 0;
+      break;
+    }
+    bytes_written += sizeof(block_len) + out_len;
+  }
+
+  MEM_freeN(wrkmem);
+  MEM_freeN(out);
+  return bytes_written;
+}
+
+static size_t seq_disk_cache_read_lzo(void *data, FILE *file, DiskCacheHeaderEntry *header_entry)
+{
+  unsigned char *out = data;
+  unsigned char *in = MEM_mallocN(DCACHE_LZO_OUT_LEN(DCACHE_LZO_BLOCK_SIZE),
+                                  "seq_disk_cache_lzo_buffer");
+  const bool switch_endian = (ENDIAN_ORDER == B_ENDIAN) && header_entry->encoding == 0;
+  size_t bytes_read = 0;
+
+  fseek(file, header_entry->offset, 0);
+
+  for (uint64_t out_offset = 0; out_offset < header_entry->size_raw;
+       out_offset += DCACHE_LZO_BLOCK_SIZE) {
+    const lzo_uint out_len = (lzo_uint)MIN2((uint64_t)DCACHE_LZO_BLOCK_SIZE,
+                                            header_entry->size_raw - out_offset);
+    uint32_t block_len;
+
+    if (fread(&block_len, sizeof(block_len), 1, file) != 1) {
+      break;
+    }
+    if (switch_endian) {
+      BLI_endian_switch_uint32(&block_len);
+    }
+    if (block_len > out_len) {
+      break;
+    }
+    if (block_len == out_len) {
+      /* Raw block. */
+      if (fread(out + out_offset, 1, out_len, file) != out_len) {
+        break;
+      }
+    }
+    else {
+      lzo_uint decompressed_len = out_len;
+      if (fread(in, 1, block_len, file) != block_len ||
+          lzo1x_decompress_safe(in, block_len, out + out_offset, &decompressed_len, NULL) !=
+              LZO_E_OK ||
+          decompressed_len != out_len) {
+        break;
+      }
+    }
+    bytes_read += out_len;
+  }
+
+  MEM_freeN(in);
+  return bytes_read;
+}
+#endif
+
 static size_t deflate_imbuf_to_file(ImBuf *ibuf,
                                     FILE *file,
                                     int level,
                                     DiskCacheHeaderEntry *header_entry)
 {
-  if (ibuf->rect) {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset, level);
-  }
-  else {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect_float, header_entry->size_raw, file, header_entry->offset, level);
+  void *data = seq_disk_cache_imbuf_data(ibuf);
+
+  switch (header_entry->codec) {
+    case DCACHE_CODEC_NONE:
+      return seq_disk_cache_write_raw(data, file, header_entry);
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO:
+      return seq_disk_cache_write_lzo(data, file, header_entry);
+#endif
+    case DCACHE_CODEC_ZLIB:
+      return BLI_gzip_mem_to_file_at_pos(
+          data, header_entry->size_raw, file, header_entry->offset, level);
   }
+
+  return 0;
 }
 
 static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
 {
-  if (ibuf->rect) {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset);
+  void *data = seq_disk_cache_imbuf_data(ibuf);
+
+  switch (header_entry->codec) {
+    case DCACHE_CODEC_NONE:
+      return seq_disk_cache_read_raw(data, file, header_entry);
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO:
+      return seq_disk_cache_read_lzo(data, file, header_entry);
+#endif
+    case DCACHE_CODEC_ZLIB:
+      return BLI_ungzip_file_to_mem_at_pos(
+          data, header_entry->size_raw, file, header_entry->offset);
+  }
+
+  /* Codec not available in this build. */
+  return 0;
+}
+
+/* Hint the OS to read images following \a entry_index into page cache, so they are read from
+ * memory when playback gets to them. */
+static void seq_disk_cache_read_ahead(FILE *file, DiskCacheHeader *header, int entry_index)
+{
+#ifdef __linux__
+  const DiskCacheHeaderEntry *first = NULL, *last = NULL;
+  const uint64_t frameno = header->entry[entry_index].frameno;
+
+  for (int i = 0; i < DCACHE_IMAGES_PER_FILE; i++) {
+    const DiskCacheHeaderEntry *entry = &header->entry[i];
+    if (entry->size_compressed == 0 || entry->frameno <= frameno ||
+        entry->frameno > frameno + DCACHE_READ_AHEAD) {
+      continue;
+    }
+    if (first == NULL || entry->offset < first->offset) {
+      first = entry;
+    }
+    if (last == NULL || entry->offset > last->offset) {
+      last = entry;
+    }
   }
-  else {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect_float, header_entry->size_raw, file, header_entry->offset);
+
+  if (first != NULL) {
+    posix_fadvise(fileno(file),
+                  (off_t)first->offset,
+                  (off_t)(last->offset + last->size_compressed - first->offset),
+                  POSIX_FADV_WILLNEED);
   }
+#else
+  UNUSED_VARS(file, header, entry_index);
+#endif
 }
 
 static void seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
@@ -554,6 +798,7 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
     header->entry[i].encoding = 0;
   }
 
+  header->entry[i].codec = seq_disk_cache_codec();
   header->entry[i].offset = offset;
   header->entry[i].frameno = key->nfra;
 
@@ -584,59 +829,114 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, DiskCacheHeader *he
   return -1;
 }
 
+/* Get header of the file, read it on first access. */
+static DiskCacheHeader *seq_disk_cache_file_header(DiskCacheFile *cache_file, FILE *file)
+{
+  if (cache_file->header == NULL) {
+    cache_file->header = MEM_callocN(sizeof(DiskCacheHeader), "DiskCacheHeader");
+    seq_disk_cache_read_header(file, cache_file->header);
+  }
+  return cache_file->header;
+}
+
+static bool seq_disk_cache_header_is_full(const DiskCacheHeader *header)
+{
+  return header->entry[DCACHE_IMAGES_PER_FILE - 1].size_compressed != 0;
+}
+
 static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
 {
   char path[FILE_MAX];
+  char path_temp[FILE_MAX];
 
   seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
-  BLI_make_existing_file(path);
+  DiskCacheFile *cache_file = seq_disk_cache_get_file_entry_by_path(disk_cache, path);
 
-  FILE *file = BLI_fopen(path, "rb+");
-  if (!file) {
-    file = BLI_fopen(path, "wb+");
+  /* Images are added to existing files in place, past the data of the other images. The header
+   * is written last, so readers don't see the entry before its data. */
+  FILE *file = cache_file ? BLI_fopen(path, "rb+") : NULL;
+  DiskCacheHeader *header = NULL;
+  if (file) {
+    header = seq_disk_cache_file_header(cache_file, file);
+    if (seq_disk_cache_header_is_full(header)) {
+      fclose(file);
+      file = NULL;
+    }
+  }
+
+  /* Other files are written under a temporary name and renamed when complete, so readers of the
+   * file which is replaced never see it truncated or partially written. */
+  const bool is_new_file = (file == NULL);
+  if (is_new_file) {
+    BLI_snprintf(path_temp, sizeof(path_temp), "%s%s", path, DCACHE_TEMP_SUFFIX);
+    BLI_make_existing_file(path_temp);
+    file = BLI_fopen(path_temp, "wb+");
     if (!file) {
       return false;
     }
-    seq_disk_cache_add_file_to_list(disk_cache, path);
+    header = MEM_callocN(sizeof(DiskCacheHeader), "DiskCacheHeader");
   }
 
-  DiskCacheHeader header;
-  memset(&header, 0, sizeof(header));
-  seq_disk_cache_read_header(file, &header);
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
+  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, header);
   size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+      ibuf, file, seq_disk_cache_compression_level(), &header->entry[entry_index]);
 
-  if (bytes_written != 0) {
+  bool success = (bytes_written != 0);
+  if (success) {
     /* Last step is writing header, as image data can be overwritten,
      * but missing data would cause problems.
      */
-    header.entry[entry_index].size_compressed = bytes_written;
-    seq_disk_cache_write_header(file, &header);
-    seq_disk_cache_update_file(disk_cache, path);
-    fclose(file);
+    header->entry[entry_index].size_compressed = bytes_written;
+    success = (seq_disk_cache_write_header(file, header) == 1);
+  }
+  success = (fclose(file) == 0) && success;
 
-    return true;
+  if (is_new_file) {
+    if (!success || BLI_rename(path_temp, path) != 0) {
+      BLI_delete(path_temp, false, false);
+      MEM_freeN(header);
+      return false;
+    }
+    if (cache_file == NULL) {
+      cache_file = seq_disk_cache_add_file_to_list(disk_cache, path);
+    }
+    MEM_SAFE_FREE(cache_file->header);
+    cache_file->header = header;
+  }
+  else if (!success) {
+    /* Header in memory may not match file anymore. */
+    MEM_SAFE_FREE(cache_file->header);
+    return false;
   }
 
-  return false;
+  seq_disk_cache_update_file(disk_cache, path);
+  return true;
 }
 
 static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
 {
   char path[FILE_MAX];
-  DiskCacheHeader header;
 
   seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
-  BLI_make_existing_file(path);
+
+  /* All cache files are indexed, so files which are not known don't have to be opened. */
+  DiskCacheFile *cache_file = seq_disk_cache_get_file_entry_by_path(disk_cache, path);
+  if (cache_file == NULL) {
+    return NULL;
+  }
+
+  /* Item not found. */
+  if (cache_file->header != NULL && seq_disk_cache_get_header_entry(key, cache_file->header) < 0) {
+    return NULL;
+  }
 
   FILE *file = BLI_fopen(path, "rb");
   if (!file) {
     return NULL;
   }
 
-  seq_disk_cache_read_header(file, &header);
-  int entry_index = seq_disk_cache_get_header_entry(key, &header);
+  DiskCacheHeader *header = seq_disk_cache_file_header(cache_file, file);
+  int entry_index = seq_disk_cache_get_header_entry(key, header);
 
   /* Item not found. */
   if (entry_index < 0) {
@@ -649,22 +949,23 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
   uint64_t size_float = (uint64_t)key->context.rectx * key->context.recty * 16;
   size_t expected_size;
 
-  if (header.entry[entry_index].size_raw == size_char) {
+  if (header->entry[entry_index].size_raw == size_char) {
     expected_size = size_char;
     ibuf = IMB_allocImBuf(key->context.rectx, key->context.recty, 32, IB_rect);
-    IMB_colormanagement_assign_rect_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_rect_colorspace(ibuf, header->entry[entry_index].colorspace_name);
   }
-  else if (header.entry[entry_index].size_raw == size_float) {
+  else if (header->entry[entry_index].size_raw == size_float) {
     expected_size = size_float;
     ibuf = IMB_allocImBuf(key->context.rectx, key->context.recty, 32, IB_rectfloat);
-    IMB_colormanagement_assign_float_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_float_colorspace(ibuf, header->entry[entry_index].colorspace_name);
   }
   else {
     fclose(file);
     return NULL;
   }
 
-  size_t bytes_read = inflate_file_to_imbuf(ibuf, file, &header.entry[entry_index]);
+  seq_disk_cache_read_ahead(file, header, entry_index);
+  size_t bytes_read = inflate_file_to_imbuf(ibuf, file, &header->entry[entry_index]);
 
   /* Sanity check. */
   if (bytes_read != expected_size) {
@@ -672,10 +973,12 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
     IMB_freeImBuf(ibuf);
     return NULL;
   }
-  BLI_file_touch(path);
-  seq_disk_cache_update_file(disk_cache, path);
   fclose(file);
 
+  /* Size of the file didn't change, only timestamp has to be updated. */
+  BLI_file_touch(path);
+  cache_file->fstat.st_mtime = time(NULL);
+
   return ibuf;
 }
 
@@ -683,6 +986,10 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
 #undef DCACHE_IMAGES_PER_FILE
 #undef COLORSPACE_NAME_MAX
 #undef DCACHE_CURRENT_VERSION
+#undef DCACHE_TEMP_SUFFIX
+#undef DCACHE_LZO_BLOCK_SIZE
+#undef DCACHE_LZO_OUT_LEN
+#undef DCACHE_READ_AHEAD
 
 static bool seq_cmp_render_data(const SeqRenderData *a, const SeqRenderData *b)
 {
@@ -798,11 +1105,16 @@ static void seq_cache_put(SeqCache *cache, SeqCacheKey *key, ImBuf *ibuf)
 
   if (BLI_ghash_reinsert(cache->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
     IMB_refImBuf(ibuf);
-    cache->last_key = key;
+    cache->last_key[key->task_id] = key;
     cache->memory_used += IMB_get_size_in_memory(ibuf);
   }
 }
 
+static void seq_cache_reset_linking(SeqCache *cache)
+{
+  memset(cache->last_key, 0, sizeof(cache->last_key));
+}
+
 static ImBuf *seq_cache_get(SeqCache *cache, SeqCacheKey *key)
 {
   SeqCacheItem *item = BLI_ghash_lookup(cache->hash, key);
@@ -1047,6 +1359,8 @@ static void seq_disk_cache_create(Main *bmain, Scene *scene)
 
   cache->disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
   cache->disk_cache->bmain = bmain;
+  cache->disk_cache->files_hash = BLI_ghash_new(
+      seq_disk_cache_path_hash, seq_disk_cache_path_cmp, "SeqDiskCache files");
   BLI_mutex_init(&cache->disk_cache->read_write_mutex);
   seq_disk_cache_handle_versioning(cache->disk_cache);
   seq_disk_cache_get_files(cache->disk_cache, seq_disk_cache_base_dir());
@@ -1062,7 +1376,7 @@ static void seq_cache_create(Main *bmain, Scene *scene)
     cache->keys_pool = BLI_mempool_create(sizeof(SeqCacheKey), 0, 64, BLI_MEMPOOL_NOP);
     cache->items_pool = BLI_mempool_create(sizeof(SeqCacheItem), 0, 64, BLI_MEMPOOL_NOP);
     cache->hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
-    cache->last_key = NULL;
+    seq_cache_reset_linking(cache);
     cache->bmain = bmain;
     BLI_mutex_init(&cache->iterator_mutex);
     scene->ed->cache = cache;
@@ -1112,7 +1426,8 @@ void BKE_sequencer_cache_destruct(Scene *scene)
   BLI_mutex_end(&cache->iterator_mutex);
 
   if (cache->disk_cache != NULL) {
-    BLI_freelistN(&cache->disk_cache->files);
+    seq_disk_cache_free_files(cache->disk_cache);
+    BLI_ghash_free(cache->disk_cache->files_hash, NULL, NULL);
     BLI_mutex_end(&cache->disk_cache->read_write_mutex);
     MEM_freeN(cache->disk_cache);
   }
@@ -1146,7 +1461,7 @@ void BKE_sequencer_cache_cleanup(Scene *scene)
     BLI_ghashIterator_step(&gh_iter);
     BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
   }
-  cache->last_key = NULL;
+  seq_cache_reset_linking(cache);
   seq_cache_unlock(scene);
 }
 
@@ -1210,7 +1525,7 @@ void BKE_sequencer_cache_cleanup_sequence(Scene *scene,
       BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
     }
   }
-  cache->last_key = NULL;
+  seq_cache_reset_linking(cache);
   seq_cache_unlock(scene);
 }
 
@@ -1305,8 +1620,8 @@ bool BKE_sequencer_cache_put_if_possible(const SeqRenderData *context,
     return true;
   }
   else {
-    seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key);
-    scene->ed->cache->last_key = NULL;
+    seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key[context->task_id]);
+    scene->ed->cache->last_key[context->task_id] = NULL;
     return false;
   }
 }
@@ -1378,27 +1693,27 @@ void BKE_sequencer_cache_put(const SeqRenderData *context,
   /* Item stored for later use */
   if (flag & type) {
     key->is_temp_cache = false;
-    key->link_prev = cache->last_key;
+    key->link_prev = cache->last_key[key->task_id];
   }
 
-  SeqCacheKey *temp_last_key = cache->last_key;
+  SeqCacheKey *temp_last_key = cache->last_key[key->task_id];
   seq_cache_put(cache, key, i);
 
   /* Restore pointer to previous item as this one will be freed when stack is rendered. */
   if (key->is_temp_cache) {
-    cache->last_key = temp_last_key;
+    cache->last_key[key->task_id] = temp_last_key;
   }
 
   /* Set last_key's reference to this key so we can look up chain backwards.
    * Item is already put in cache, so cache->last_key points to current key.
    */
   if (flag & type && temp_last_key) {
-    temp_last_key->link_next = cache->last_key;
+    temp_last_key->link_next = cache->last_key[key->task_id];
   }
 
   /* Reset linking. */
   if (key->type == SEQ_CACHE_STORE_FINAL_OUT) {
-    cache->last_key = NULL;
+    cache->last_key[key->task_id] = NULL;
   }
 
   seq_cache_unlock(scene);
@@ -1441,7 +1756,7 @@ void BKE_sequencer_cache_iterate(
     interrupt = callback_iter(userdata, key->seq, key->nfra, key->type, key->cost);
   }
 
-  cache->last_key = NULL;
+  seq_cache_reset_linking(cache);
   seq_cache_unlock(scene);
 }
 
@@ -61,7 +61,22 @@
 
 #include "BLF_api.h"
 
+#include "seqeffects_intern.h"
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static struct SeqEffectHandle get_sequence_effect_impl(int seq_type);
+static void do_blend_kernel_effect(const SeqRenderData *context,
+                                   int seq_type,
+                                   float facf0,
+                                   float facf1,
+                                   ImBuf *ibuf1,
+                                   ImBuf *ibuf2,
+                                   int start_line,
+                                   int total_lines,
+                                   ImBuf *out);
 
 static void slice_get_byte_buffers(const SeqRenderData *context,
                                    const ImBuf *ibuf1,
@@ -183,6 +198,75 @@ static ImBuf *prepare_effect_imbufs(const SeqRenderData *context,
   return out;
 }
 
+#ifdef __SSE2__
+
+/* -------------------------------------------------------------------- */
+/** \name SSE2 Helpers
+ *
+ * Vector versions of the color conversions used by the byte effects, giving the same results.
+ * \{ */
+
+MALWAYS_INLINE __m128 seq_alpha_mask_sse2(void)
+{
+  return _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+}
+
+MALWAYS_INLINE __m128 seq_alpha_sse2(const __m128 color)
+{
+  return _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Same as #straight_uchar_to_premul_float. */
+MALWAYS_INLINE __m128 straight_uchar_to_premul_float_sse2(const unsigned char color[4])
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i color_i = _mm_cvtsi32_si128(*((const int *)color));
+  color_i = _mm_unpacklo_epi16(_mm_unpacklo_epi8(color_i, zero), zero);
+  const __m128 color_f = _mm_cvtepi32_ps(color_i);
+
+  const __m128 alpha = _mm_mul_ps(seq_alpha_sse2(color_f), _mm_set1_ps(1.0f / 255.0f));
+  const __m128 fac = _mm_mul_ps(alpha, _mm_set1_ps(1.0f / 255.0f));
+  return _bli_math_blend_sse(seq_alpha_mask_sse2(), alpha, _mm_mul_ps(color_f, fac));
+}
+
+/* Same as #premul_float_to_straight_uchar. */
+MALWAYS_INLINE void premul_float_to_straight_uchar_sse2(unsigned char result[4],
+                                                        const __m128 color)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 alpha = seq_alpha_sse2(color);
+  const __m128 keep_mask = _mm_or_ps(
+      _mm_or_ps(_mm_cmpeq_ps(alpha, zero), _mm_cmpeq_ps(alpha, one)), seq_alpha_mask_sse2());
+  const __m128 straight = _bli_math_blend_sse(
+      keep_mask, color, _mm_mul_ps(color, _mm_div_ps(one, alpha)));
+
+  /* #unit_float_to_uchar_clamp, the limits are tested explicitly since the conversion of large
+   * values overflows. */
+  __m128i result_i = _mm_cvttps_epi32(
+      _mm_add_ps(_mm_mul_ps(straight, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+  const __m128i over = _mm_castps_si128(
+      _mm_cmpgt_ps(straight, _mm_set1_ps(1.0f - 0.5f / 255.0f)));
+  const __m128i under = _mm_castps_si128(_mm_cmple_ps(straight, zero));
+  result_i = _mm_or_si128(_mm_andnot_si128(over, result_i),
+                          _mm_and_si128(over, _mm_set1_epi32(255)));
+  result_i = _mm_andnot_si128(under, result_i);
+  result_i = _mm_packs_epi32(result_i, result_i);
+  result_i = _mm_packus_epi16(result_i, result_i);
+  *((int *)result) = _mm_cvtsi128_si32(result_i);
+}
+
+/* Broadcast the alpha of the two pixels in 16 bit lanes. */
+MALWAYS_INLINE __m128i seq_alpha_epi16_sse2(const __m128i color)
+{
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3)),
+                             _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/** \} */
+
+#endif /* __SSE2__ */
+
 /*********************** Alpha Over *************************/
 
 static void init_alpha_over_or_under(Sequence *seq)
@@ -348,6 +432,81 @@ static void do_alphaover_effect_float(
   }
 }
 
+#ifdef __SSE2__
+static void do_alphaover_effect_byte_sse2(float facf0,
+                                          float facf1,
+                                          int x,
+                                          int y,
+                                          unsigned char *rect1,
+                                          unsigned char *rect2,
+                                          unsigned char *out)
+{
+  unsigned char *cp1 = rect1, *cp2 = rect2, *rt = out;
+
+  for (int line = 0; line < y; line++) {
+    const float fac = (line & 1) ? facf1 : facf0;
+
+    if (fac <= 0.0f) {
+      memcpy(rt, cp2, sizeof(*rt) * 4 * x);
+      cp1 += 4 * x;
+      cp2 += 4 * x;
+      rt += 4 * x;
+      continue;
+    }
+
+    const __m128 fac_v = _mm_set1_ps(fac);
+    for (int i = 0; i < x; i++) {
+      /* rt = rt1 over rt2  (alpha from rt1) */
+      const __m128 rt1 = straight_uchar_to_premul_float_sse2(cp1);
+      const __m128 mfac = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(fac_v, seq_alpha_sse2(rt1)));
+
+      if (_mm_cvtss_f32(mfac) <= 0.0f) {
+        *((unsigned int *)rt) = *((unsigned int *)cp1);
+      }
+      else {
+        const __m128 rt2 = straight_uchar_to_premul_float_sse2(cp2);
+        premul_float_to_straight_uchar_sse2(
+            rt, _mm_add_ps(_mm_mul_ps(fac_v, rt1), _mm_mul_ps(mfac, rt2)));
+      }
+      cp1 += 4;
+      cp2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+static void do_alphaover_effect_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  float *rt1 = rect1, *rt2 = rect2, *rt = out;
+
+  for (int line = 0; line < y; line++) {
+    const float fac = (line & 1) ? facf1 : facf0;
+
+    if (fac <= 0.0f) {
+      memcpy(rt, rt2, sizeof(*rt) * 4 * x);
+      rt1 += 4 * x;
+      rt2 += 4 * x;
+      rt += 4 * x;
+      continue;
+    }
+
+    const __m128 fac_v = _mm_set1_ps(fac);
+    for (int i = 0; i < x; i++) {
+      const __m128 color1 = _mm_loadu_ps(rt1);
+      const __m128 color2 = _mm_loadu_ps(rt2);
+      const __m128 mfac = _mm_sub_ps(_mm_set1_ps(1.0f),
+                                     _mm_mul_ps(fac_v, seq_alpha_sse2(color1)));
+      const __m128 result = _mm_add_ps(_mm_mul_ps(fac_v, color1), _mm_mul_ps(mfac, color2));
+      _mm_storeu_ps(rt, _bli_math_blend_sse(_mm_cmple_ps(mfac, _mm_setzero_ps()), color1, result));
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+#endif /* __SSE2__ */
+
 static void do_alphaover_effect(const SeqRenderData *context,
                                 Sequence *UNUSED(seq),
                                 float UNUSED(cfra),
@@ -360,22 +519,8 @@ static void do_alphaover_effect(const SeqRenderData *context,
                                 int total_lines,
                                 ImBuf *out)
 {
-  if (out->rect_float) {
-    float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_float_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_alphaover_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
-  else {
-    unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_byte_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_alphaover_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
+  do_blend_kernel_effect(
+      context, SEQ_TYPE_ALPHAOVER, facf0, facf1, ibuf1, ibuf2, start_line, total_lines, out);
 }
 
 /*********************** Alpha Under *************************/
@@ -555,6 +700,82 @@ static void do_alphaunder_effect_float(
   }
 }
 
+#ifdef __SSE2__
+static void do_alphaunder_effect_byte_sse2(float facf0,
+                                           float facf1,
+                                           int x,
+                                           int y,
+                                           unsigned char *rect1,
+                                           unsigned char *rect2,
+                                           unsigned char *out)
+{
+  unsigned char *cp1 = rect1, *cp2 = rect2, *rt = out;
+
+  for (int line = 0; line < y; line++) {
+    const float fac_line = (line & 1) ? facf1 : facf0;
+
+    for (int i = 0; i < x; i++) {
+      /* rt = rt1 under rt2  (alpha from rt2) */
+      const __m128 rt2 = straight_uchar_to_premul_float_sse2(cp2);
+      const float alpha2 = _mm_cvtss_f32(seq_alpha_sse2(rt2));
+
+      if (alpha2 <= 0.0f && fac_line >= 1.0f) {
+        *((unsigned int *)rt) = *((unsigned int *)cp1);
+      }
+      else if (alpha2 >= 1.0f) {
+        *((unsigned int *)rt) = *((unsigned int *)cp2);
+      }
+      else {
+        const float fac = fac_line * (1.0f - alpha2);
+
+        if (fac <= 0) {
+          *((unsigned int *)rt) = *((unsigned int *)cp2);
+        }
+        else {
+          const __m128 rt1 = straight_uchar_to_premul_float_sse2(cp1);
+          premul_float_to_straight_uchar_sse2(rt,
+                                              _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), rt1), rt2));
+        }
+      }
+      cp1 += 4;
+      cp2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+static void do_alphaunder_effect_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  float *rt1 = rect1, *rt2 = rect2, *rt = out;
+
+  for (int line = 0; line < y; line++) {
+    const float fac_line = (line & 1) ? facf1 : facf0;
+    const __m128 fac_v = _mm_set1_ps(fac_line);
+
+    for (int i = 0; i < x; i++) {
+      const __m128 color1 = _mm_loadu_ps(rt1);
+      const __m128 color2 = _mm_loadu_ps(rt2);
+      const __m128 alpha2 = seq_alpha_sse2(color2);
+      const __m128 fac = _mm_mul_ps(fac_v, _mm_sub_ps(one, alpha2));
+
+      __m128 result = _mm_add_ps(_mm_mul_ps(fac, color1), color2);
+      result = _bli_math_blend_sse(_mm_cmpeq_ps(fac, zero), color2, result);
+      result = _bli_math_blend_sse(_mm_cmpge_ps(alpha2, one), color2, result);
+      if (fac_line >= 1.0f) {
+        result = _bli_math_blend_sse(_mm_cmple_ps(alpha2, zero), color1, result);
+      }
+      _mm_storeu_ps(rt, result);
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+#endif /* __SSE2__ */
+
 static void do_alphaunder_effect(const SeqRenderData *context,
                                  Sequence *UNUSED(seq),
                                  float UNUSED(cfra),
@@ -567,22 +788,8 @@ static void do_alphaunder_effect(const SeqRenderData *context,
                                  int total_lines,
                                  ImBuf *out)
 {
-  if (out->rect_float) {
-    float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_float_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_alphaunder_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
-  else {
-    unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_byte_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_alphaunder_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
+  do_blend_kernel_effect(
+      context, SEQ_TYPE_ALPHAUNDER, facf0, facf1, ibuf1, ibuf2, start_line, total_lines, out);
 }
 
 /*********************** Cross *************************/
@@ -690,6 +897,82 @@ static void do_cross_effect_float(
   }
 }
 
+#ifdef __SSE2__
+static void do_cross_effect_byte_sse2(float facf0,
+                                      float facf1,
+                                      int x,
+                                      int y,
+                                      unsigned char *rect1,
+                                      unsigned char *rect2,
+                                      unsigned char *out)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  for (int line = 0; line < y; line++) {
+    const size_t offset = (size_t)line * x * 4;
+    unsigned char *rt1 = rect1 + offset, *rt2 = rect2 + offset, *rt = out + offset;
+    const float facf = (line & 1) ? facf1 : facf0;
+    const int fac2 = (int)(256.0f * facf);
+    const int fac1 = 256 - fac2;
+    int i = 0;
+
+    /* Factors outside of the 16 bit multiplication are left to the scalar code. */
+    if (fac2 >= 0 && fac2 <= 256) {
+      /* Pairs of rt1 and rt2 channels are multiplied and summed in 32 bit. */
+      const __m128i fac = _mm_set1_epi32((fac2 << 16) | fac1);
+
+      for (; i + 4 <= x; i += 4) {
+        const __m128i color1 = _mm_loadu_si128((const __m128i *)rt1);
+        const __m128i color2 = _mm_loadu_si128((const __m128i *)rt2);
+        const __m128i pairs_lo = _mm_unpacklo_epi8(color1, color2);
+        const __m128i pairs_hi = _mm_unpackhi_epi8(color1, color2);
+
+        const __m128i result0 = _mm_srli_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi8(pairs_lo, zero), fac), 8);
+        const __m128i result1 = _mm_srli_epi32(
+            _mm_madd_epi16(_mm_unpackhi_epi8(pairs_lo, zero), fac), 8);
+        const __m128i result2 = _mm_srli_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi8(pairs_hi, zero), fac), 8);
+        const __m128i result3 = _mm_srli_epi32(
+            _mm_madd_epi16(_mm_unpackhi_epi8(pairs_hi, zero), fac), 8);
+
+        _mm_storeu_si128((__m128i *)rt,
+                         _mm_packus_epi16(_mm_packs_epi32(result0, result1),
+                                          _mm_packs_epi32(result2, result3)));
+        rt1 += 16;
+        rt2 += 16;
+        rt += 16;
+      }
+    }
+
+    if (i < x) {
+      do_cross_effect_byte(facf, facf, x - i, 1, rt1, rt2, rt);
+    }
+  }
+}
+
+static void do_cross_effect_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  float *rt1 = rect1, *rt2 = rect2, *rt = out;
+
+  for (int line = 0; line < y; line++) {
+    const float fac = (line & 1) ? facf1 : facf0;
+    const __m128 fac2 = _mm_set1_ps(fac);
+    const __m128 fac1 = _mm_set1_ps(1.0f - fac);
+
+    for (int i = 0; i < x; i++) {
+      _mm_storeu_ps(rt,
+                    _mm_add_ps(_mm_mul_ps(fac1, _mm_loadu_ps(rt1)),
+                               _mm_mul_ps(fac2, _mm_loadu_ps(rt2))));
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+#endif /* __SSE2__ */
+
 static void do_cross_effect(const SeqRenderData *context,
                             Sequence *UNUSED(seq),
                             float UNUSED(cfra),
@@ -702,22 +985,8 @@ static void do_cross_effect(const SeqRenderData *context,
                             int total_lines,
                             ImBuf *out)
 {
-  if (out->rect_float) {
-    float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_float_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_cross_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
-  else {
-    unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_byte_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_cross_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
+  do_blend_kernel_effect(
+      context, SEQ_TYPE_CROSS, facf0, facf1, ibuf1, ibuf2, start_line, total_lines, out);
 }
 
 /*********************** Gamma Cross *************************/
@@ -1123,6 +1392,84 @@ static void do_add_effect_float(
   }
 }
 
+#ifdef __SSE2__
+/* The (fac * alpha2 * color2) >> 16 term of the byte add and sub effects for four pixels, zero
+ * for alpha. */
+MALWAYS_INLINE __m128i seq_add_sub_term_sse2(const __m128i color2, const __m128i fac)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i color2_lo = _mm_unpacklo_epi8(color2, zero);
+  const __m128i color2_hi = _mm_unpackhi_epi8(color2, zero);
+  const __m128i term_lo = _mm_mulhi_epu16(
+      _mm_mullo_epi16(fac, seq_alpha_epi16_sse2(color2_lo)), color2_lo);
+  const __m128i term_hi = _mm_mulhi_epu16(
+      _mm_mullo_epi16(fac, seq_alpha_epi16_sse2(color2_hi)), color2_hi);
+  return _mm_and_si128(_mm_packus_epi16(term_lo, term_hi), _mm_set1_epi32(0x00ffffff));
+}
+#endif /* __SSE2__ */
+
+#ifdef __SSE2__
+static void do_add_effect_byte_sse2(float facf0,
+                                    float facf1,
+                                    int x,
+                                    int y,
+                                    unsigned char *rect1,
+                                    unsigned char *rect2,
+                                    unsigned char *out)
+{
+  for (int line = 0; line < y; line++) {
+    const size_t offset = (size_t)line * x * 4;
+    unsigned char *cp1 = rect1 + offset, *cp2 = rect2 + offset, *rt = out + offset;
+    const float facf = (line & 1) ? facf1 : facf0;
+    const int fac1 = (int)(256.0f * facf);
+    int i = 0;
+
+    /* Factors outside of the 16 bit multiplication are left to the scalar code. */
+    if (fac1 >= 0 && fac1 <= 256) {
+      const __m128i fac = _mm_set1_epi16((short)fac1);
+
+      for (; i + 4 <= x; i += 4) {
+        const __m128i color1 = _mm_loadu_si128((const __m128i *)cp1);
+        const __m128i color2 = _mm_loadu_si128((const __m128i *)cp2);
+        _mm_storeu_si128((__m128i *)rt,
+                         _mm_adds_epu8(color1, seq_add_sub_term_sse2(color2, fac)));
+        cp1 += 16;
+        cp2 += 16;
+        rt += 16;
+      }
+    }
+
+    if (i < x) {
+      do_add_effect_byte(facf, facf, x - i, 1, cp1, cp2, rt);
+    }
+  }
+}
+
+static void do_add_effect_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 alpha_mask = seq_alpha_mask_sse2();
+  float *rt1 = rect1, *rt2 = rect2, *rt = out;
+
+  for (int line = 0; line < y; line++) {
+    const __m128 fac_inv = _mm_set1_ps(1.0f - ((line & 1) ? facf1 : facf0));
+
+    for (int i = 0; i < x; i++) {
+      const __m128 color1 = _mm_loadu_ps(rt1);
+      const __m128 color2 = _mm_loadu_ps(rt2);
+      const __m128 m = _mm_mul_ps(
+          _mm_sub_ps(one, _mm_mul_ps(seq_alpha_sse2(color1), fac_inv)), seq_alpha_sse2(color2));
+      const __m128 result = _mm_add_ps(color1, _mm_mul_ps(m, color2));
+      _mm_storeu_ps(rt, _bli_math_blend_sse(alpha_mask, color1, result));
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+#endif /* __SSE2__ */
+
 static void do_add_effect(const SeqRenderData *context,
                           Sequence *UNUSED(seq),
                           float UNUSED(cfra),
@@ -1135,22 +1482,8 @@ static void do_add_effect(const SeqRenderData *context,
                           int total_lines,
                           ImBuf *out)
 {
-  if (out->rect_float) {
-    float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_float_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_add_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
-  else {
-    unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_byte_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_add_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
+  do_blend_kernel_effect(
+      context, SEQ_TYPE_ADD, facf0, facf1, ibuf1, ibuf2, start_line, total_lines, out);
 }
 
 /*********************** Sub *************************/
@@ -1258,6 +1591,68 @@ static void do_sub_effect_float(
   }
 }
 
+#ifdef __SSE2__
+static void do_sub_effect_byte_sse2(float facf0,
+                                    float facf1,
+                                    int x,
+                                    int y,
+                                    unsigned char *rect1,
+                                    unsigned char *rect2,
+                                    unsigned char *out)
+{
+  for (int line = 0; line < y; line++) {
+    const size_t offset = (size_t)line * x * 4;
+    unsigned char *cp1 = rect1 + offset, *cp2 = rect2 + offset, *rt = out + offset;
+    const float facf = (line & 1) ? facf1 : facf0;
+    const int fac1 = (int)(256.0f * facf);
+    int i = 0;
+
+    /* Factors outside of the 16 bit multiplication are left to the scalar code. */
+    if (fac1 >= 0 && fac1 <= 256) {
+      const __m128i fac = _mm_set1_epi16((short)fac1);
+
+      for (; i + 4 <= x; i += 4) {
+        const __m128i color1 = _mm_loadu_si128((const __m128i *)cp1);
+        const __m128i color2 = _mm_loadu_si128((const __m128i *)cp2);
+        _mm_storeu_si128((__m128i *)rt,
+                         _mm_subs_epu8(color1, seq_add_sub_term_sse2(color2, fac)));
+        cp1 += 16;
+        cp2 += 16;
+        rt += 16;
+      }
+    }
+
+    if (i < x) {
+      do_sub_effect_byte(facf, facf, x - i, 1, cp1, cp2, rt);
+    }
+  }
+}
+
+static void do_sub_effect_float_sse2(
+    float UNUSED(facf0), float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 alpha_mask = seq_alpha_mask_sse2();
+  /* Like the scalar version, only the second factor is used. */
+  const __m128 fac3_inv = _mm_set1_ps(1.0f - facf1);
+  const int len = x * y;
+  float *rt1 = rect1, *rt2 = rect2, *rt = out;
+
+  for (int i = 0; i < len; i++) {
+    const __m128 color1 = _mm_loadu_ps(rt1);
+    const __m128 color2 = _mm_loadu_ps(rt2);
+    const __m128 m = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(seq_alpha_sse2(color1), fac3_inv)),
+                                seq_alpha_sse2(color2));
+    const __m128 result = _mm_max_ps(_mm_sub_ps(color1, _mm_mul_ps(m, color2)), zero);
+    _mm_storeu_ps(rt, _bli_math_blend_sse(alpha_mask, color1, result));
+    rt1 += 4;
+    rt2 += 4;
+    rt += 4;
+  }
+}
+#endif /* __SSE2__ */
+
 static void do_sub_effect(const SeqRenderData *context,
                           Sequence *UNUSED(seq),
                           float UNUSED(cfra),
@@ -1270,22 +1665,8 @@ static void do_sub_effect(const SeqRenderData *context,
                           int total_lines,
                           ImBuf *out)
 {
-  if (out->rect_float) {
-    float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_float_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_sub_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
-  else {
-    unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
-
-    slice_get_byte_buffers(
-        context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-
-    do_sub_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
-  }
+  do_blend_kernel_effect(
+      context, SEQ_TYPE_SUB, facf0, facf1, ibuf1, ibuf2, start_line, total_lines, out);
 }
 
 /*********************** Drop *************************/
@@ -1294,10 +1675,20 @@ static void do_sub_effect(const SeqRenderData *context,
 #define XOFF 8
 #define YOFF 8
 
+/* The shadow of a line is read from the line YOFF lines below it in the image, which can be
+ * outside of the slice. The last lines of the image have no shadow. */
+static int drop_effect_shadow_lines(int start_line, int total_lines, int image_height)
+{
+  const int yoff = min_ii(YOFF, image_height);
+  return clamp_i(image_height - yoff - start_line, 0, total_lines);
+}
+
 static void do_drop_effect_byte(float facf0,
                                 float facf1,
                                 int x,
                                 int y,
+                                int start_line,
+                                int image_height,
                                 unsigned char *rect2i,
                                 unsigned char *rect1i,
                                 unsigned char *outi)
@@ -1307,9 +1698,9 @@ static void do_drop_effect_byte(float facf0,
   int field = 1;
 
   const int width = x;
-  const int height = y;
   const int xoff = min_ii(XOFF, width);
-  const int yoff = min_ii(YOFF, height);
+  const int yoff = min_ii(YOFF, image_height);
+  const int shadow_lines = drop_effect_shadow_lines(start_line, y, image_height);
 
   fac1 = (int)(70.0f * facf0);
   fac2 = (int)(70.0f * facf1);
@@ -1317,7 +1708,7 @@ static void do_drop_effect_byte(float facf0,
   rt2 = rect2i + yoff * 4 * width;
   rt1 = rect1i;
   out = outi;
-  for (y = 0; y < height - yoff; y++) {
+  for (int line = 0; line < shadow_lines; line++) {
     if (field) {
       fac = fac1;
     }
@@ -1345,20 +1736,27 @@ static void do_drop_effect_byte(float facf0,
     }
     rt2 += xoff * 4;
   }
-  memcpy(out, rt1, sizeof(*out) * yoff * 4 * width);
+  memcpy(out, rt1, sizeof(*out) * (y - shadow_lines) * 4 * width);
 }
 
-static void do_drop_effect_float(
-    float facf0, float facf1, int x, int y, float *rect2i, float *rect1i, float *outi)
+static void do_drop_effect_float(float facf0,
+                                 float facf1,
+                                 int x,
+                                 int y,
+                                 int start_line,
+                                 int image_height,
+                                 float *rect2i,
+                                 float *rect1i,
+                                 float *outi)
 {
   float temp, fac, fac1, fac2;
   float *rt1, *rt2, *out;
   int field = 1;
 
   const int width = x;
-  const int height = y;
   const int xoff = min_ii(XOFF, width);
-  const int yoff = min_ii(YOFF, height);
+  const int yoff = min_ii(YOFF, image_height);
+  const int shadow_lines = drop_effect_shadow_lines(start_line, y, image_height);
 
   fac1 = 70.0f * facf0;
   fac2 = 70.0f * facf1;
@@ -1366,7 +1764,7 @@ static void do_drop_effect_float(
   rt2 = rect2i + yoff * 4 * width;
   rt1 = rect1i;
   out = outi;
-  for (y = 0; y < height - yoff; y++) {
+  for (int line = 0; line < shadow_lines; line++) {
     if (field) {
       fac = fac1;
     }
@@ -1394,7 +1792,7 @@ static void do_drop_effect_float(
     }
     rt2 += xoff * 4;
   }
-  memcpy(out, rt1, sizeof(*out) * yoff * 4 * width);
+  memcpy(out, rt1, sizeof(*out) * (y - shadow_lines) * 4 * width);
 }
 
 /*********************** Mul *************************/
@@ -1509,6 +1907,88 @@ static void do_mul_effect_float(
   }
 }
 
+#ifdef __SSE2__
+/* rt1 + ((fac * rt1 * (rt2 - 255)) >> 16) for two pixels in 16 bit lanes. The product is
+ * negative, the arithmetic shift rounds down so the magnitude is rounded up. */
+MALWAYS_INLINE __m128i seq_mul_byte_sse2(const __m128i color1,
+                                         const __m128i color2,
+                                         const __m128i fac)
+{
+  const __m128i scaled = _mm_mullo_epi16(fac, color1);
+  const __m128i inv2 = _mm_sub_epi16(_mm_set1_epi16(255), color2);
+  const __m128i product_hi = _mm_mulhi_epu16(scaled, inv2);
+  const __m128i product_lo = _mm_mullo_epi16(scaled, inv2);
+  /* Add one when the low bits are not zero, the comparison gives -1 when they are. */
+  const __m128i product_ceil = _mm_add_epi16(
+      _mm_add_epi16(product_hi, _mm_set1_epi16(1)),
+      _mm_cmpeq_epi16(product_lo, _mm_setzero_si128()));
+  return _mm_sub_epi16(color1, product_ceil);
+}
+
+static void do_mul_effect_byte_sse2(float facf0,
+                                    float facf1,
+                                    int x,
+                                    int y,
+                                    unsigned char *rect1,
+                                    unsigned char *rect2,
+                                    unsigned char *out)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  for (int line = 0; line < y; line++) {
+    const size_t offset = (size_t)line * x * 4;
+    unsigned char *rt1 = rect1 + offset, *rt2 = rect2 + offset, *rt = out + offset;
+    const float facf = (line & 1) ? facf1 : facf0;
+    const int fac1 = (int)(256.0f * facf);
+    int i = 0;
+
+    /* Factors outside of the 16 bit multiplication are left to the scalar code. */
+    if (fac1 >= 0 && fac1 <= 256) {
+      const __m128i fac = _mm_set1_epi16((short)fac1);
+
+      for (; i + 4 <= x; i += 4) {
+        const __m128i color1 = _mm_loadu_si128((const __m128i *)rt1);
+        const __m128i color2 = _mm_loadu_si128((const __m128i *)rt2);
+        const __m128i result_lo = seq_mul_byte_sse2(
+            _mm_unpacklo_epi8(color1, zero), _mm_unpacklo_epi8(color2, zero), fac);
+        const __m128i result_hi = seq_mul_byte_sse2(
+            _mm_unpackhi_epi8(color1, zero), _mm_unpackhi_epi8(color2, zero), fac);
+        _mm_storeu_si128((__m128i *)rt, _mm_packus_epi16(result_lo, result_hi));
+        rt1 += 16;
+        rt2 += 16;
+        rt += 16;
+      }
+    }
+
+    if (i < x) {
+      do_mul_effect_byte(facf, facf, x - i, 1, rt1, rt2, rt);
+    }
+  }
+}
+
+static void do_mul_effect_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  float *rt1 = rect1, *rt2 = rect2, *rt = out;
+
+  for (int line = 0; line < y; line++) {
+    const __m128 fac = _mm_set1_ps((line & 1) ? facf1 : facf0);
+
+    for (int i = 0; i < x; i++) {
+      const __m128 color1 = _mm_loadu_ps(rt1);
+      const __m128 color2 = _mm_loadu_ps(rt2);
+      _mm_storeu_ps(
+          rt,
+          _mm_add_ps(color1, _mm_mul_ps(_mm_mul_ps(fac, color1), _mm_sub_ps(color2, one))));
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+#endif /* __SSE2__ */
+
 static void do_mul_effect(const SeqRenderData *context,
                           Sequence *UNUSED(seq),
                           float UNUSED(cfra),
@@ -1521,13 +2001,103 @@ static void do_mul_effect(const SeqRenderData *context,
                           int total_lines,
                           ImBuf *out)
 {
+  do_blend_kernel_effect(
+      context, SEQ_TYPE_MUL, facf0, facf1, ibuf1, ibuf2, start_line, total_lines, out);
+}
+
+/*********************** Blend Kernels *************************/
+
+bool seq_effect_blend_kernels_get(int seq_type,
+                                  bool use_simd,
+                                  SeqEffectByteKernel *r_kernel_byte,
+                                  SeqEffectFloatKernel *r_kernel_float)
+{
+#ifdef __SSE2__
+  if (use_simd) {
+    switch (seq_type) {
+      case SEQ_TYPE_ALPHAOVER:
+        *r_kernel_byte = do_alphaover_effect_byte_sse2;
+        *r_kernel_float = do_alphaover_effect_float_sse2;
+        return true;
+      case SEQ_TYPE_ALPHAUNDER:
+        *r_kernel_byte = do_alphaunder_effect_byte_sse2;
+        *r_kernel_float = do_alphaunder_effect_float_sse2;
+        return true;
+      case SEQ_TYPE_CROSS:
+        *r_kernel_byte = do_cross_effect_byte_sse2;
+        *r_kernel_float = do_cross_effect_float_sse2;
+        return true;
+      case SEQ_TYPE_ADD:
+        *r_kernel_byte = do_add_effect_byte_sse2;
+        *r_kernel_float = do_add_effect_float_sse2;
+        return true;
+      case SEQ_TYPE_SUB:
+        *r_kernel_byte = do_sub_effect_byte_sse2;
+        *r_kernel_float = do_sub_effect_float_sse2;
+        return true;
+      case SEQ_TYPE_MUL:
+        *r_kernel_byte = do_mul_effect_byte_sse2;
+        *r_kernel_float = do_mul_effect_float_sse2;
+        return true;
+    }
+  }
+#else
+  UNUSED_VARS(use_simd);
+#endif
+
+  switch (seq_type) {
+    case SEQ_TYPE_ALPHAOVER:
+      *r_kernel_byte = do_alphaover_effect_byte;
+      *r_kernel_float = do_alphaover_effect_float;
+      return true;
+    case SEQ_TYPE_ALPHAUNDER:
+      *r_kernel_byte = do_alphaunder_effect_byte;
+      *r_kernel_float = do_alphaunder_effect_float;
+      return true;
+    case SEQ_TYPE_CROSS:
+      *r_kernel_byte = do_cross_effect_byte;
+      *r_kernel_float = do_cross_effect_float;
+      return true;
+    case SEQ_TYPE_ADD:
+      *r_kernel_byte = do_add_effect_byte;
+      *r_kernel_float = do_add_effect_float;
+      return true;
+    case SEQ_TYPE_SUB:
+      *r_kernel_byte = do_sub_effect_byte;
+      *r_kernel_float = do_sub_effect_float;
+      return true;
+    case SEQ_TYPE_MUL:
+      *r_kernel_byte = do_mul_effect_byte;
+      *r_kernel_float = do_mul_effect_float;
+      return true;
+  }
+  return false;
+}
+
+static void do_blend_kernel_effect(const SeqRenderData *context,
+                                   int seq_type,
+                                   float facf0,
+                                   float facf1,
+                                   ImBuf *ibuf1,
+                                   ImBuf *ibuf2,
+                                   int start_line,
+                                   int total_lines,
+                                   ImBuf *out)
+{
+  SeqEffectByteKernel kernel_byte;
+  SeqEffectFloatKernel kernel_float;
+  if (!seq_effect_blend_kernels_get(seq_type, true, &kernel_byte, &kernel_float)) {
+    BLI_assert(0);
+    return;
+  }
+
   if (out->rect_float) {
     float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
 
     slice_get_float_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_mul_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    kernel_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
   else {
     unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
@@ -1535,7 +2105,7 @@ static void do_mul_effect(const SeqRenderData *context,
     slice_get_byte_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_mul_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    kernel_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
 }
 
@@ -3329,7 +3899,7 @@ static void do_overdrop_effect(const SeqRenderData *context,
     slice_get_float_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_drop_effect_float(facf0, facf1, x, y, rect1, rect2, rect_out);
+    do_drop_effect_float(facf0, facf1, x, y, start_line, out->y, rect1, rect2, rect_out);
     do_alphaover_effect_float(facf0, facf1, x, y, rect1, rect2, rect_out);
   }
   else {
@@ -3338,7 +3908,7 @@ static void do_overdrop_effect(const SeqRenderData *context,
     slice_get_byte_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_drop_effect_byte(facf0, facf1, x, y, rect1, rect2, rect_out);
+    do_drop_effect_byte(facf0, facf1, x, y, start_line, out->y, rect1, rect2, rect_out);
     do_alphaover_effect_byte(facf0, facf1, x, y, rect1, rect2, rect_out);
   }
 }
@@ -3797,6 +4367,9 @@ static void init_text_effect(Sequence *seq)
   data->align_y = SEQ_TEXT_ALIGN_Y_BOTTOM;
 }
 
+/* BLF keeps the state of fonts and glyph caches globally, prefetch workers render text too. */
+static ThreadMutex text_effect_mutex = BLI_MUTEX_INITIALIZER;
+
 void BKE_sequencer_text_font_unload(TextVars *data, const bool do_id_user)
 {
   if (data) {
@@ -3808,7 +4381,9 @@ void BKE_sequencer_text_font_unload(TextVars *data, const bool do_id_user)
 
     /* Unload the BLF font. */
     if (data->text_blf_id >= 0) {
+      BLI_mutex_lock(&text_effect_mutex);
       BLF_unload_id(data->text_blf_id);
+      BLI_mutex_unlock(&text_effect_mutex);
     }
   }
 }
@@ -3825,7 +4400,9 @@ void BKE_sequencer_text_font_load(TextVars *data, const bool do_id_user)
     BLI_assert(BLI_thread_is_main());
     BLI_path_abs(path, ID_BLEND_PATH_FROM_GLOBAL(&data->text_font->id));
 
+    BLI_mutex_lock(&text_effect_mutex);
     data->text_blf_id = BLF_load(path);
+    BLI_mutex_unlock(&text_effect_mutex);
   }
 }
 
@@ -3891,6 +4468,8 @@ static ImBuf *do_text_effect(const SeqRenderData *context,
   int y_ofs, x, y;
   double proxy_size_comp;
 
+  BLI_mutex_lock(&text_effect_mutex);
+
   if (data->text_blf_id == SEQ_FONT_NOT_LOADED) {
     data->text_blf_id = -1;
 
@@ -3978,6 +4557,8 @@ static ImBuf *do_text_effect(const SeqRenderData *context,
 
   BLF_disable(font, BLF_WORD_WRAP);
 
+  BLI_mutex_unlock(&text_effect_mutex);
+
   return out;
 }
 
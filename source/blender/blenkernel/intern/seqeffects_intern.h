@@ -0,0 +1,55 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+/** \file
+ * \ingroup bke
+ */
+
+#ifndef __SEQEFFECTS_INTERN_H__
+#define __SEQEFFECTS_INTERN_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Blend y lines of x pixels of rect1 and rect2 into out, facf0 is used for the first line and
+ * alternates with facf1. */
+typedef void (*SeqEffectByteKernel)(float facf0,
+                                    float facf1,
+                                    int x,
+                                    int y,
+                                    unsigned char *rect1,
+                                    unsigned char *rect2,
+                                    unsigned char *out);
+typedef void (*SeqEffectFloatKernel)(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+
+/**
+ * Get the per pixel kernels of the blend effect \a seq_type, the SIMD ones when \a use_simd is
+ * set and they are available. Returns false when the effect has no such kernels.
+ */
+bool seq_effect_blend_kernels_get(int seq_type,
+                                  bool use_simd,
+                                  SeqEffectByteKernel *r_kernel_byte,
+                                  SeqEffectFloatKernel *r_kernel_float);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SEQEFFECTS_INTERN_H__ */
@@ -0,0 +1,144 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <vector>
+
+extern "C" {
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_sequence_types.h"
+
+#include "seqeffects_intern.h"
+}
+
+namespace blender::bke::tests {
+
+/* Odd size, so the vector loops leave pixels to the scalar code. */
+static const int WIDTH = 37;
+static const int HEIGHT = 6;
+
+static const int EFFECT_TYPES[] = {
+    SEQ_TYPE_ALPHAOVER,
+    SEQ_TYPE_ALPHAUNDER,
+    SEQ_TYPE_CROSS,
+    SEQ_TYPE_ADD,
+    SEQ_TYPE_SUB,
+    SEQ_TYPE_MUL,
+};
+
+/* Factor pairs of the first and second line, including factors outside of [0, 1]. */
+static const float FACTORS[][2] = {
+    {0.0f, 0.0f},
+    {0.25f, 0.75f},
+    {0.5f, 0.5f},
+    {1.0f, 1.0f},
+    {0.8f, 0.0f},
+    {1.5f, -0.25f},
+};
+
+static void fill_byte(RNG *rng, std::vector<unsigned char> &rect)
+{
+  for (size_t i = 0; i < rect.size(); i++) {
+    rect[i] = (unsigned char)BLI_rng_get_uint(rng);
+  }
+  /* Fully transparent and opaque pixels take other paths. */
+  for (size_t i = 3; i < rect.size(); i += 4 * 3) {
+    rect[i] = (i % 8 == 3) ? 0 : 255;
+  }
+}
+
+static void fill_float(RNG *rng, std::vector<float> &rect)
+{
+  for (size_t i = 0; i < rect.size(); i++) {
+    rect[i] = BLI_rng_get_float(rng) * 1.2f - 0.1f;
+  }
+  for (size_t i = 3; i < rect.size(); i += 4 * 3) {
+    rect[i] = (i % 8 == 3) ? 0.0f : 1.0f;
+  }
+}
+
+TEST(seqeffects, BlendKernelsByte)
+{
+  RNG *rng = BLI_rng_new(0);
+  std::vector<unsigned char> rect1(WIDTH * HEIGHT * 4), rect2(WIDTH * HEIGHT * 4);
+  std::vector<unsigned char> out_scalar(WIDTH * HEIGHT * 4), out_simd(WIDTH * HEIGHT * 4);
+
+  for (int type : EFFECT_TYPES) {
+    SeqEffectByteKernel kernel_scalar, kernel_simd;
+    SeqEffectFloatKernel kernel_float;
+    ASSERT_TRUE(seq_effect_blend_kernels_get(type, false, &kernel_scalar, &kernel_float));
+    ASSERT_TRUE(seq_effect_blend_kernels_get(type, true, &kernel_simd, &kernel_float));
+
+    for (const float *factors : FACTORS) {
+      fill_byte(rng, rect1);
+      fill_byte(rng, rect2);
+      kernel_scalar(
+          factors[0], factors[1], WIDTH, HEIGHT, &rect1[0], &rect2[0], &out_scalar[0]);
+      kernel_simd(factors[0], factors[1], WIDTH, HEIGHT, &rect1[0], &rect2[0], &out_simd[0]);
+
+      for (size_t i = 0; i < out_scalar.size(); i++) {
+        EXPECT_EQ(out_scalar[i], out_simd[i])
+            << "effect " << type << ", factors " << factors[0] << " " << factors[1]
+            << ", index " << i;
+      }
+    }
+  }
+
+  BLI_rng_free(rng);
+}
+
+TEST(seqeffects, BlendKernelsFloat)
+{
+  RNG *rng = BLI_rng_new(0);
+  std::vector<float> rect1(WIDTH * HEIGHT * 4), rect2(WIDTH * HEIGHT * 4);
+  std::vector<float> out_scalar(WIDTH * HEIGHT * 4), out_simd(WIDTH * HEIGHT * 4);
+
+  for (int type : EFFECT_TYPES) {
+    SeqEffectByteKernel kernel_byte;
+    SeqEffectFloatKernel kernel_scalar, kernel_simd;
+    ASSERT_TRUE(seq_effect_blend_kernels_get(type, false, &kernel_byte, &kernel_scalar));
+    ASSERT_TRUE(seq_effect_blend_kernels_get(type, true, &kernel_byte, &kernel_simd));
+
+    for (const float *factors : FACTORS) {
+      fill_float(rng, rect1);
+      fill_float(rng, rect2);
+      kernel_scalar(
+          factors[0], factors[1], WIDTH, HEIGHT, &rect1[0], &rect2[0], &out_scalar[0]);
+      kernel_simd(factors[0], factors[1], WIDTH, HEIGHT, &rect1[0], &rect2[0], &out_simd[0]);
+
+      for (size_t i = 0; i < out_scalar.size(); i++) {
+        EXPECT_FLOAT_EQ(out_scalar[i], out_simd[i])
+            << "effect " << type << ", factors " << factors[0] << " " << factors[1]
+            << ", index " << i;
+      }
+    }
+  }
+
+  BLI_rng_free(rng);
+}
+
+TEST(seqeffects, BlendKernelsOther)
+{
+  SeqEffectByteKernel kernel_byte;
+  SeqEffectFloatKernel kernel_float;
+  EXPECT_FALSE(seq_effect_blend_kernels_get(SEQ_TYPE_WIPE, true, &kernel_byte, &kernel_float));
+}
+
+}  // namespace blender::bke::tests
@@ -48,6 +48,7 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utf8.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -124,7 +125,12 @@ static ImBuf *seq_render_mask(const SeqRenderData *context, Mask *mask, float nr
 static int seq_num_files(Scene *scene, char views_format, const bool is_multiview);
 static void seq_anim_add_suffix(Scene *scene, struct anim *anim, const int view_id);
 
-static ThreadMutex seq_render_mutex = BLI_MUTEX_INITIALIZER;
+/* Rendering of the main thread is exclusive. Prefetch workers render their own copies of the
+ * scene and share the lock, they back off while the main thread waits for it. */
+static ThreadRWMutex seq_render_mutex = BLI_RWLOCK_INITIALIZER;
+static ThreadMutex seq_render_wait_mutex = BLI_MUTEX_INITIALIZER;
+static ThreadCondition seq_render_wait_cond = BLI_CONDITION_INITIALIZER;
+static int seq_render_main_waiting = 0;
 
 /* **** XXX ******** */
 #define SELECT 1
@@ -2241,6 +2247,13 @@ void BKE_sequencer_proxy_rebuild(SeqIndexBuildContext *context,
   }
 }
 
+/* Movie strips are indexed by the image buffer module on their own copy of the strip, so the
+ * proxies of several movies can be built at once. */
+bool BKE_sequencer_proxy_rebuild_is_movie(SeqIndexBuildContext *context)
+{
+  return context->index_context != NULL;
+}
+
 void BKE_sequencer_proxy_rebuild_finish(SeqIndexBuildContext *context, bool stop)
 {
   if (context->index_context) {
@@ -2822,7 +2835,7 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
 
 /*********************** strip rendering functions  *************************/
 
-typedef struct RenderEffectInitData {
+typedef struct RenderEffectData {
   struct SeqEffectHandle *sh;
   const SeqRenderData *context;
   Sequence *seq;
@@ -2830,59 +2843,31 @@ typedef struct RenderEffectInitData {
   ImBuf *ibuf1, *ibuf2, *ibuf3;
 
   ImBuf *out;
-} RenderEffectInitData;
+} RenderEffectData;
 
-typedef struct RenderEffectThread {
-  struct SeqEffectHandle *sh;
-  const SeqRenderData *context;
-  Sequence *seq;
-  float cfra, facf0, facf1;
-  ImBuf *ibuf1, *ibuf2, *ibuf3;
+static void render_effect_execute_line(void *__restrict userdata,
+                                       const int line,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RenderEffectData *data = (RenderEffectData *)userdata;
 
-  ImBuf *out;
-  int start_line, tot_line;
-} RenderEffectThread;
-
-static void render_effect_execute_init_handle(void *handle_v,
-                                              int start_line,
-                                              int tot_line,
-                                              void *init_data_v)
-{
-  RenderEffectThread *handle = (RenderEffectThread *)handle_v;
-  RenderEffectInitData *init_data = (RenderEffectInitData *)init_data_v;
-
-  handle->sh = init_data->sh;
-  handle->context = init_data->context;
-  handle->seq = init_data->seq;
-  handle->cfra = init_data->cfra;
-  handle->facf0 = init_data->facf0;
-  handle->facf1 = init_data->facf1;
-  handle->ibuf1 = init_data->ibuf1;
-  handle->ibuf2 = init_data->ibuf2;
-  handle->ibuf3 = init_data->ibuf3;
-  handle->out = init_data->out;
-
-  handle->start_line = start_line;
-  handle->tot_line = tot_line;
-}
-
-static void *render_effect_execute_do_thread(void *thread_data_v)
-{
-  RenderEffectThread *thread_data = (RenderEffectThread *)thread_data_v;
-
-  thread_data->sh->execute_slice(thread_data->context,
-                                 thread_data->seq,
-                                 thread_data->cfra,
-                                 thread_data->facf0,
-                                 thread_data->facf1,
-                                 thread_data->ibuf1,
-                                 thread_data->ibuf2,
-                                 thread_data->ibuf3,
-                                 thread_data->start_line,
-                                 thread_data->tot_line,
-                                 thread_data->out);
+  /* Slices are single lines, effects which read other lines of the inputs, like the drop shadow
+   * of Alpha Over Drop, read them from the whole input buffers instead of the slice.
+   * Effects use the first factor for the first line of a slice and alternate, swap the factors
+   * of odd lines so the result doesn't depend on how the image is split. */
+  const bool odd_line = (line & 1) != 0;
 
-  return NULL;
+  data->sh->execute_slice(data->context,
+                          data->seq,
+                          data->cfra,
+                          odd_line ? data->facf1 : data->facf0,
+                          odd_line ? data->facf0 : data->facf1,
+                          data->ibuf1,
+                          data->ibuf2,
+                          data->ibuf3,
+                          line,
+                          1,
+                          data->out);
 }
 
 ImBuf *BKE_sequencer_effect_execute_threaded(struct SeqEffectHandle *sh,
@@ -2895,25 +2880,24 @@ ImBuf *BKE_sequencer_effect_execute_threaded(struct SeqEffectHandle *sh,
                                              ImBuf *ibuf2,
                                              ImBuf *ibuf3)
 {
-  RenderEffectInitData init_data;
+  RenderEffectData data;
   ImBuf *out = sh->init_execution(context, ibuf1, ibuf2, ibuf3);
 
-  init_data.sh = sh;
-  init_data.context = context;
-  init_data.seq = seq;
-  init_data.cfra = cfra;
-  init_data.facf0 = facf0;
-  init_data.facf1 = facf1;
-  init_data.ibuf1 = ibuf1;
-  init_data.ibuf2 = ibuf2;
-  init_data.ibuf3 = ibuf3;
-  init_data.out = out;
-
-  IMB_processor_apply_threaded(out->y,
-                               sizeof(RenderEffectThread),
-                               &init_data,
-                               render_effect_execute_init_handle,
-                               render_effect_execute_do_thread);
+  data.sh = sh;
+  data.context = context;
+  data.seq = seq;
+  data.cfra = cfra;
+  data.facf0 = facf0;
+  data.facf1 = facf1;
+  data.ibuf1 = ibuf1;
+  data.ibuf2 = ibuf2;
+  data.ibuf3 = ibuf3;
+  data.out = out;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 8;
+  BLI_task_parallel_range(0, out->y, &data, render_effect_execute_line, &settings);
 
   return out;
 }
@@ -3960,6 +3944,143 @@ static ImBuf *seq_render_strip_stack_apply_effect(
   return out;
 }
 
+/* Strips blended on top of the lowest strip of a stack are rendered on other threads while the
+ * strips below them are rendered and blended. */
+typedef struct SeqRenderStackInput {
+  ImBuf *ibuf;
+  /** Set by the thread rendering the input, it is rendered once. */
+  bool claimed;
+  bool done;
+} SeqRenderStackInput;
+
+typedef struct SeqRenderStackInputs {
+  const SeqRenderData *context;
+  float cfra;
+  Sequence **seq_arr;
+  /** Created when the first input is started. */
+  TaskPool *pool;
+  ThreadMutex mutex;
+  ThreadCondition cond;
+  SeqRenderStackInput inputs[MAXSEQ + 1];
+} SeqRenderStackInputs;
+
+/* Scene strips use the render pipeline or OpenGL, meta-strips and effects render other strips,
+ * as do modifiers with a mask strip. */
+static bool seq_render_strip_is_threadsafe(Sequence *seq)
+{
+  if (!ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE)) {
+    return false;
+  }
+  LISTBASE_FOREACH (SequenceModifierData *, smd, &seq->modifiers) {
+    if (smd->mask_sequence) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void seq_render_stack_inputs_init(SeqRenderStackInputs *inputs,
+                                         const SeqRenderData *context,
+                                         Sequence **seq_arr,
+                                         float cfra)
+{
+  memset(inputs, 0, sizeof(*inputs));
+  inputs->context = context;
+  inputs->seq_arr = seq_arr;
+  inputs->cfra = cfra;
+}
+
+static void seq_render_stack_input_task(TaskPool *__restrict pool, void *taskdata)
+{
+  SeqRenderStackInputs *inputs = BLI_task_pool_user_data(pool);
+  const int index = POINTER_AS_INT(taskdata);
+  SeqRenderStackInput *input = &inputs->inputs[index];
+
+  BLI_mutex_lock(&inputs->mutex);
+  const bool claimed = input->claimed;
+  input->claimed = true;
+  BLI_mutex_unlock(&inputs->mutex);
+
+  if (claimed) {
+    return;
+  }
+
+  SeqRenderState state;
+  sequencer_state_init(&state);
+  ImBuf *ibuf = seq_render_strip(inputs->context, &state, inputs->seq_arr[index], inputs->cfra);
+
+  BLI_mutex_lock(&inputs->mutex);
+  input->ibuf = ibuf;
+  input->done = true;
+  BLI_condition_notify_all(&inputs->cond);
+  BLI_mutex_unlock(&inputs->mutex);
+}
+
+/* Start rendering the strip at index in the background when possible. */
+static void seq_render_stack_input_start(SeqRenderStackInputs *inputs, int index)
+{
+  if (!seq_render_strip_is_threadsafe(inputs->seq_arr[index]) ||
+      BLI_task_scheduler_num_threads() < 2) {
+    return;
+  }
+
+  if (inputs->pool == NULL) {
+    BLI_mutex_init(&inputs->mutex);
+    BLI_condition_init(&inputs->cond);
+    inputs->pool = BLI_task_pool_create(inputs, TASK_PRIORITY_HIGH);
+  }
+  BLI_task_pool_push(
+      inputs->pool, seq_render_stack_input_task, POINTER_FROM_INT(index), false, NULL);
+}
+
+/* Rendered strip at index, waits for it when another thread is rendering it. A strip which
+ * hasn't been started yet is rendered right away. */
+static ImBuf *seq_render_stack_input_get(SeqRenderStackInputs *inputs,
+                                         SeqRenderState *state,
+                                         int index)
+{
+  SeqRenderStackInput *input = &inputs->inputs[index];
+  Sequence *seq = inputs->seq_arr[index];
+
+  if (inputs->pool == NULL) {
+    return seq_render_strip(inputs->context, state, seq, inputs->cfra);
+  }
+
+  BLI_mutex_lock(&inputs->mutex);
+  if (!input->claimed) {
+    input->claimed = true;
+    BLI_mutex_unlock(&inputs->mutex);
+    return seq_render_strip(inputs->context, state, seq, inputs->cfra);
+  }
+
+  while (!input->done) {
+    BLI_condition_wait(&inputs->cond, &inputs->mutex);
+  }
+  ImBuf *ibuf = input->ibuf;
+  input->ibuf = NULL;
+  BLI_mutex_unlock(&inputs->mutex);
+
+  return ibuf;
+}
+
+static void seq_render_stack_inputs_free(SeqRenderStackInputs *inputs)
+{
+  if (inputs->pool == NULL) {
+    return;
+  }
+
+  BLI_task_pool_work_and_wait(inputs->pool);
+  BLI_task_pool_free(inputs->pool);
+  BLI_condition_end(&inputs->cond);
+  BLI_mutex_end(&inputs->mutex);
+
+  for (int i = 0; i <= MAXSEQ; i++) {
+    if (inputs->inputs[i].ibuf) {
+      IMB_freeImBuf(inputs->inputs[i].ibuf);
+    }
+  }
+}
+
 static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      SeqRenderState *state,
                                      ListBase *seqbasep,
@@ -3978,6 +4099,9 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     return NULL;
   }
 
+  SeqRenderStackInputs inputs;
+  seq_render_stack_inputs_init(&inputs, context, seq_arr, cfra);
+
   for (i = count - 1; i >= 0; i--) {
     int early_out;
     Sequence *seq = seq_arr[i];
@@ -4020,6 +4144,10 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
           IMB_freeImBuf(ibuf1);
           IMB_freeImBuf(ibuf2);
         }
+        else {
+          /* Blended on top of the strips below, render it while they are rendered. */
+          seq_render_stack_input_start(&inputs, i);
+        }
         break;
     }
     if (out) {
@@ -4034,7 +4162,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
 
     if (seq_get_early_out_for_blend_mode(seq) == EARLY_DO_EFFECT) {
       ImBuf *ibuf1 = out;
-      ImBuf *ibuf2 = seq_render_strip(context, state, seq, cfra);
+      ImBuf *ibuf2 = seq_render_stack_input_get(&inputs, state, i);
 
       out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
 
@@ -4047,9 +4175,37 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
         context, seq_arr[i], cfra, SEQ_CACHE_STORE_COMPOSITE, out, cost, false);
   }
 
+  seq_render_stack_inputs_free(&inputs);
+
   return out;
 }
 
+static void seq_render_lock(const SeqRenderData *context)
+{
+  if (!context->is_prefetch_render) {
+    BLI_mutex_lock(&seq_render_wait_mutex);
+    seq_render_main_waiting++;
+    BLI_mutex_unlock(&seq_render_wait_mutex);
+
+    BLI_rw_mutex_lock(&seq_render_mutex, THREAD_LOCK_WRITE);
+
+    BLI_mutex_lock(&seq_render_wait_mutex);
+    seq_render_main_waiting--;
+    BLI_condition_notify_all(&seq_render_wait_cond);
+    BLI_mutex_unlock(&seq_render_wait_mutex);
+    return;
+  }
+
+  /* Prefetch workers would keep the lock shared all the time, don't let new ones in while main
+   * thread waits. */
+  BLI_mutex_lock(&seq_render_wait_mutex);
+  while (seq_render_main_waiting != 0) {
+    BLI_condition_wait(&seq_render_wait_cond, &seq_render_wait_mutex);
+  }
+  BLI_mutex_unlock(&seq_render_wait_mutex);
+  BLI_rw_mutex_lock(&seq_render_mutex, THREAD_LOCK_READ);
+}
+
 /*
  * returned ImBuf is refed!
  * you have to free after usage!
@@ -4093,7 +4249,7 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
   float cost = 0;
 
   if (count && !out) {
-    BLI_mutex_lock(&seq_render_mutex);
+    seq_render_lock(context);
     out = seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
     cost = seq_estimate_render_cost_end(context->scene, begin);
 
@@ -4105,7 +4261,7 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
       BKE_sequencer_cache_put_if_possible(
           context, seq_arr[count - 1], cfra, SEQ_CACHE_STORE_FINAL_OUT, out, cost, false);
     }
-    BLI_mutex_unlock(&seq_render_mutex);
+    BLI_rw_mutex_unlock(&seq_render_mutex);
   }
 
   BKE_sequencer_prefetch_start(context, cfra, cost);
@@ -410,10 +410,20 @@ static void studiolight_multilayer_addpass(void *base,
   }
 }
 
+static bool studiolight_multilayer_filter_pass(void *UNUSED(base),
+                                               const char *UNUSED(layer_name),
+                                               const char *pass_name,
+                                               const char *UNUSED(chan_id),
+                                               const char *UNUSED(view_name))
+{
+  return STREQ(pass_name, STUDIOLIGHT_PASSNAME_DIFFUSE) ||
+         STREQ(pass_name, STUDIOLIGHT_PASSNAME_SPECULAR);
+}
+
 static void studiolight_load_equirect_image(StudioLight *sl)
 {
   if (sl->flag & STUDIOLIGHT_EXTERNAL_FILE) {
-    ImBuf *ibuf = IMB_loadiffname(sl->path, IB_multilayer, NULL);
+    ImBuf *ibuf = IMB_loadiffname(sl->path, IB_multilayer | IB_multilayer_deferred, NULL);
     ImBuf *specular_ibuf = NULL;
     ImBuf *diffuse_ibuf = NULL;
     const bool failed = (ibuf == NULL);
@@ -425,6 +435,7 @@ static void studiolight_load_equirect_image(StudioLight *sl)
          * the first found 'diffuse' pass will be used for diffuse lighting
          * and the first found 'specular' pass will be used for specular lighting */
         MultilayerConvertContext ctx = {0};
+        IMB_exr_read_passes(ibuf->userdata, &studiolight_multilayer_filter_pass, NULL);
         IMB_exr_multilayer_convert(ibuf->userdata,
                                    &ctx,
                                    &studiolight_multilayer_addview,
@@ -27,6 +27,8 @@
 #include "DNA_meshdata_types.h"
 #include "DNA_modifier_types.h"
 
+#include "BLI_ghash.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "MEM_guardedalloc.h"
@@ -45,8 +47,11 @@ void BKE_subdiv_init()
   openSubdiv_init();
 }
 
+static void topology_refiner_cache_free(void);
+
 void BKE_subdiv_exit()
 {
+  topology_refiner_cache_free();
   openSubdiv_cleanup();
 }
 
@@ -104,16 +109,116 @@ bool BKE_subdiv_settings_equal(const SubdivSettings *settings_a, const SubdivSet
           settings_a->fvar_linear_interpolation == settings_b->fvar_linear_interpolation);
 }
 
-/* ============================== CONSTRUCTION ============================== */
+static bool subdiv_settings_equal_for_topology(const SubdivSettings *settings_a,
+                                               const SubdivSettings *settings_b)
+{
+  return BKE_subdiv_settings_equal(settings_a, settings_b) &&
+         settings_a->use_creases == settings_b->use_creases;
+}
 
-/* Creation from scratch. */
+/* ========================= TOPOLOGY REFINER CACHE ========================= */
 
-Subdiv *BKE_subdiv_new_from_converter(const SubdivSettings *settings,
-                                      struct OpenSubdiv_Converter *converter)
+/* Topology refiners only depend on the coarse mesh topology and the settings, so subdivision
+ * surfaces of meshes with identical topology (linked duplicates, instanced assets) share one
+ * refiner. Entries are reference counted and freed together with their last user.
+ *
+ * Cached refiners are refined for the level and adaptivity of their settings before they are
+ * shared and never change afterwards, so evaluators can be created from them in parallel.
+ *
+ * The hash only finds the candidate entry, the topology is compared with the refiner before
+ * taking one built for another mesh, so a hash collision never gives a mesh the refiner of
+ * another mesh. A subdivision surface keeps its refiner while the hash of its mesh stays. */
+
+typedef struct SubdivTopologyRefinerCacheEntry {
+  /* See BKE_subdiv_converter_mesh_topology_hash(). */
+  uint64_t topology_hash;
+  SubdivSettings settings;
+  int num_users;
+  /* Set once under the cache mutex by the first user which finished building and refining the
+   * refiner. The build itself happens without any lock held, as it uses the task scheduler. */
+  bool is_built;
+  struct OpenSubdiv_TopologyRefiner *topology_refiner;
+} SubdivTopologyRefinerCacheEntry;
+
+static GHash *topology_refiner_cache = NULL;
+static ThreadMutex topology_refiner_cache_mutex = BLI_MUTEX_INITIALIZER;
+
+static uint topology_refiner_cache_entry_hash(const void *key)
+{
+  const SubdivTopologyRefinerCacheEntry *entry = key;
+  return (uint)(entry->topology_hash ^ (entry->topology_hash >> 32));
+}
+
+static bool topology_refiner_cache_entry_cmp(const void *a, const void *b)
+{
+  const SubdivTopologyRefinerCacheEntry *entry_a = a;
+  const SubdivTopologyRefinerCacheEntry *entry_b = b;
+  return !(entry_a->topology_hash == entry_b->topology_hash &&
+           subdiv_settings_equal_for_topology(&entry_a->settings, &entry_b->settings));
+}
+
+static SubdivTopologyRefinerCacheEntry *topology_refiner_cache_acquire(
+    const SubdivSettings *settings, const uint64_t topology_hash)
+{
+  SubdivTopologyRefinerCacheEntry key = {
+      .topology_hash = topology_hash,
+      .settings = *settings,
+  };
+  BLI_mutex_lock(&topology_refiner_cache_mutex);
+  if (topology_refiner_cache == NULL) {
+    topology_refiner_cache = BLI_ghash_new(
+        topology_refiner_cache_entry_hash, topology_refiner_cache_entry_cmp, __func__);
+  }
+  SubdivTopologyRefinerCacheEntry *entry = BLI_ghash_lookup(topology_refiner_cache, &key);
+  if (entry == NULL) {
+    entry = MEM_callocN(sizeof(*entry), __func__);
+    entry->topology_hash = topology_hash;
+    entry->settings = *settings;
+    BLI_ghash_insert(topology_refiner_cache, entry, entry);
+  }
+  entry->num_users++;
+  BLI_mutex_unlock(&topology_refiner_cache_mutex);
+  return entry;
+}
+
+static void topology_refiner_cache_entry_free(SubdivTopologyRefinerCacheEntry *entry)
+{
+  if (entry->topology_refiner != NULL) {
+    openSubdiv_deleteTopologyRefiner(entry->topology_refiner);
+  }
+  MEM_freeN(entry);
+}
+
+static void topology_refiner_cache_release(SubdivTopologyRefinerCacheEntry *entry)
+{
+  BLI_mutex_lock(&topology_refiner_cache_mutex);
+  BLI_assert(entry->num_users > 0);
+  const bool is_last_user = (--entry->num_users == 0);
+  if (is_last_user) {
+    BLI_ghash_remove(topology_refiner_cache, entry, NULL, NULL);
+  }
+  BLI_mutex_unlock(&topology_refiner_cache_mutex);
+  if (is_last_user) {
+    topology_refiner_cache_entry_free(entry);
+  }
+}
+
+static void topology_refiner_cache_free(void)
+{
+  if (topology_refiner_cache == NULL) {
+    return;
+  }
+  /* All subdivision surfaces are expected to be freed by now. */
+  BLI_assert(BLI_ghash_len(topology_refiner_cache) == 0);
+  BLI_ghash_free(topology_refiner_cache, NULL, NULL);
+  topology_refiner_cache = NULL;
+}
+
+/* ============================== CONSTRUCTION ============================== */
+
+static struct OpenSubdiv_TopologyRefiner *subdiv_topology_refiner_create(
+    const SubdivSettings *settings, struct OpenSubdiv_Converter *converter)
 {
-  SubdivStats stats;
-  BKE_subdiv_stats_init(&stats);
-  BKE_subdiv_stats_begin(&stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
   OpenSubdiv_TopologyRefinerSettings topology_refiner_settings;
   topology_refiner_settings.level = settings->level;
   topology_refiner_settings.is_adaptive = settings->is_adaptive;
@@ -127,6 +232,19 @@ Subdiv *BKE_subdiv_new_from_converter(const SubdivSettings *settings,
      * The thing here is: OpenSubdiv can only deal with faces, but our
      * side of subdiv also deals with loose vertices and edges. */
   }
+  return osd_topology_refiner;
+}
+
+/* Creation from scratch. */
+
+Subdiv *BKE_subdiv_new_from_converter(const SubdivSettings *settings,
+                                      struct OpenSubdiv_Converter *converter)
+{
+  SubdivStats stats;
+  BKE_subdiv_stats_init(&stats);
+  BKE_subdiv_stats_begin(&stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
+  struct OpenSubdiv_TopologyRefiner *osd_topology_refiner = subdiv_topology_refiner_create(
+      settings, converter);
   Subdiv *subdiv = MEM_callocN(sizeof(Subdiv), "subdiv from converetr");
   subdiv->settings = *settings;
   subdiv->topology_refiner = osd_topology_refiner;
@@ -181,13 +299,119 @@ Subdiv *BKE_subdiv_update_from_converter(Subdiv *subdiv,
   return BKE_subdiv_new_from_converter(settings, converter);
 }
 
+/* Full comparison of the mesh topology with a refiner, see #BKE_subdiv_update_from_converter. */
+static bool subdiv_topology_refiner_matches(SubdivStats *stats,
+                                            struct OpenSubdiv_TopologyRefiner *topology_refiner,
+                                            struct OpenSubdiv_Converter *converter)
+{
+  bool matches;
+  BKE_subdiv_stats_begin(stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+  if (topology_refiner != NULL) {
+    matches = openSubdiv_topologyRefinerCompareWithConverter(topology_refiner, converter);
+  }
+  else {
+    /* No refiner is created for meshes without faces. */
+    matches = (converter->getNumVertices(converter) == 0);
+  }
+  BKE_subdiv_stats_end(stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+  return matches;
+}
+
+/* Create subdivision surface which uses the topology refiner from the cache,
+ * building it if no other subdivision surface uses the same topology. */
+static Subdiv *subdiv_new_from_mesh_cached(const SubdivSettings *settings,
+                                           struct OpenSubdiv_Converter *converter,
+                                           const uint64_t topology_hash,
+                                           SubdivStats *stats)
+{
+  SubdivTopologyRefinerCacheEntry *entry = topology_refiner_cache_acquire(settings,
+                                                                          topology_hash);
+  struct OpenSubdiv_TopologyRefiner *topology_refiner = NULL;
+  bool is_built;
+
+  BLI_mutex_lock(&topology_refiner_cache_mutex);
+  is_built = entry->is_built;
+  BLI_mutex_unlock(&topology_refiner_cache_mutex);
+
+  if (!is_built) {
+    /* Several users of the same topology may build at the same time, the first one to finish
+     * is kept. This avoids waiting on a lock while the build uses the task scheduler. */
+    BKE_subdiv_stats_begin(stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
+    topology_refiner = subdiv_topology_refiner_create(settings, converter);
+    if (topology_refiner != NULL) {
+      openSubdiv_topologyRefinerRefine(topology_refiner);
+    }
+    BKE_subdiv_stats_end(stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
+
+    BLI_mutex_lock(&topology_refiner_cache_mutex);
+    if (!entry->is_built) {
+      entry->topology_refiner = topology_refiner;
+      entry->is_built = true;
+      topology_refiner = NULL;
+      is_built = false;
+    }
+    else {
+      is_built = true;
+    }
+    BLI_mutex_unlock(&topology_refiner_cache_mutex);
+  }
+
+  /* The entry was built from another mesh with the same hash, check it really matches. */
+  if (is_built && !subdiv_topology_refiner_matches(stats, entry->topology_refiner, converter)) {
+    topology_refiner_cache_release(entry);
+    entry = NULL;
+    if (topology_refiner == NULL) {
+      BKE_subdiv_stats_begin(stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
+      topology_refiner = subdiv_topology_refiner_create(settings, converter);
+      BKE_subdiv_stats_end(stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
+    }
+  }
+  else if (topology_refiner != NULL) {
+    openSubdiv_deleteTopologyRefiner(topology_refiner);
+    topology_refiner = NULL;
+  }
+
+  Subdiv *subdiv = MEM_callocN(sizeof(Subdiv), "subdiv from cache");
+  subdiv->settings = *settings;
+  if (entry != NULL) {
+    subdiv->topology_refiner = entry->topology_refiner;
+    subdiv->topology_refiner_cache_entry = entry;
+  }
+  else {
+    /* Hash collision, the refiner is owned by this subdivision surface. */
+    subdiv->topology_refiner = topology_refiner;
+  }
+  subdiv->stats = *stats;
+  return subdiv;
+}
+
 Subdiv *BKE_subdiv_update_from_mesh(Subdiv *subdiv,
                                     const SubdivSettings *settings,
                                     const Mesh *mesh)
 {
+  /* The hash allows to find refiners of other meshes with the same topology. */
+  SubdivStats stats;
+  BKE_subdiv_stats_init(&stats);
+  BKE_subdiv_stats_begin(&stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+  const uint64_t topology_hash = BKE_subdiv_converter_mesh_topology_hash(settings, mesh);
+  BKE_subdiv_stats_end(&stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+
+  if (subdiv != NULL && subdiv->topology_refiner_cache_entry != NULL) {
+    /* The refiner was compared with the mesh when it was taken, only the hash is checked. */
+    const SubdivTopologyRefinerCacheEntry *entry = subdiv->topology_refiner_cache_entry;
+    if (entry->topology_hash == topology_hash &&
+        subdiv_settings_equal_for_topology(&entry->settings, settings)) {
+      subdiv->stats.topology_compare_time = stats.topology_compare_time;
+      return subdiv;
+    }
+  }
+  if (subdiv != NULL) {
+    BKE_subdiv_free(subdiv);
+  }
+
   OpenSubdiv_Converter converter;
   BKE_subdiv_converter_init_for_mesh(&converter, settings, mesh);
-  subdiv = BKE_subdiv_update_from_converter(subdiv, settings, &converter);
+  subdiv = subdiv_new_from_mesh_cached(settings, &converter, topology_hash, &stats);
   BKE_subdiv_converter_free(&converter);
   return subdiv;
 }
@@ -199,7 +423,10 @@ void BKE_subdiv_free(Subdiv *subdiv)
   if (subdiv->evaluator != NULL) {
     openSubdiv_deleteEvaluator(subdiv->evaluator);
   }
-  if (subdiv->topology_refiner != NULL) {
+  if (subdiv->topology_refiner_cache_entry != NULL) {
+    topology_refiner_cache_release(subdiv->topology_refiner_cache_entry);
+  }
+  else if (subdiv->topology_refiner != NULL) {
     openSubdiv_deleteTopologyRefiner(subdiv->topology_refiner);
   }
   BKE_subdiv_displacement_detach(subdiv);
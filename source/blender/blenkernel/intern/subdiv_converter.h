@@ -38,6 +38,11 @@ void BKE_subdiv_converter_init_for_mesh(struct OpenSubdiv_Converter *converter,
                                         const struct SubdivSettings *settings,
                                         const struct Mesh *mesh);
 
+/* Hash of everything the mesh converter passes to the topology refiner: topology, creases,
+ * UV layers and settings. Meshes with the same hash can share a topology refiner. */
+uint64_t BKE_subdiv_converter_mesh_topology_hash(const struct SubdivSettings *settings,
+                                                 const struct Mesh *mesh);
+
 /* NOTE: Frees converter data, but not converter itself. This means, that if
  * converter was allocated on heap, it is up to the user to free that memory. */
 void BKE_subdiv_converter_free(struct OpenSubdiv_Converter *converter);
@@ -29,6 +29,8 @@
 #include "DNA_meshdata_types.h"
 
 #include "BLI_bitmap.h"
+#include "BLI_hash.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_customdata.h"
@@ -37,6 +39,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "opensubdiv_capi.h"
 #include "opensubdiv_converter_capi.h"
 
@@ -345,23 +349,48 @@ static void initialize_manifold_index_array(const BLI_bitmap *used_map,
   *num_manifold_elements_r = num_elements - offset;
 }
 
+typedef struct ManifoldUsedMapData {
+  const MPoly *mpoly;
+  const MLoop *mloop;
+  BLI_bitmap *vert_used_map;
+  BLI_bitmap *edge_used_map;
+} ManifoldUsedMapData;
+
+BLI_INLINE void bitmap_enable_atomic(BLI_bitmap *bitmap, const unsigned int index)
+{
+  atomic_fetch_and_or_uint32(&bitmap[index >> _BITMAP_POWER], 1u << (index & _BITMAP_MASK));
+}
+
+static void manifold_used_map_cb(void *__restrict userdata,
+                                 const int poly_index,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ManifoldUsedMapData *data = userdata;
+  const MPoly *poly = &data->mpoly[poly_index];
+  for (int corner = 0; corner < poly->totloop; corner++) {
+    const MLoop *loop = &data->mloop[poly->loopstart + corner];
+    bitmap_enable_atomic(data->vert_used_map, loop->v);
+    bitmap_enable_atomic(data->edge_used_map, loop->e);
+  }
+}
+
 static void initialize_manifold_indices(ConverterStorage *storage)
 {
   const Mesh *mesh = storage->mesh;
   const MEdge *medge = mesh->medge;
-  const MLoop *mloop = mesh->mloop;
-  const MPoly *mpoly = mesh->mpoly;
   /* Set bits of elements which are not loose. */
   BLI_bitmap *vert_used_map = BLI_BITMAP_NEW(mesh->totvert, "vert used map");
   BLI_bitmap *edge_used_map = BLI_BITMAP_NEW(mesh->totedge, "edge used map");
-  for (int poly_index = 0; poly_index < mesh->totpoly; poly_index++) {
-    const MPoly *poly = &mpoly[poly_index];
-    for (int corner = 0; corner < poly->totloop; corner++) {
-      const MLoop *loop = &mloop[poly->loopstart + corner];
-      BLI_BITMAP_ENABLE(vert_used_map, loop->v);
-      BLI_BITMAP_ENABLE(edge_used_map, loop->e);
-    }
-  }
+  ManifoldUsedMapData used_map_data = {
+      .mpoly = mesh->mpoly,
+      .mloop = mesh->mloop,
+      .vert_used_map = vert_used_map,
+      .edge_used_map = edge_used_map,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 4096;
+  BLI_task_parallel_range(0, mesh->totpoly, &used_map_data, manifold_used_map_cb, &settings);
   initialize_manifold_index_array(vert_used_map,
                                   mesh->totvert,
                                   &storage->manifold_vertex_index,
@@ -405,3 +434,57 @@ void BKE_subdiv_converter_init_for_mesh(struct OpenSubdiv_Converter *converter,
   init_functions(converter);
   init_user_data(converter, settings, mesh);
 }
+
+static uint64_t topology_hash_step_float(uint64_t hash, const float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return BLI_hash_fnv1a_64_step(hash, bits);
+}
+
+uint64_t BKE_subdiv_converter_mesh_topology_hash(const SubdivSettings *settings,
+                                                 const Mesh *mesh)
+{
+  uint64_t hash = BLI_HASH_FNV1A_64_INIT;
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)settings->is_simple);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)settings->is_adaptive);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)settings->level);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)settings->use_creases);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)settings->vtx_boundary_interpolation);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)settings->fvar_linear_interpolation);
+
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mesh->totvert);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mesh->totedge);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mesh->totloop);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mesh->totpoly);
+
+  const MEdge *medge = mesh->medge;
+  for (int i = 0; i < mesh->totedge; i++) {
+    hash = BLI_hash_fnv1a_64_step(hash, medge[i].v1);
+    hash = BLI_hash_fnv1a_64_step(hash, medge[i].v2);
+    if (settings->use_creases) {
+      hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)medge[i].crease);
+    }
+  }
+  const MLoop *mloop = mesh->mloop;
+  for (int i = 0; i < mesh->totloop; i++) {
+    hash = BLI_hash_fnv1a_64_step(hash, mloop[i].v);
+    hash = BLI_hash_fnv1a_64_step(hash, mloop[i].e);
+  }
+  const MPoly *mpoly = mesh->mpoly;
+  for (int i = 0; i < mesh->totpoly; i++) {
+    hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mpoly[i].loopstart);
+    hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)mpoly[i].totloop);
+  }
+  /* Face-varying topology is derived from UV coordinates being equal. */
+  const int num_uv_layers = CustomData_number_of_layers(&mesh->ldata, CD_MLOOPUV);
+  hash = BLI_hash_fnv1a_64_step(hash, (uint32_t)num_uv_layers);
+  for (int layer_index = 0; layer_index < num_uv_layers; layer_index++) {
+    const MLoopUV *mloopuv = CustomData_get_layer_n(&mesh->ldata, CD_MLOOPUV, layer_index);
+    for (int i = 0; i < mesh->totloop; i++) {
+      hash = topology_hash_step_float(hash, mloopuv[i].uv[0]);
+      hash = topology_hash_step_float(hash, mloopuv[i].uv[1]);
+    }
+  }
+  return hash;
+}
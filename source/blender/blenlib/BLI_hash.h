@@ -88,6 +88,14 @@ BLI_INLINE void BLI_hash_pointer_to_color(const void *ptr, int *r, int *g, int *
   *b = hash & 0x0000ff;
 }
 
+#define BLI_HASH_FNV1A_64_INIT 0xcbf29ce484222325ULL
+
+/* 64 bit FNV-1a step on a 32 bit word, start from #BLI_HASH_FNV1A_64_INIT. */
+BLI_INLINE uint64_t BLI_hash_fnv1a_64_step(uint64_t hash, const uint32_t value)
+{
+  return (hash ^ value) * 0x100000001b3ULL;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -151,6 +151,8 @@ void BLI_ticket_mutex_unlock(TicketMutex *ticket);
 
 typedef pthread_cond_t ThreadCondition;
 
+#define BLI_CONDITION_INITIALIZER PTHREAD_COND_INITIALIZER
+
 void BLI_condition_init(ThreadCondition *cond);
 void BLI_condition_wait(ThreadCondition *cond, ThreadMutex *mutex);
 void BLI_condition_wait_global_mutex(ThreadCondition *cond, const int type);
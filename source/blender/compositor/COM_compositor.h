@@ -112,12 +112,13 @@ extern "C" {
  *  - [@ref OrderOfChunks.COM_TO_RULE_OF_THIRDS]:
  *    Experimental order based on 9 hot-spots in the image.
  *
- * When the chunk-order is determined, the first few chunks will be checked if they can be scheduled.
+ * When the chunk-order is determined, all chunks are scheduled in that order.
  * Chunks can have three states:
  *  - [@ref ChunkExecutionState.COM_ES_NOT_SCHEDULED]:
- *    Chunk is not yet scheduled, or dependencies are not met.
+ *    Chunk is not yet scheduled.
  *  - [@ref ChunkExecutionState.COM_ES_SCHEDULED]:
- *    All dependencies are met, chunk is scheduled, but not finished.
+ *    Chunk is scheduled, but not finished. It is added to the WorkScheduler when the chunks it
+ *    depends on are finished.
  *  - [@ref ChunkExecutionState.COM_ES_EXECUTED]:
  *    Chunk is finished.
  *
@@ -128,7 +129,7 @@ extern "C" {
  * \section interest Area of interest
  * An ExecutionGroup can have dependencies to other ExecutionGroup's.
  * Data passing from one ExecutionGroup to another one are stored in 'chunks'.
- * If not all input chunks are available the chunk execution will not be scheduled.
+ * A chunk is not executed before all its input chunks are available.
  * <pre>
  * +-------------------------------------+              +--------------------------------------+
  * | ExecutionGroup A                    |              | ExecutionGroup B                     |
@@ -158,8 +159,11 @@ extern "C" {
  * The relevant ExecutionGroup (that can calculate the missing chunks; ExecutionGroup A)
  * is asked to calculate the area ExecutionGroup B is missing.
  * [@ref ExecutionGroup.scheduleAreaWhenPossible]
- * ExecutionGroup B checks what chunks the area spans, and tries to schedule these chunks.
- * If all input data is available these chunks are scheduled [@ref ExecutionGroup.scheduleChunk]
+ * ExecutionGroup A checks what chunks the area spans, schedules these chunks and remembers that
+ * the chunk of ExecutionGroup B waits for them.
+ * Chunks without missing input are added to the WorkScheduler [@ref ExecutionGroup.scheduleChunk]
+ * When a chunk is finished, the waiting chunks of which it was the last missing input are added
+ * to the WorkScheduler [@ref ExecutionGroup.finalizeChunkExecution]
  *
  * <pre>
  *
@@ -222,10 +226,10 @@ extern "C" {
  *
  * \see ExecutionGroup.execute Execute a complete ExecutionGroup.
  * Halts until finished or breaked by user
- * \see ExecutionGroup.scheduleChunkWhenPossible Tries to schedule a single chunk,
- * checks if all input data is available. Can trigger dependent chunks to be calculated
+ * \see ExecutionGroup.scheduleChunkWhenPossible Schedules a single chunk,
+ * and the input chunks it depends on
  * \see ExecutionGroup.scheduleAreaWhenPossible
- * Tries to schedule an area. This can be multiple chunks
+ * Schedules an area. This can be multiple chunks
  * (is called from [@ref ExecutionGroup.scheduleChunkWhenPossible])
  * \see ExecutionGroup.scheduleChunk Schedule a chunk on the WorkScheduler
  * \see NodeOperation.determineDependingAreaOfInterest Influence the area of interest of a chunk.
@@ -238,11 +242,16 @@ extern "C" {
  * \section workscheduler WorkScheduler
  * the WorkScheduler is implemented as a static class. the responsibility of the WorkScheduler
  * is to balance WorkPackages to the available and free devices.
- * the work-scheduler can work in 2 states.
+ * the work-scheduler can work in 3 states.
  * For witching these between the state you need to recompile blender
  *
  * \subsection multithread Multi threaded
- * Default the work-scheduler will place all work as WorkPackage in a queue.
+ * Default the work-scheduler will push every WorkPackage as a task in a BLI_task pool.
+ * The threads of the task scheduler execute the tasks, every thread has its own CPUDevice.
+ * Idle threads steal tasks from busy ones, and work scheduled by a finishing task is usually
+ * executed by the same thread while its input is still in the cache.
+ *
+ * With COM_TM_QUEUE the work-scheduler places all work as WorkPackage in a queue.
  * For every CPUcore a working thread is created.
  * These working threads will ask the WorkScheduler if there is work
  * for a specific Device.
@@ -348,6 +357,24 @@ void COM_execute(RenderData *rd,
                  const ColorManagedDisplaySettings *displaySettings,
                  const char *viewName);
 
+/**
+ * \brief Execute the compositor \a iterations times for benchmarking.
+ *
+ * Executes like COM_execute during rendering and writes the time of every execution, the
+ * timing of its execution groups and operations and the buffer memory used as JSON to
+ * \a filepath.
+ * \return false when the report can't be written.
+ * \see ExecutionStatistics
+ */
+bool COM_benchmark(RenderData *rd,
+                   Scene *scene,
+                   bNodeTree *editingtree,
+                   int iterations,
+                   const ColorManagedViewSettings *viewSettings,
+                   const ColorManagedDisplaySettings *displaySettings,
+                   const char *viewName,
+                   const char *filepath);
+
 /**
  * \brief Deinitialize the compositor caches and allocated memory.
  * Use COM_clearCaches to only free the caches.
@@ -59,6 +59,18 @@ typedef enum CompositorPriority {
   COM_PRIORITY_LOW = 0,
 } CompositorPriority;
 
+/**
+ * \brief Possible execution models
+ * \see CompositorContext.getExecutionModel
+ * \ingroup Execution
+ */
+typedef enum CompositorExecutionModel {
+  /** \brief Output operations pull chunks of pixels from their inputs */
+  COM_EXECUTION_MODEL_TILED = 0,
+  /** \brief Operations are executed one at a time from inputs to outputs, on full frames */
+  COM_EXECUTION_MODEL_FULL_FRAME = 1,
+} CompositorExecutionModel;
+
 // configurable items
 
 // chunk size determination
@@ -69,10 +81,17 @@ typedef enum CompositorPriority {
 // workscheduler threading models
 /**
  * COM_TM_QUEUE is a multi-threaded model, which uses the BLI_thread_queue pattern.
- * This is the default option.
+ * A thread per CPUDevice pops work from one shared queue.
  */
 #define COM_TM_QUEUE 1
 
+/**
+ * COM_TM_TASK is a multi-threaded model, which uses the BLI_task scheduler.
+ * Chunks are executed as tasks by the threads of the task scheduler, which steal work from each
+ * other. This is the default option when building with TBB.
+ */
+#define COM_TM_TASK 2
+
 /**
  * COM_TM_NOTHREAD is a single threading model, everything is executed in the caller thread.
  * easy for debugging
@@ -80,9 +99,14 @@ typedef enum CompositorPriority {
 #define COM_TM_NOTHREAD 0
 
 /**
- * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_QUEUE is currently default.
+ * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_TASK is currently default.
+ * Without TBB task pools run their tasks in the thread waiting for them, COM_TM_QUEUE is used.
  */
-#define COM_CURRENT_THREADING_MODEL COM_TM_QUEUE
+#ifdef WITH_TBB
+#  define COM_CURRENT_THREADING_MODEL COM_TM_TASK
+#else
+#  define COM_CURRENT_THREADING_MODEL COM_TM_QUEUE
+#endif
 // chunk order
 /**
  * \brief The order of chunks to be scheduled
@@ -109,4 +133,16 @@ typedef enum OrderOfChunks {
 
 #define COM_BLUR_BOKEH_PIXELS 512
 
+/**
+ * Maximum number of pixels a row-based operation processes at once,
+ * see #SocketReader::executeRow.
+ */
+#define COM_ROW_SPAN_LENGTH 256
+
+/**
+ * Maximum size in bytes of a #ResultCacheKey, keys contain the keys of their inputs and grow
+ * quickly when results are read through many paths. Larger results are not cached.
+ */
+#define COM_RESULT_CACHE_KEY_MAX_SIZE (256 * 1024)
+
 #endif /* __COM_DEFINES_H__ */
@@ -17,6 +17,9 @@
  */
 
 #include "COM_CPUDevice.h"
+#include "COM_ExecutionStatistics.h"
+
+#include "PIL_time.h"
 
 CPUDevice::CPUDevice(int thread_id) : Device(), m_thread_id(thread_id)
 {
@@ -27,10 +30,14 @@ void CPUDevice::execute(WorkPackage *work)
   const unsigned int chunkNumber = work->getChunkNumber();
   ExecutionGroup *executionGroup = work->getExecutionGroup();
   rcti rect;
+  const double start_time = ExecutionStatistics::isEnabled() ? PIL_check_seconds_timer() : 0.0;
 
   executionGroup->determineChunkRect(&rect, chunkNumber);
 
   executionGroup->getOutputOperation()->executeRegion(&rect, chunkNumber);
 
+  if (ExecutionStatistics::isEnabled()) {
+    ExecutionStatistics::chunkExecuted(executionGroup, PIL_check_seconds_timer() - start_time);
+  }
   executionGroup->finalizeChunkExecution(chunkNumber, NULL);
 }
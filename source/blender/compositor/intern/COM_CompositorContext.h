@@ -256,6 +256,11 @@ class CompositorContext {
     return this->getbNodeTree()->chunksize;
   }
 
+  CompositorExecutionModel getExecutionModel() const
+  {
+    return (CompositorExecutionModel)this->getbNodeTree()->execution_mode;
+  }
+
   void setFastCalculation(bool fastCalculation)
   {
     this->m_fastCalculation = fastCalculation;
@@ -26,6 +26,7 @@
 #include "COM_ChunkOrder.h"
 #include "COM_Debug.h"
 #include "COM_ExecutionGroup.h"
+#include "COM_ExecutionStatistics.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_ReadBufferOperation.h"
 #include "COM_ViewerOperation.h"
@@ -46,6 +47,8 @@ ExecutionGroup::ExecutionGroup()
   this->m_isOutput = false;
   this->m_complex = false;
   this->m_chunkExecutionStates = NULL;
+  this->m_chunkDependencies = NULL;
+  this->m_chunkDependents = NULL;
   this->m_bTree = NULL;
   this->m_height = 0;
   this->m_width = 0;
@@ -59,6 +62,12 @@ ExecutionGroup::ExecutionGroup()
   this->m_chunksFinished = 0;
   BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
   this->m_executionStartTime = 0;
+  BLI_spin_init(&this->m_chunksLock);
+}
+
+ExecutionGroup::~ExecutionGroup()
+{
+  BLI_spin_end(&this->m_chunksLock);
 }
 
 CompositorPriority ExecutionGroup::getRenderPriotrity()
@@ -123,17 +132,24 @@ void ExecutionGroup::initExecution()
 {
   if (this->m_chunkExecutionStates != NULL) {
     MEM_freeN(this->m_chunkExecutionStates);
+    MEM_freeN(this->m_chunkDependencies);
+    delete[] this->m_chunkDependents;
   }
   unsigned int index;
   determineNumberOfChunks();
 
   this->m_chunkExecutionStates = NULL;
+  this->m_chunkDependencies = NULL;
+  this->m_chunkDependents = NULL;
   if (this->m_numberOfChunks != 0) {
     this->m_chunkExecutionStates = (ChunkExecutionState *)MEM_mallocN(
         sizeof(ChunkExecutionState) * this->m_numberOfChunks, __func__);
     for (index = 0; index < this->m_numberOfChunks; index++) {
       this->m_chunkExecutionStates[index] = COM_ES_NOT_SCHEDULED;
     }
+    this->m_chunkDependencies = (unsigned int *)MEM_callocN(
+        sizeof(unsigned int) * this->m_numberOfChunks, __func__);
+    this->m_chunkDependents = new vector<ChunkDependent>[this->m_numberOfChunks];
   }
 
   unsigned int maxNumber = 0;
@@ -155,6 +171,10 @@ void ExecutionGroup::deinitExecution()
   if (this->m_chunkExecutionStates != NULL) {
     MEM_freeN(this->m_chunkExecutionStates);
     this->m_chunkExecutionStates = NULL;
+    MEM_freeN(this->m_chunkDependencies);
+    this->m_chunkDependencies = NULL;
+    delete[] this->m_chunkDependents;
+    this->m_chunkDependents = NULL;
   }
   this->m_numberOfChunks = 0;
   this->m_numberOfXChunks = 0;
@@ -322,49 +342,24 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
   DebugInfo::execution_group_started(this);
   DebugInfo::graphviz(graph);
 
-  bool breaked = false;
-  bool finished = false;
-  unsigned int startIndex = 0;
-  const int maxNumberEvaluated = BLI_system_thread_count() * 2;
-
-  while (!finished && !breaked) {
-    bool startEvaluated = false;
-    finished = true;
-    int numberEvaluated = 0;
-
-    for (index = startIndex;
-         index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated;
-         index++) {
-      chunkNumber = chunkOrder[index];
-      int yChunk = chunkNumber / this->m_numberOfXChunks;
-      int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
-      const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
-      if (state == COM_ES_NOT_SCHEDULED) {
-        scheduleChunkWhenPossible(graph, xChunk, yChunk);
-        finished = false;
-        startEvaluated = true;
-        numberEvaluated++;
-
-        if (bTree->update_draw) {
-          bTree->update_draw(bTree->udh);
-        }
-      }
-      else if (state == COM_ES_SCHEDULED) {
-        finished = false;
-        startEvaluated = true;
-        numberEvaluated++;
-      }
-      else if (state == COM_ES_EXECUTED && !startEvaluated) {
-        startIndex = index + 1;
-      }
-    }
-
-    WorkScheduler::finish();
+  /* Chunks are executed as soon as their input is available, in about the order they are
+   * scheduled in. The WorkScheduler is busy with the first chunks while the others are being
+   * scheduled. */
+  for (index = 0; index < this->m_numberOfChunks; index++) {
+    chunkNumber = chunkOrder[index];
+    int yChunk = chunkNumber / this->m_numberOfXChunks;
+    int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
+    scheduleChunkWhenPossible(graph, xChunk, yChunk);
 
     if (bTree->test_break && bTree->test_break(bTree->tbh)) {
-      breaked = true;
+      break;
     }
   }
+
+  WorkScheduler::finish();
+
+  ExecutionStatistics::groupExecuted(this,
+                                     PIL_check_seconds_timer() - this->m_executionStartTime);
   DebugInfo::execution_group_finished(this);
   DebugInfo::graphviz(graph);
 
@@ -405,9 +400,20 @@ MemoryBuffer *ExecutionGroup::constructConsolidatedMemoryBuffer(MemoryProxy *mem
 
 void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers)
 {
+  vector<ChunkDependent> dependents;
+  BLI_spin_lock(&this->m_chunksLock);
   if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED) {
     this->m_chunkExecutionStates[chunkNumber] = COM_ES_EXECUTED;
   }
+  dependents.swap(this->m_chunkDependents[chunkNumber]);
+  BLI_spin_unlock(&this->m_chunksLock);
+
+  /* No new work when the user breaks, the WorkScheduler finishes with the chunks in progress. */
+  if (!this->getOutputOperation()->isBraked()) {
+    for (unsigned int index = 0; index < dependents.size(); index++) {
+      dependents[index].group->scheduleChunk(dependents[index].chunkNumber);
+    }
+  }
 
   atomic_add_and_fetch_u(&this->m_chunksFinished, 1);
   if (memoryBuffers) {
@@ -435,6 +441,10 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
                  this->m_chunksFinished,
                  this->m_numberOfChunks);
     this->m_bTree->stats_draw(this->m_bTree->sdh, buf);
+
+    if (this->m_bTree->update_draw) {
+      this->m_bTree->update_draw(this->m_bTree->udh);
+    }
   }
 }
 
@@ -481,10 +491,15 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int /*chunkNumber*/, rcti *re
   return NULL;
 }
 
-bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
+void ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph,
+                                              rcti *area,
+                                              ExecutionGroup *dependent,
+                                              unsigned int dependentChunk)
 {
   if (this->m_singleThreaded) {
-    return scheduleChunkWhenPossible(graph, 0, 0);
+    scheduleChunkWhenPossible(graph, 0, 0);
+    addChunkDependent(0, dependent, dependentChunk);
+    return;
   }
   // find all chunks inside the rect
   // determine minxchunk, minychunk, maxxchunk, maxychunk where x and y are chunknumbers
@@ -503,55 +518,64 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
   maxxchunk = min_ii(maxxchunk, (int)m_numberOfXChunks);
   maxychunk = min_ii(maxychunk, (int)m_numberOfYChunks);
 
-  bool result = true;
   for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
     for (indexy = minychunk; indexy < maxychunk; indexy++) {
-      if (!scheduleChunkWhenPossible(graph, indexx, indexy)) {
-        result = false;
-      }
+      scheduleChunkWhenPossible(graph, indexx, indexy);
+      addChunkDependent(indexy * this->m_numberOfXChunks + indexx, dependent, dependentChunk);
     }
   }
+}
 
-  return result;
+void ExecutionGroup::addChunkDependent(unsigned int chunkNumber,
+                                       ExecutionGroup *dependent,
+                                       unsigned int dependentChunk)
+{
+  BLI_spin_lock(&this->m_chunksLock);
+  if (this->m_chunkExecutionStates[chunkNumber] != COM_ES_EXECUTED) {
+    /* Counted while locked, the chunk can't finish and release the dependent before. */
+    atomic_add_and_fetch_u(&dependent->m_chunkDependencies[dependentChunk], 1);
+    ChunkDependent chunkDependent = {dependent, dependentChunk};
+    this->m_chunkDependents[chunkNumber].push_back(chunkDependent);
+  }
+  BLI_spin_unlock(&this->m_chunksLock);
 }
 
-bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
+void ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
 {
-  if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
-    this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
+  if (atomic_sub_and_fetch_u(&this->m_chunkDependencies[chunkNumber], 1) == 0) {
     WorkScheduler::schedule(this, chunkNumber);
-    return true;
   }
-  return false;
 }
 
-bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
+void ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
 {
   if (xChunk < 0 || xChunk >= (int)this->m_numberOfXChunks) {
-    return true;
+    return;
   }
   if (yChunk < 0 || yChunk >= (int)this->m_numberOfYChunks) {
-    return true;
+    return;
   }
   int chunkNumber = yChunk * this->m_numberOfXChunks + xChunk;
-  // chunk is already executed
-  if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_EXECUTED) {
-    return true;
-  }
 
-  // chunk is scheduled, but not executed
-  if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED) {
-    return false;
+  // chunk is already scheduled or executed.
+  BLI_spin_lock(&this->m_chunksLock);
+  if (this->m_chunkExecutionStates[chunkNumber] != COM_ES_NOT_SCHEDULED) {
+    BLI_spin_unlock(&this->m_chunksLock);
+    return;
   }
+  this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
+  BLI_spin_unlock(&this->m_chunksLock);
+
+  /* Hold the chunk back until all chunks it depends on are known, chunks scheduled first may
+   * already be finished. */
+  this->m_chunkDependencies[chunkNumber] = 1;
 
-  // chunk is nor executed nor scheduled.
   vector<MemoryProxy *> memoryProxies;
   this->determineDependingMemoryProxies(&memoryProxies);
 
   rcti rect;
   determineChunkRect(&rect, xChunk, yChunk);
   unsigned int index;
-  bool canBeExecuted = true;
   rcti area;
 
   for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
@@ -563,20 +587,14 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
     ExecutionGroup *group = memoryProxy->getExecutor();
 
     if (group != NULL) {
-      if (!group->scheduleAreaWhenPossible(graph, &area)) {
-        canBeExecuted = false;
-      }
+      group->scheduleAreaWhenPossible(graph, &area, this, chunkNumber);
     }
     else {
       throw "ERROR";
     }
   }
 
-  if (canBeExecuted) {
-    scheduleChunk(chunkNumber);
-  }
-
-  return false;
+  scheduleChunk(chunkNumber);
 }
 
 void ExecutionGroup::determineDependingAreaOfInterest(rcti *input,
@@ -24,6 +24,7 @@
 #endif
 
 #include "BLI_rect.h"
+#include "BLI_threads.h"
 #include "COM_CompositorContext.h"
 #include "COM_Device.h"
 #include "COM_MemoryProxy.h"
@@ -49,6 +50,7 @@ typedef enum ChunkExecutionState {
   COM_ES_NOT_SCHEDULED = 0,
   /**
    * \brief chunk is scheduled, but not yet executed
+   * \note the chunk may still wait for the chunks it depends on
    */
   COM_ES_SCHEDULED = 1,
   /**
@@ -159,6 +161,31 @@ class ExecutionGroup {
    */
   ChunkExecutionState *m_chunkExecutionStates;
 
+  /**
+   * \brief a chunk of another ExecutionGroup waiting for a chunk of this ExecutionGroup
+   */
+  typedef struct ChunkDependent {
+    ExecutionGroup *group;
+    unsigned int chunkNumber;
+  } ChunkDependent;
+
+  /**
+   * \brief per chunk the number of input chunks it still waits for, plus one while its
+   * dependencies are being scheduled. The chunk is added to the WorkScheduler when it reaches 0.
+   */
+  unsigned int *m_chunkDependencies;
+
+  /**
+   * \brief per chunk the chunks waiting for it, only for chunks which are not executed yet.
+   */
+  vector<ChunkDependent> *m_chunkDependents;
+
+  /**
+   * \brief protects m_chunkExecutionStates and m_chunkDependents, chunks finish on other threads
+   * while chunks are being scheduled.
+   */
+  SpinLock m_chunksLock;
+
   /**
    * \brief indicator when this ExecutionGroup has valid Operations in its vector for Execution
    * \note When building the ExecutionGroup Operations are added via recursion.
@@ -211,35 +238,41 @@ class ExecutionGroup {
   void determineNumberOfChunks();
 
   /**
-   * \brief try to schedule a specific chunk.
-   * \note scheduling succeeds when all input requirements are met and the chunks hasn't been
-   * scheduled yet.
+   * \brief schedule a specific chunk and the chunks of other ExecutionGroup's it depends on.
+   * \note the chunk is added to the WorkScheduler when all chunks it depends on are executed.
+   * Does nothing when the chunk is already scheduled.
    * \param graph:
    * \param xChunk:
    * \param yChunk:
-   * \return [true:false]
-   * true: package(s) are scheduled
-   * false: scheduling is deferred (depending workpackages are scheduled)
    */
-  bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
+  void scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
 
   /**
-   * \brief try to schedule a specific area.
-   * \note Check if a certain area is available, when not available this are will be checked.
+   * \brief schedule the chunks of a specific area.
    * \note This method is called from other ExecutionGroup's.
    * \param graph:
    * \param rect:
-   * \return [true:false]
-   * true: package(s) are scheduled
-   * false: scheduling is deferred (depending workpackages are scheduled)
+   * \param dependent: ExecutionGroup of the chunk which needs the area
+   * \param dependentChunk: chunk which needs the area, it waits for the chunks of the area
    */
-  bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect);
+  void scheduleAreaWhenPossible(ExecutionSystem *graph,
+                                rcti *rect,
+                                ExecutionGroup *dependent,
+                                unsigned int dependentChunk);
 
   /**
-   * \brief add a chunk to the WorkScheduler.
-   * \param chunknumber:
+   * \brief let chunk \a dependentChunk of \a dependent wait for \a chunkNumber
+   * \note does nothing when \a chunkNumber is already executed
+   */
+  void addChunkDependent(unsigned int chunkNumber,
+                         ExecutionGroup *dependent,
+                         unsigned int dependentChunk);
+
+  /**
+   * \brief one of the chunks \a chunkNumber waits for is available.
+   * When it was the last one the chunk is added to the WorkScheduler.
    */
-  bool scheduleChunk(unsigned int chunkNumber);
+  void scheduleChunk(unsigned int chunkNumber);
 
   /**
    * \brief determine the area of interest of a certain input area
@@ -255,6 +288,7 @@ class ExecutionGroup {
  public:
   // constructors
   ExecutionGroup();
+  ~ExecutionGroup();
 
   // methods
   /**
@@ -393,7 +427,8 @@ class ExecutionGroup {
    *   - CenterX
    *   - CenterY
    *
-   * After determining the order of the chunks the chunks will be scheduled
+   * After determining the order of the chunks the chunks will be scheduled, this method waits
+   * for the WorkScheduler to finish them.
    *
    * \see ViewerOperation
    * \param system:
@@ -440,8 +475,17 @@ class ExecutionGroup {
 
   void setRenderBorder(float xmin, float xmax, float ymin, float ymax);
 
+  /**
+   * \brief get the area of the output operation to calculate (viewer or render border)
+   */
+  const rcti *getViewerBorder() const
+  {
+    return &this->m_viewerBorder;
+  }
+
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
+  friend class ExecutionStatistics;
 
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:ExecutionGroup")
@@ -0,0 +1,323 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#include <ctype.h>
+#include <map>
+#include <string.h>
+#include <typeinfo>
+#include <vector>
+
+#include "COM_ExecutionGroup.h"
+#include "COM_ExecutionStatistics.h"
+#include "COM_ExecutionSystem.h"
+#include "COM_MemoryBufferPool.h"
+#include "COM_NodeOperation.h"
+#include "COM_WriteBufferOperation.h"
+
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "DNA_node_types.h"
+#include "DNA_scene_types.h"
+
+typedef struct StatisticsEntry {
+  /** Executions of the group or operation. */
+  unsigned int executions;
+  /** Chunks executed, only for groups. */
+  unsigned int chunks;
+  /** Summed time of all chunks, over all threads. */
+  double time;
+  /** Time from start to end, only for output groups. */
+  double wall_time;
+  /** Summed size of the output buffers. */
+  size_t bytes;
+  /** Names of the operations of a group. */
+  std::vector<std::string> operations;
+  bool is_output;
+} StatisticsEntry;
+
+typedef struct BufferStatistics {
+  size_t allocations;
+  size_t reused;
+  size_t allocated_bytes;
+  size_t peak_bytes;
+} BufferStatistics;
+
+typedef std::map<std::string, StatisticsEntry> StatisticsEntries;
+
+bool ExecutionStatistics::m_enabled = false;
+
+static StatisticsEntries g_groups;
+static StatisticsEntries g_operations;
+static std::vector<double> g_iteration_times;
+static std::vector<BufferStatistics> g_buffers;
+/* Groups of the running execution. */
+static std::map<const ExecutionGroup *, StatisticsEntry *> g_running_groups;
+static SpinLock g_lock;
+
+static StatisticsEntry &statistics_entry(StatisticsEntries &entries, const std::string &name)
+{
+  StatisticsEntries::iterator iter = entries.find(name);
+  if (iter == entries.end()) {
+    StatisticsEntry &entry = entries[name];
+    entry.executions = 0;
+    entry.chunks = 0;
+    entry.time = 0.0;
+    entry.wall_time = 0.0;
+    entry.bytes = 0;
+    entry.is_output = false;
+    return entry;
+  }
+  return iter->second;
+}
+
+static unsigned int statistics_num_channels(DataType datatype)
+{
+  switch (datatype) {
+    case COM_DT_VALUE:
+      return COM_NUM_CHANNELS_VALUE;
+    case COM_DT_VECTOR:
+      return COM_NUM_CHANNELS_VECTOR;
+    case COM_DT_COLOR:
+    default:
+      return COM_NUM_CHANNELS_COLOR;
+  }
+}
+
+void ExecutionStatistics::begin()
+{
+  g_groups.clear();
+  g_operations.clear();
+  g_iteration_times.clear();
+  g_buffers.clear();
+  BLI_spin_init(&g_lock);
+  m_enabled = true;
+}
+
+void ExecutionStatistics::end()
+{
+  if (m_enabled) {
+    BLI_spin_end(&g_lock);
+    m_enabled = false;
+  }
+}
+
+std::string ExecutionStatistics::operationName(const NodeOperation *operation)
+{
+  /* Strip the length prefix of mangled names and the class keyword of MSVC. */
+  const char *class_name = typeid(*operation).name();
+  while (isdigit(*class_name)) {
+    class_name++;
+  }
+  if (strncmp(class_name, "class ", 6) == 0) {
+    class_name += 6;
+  }
+  const bNode *node = operation->getbNode();
+  if (node == NULL) {
+    return class_name;
+  }
+  return std::string(node->name) + "/" + class_name;
+}
+
+void ExecutionStatistics::executionStarted(const ExecutionSystem *system)
+{
+  if (!m_enabled) {
+    return;
+  }
+  for (unsigned int index = 0; index < system->m_groups.size(); index++) {
+    const ExecutionGroup *group = system->m_groups[index];
+    NodeOperation *output = group->getOutputOperation();
+    char prefix[16];
+    BLI_snprintf(prefix, sizeof(prefix), "%u ", index);
+    StatisticsEntry &entry = statistics_entry(g_groups, prefix + operationName(output));
+    if (entry.operations.empty()) {
+      for (unsigned int op_index = 0; op_index < group->m_operations.size(); op_index++) {
+        entry.operations.push_back(operationName(group->m_operations[op_index]));
+      }
+    }
+    entry.is_output = group->isOutputExecutionGroup();
+    if (output->isWriteBufferOperation()) {
+      MemoryProxy *proxy = ((WriteBufferOperation *)output)->getMemoryProxy();
+      entry.bytes += sizeof(float) * output->getWidth() * output->getHeight() *
+                     statistics_num_channels(proxy->getDataType());
+    }
+    g_running_groups[group] = &entry;
+  }
+}
+
+void ExecutionStatistics::executionFinished(const ExecutionSystem * /*system*/)
+{
+  if (!m_enabled) {
+    return;
+  }
+  for (std::map<const ExecutionGroup *, StatisticsEntry *>::iterator iter =
+           g_running_groups.begin();
+       iter != g_running_groups.end();
+       ++iter) {
+    iter->second->executions++;
+  }
+  g_running_groups.clear();
+
+  BufferStatistics buffers;
+  MemoryBufferPool::getStatistics(
+      &buffers.allocations, &buffers.reused, &buffers.allocated_bytes, &buffers.peak_bytes);
+  g_buffers.push_back(buffers);
+}
+
+void ExecutionStatistics::iterationFinished(double time)
+{
+  if (m_enabled) {
+    g_iteration_times.push_back(time);
+  }
+}
+
+void ExecutionStatistics::groupExecuted(const ExecutionGroup *group, double time)
+{
+  if (!m_enabled) {
+    return;
+  }
+  std::map<const ExecutionGroup *, StatisticsEntry *>::iterator iter = g_running_groups.find(
+      group);
+  if (iter != g_running_groups.end()) {
+    iter->second->wall_time += time;
+  }
+}
+
+void ExecutionStatistics::chunkExecuted(const ExecutionGroup *group, double time)
+{
+  if (!m_enabled) {
+    return;
+  }
+  BLI_spin_lock(&g_lock);
+  std::map<const ExecutionGroup *, StatisticsEntry *>::iterator iter = g_running_groups.find(
+      group);
+  if (iter != g_running_groups.end()) {
+    iter->second->chunks++;
+    iter->second->time += time;
+  }
+  BLI_spin_unlock(&g_lock);
+}
+
+void ExecutionStatistics::operationExecuted(const NodeOperation *operation,
+                                            double time,
+                                            size_t bytes)
+{
+  if (!m_enabled) {
+    return;
+  }
+  StatisticsEntry &entry = statistics_entry(g_operations, operationName(operation));
+  entry.executions++;
+  entry.time += time;
+  entry.wall_time += time;
+  entry.bytes += bytes;
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Report
+ * \{ */
+
+static void report_string(FILE *file, const std::string &str)
+{
+  fputc('"', file);
+  for (size_t index = 0; index < str.size(); index++) {
+    const unsigned char c = str[index];
+    if (c == '"' || c == '\\') {
+      fprintf(file, "\\%c", c);
+    }
+    else if (c < 0x20) {
+      fprintf(file, "\\u%04x", c);
+    }
+    else {
+      fputc(c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+static void report_entries(FILE *file, const StatisticsEntries &entries, bool is_group)
+{
+  for (StatisticsEntries::const_iterator iter = entries.begin(); iter != entries.end(); ++iter) {
+    const StatisticsEntry &entry = iter->second;
+    fprintf(file, "%s\n    {\"name\": ", (iter == entries.begin()) ? "" : ",");
+    report_string(file, iter->first);
+    fprintf(file,
+            ", \"executions\": %u, \"time\": %f, \"wall_time\": %f, \"bytes\": %zu",
+            entry.executions,
+            entry.time,
+            entry.wall_time,
+            entry.bytes);
+    if (is_group) {
+      fprintf(file,
+              ", \"chunks\": %u, \"output\": %s, \"operations\": [",
+              entry.chunks,
+              entry.is_output ? "true" : "false");
+      for (unsigned int index = 0; index < entry.operations.size(); index++) {
+        if (index > 0) {
+          fputs(", ", file);
+        }
+        report_string(file, entry.operations[index]);
+      }
+      fputc(']', file);
+    }
+    fputc('}', file);
+  }
+}
+
+void ExecutionStatistics::writeReport(FILE *file, const RenderData *rd, const bNodeTree *tree)
+{
+  fputs("{\n", file);
+  fprintf(file,
+          "  \"resolution\": [%d, %d],\n  \"chunk_size\": %d,\n  \"execution_mode\": \"%s\",\n"
+          "  \"threads\": %d,\n",
+          rd->xsch * rd->size / 100,
+          rd->ysch * rd->size / 100,
+          tree->chunksize,
+          (tree->execution_mode == NTREE_EXECUTION_MODE_FULL_FRAME) ? "FULL_FRAME" : "TILED",
+          BLI_task_scheduler_num_threads());
+
+  fputs("  \"iterations\": [", file);
+  for (unsigned int index = 0; index < g_iteration_times.size(); index++) {
+    fprintf(file, "%s%f", (index > 0) ? ", " : "", g_iteration_times[index]);
+  }
+  fputs("],\n", file);
+
+  fputs("  \"buffers\": [", file);
+  for (unsigned int index = 0; index < g_buffers.size(); index++) {
+    const BufferStatistics &buffers = g_buffers[index];
+    fprintf(file,
+            "%s\n    {\"allocations\": %zu, \"reused\": %zu, \"allocated_bytes\": %zu, "
+            "\"peak_bytes\": %zu}",
+            (index > 0) ? "," : "",
+            buffers.allocations,
+            buffers.reused,
+            buffers.allocated_bytes,
+            buffers.peak_bytes);
+  }
+  fputs("\n  ],\n", file);
+
+  fputs("  \"groups\": [", file);
+  report_entries(file, g_groups, true);
+  fputs("\n  ],\n", file);
+
+  fputs("  \"operations\": [", file);
+  report_entries(file, g_operations, false);
+  fputs("\n  ]\n}\n", file);
+}
+
+/** \} */
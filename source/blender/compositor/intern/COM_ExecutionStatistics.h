@@ -0,0 +1,101 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#ifndef __COM_EXECUTIONSTATISTICS_H__
+#define __COM_EXECUTIONSTATISTICS_H__
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+
+class ExecutionGroup;
+class ExecutionSystem;
+class NodeOperation;
+struct RenderData;
+struct bNodeTree;
+
+/**
+ * \brief Collects timing and memory use of compositor executions for benchmarking.
+ *
+ * Results are summed over executions by name, so repeated executions of the same node tree add
+ * up. Execution groups are named by their index and output operation, operations by their node
+ * and class.
+ *
+ * In the tiled execution model the operations of an execution group are executed together per
+ * chunk, only the time of groups is known. The full-frame execution model executes operations
+ * one at a time and gives the time of every operation.
+ *
+ * Collection is disabled unless started by #begin, see COM_benchmark.
+ * \ingroup Execution
+ */
+class ExecutionStatistics {
+ private:
+  static bool m_enabled;
+
+ public:
+  /**
+   * \brief clear previous results and start collecting
+   */
+  static void begin();
+
+  /**
+   * \brief stop collecting, results are kept for #writeReport
+   */
+  static void end();
+
+  static bool isEnabled()
+  {
+    return m_enabled;
+  }
+
+  static void executionStarted(const ExecutionSystem *system);
+  static void executionFinished(const ExecutionSystem *system);
+
+  /**
+   * \brief a complete COM_execute call took \a time seconds
+   */
+  static void iterationFinished(double time);
+
+  /**
+   * \brief an output execution group finished after \a time seconds, including the groups it
+   * depends on
+   */
+  static void groupExecuted(const ExecutionGroup *group, double time);
+
+  /**
+   * \brief a chunk of \a group took \a time seconds, called from the threads executing chunks
+   */
+  static void chunkExecuted(const ExecutionGroup *group, double time);
+
+  /**
+   * \brief \a operation calculated its output buffer of \a bytes in \a time seconds
+   */
+  static void operationExecuted(const NodeOperation *operation, double time, size_t bytes);
+
+  /**
+   * \brief write the results as JSON
+   */
+  static void writeReport(FILE *file, const RenderData *rd, const bNodeTree *tree);
+
+  /**
+   * \brief name of the node of \a operation and its class
+   */
+  static std::string operationName(const NodeOperation *operation);
+};
+
+#endif /* __COM_EXECUTIONSTATISTICS_H__ */
@@ -28,6 +28,9 @@
 #include "COM_Converter.h"
 #include "COM_Debug.h"
 #include "COM_ExecutionGroup.h"
+#include "COM_ExecutionStatistics.h"
+#include "COM_FullFrameExecutionModel.h"
+#include "COM_MemoryBufferPool.h"
 #include "COM_NodeOperation.h"
 #include "COM_NodeOperationBuilder.h"
 #include "COM_ReadBufferOperation.h"
@@ -46,6 +49,8 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
                                  const ColorManagedDisplaySettings *displaySettings,
                                  const char *viewName)
 {
+  MemoryBufferPool::beginExecution();
+
   this->m_context.setViewName(viewName);
   this->m_context.setScene(scene);
   this->m_context.setbNodeTree(editingtree);
@@ -108,6 +113,8 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
 
 ExecutionSystem::~ExecutionSystem()
 {
+  ExecutionStatistics::executionFinished(this);
+
   unsigned int index;
   for (index = 0; index < this->m_operations.size(); index++) {
     NodeOperation *operation = this->m_operations[index];
@@ -119,6 +126,8 @@ ExecutionSystem::~ExecutionSystem()
     delete group;
   }
   this->m_groups.clear();
+
+  MemoryBufferPool::endExecution();
 }
 
 void ExecutionSystem::set_operations(const Operations &operations, const Groups &groups)
@@ -133,6 +142,13 @@ void ExecutionSystem::execute()
   editingtree->stats_draw(editingtree->sdh, TIP_("Compositing | Initializing execution"));
 
   DebugInfo::execute_started(this);
+  ExecutionStatistics::executionStarted(this);
+
+  if (this->m_context.getExecutionModel() == COM_EXECUTION_MODEL_FULL_FRAME) {
+    FullFrameExecutionModel execution_model(this->m_context, this->m_operations, this->m_groups);
+    execution_model.execute();
+    return;
+  }
 
   unsigned int order = 0;
   for (vector<NodeOperation *>::iterator iter = this->m_operations.begin();
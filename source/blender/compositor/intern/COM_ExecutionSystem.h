@@ -175,6 +175,9 @@ class ExecutionSystem {
    * - initialize the NodeOperation's and ExecutionGroup's
    * - schedule the output ExecutionGroup's based on their priority
    * - deinitialize the ExecutionGroup's and NodeOperation's
+   *
+   * With the full-frame execution model the operations are executed one at a time instead,
+   * see FullFrameExecutionModel.
    */
   void execute();
 
@@ -191,6 +194,7 @@ class ExecutionSystem {
 
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
+  friend class ExecutionStatistics;
 
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:ExecutionSystem")
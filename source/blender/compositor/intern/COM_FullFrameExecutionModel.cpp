@@ -0,0 +1,419 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#include "COM_FullFrameExecutionModel.h"
+
+#include "BLI_math.h"
+#include "BLI_rect.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLT_translation.h"
+#include "PIL_time.h"
+
+#include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
+
+#include "COM_BufferOperation.h"
+#include "COM_ExecutionStatistics.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_WorkScheduler.h"
+#include "COM_WriteBufferOperation.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+/* Smallest number of rows calculated at once, complex operations initialize tile data for every
+ * area they calculate. */
+#define COM_FULL_FRAME_MIN_ROWS 16
+
+FullFrameExecutionModel::FullFrameExecutionModel(const CompositorContext &context,
+                                                 const std::vector<NodeOperation *> &operations,
+                                                 const std::vector<ExecutionGroup *> &groups)
+    : m_context(context), m_operations(operations), m_groups(groups)
+{
+}
+
+FullFrameExecutionModel::~FullFrameExecutionModel()
+{
+  /* Buffers are left when execution was canceled. */
+  for (std::map<NodeOperation *, MemoryBuffer *>::iterator iter = this->m_buffers.begin();
+       iter != this->m_buffers.end();
+       ++iter) {
+    releaseBuffer(iter->first, iter->second);
+  }
+  this->m_buffers.clear();
+}
+
+/**
+ * Operation calculating the buffer which is read through \a operation, skipping the buffer
+ * operations added for the tiled execution.
+ */
+NodeOperation *FullFrameExecutionModel::getBufferOwner(NodeOperation *operation)
+{
+  for (;;) {
+    if (operation->isReadBufferOperation()) {
+      operation = ((ReadBufferOperation *)operation)->getMemoryProxy()->getWriteBufferOperation();
+    }
+    else if (operation->isWriteBufferOperation()) {
+      operation = &operation->getInputSocket(0)->getLink()->getOperation();
+    }
+    else {
+      return operation;
+    }
+  }
+}
+
+void FullFrameExecutionModel::determineOrder(NodeOperation *operation,
+                                             std::set<NodeOperation *> &visited)
+{
+  if (visited.count(operation)) {
+    return;
+  }
+  visited.insert(operation);
+
+  for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+    NodeOperationInput *input = operation->getInputSocket(index);
+    if (!input->isConnected()) {
+      continue;
+    }
+    NodeOperation *input_operation = getBufferOwner(&input->getLink()->getOperation());
+    determineOrder(input_operation, visited);
+  }
+  this->m_order.push_back(operation);
+}
+
+/**
+ * Key every operation which can be cached, from the settings of the operation and the keys of
+ * its inputs. Output operations write outside of the compositor and are never cached.
+ */
+void FullFrameExecutionModel::determineCacheKeys(
+    const std::map<NodeOperation *, const rcti *> &output_areas)
+{
+  ResultCacheKey context_key;
+  const RenderData *rd = this->m_context.getRenderData();
+  context_key.addInt(this->m_context.getQuality());
+  context_key.addInt(this->m_context.isRendering());
+  context_key.addString(this->m_context.getViewName());
+  context_key.addPointer(this->m_context.getScene());
+  context_key.addInt(rd->xsch);
+  context_key.addInt(rd->ysch);
+  context_key.addInt(rd->size);
+  context_key.addInt(rd->mode & (R_BORDER | R_CROP));
+  context_key.add(&rd->border, sizeof(rd->border));
+
+  for (unsigned int index = 0; index < this->m_order.size(); index++) {
+    NodeOperation *operation = this->m_order[index];
+    if (output_areas.count(operation)) {
+      continue;
+    }
+    ResultCacheKey key;
+    key.addKey(context_key);
+    if (!operation->getCacheKey(key)) {
+      continue;
+    }
+    bool cacheable = true;
+    for (unsigned int input_index = 0; input_index < operation->getNumberOfInputSockets();
+         input_index++) {
+      NodeOperationInput *input = operation->getInputSocket(input_index);
+      if (!input->isConnected()) {
+        key.addInt(-1);
+        continue;
+      }
+      std::map<NodeOperation *, ResultCacheKey>::iterator input_key = this->m_cache_keys.find(
+          getBufferOwner(&input->getLink()->getOperation()));
+      if (input_key == this->m_cache_keys.end()) {
+        cacheable = false;
+        break;
+      }
+      key.addKey(input_key->second);
+    }
+    if (cacheable && key.getData().size() <= COM_RESULT_CACHE_KEY_MAX_SIZE) {
+      this->m_cache_keys[operation] = key;
+    }
+  }
+}
+
+/**
+ * Take the buffers of operations from the cache and remove operations from the execution order
+ * which are not needed for anything else than calculating cached results.
+ */
+void FullFrameExecutionModel::useCachedResults(
+    const std::map<NodeOperation *, const rcti *> &output_areas)
+{
+  std::set<NodeOperation *> needed;
+  std::vector<NodeOperation *> order;
+  /* Readers come after the operations they read from. */
+  for (int index = this->m_order.size() - 1; index >= 0; index--) {
+    NodeOperation *operation = this->m_order[index];
+    if (!output_areas.count(operation) && !needed.count(operation)) {
+      continue;
+    }
+    std::map<NodeOperation *, ResultCacheKey>::iterator key = this->m_cache_keys.find(operation);
+    if (key != this->m_cache_keys.end()) {
+      MemoryBuffer *buffer = ResultCache::acquire(key->second);
+      if (buffer) {
+        this->m_buffers[operation] = buffer;
+        this->m_cached.insert(operation);
+        continue;
+      }
+    }
+    order.push_back(operation);
+    for (unsigned int input_index = 0; input_index < operation->getNumberOfInputSockets();
+         input_index++) {
+      NodeOperationInput *input = operation->getInputSocket(input_index);
+      if (input->isConnected()) {
+        needed.insert(getBufferOwner(&input->getLink()->getOperation()));
+      }
+    }
+  }
+  this->m_order.assign(order.rbegin(), order.rend());
+}
+
+void FullFrameExecutionModel::countReaders()
+{
+  for (unsigned int index = 0; index < this->m_order.size(); index++) {
+    NodeOperation *operation = this->m_order[index];
+    for (unsigned int input_index = 0; input_index < operation->getNumberOfInputSockets();
+         input_index++) {
+      NodeOperationInput *input = operation->getInputSocket(input_index);
+      if (input->isConnected()) {
+        this->m_readers[getBufferOwner(&input->getLink()->getOperation())]++;
+      }
+    }
+  }
+}
+
+void FullFrameExecutionModel::execute()
+{
+  const bNodeTree *tree = this->m_context.getbNodeTree();
+
+  /* Output operations in the order of their priority, like the tiled execution. */
+  const CompositorPriority priorities[] = {
+      COM_PRIORITY_HIGH, COM_PRIORITY_MEDIUM, COM_PRIORITY_LOW};
+  const int priorities_len = this->m_context.isFastCalculation() ? 1 : ARRAY_SIZE(priorities);
+  std::map<NodeOperation *, const rcti *> output_areas;
+  std::set<NodeOperation *> visited;
+  for (int priority_index = 0; priority_index < priorities_len; priority_index++) {
+    for (unsigned int index = 0; index < this->m_groups.size(); index++) {
+      ExecutionGroup *group = this->m_groups[index];
+      if (group->isOutputExecutionGroup() &&
+          group->getRenderPriotrity() == priorities[priority_index]) {
+        NodeOperation *operation = group->getOutputOperation();
+        output_areas[operation] = group->getViewerBorder();
+        determineOrder(operation, visited);
+      }
+    }
+  }
+
+  const size_t cache_limit = ((size_t)U.compositor_cache_limit) * 1024 * 1024;
+  ResultCache::beginExecution(cache_limit);
+  if (cache_limit > 0) {
+    determineCacheKeys(output_areas);
+    useCachedResults(output_areas);
+  }
+  countReaders();
+
+  for (unsigned int index = 0; index < this->m_order.size(); index++) {
+    if (tree->test_break && tree->test_break(tree->tbh)) {
+      break;
+    }
+    NodeOperation *operation = this->m_order[index];
+    std::map<NodeOperation *, const rcti *>::iterator output_area = output_areas.find(operation);
+    executeOperation(operation, (output_area != output_areas.end()) ? output_area->second : NULL);
+    releaseInputs(operation);
+
+    tree->progress(tree->prh, (float)(index + 1) / this->m_order.size());
+    char buf[128];
+    BLI_snprintf(buf,
+                 sizeof(buf),
+                 TIP_("Compositing | Operation %u-%u"),
+                 index + 1,
+                 (unsigned int)this->m_order.size());
+    tree->stats_draw(tree->sdh, buf);
+    if (tree->update_draw) {
+      tree->update_draw(tree->udh);
+    }
+  }
+}
+
+/**
+ * Execute \a operation with its inputs reading from the buffers of the operations before it.
+ * Output operations calculate \a output_area, other operations their full resolution into a new
+ * buffer.
+ */
+void FullFrameExecutionModel::executeOperation(NodeOperation *operation, const rcti *output_area)
+{
+  const unsigned int inputs_len = operation->getNumberOfInputSockets();
+  std::vector<NodeOperationOutput *> links(inputs_len, NULL);
+  std::vector<BufferOperation *> buffer_operations;
+  for (unsigned int index = 0; index < inputs_len; index++) {
+    NodeOperationInput *input = operation->getInputSocket(index);
+    if (!input->isConnected()) {
+      continue;
+    }
+    links[index] = input->getLink();
+    NodeOperation *input_operation = &input->getLink()->getOperation();
+    MemoryBuffer *buffer = this->m_buffers[getBufferOwner(input_operation)];
+    if (input_operation->isReadBufferOperation()) {
+      /* Read operations may sample in their own way (see WrapOperation), keep them. */
+      ((ReadBufferOperation *)input_operation)->setMemoryBuffer(buffer);
+    }
+    else {
+      unsigned int resolution[2] = {input_operation->getWidth(), input_operation->getHeight()};
+      BufferOperation *buffer_operation = new BufferOperation(
+          buffer, input->getLink()->getDataType(), resolution);
+      buffer_operations.push_back(buffer_operation);
+      input->setLink(buffer_operation->getOutputSocket());
+    }
+  }
+
+  operation->setbNodeTree(this->m_context.getbNodeTree());
+  operation->initExecution();
+  const double start_time = PIL_check_seconds_timer();
+  if (output_area) {
+    calculateArea(operation, NULL, output_area);
+    ExecutionStatistics::operationExecuted(operation, PIL_check_seconds_timer() - start_time, 0);
+  }
+  else {
+    /* Operations without resolution have a single value, stored at (0, 0). */
+    rcti rect;
+    BLI_rcti_init(&rect, 0, max_ii(operation->getWidth(), 1), 0, max_ii(operation->getHeight(), 1));
+    MemoryBuffer *buffer = new MemoryBuffer(operation->getOutputSocket()->getDataType(), &rect);
+    calculateArea(operation, buffer, &rect);
+    buffer->setCreatedState();
+    ExecutionStatistics::operationExecuted(operation,
+                                           PIL_check_seconds_timer() - start_time,
+                                           sizeof(float) * buffer->getWidth() *
+                                               buffer->getHeight() * buffer->get_num_channels());
+    this->m_buffers[operation] = buffer;
+
+    /* Results of canceled executions may be incomplete. */
+    const bNodeTree *tree = this->m_context.getbNodeTree();
+    std::map<NodeOperation *, ResultCacheKey>::iterator key = this->m_cache_keys.find(operation);
+    if (key != this->m_cache_keys.end() && !(tree->test_break && tree->test_break(tree->tbh)) &&
+        ResultCache::insert(key->second, buffer)) {
+      this->m_cached.insert(operation);
+    }
+  }
+  operation->deinitExecution();
+
+  for (unsigned int index = 0; index < inputs_len; index++) {
+    if (links[index]) {
+      operation->getInputSocket(index)->setLink(links[index]);
+    }
+  }
+  for (unsigned int index = 0; index < buffer_operations.size(); index++) {
+    delete buffer_operations[index];
+  }
+}
+
+typedef struct CalculateAreaData {
+  NodeOperation *operation;
+  MemoryBuffer *output;
+  const rcti *area;
+  int band_height;
+} CalculateAreaData;
+
+static void calculate_area_band(void *__restrict userdata,
+                                const int band,
+                                const TaskParallelTLS *__restrict /*tls*/)
+{
+  const CalculateAreaData *data = (const CalculateAreaData *)userdata;
+  const rcti *area = data->area;
+  rcti band_area;
+  BLI_rcti_init(&band_area,
+                area->xmin,
+                area->xmax,
+                area->ymin + band * data->band_height,
+                min_ii(area->ymin + (band + 1) * data->band_height, area->ymax));
+  CPUDevice *device = WorkScheduler::acquire_thread_device();
+  if (data->output) {
+    data->operation->executeFullFrameArea(data->output, &band_area);
+  }
+  else {
+    data->operation->executeRegion(&band_area, band);
+  }
+  WorkScheduler::release_thread_device(device);
+}
+
+/**
+ * Calculate \a area split in bands of rows between threads. Without \a output the operation is
+ * an output operation which writes the result itself.
+ */
+void FullFrameExecutionModel::calculateArea(NodeOperation *operation,
+                                            MemoryBuffer *output,
+                                            const rcti *area)
+{
+  const int height = BLI_rcti_size_y(area);
+  if (height <= 0 || BLI_rcti_size_x(area) <= 0) {
+    return;
+  }
+
+  CalculateAreaData data;
+  data.operation = operation;
+  data.output = output;
+  data.area = area;
+  if (operation->isSingleThreaded()) {
+    data.band_height = height;
+  }
+  else {
+    /* Several bands per thread, the cost of rows can be very different. */
+    const int threads_len = BLI_system_thread_count();
+    data.band_height = max_ii(divide_ceil_u(height, threads_len * 4), COM_FULL_FRAME_MIN_ROWS);
+  }
+  const int bands_len = divide_ceil_u(height, data.band_height);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (bands_len > 1);
+  BLI_task_parallel_range(0, bands_len, &data, calculate_area_band, &settings);
+}
+
+/**
+ * Free buffers of the inputs of \a operation which are not read by other operations anymore.
+ */
+void FullFrameExecutionModel::releaseInputs(NodeOperation *operation)
+{
+  for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+    NodeOperationInput *input = operation->getInputSocket(index);
+    if (!input->isConnected()) {
+      continue;
+    }
+    NodeOperation *input_operation = getBufferOwner(&input->getLink()->getOperation());
+    if (--this->m_readers[input_operation] == 0) {
+      std::map<NodeOperation *, MemoryBuffer *>::iterator buffer = this->m_buffers.find(
+          input_operation);
+      if (buffer != this->m_buffers.end()) {
+        releaseBuffer(buffer->first, buffer->second);
+        this->m_buffers.erase(buffer);
+      }
+    }
+  }
+}
+
+void FullFrameExecutionModel::releaseBuffer(NodeOperation *operation, MemoryBuffer *buffer)
+{
+  if (this->m_cached.count(operation)) {
+    ResultCache::release(this->m_cache_keys[operation]);
+  }
+  else {
+    delete buffer;
+  }
+}
@@ -0,0 +1,86 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#ifndef __COM_FULLFRAMEEXECUTIONMODEL_H__
+#define __COM_FULLFRAMEEXECUTIONMODEL_H__
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "COM_CompositorContext.h"
+#include "COM_ExecutionGroup.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_NodeOperation.h"
+#include "COM_ResultCache.h"
+
+/**
+ * \brief Executes the operations one at a time, from inputs to outputs.
+ *
+ * Every operation calculates its full output into a MemoryBuffer in one pass (split in areas
+ * between threads), reading its inputs from the buffers of the operations before it. Compared to
+ * the tiled execution there is no per pixel call chain through all operations of an
+ * ExecutionGroup and no re-calculation of areas shared by chunks.
+ *
+ * Buffers are freed as soon as all operations reading them were executed. Results of operations
+ * which don't depend on data outside of the node tree are kept in the ResultCache, operations
+ * with a cached result and everything only they read from are skipped in later executions.
+ * \ingroup Execution
+ */
+class FullFrameExecutionModel {
+ private:
+  const CompositorContext &m_context;
+  const std::vector<NodeOperation *> &m_operations;
+  const std::vector<ExecutionGroup *> &m_groups;
+
+  /** Operations in execution order, inputs first. */
+  std::vector<NodeOperation *> m_order;
+  /** Output buffers of executed operations which are still read by operations to execute. */
+  std::map<NodeOperation *, MemoryBuffer *> m_buffers;
+  /** Number of reads from the buffer of an operation by operations still to execute. */
+  std::map<NodeOperation *, int> m_readers;
+  /** Keys of the operations whose result can be cached. */
+  std::map<NodeOperation *, ResultCacheKey> m_cache_keys;
+  /** Operations whose buffer is owned by the ResultCache. */
+  std::set<NodeOperation *> m_cached;
+
+ public:
+  FullFrameExecutionModel(const CompositorContext &context,
+                          const std::vector<NodeOperation *> &operations,
+                          const std::vector<ExecutionGroup *> &groups);
+  ~FullFrameExecutionModel();
+
+  void execute();
+
+ private:
+  static NodeOperation *getBufferOwner(NodeOperation *operation);
+  void determineOrder(NodeOperation *operation, std::set<NodeOperation *> &visited);
+  void determineCacheKeys(const std::map<NodeOperation *, const rcti *> &output_areas);
+  void useCachedResults(const std::map<NodeOperation *, const rcti *> &output_areas);
+  void countReaders();
+  void executeOperation(NodeOperation *operation, const rcti *output_area);
+  void calculateArea(NodeOperation *operation, MemoryBuffer *output, const rcti *area);
+  void releaseInputs(NodeOperation *operation);
+  void releaseBuffer(NodeOperation *operation, MemoryBuffer *buffer);
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:FullFrameExecutionModel")
+#endif
+};
+
+#endif /* __COM_FULLFRAMEEXECUTIONMODEL_H__ */
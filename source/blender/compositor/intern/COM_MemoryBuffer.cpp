@@ -17,6 +17,7 @@
  */
 
 #include "COM_MemoryBuffer.h"
+#include "COM_MemoryBufferPool.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -58,8 +59,8 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, r
   this->m_memoryProxy = memoryProxy;
   this->m_chunkNumber = chunkNumber;
   this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
-  this->m_buffer = (float *)MEM_mallocN_aligned(
-      sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  this->m_buffer = MemoryBufferPool::allocate(sizeof(float) * determineBufferSize() *
+                                              this->m_num_channels);
   this->m_state = COM_MB_ALLOCATED;
   this->m_datatype = memoryProxy->getDataType();
 }
@@ -72,8 +73,8 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
   this->m_memoryProxy = memoryProxy;
   this->m_chunkNumber = -1;
   this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
-  this->m_buffer = (float *)MEM_mallocN_aligned(
-      sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  this->m_buffer = MemoryBufferPool::allocate(sizeof(float) * determineBufferSize() *
+                                              this->m_num_channels);
   this->m_state = COM_MB_TEMPORARILY;
   this->m_datatype = memoryProxy->getDataType();
 }
@@ -86,14 +87,17 @@ MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
   this->m_memoryProxy = NULL;
   this->m_chunkNumber = -1;
   this->m_num_channels = determine_num_channels(dataType);
-  this->m_buffer = (float *)MEM_mallocN_aligned(
-      sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  this->m_buffer = MemoryBufferPool::allocate(sizeof(float) * determineBufferSize() *
+                                              this->m_num_channels);
   this->m_state = COM_MB_TEMPORARILY;
   this->m_datatype = dataType;
 }
 MemoryBuffer *MemoryBuffer::duplicate()
 {
-  MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
+  /* Buffers of the full-frame execution model are not associated with a memory proxy. */
+  MemoryBuffer *result = (this->m_memoryProxy) ?
+                             new MemoryBuffer(this->m_memoryProxy, &this->m_rect) :
+                             new MemoryBuffer(this->m_datatype, &this->m_rect);
   memcpy(result->m_buffer,
          this->m_buffer,
          this->determineBufferSize() * this->m_num_channels * sizeof(float));
@@ -145,7 +149,8 @@ float MemoryBuffer::getMaximumValue(rcti *rect)
 MemoryBuffer::~MemoryBuffer()
 {
   if (this->m_buffer) {
-    MEM_freeN(this->m_buffer);
+    MemoryBufferPool::free(this->m_buffer,
+                           sizeof(float) * determineBufferSize() * this->m_num_channels);
     this->m_buffer = NULL;
   }
 }
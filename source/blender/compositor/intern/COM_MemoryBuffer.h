@@ -251,6 +251,42 @@ class MemoryBuffer {
     }
   }
 
+  /**
+   * Read \a length pixels starting at (\a x, \a y), \a stride floats apart in \a result.
+   * Same as calling #read for every pixel with COM_MB_CLIP.
+   */
+  inline void readRow(float *result, int x, int y, int length, int stride)
+  {
+    const size_t pixel_size = sizeof(float) * this->m_num_channels;
+    int inside_start = max_ii(x, m_rect.xmin);
+    int inside_end = min_ii(x + length, m_rect.xmax);
+    if (y < m_rect.ymin || y >= m_rect.ymax || inside_start >= inside_end) {
+      inside_start = inside_end = x + length;
+    }
+    int i = 0;
+    for (; i < inside_start - x; i++) {
+      memset(&result[i * stride], 0, pixel_size);
+    }
+    if (inside_start < inside_end) {
+      const float *buffer = &this->m_buffer[((y - m_rect.ymin) * this->m_width +
+                                             (inside_start - m_rect.xmin)) *
+                                            this->m_num_channels];
+      if (stride == (int)this->m_num_channels) {
+        memcpy(&result[i * stride], buffer, pixel_size * (inside_end - inside_start));
+        i = inside_end - x;
+      }
+      else {
+        for (; i < inside_end - x; i++) {
+          memcpy(&result[i * stride], buffer, pixel_size);
+          buffer += this->m_num_channels;
+        }
+      }
+    }
+    for (; i < length; i++) {
+      memset(&result[i * stride], 0, pixel_size);
+    }
+  }
+
   inline void readNoCheck(float *result,
                           int x,
                           int y,
@@ -0,0 +1,255 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#include <map>
+#include <stdio.h>
+#include <vector>
+
+#include "COM_MemoryBufferPool.h"
+
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_global.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "atomic_ops.h"
+
+/* Number of free list shards, threads are assigned round robin. */
+#define POOL_SHARDS_NUM 16
+/* Smallest size class in bytes. */
+#define POOL_MIN_CLASS_SIZE 4096
+
+typedef struct PoolBuffer {
+  float *buffer;
+  /** Execution in which the buffer was last given back. */
+  unsigned int last_used;
+} PoolBuffer;
+
+/* Free buffers by size class. */
+typedef std::map<size_t, std::vector<PoolBuffer>> PoolFreeLists;
+
+typedef struct PoolShard {
+  SpinLock lock;
+  PoolFreeLists free_lists;
+} PoolShard;
+
+static PoolShard g_shards[POOL_SHARDS_NUM];
+static ThreadLocal(void *) g_thread_shard;
+static unsigned int g_next_shard = 0;
+static bool g_initialized = false;
+static unsigned int g_execution = 0;
+
+/* Statistics. */
+static size_t g_allocations = 0;
+static size_t g_reused = 0;
+static size_t g_memory_allocated = 0;
+static size_t g_memory_in_use = 0;
+static size_t g_memory_peak = 0;
+static size_t g_memory_pooled = 0;
+
+/**
+ * Four size classes per power of two, so at most a quarter of a buffer is unused while it can
+ * be reused for all sizes in its class.
+ */
+static size_t pool_class_size(size_t size)
+{
+  if (size <= POOL_MIN_CLASS_SIZE) {
+    return POOL_MIN_CLASS_SIZE;
+  }
+  size_t power = POOL_MIN_CLASS_SIZE;
+  while (power * 2 < size) {
+    power *= 2;
+  }
+  const size_t step = power / 4;
+  return (size + step - 1) / step * step;
+}
+
+static PoolShard *pool_thread_shard()
+{
+  PoolShard *shard = (PoolShard *)BLI_thread_local_get(g_thread_shard);
+  if (shard == NULL) {
+    shard = &g_shards[atomic_fetch_and_add_u(&g_next_shard, 1) % POOL_SHARDS_NUM];
+    BLI_thread_local_set(g_thread_shard, shard);
+  }
+  return shard;
+}
+
+static float *pool_shard_pop(PoolShard *shard, size_t class_size)
+{
+  float *buffer = NULL;
+  BLI_spin_lock(&shard->lock);
+  PoolFreeLists::iterator free_list = shard->free_lists.find(class_size);
+  if (free_list != shard->free_lists.end() && !free_list->second.empty()) {
+    buffer = free_list->second.back().buffer;
+    free_list->second.pop_back();
+  }
+  BLI_spin_unlock(&shard->lock);
+  return buffer;
+}
+
+static void pool_memory_in_use_add(size_t size)
+{
+  const size_t in_use = atomic_add_and_fetch_z(&g_memory_in_use, size);
+  size_t peak = g_memory_peak;
+  while (in_use > peak) {
+    const size_t prev_peak = atomic_cas_z(&g_memory_peak, peak, in_use);
+    if (prev_peak == peak) {
+      break;
+    }
+    peak = prev_peak;
+  }
+}
+
+void MemoryBufferPool::initialize()
+{
+  if (g_initialized) {
+    return;
+  }
+  for (int index = 0; index < POOL_SHARDS_NUM; index++) {
+    BLI_spin_init(&g_shards[index].lock);
+  }
+  BLI_thread_local_create(g_thread_shard);
+  g_initialized = true;
+}
+
+void MemoryBufferPool::deinitialize()
+{
+  if (!g_initialized) {
+    return;
+  }
+  for (int index = 0; index < POOL_SHARDS_NUM; index++) {
+    PoolShard *shard = &g_shards[index];
+    for (PoolFreeLists::iterator free_list = shard->free_lists.begin();
+         free_list != shard->free_lists.end();
+         ++free_list) {
+      for (unsigned int buffer_index = 0; buffer_index < free_list->second.size();
+           buffer_index++) {
+        MEM_freeN(free_list->second[buffer_index].buffer);
+      }
+    }
+    shard->free_lists.clear();
+    BLI_spin_end(&shard->lock);
+  }
+  BLI_thread_local_delete(g_thread_shard);
+  g_memory_pooled = 0;
+  g_initialized = false;
+}
+
+void MemoryBufferPool::beginExecution()
+{
+  g_execution++;
+  g_allocations = 0;
+  g_reused = 0;
+  g_memory_allocated = 0;
+  g_memory_peak = g_memory_in_use;
+}
+
+void MemoryBufferPool::endExecution()
+{
+  if (!g_initialized) {
+    return;
+  }
+  /* Keep buffers used by this or the previous execution, the first pass of two-pass
+   * compositing uses fewer buffers than the second one. */
+  for (int index = 0; index < POOL_SHARDS_NUM; index++) {
+    PoolShard *shard = &g_shards[index];
+    BLI_spin_lock(&shard->lock);
+    for (PoolFreeLists::iterator free_list = shard->free_lists.begin();
+         free_list != shard->free_lists.end();
+         ++free_list) {
+      std::vector<PoolBuffer> &buffers = free_list->second;
+      unsigned int kept_len = 0;
+      for (unsigned int buffer_index = 0; buffer_index < buffers.size(); buffer_index++) {
+        if (buffers[buffer_index].last_used + 1 >= g_execution) {
+          buffers[kept_len++] = buffers[buffer_index];
+        }
+        else {
+          MEM_freeN(buffers[buffer_index].buffer);
+          g_memory_pooled -= free_list->first;
+        }
+      }
+      buffers.resize(kept_len);
+    }
+    BLI_spin_unlock(&shard->lock);
+  }
+
+  if (G.debug & G_DEBUG) {
+    printf("Compositor buffer pool: %zu allocations, %zu reused, peak %.1f MB, pooled %.1f MB\n",
+           g_allocations,
+           g_reused,
+           g_memory_peak / (1024.0 * 1024.0),
+           g_memory_pooled / (1024.0 * 1024.0));
+  }
+}
+
+float *MemoryBufferPool::allocate(size_t size)
+{
+  const size_t class_size = pool_class_size(size);
+  atomic_add_and_fetch_z(&g_allocations, 1);
+  pool_memory_in_use_add(class_size);
+
+  if (g_initialized) {
+    /* Own shard first, then the buffers other threads gave back. */
+    PoolShard *own_shard = pool_thread_shard();
+    const int own_index = own_shard - g_shards;
+    for (int index = 0; index < POOL_SHARDS_NUM; index++) {
+      float *buffer = pool_shard_pop(&g_shards[(own_index + index) % POOL_SHARDS_NUM],
+                                     class_size);
+      if (buffer) {
+        atomic_add_and_fetch_z(&g_reused, 1);
+        atomic_sub_and_fetch_z(&g_memory_pooled, class_size);
+        return buffer;
+      }
+    }
+  }
+  atomic_add_and_fetch_z(&g_memory_allocated, class_size);
+  return (float *)MEM_mallocN_aligned(class_size, 16, "COM_MemoryBuffer");
+}
+
+void MemoryBufferPool::free(float *buffer, size_t size)
+{
+  const size_t class_size = pool_class_size(size);
+  atomic_sub_and_fetch_z(&g_memory_in_use, class_size);
+
+  if (!g_initialized) {
+    MEM_freeN(buffer);
+    return;
+  }
+  PoolBuffer pool_buffer;
+  pool_buffer.buffer = buffer;
+  pool_buffer.last_used = g_execution;
+
+  PoolShard *shard = pool_thread_shard();
+  BLI_spin_lock(&shard->lock);
+  shard->free_lists[class_size].push_back(pool_buffer);
+  BLI_spin_unlock(&shard->lock);
+  atomic_add_and_fetch_z(&g_memory_pooled, class_size);
+}
+
+void MemoryBufferPool::getStatistics(size_t *r_allocations,
+                                     size_t *r_reused,
+                                     size_t *r_allocated_bytes,
+                                     size_t *r_peak_bytes)
+{
+  *r_allocations = g_allocations;
+  *r_reused = g_reused;
+  *r_allocated_bytes = g_memory_allocated;
+  *r_peak_bytes = g_memory_peak;
+}
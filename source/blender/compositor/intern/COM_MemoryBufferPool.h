@@ -0,0 +1,81 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#ifndef __COM_MEMORYBUFFERPOOL_H__
+#define __COM_MEMORYBUFFERPOOL_H__
+
+#include <stddef.h>
+
+/**
+ * \brief Reuses the float buffers of MemoryBuffer's.
+ *
+ * Chunks and consolidated input buffers are allocated and freed all the time during an
+ * execution, and mostly have the same few sizes. Freed buffers are kept in free lists per size
+ * class so they can be reused without going through the allocator and touching fresh pages.
+ * Free lists are split in shards which threads pick once, so threads rarely wait for each other.
+ *
+ * Buffers which were not reused during an execution are freed at the end of it, the pool stays
+ * around the peak memory use of an execution. Animation frames reuse the buffers of the
+ * previous frame.
+ * \ingroup Memory
+ */
+class MemoryBufferPool {
+ public:
+  /**
+   * \brief initialize the pool, called before executing
+   */
+  static void initialize();
+
+  /**
+   * \brief free all pooled buffers
+   */
+  static void deinitialize();
+
+  /**
+   * \brief called by the ExecutionSystem when starting an execution
+   */
+  static void beginExecution();
+
+  /**
+   * \brief called by the ExecutionSystem after an execution, frees the buffers which were not
+   * used and prints statistics in debug mode
+   */
+  static void endExecution();
+
+  /**
+   * \brief get a buffer of at least \a size bytes, aligned to 16 bytes
+   * \note contents are not initialized
+   */
+  static float *allocate(size_t size);
+
+  /**
+   * \brief give back \a buffer allocated with the same \a size
+   */
+  static void free(float *buffer, size_t size);
+
+  /**
+   * \brief statistics of the current execution: buffers requested, buffers which were reused,
+   * bytes which had to be allocated and the peak of the bytes in use
+   */
+  static void getStatistics(size_t *r_allocations,
+                            size_t *r_reused,
+                            size_t *r_allocated_bytes,
+                            size_t *r_peak_bytes);
+};
+
+#endif /* __COM_MEMORYBUFFERPOOL_H__ */
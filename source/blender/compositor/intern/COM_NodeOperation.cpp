@@ -37,6 +37,8 @@ NodeOperation::NodeOperation()
   this->m_isResolutionSet = false;
   this->m_openCL = false;
   this->m_btree = NULL;
+  this->m_isNodeCacheable = true;
+  this->m_bnode = NULL;
 }
 
 NodeOperation::~NodeOperation()
@@ -134,6 +136,49 @@ void NodeOperation::deinitExecution()
 {
   /* pass */
 }
+
+void NodeOperation::executeFullFrameArea(MemoryBuffer *output, rcti *area)
+{
+  float *buffer = output->getBuffer();
+  const int num_channels = output->get_num_channels();
+  const int width = output->getWidth();
+  if (this->isComplex()) {
+    void *data = this->initializeTileData(area);
+    for (int y = area->ymin; y < area->ymax; y++) {
+      int offset = (y * width + area->xmin) * num_channels;
+      for (int x = area->xmin; x < area->xmax; x++) {
+        this->read(&buffer[offset], x, y, data);
+        offset += num_channels;
+      }
+    }
+    if (data) {
+      this->deinitializeTileData(area, data);
+    }
+  }
+  else {
+    for (int y = area->ymin; y < area->ymax; y++) {
+      const int offset = (y * width + area->xmin) * num_channels;
+      this->readRow(&buffer[offset], area->xmin, y, area->xmax - area->xmin, num_channels);
+    }
+  }
+}
+bool NodeOperation::getCacheKey(ResultCacheKey &key)
+{
+  if (!this->m_isNodeCacheable || this->getNumberOfOutputSockets() != 1) {
+    return false;
+  }
+  key.addString(typeid(*this).name());
+  key.addKey(this->m_nodeCacheKey);
+  key.addInt(this->m_width);
+  key.addInt(this->m_height);
+  key.addInt(this->getOutputSocket()->getDataType());
+  for (unsigned int index = 0; index < this->getNumberOfInputSockets(); index++) {
+    key.addInt(this->getInputSocket(index)->getDataType());
+    key.addInt(this->getInputSocket(index)->getResizeMode());
+  }
+  return getCacheState(key);
+}
+
 SocketReader *NodeOperation::getInputSocketReader(unsigned int inputSocketIndex)
 {
   return this->getInputSocket(inputSocketIndex)->getReader();
@@ -30,6 +30,7 @@
 #include "COM_MemoryBuffer.h"
 #include "COM_MemoryProxy.h"
 #include "COM_Node.h"
+#include "COM_ResultCache.h"
 #include "COM_SocketReader.h"
 
 #include "clew.h"
@@ -124,6 +125,24 @@ class NodeOperation : public SocketReader {
    */
   bool m_isResolutionSet;
 
+  /**
+   * \brief key of the settings of the node this operation was created from
+   * \see ResultCache
+   */
+  ResultCacheKey m_nodeCacheKey;
+
+  /**
+   * \brief false when the node this operation was created from depends on data outside of the
+   * node tree, results of the operation can't be cached then
+   */
+  bool m_isNodeCacheable;
+
+  /**
+   * \brief the node this operation was created from, NULL for operations added while building
+   * the execution system
+   */
+  const bNode *m_bnode;
+
  public:
   virtual ~NodeOperation();
 
@@ -201,6 +220,18 @@ class NodeOperation : public SocketReader {
   {
   }
 
+  /**
+   * \brief when executing the full-frame execution model, this method is called
+   * to calculate an area of the output of the operation
+   * \ingroup execution
+   * \note called from multiple threads for disjoint areas, inputs are read through the socket
+   * readers which are replaced by reads from the buffers of the input operations.
+   * \param output: the buffer of the full output of the operation to write to
+   * \param area: the area to calculate
+   * \see FullFrameExecutionModel
+   */
+  virtual void executeFullFrameArea(MemoryBuffer *output, rcti *area);
+
   /**
    * \brief when a chunk is executed by an OpenCLDevice, this method is called
    * \ingroup execution
@@ -282,6 +313,30 @@ class NodeOperation : public SocketReader {
     return false;
   }
 
+  void setbNode(const bNode *node)
+  {
+    this->m_bnode = node;
+  }
+
+  const bNode *getbNode() const
+  {
+    return this->m_bnode;
+  }
+
+  void setNodeCacheKey(const ResultCacheKey &key, bool cacheable)
+  {
+    this->m_nodeCacheKey = key;
+    this->m_isNodeCacheable = cacheable;
+  }
+
+  /**
+   * \brief add everything the result of this operation depends on to \a key, except for its
+   * inputs which are added by the caller
+   * \return false when the result can't be cached
+   * \see ResultCache
+   */
+  bool getCacheKey(ResultCacheKey &key);
+
   /**
    * \brief is this operation of type ReadBufferOperation
    * \return [true:false]
@@ -381,6 +436,16 @@ class NodeOperation : public SocketReader {
  protected:
   NodeOperation();
 
+  /**
+   * \brief add the state of the operation which is not part of the node settings to \a key,
+   * for example values it was created with or data it reads at execution
+   * \return false when the result of the operation can't be cached
+   */
+  virtual bool getCacheState(ResultCacheKey & /*key*/)
+  {
+    return true;
+  }
+
   void addInputSocket(DataType datatype, InputResizeMode resize_mode = COM_SC_CENTER);
   void addOutputSocket(DataType datatype);
 
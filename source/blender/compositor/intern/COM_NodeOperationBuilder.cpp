@@ -23,6 +23,7 @@
 #include "COM_ExecutionSystem.h"
 #include "COM_Node.h"
 #include "COM_NodeConverter.h"
+#include "COM_ResultCache.h"
 #include "COM_SocketProxyNode.h"
 
 #include "COM_NodeOperation.h"
@@ -57,8 +58,20 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
     m_current_node = node;
 
+    const unsigned int operations_len = m_operations.size();
     DebugInfo::node_to_operations(node);
     node->convertToOperations(converter, *m_context);
+
+    for (unsigned int op_index = operations_len; op_index < m_operations.size(); op_index++) {
+      m_operations[op_index]->setbNode(node->getbNode());
+    }
+    if (m_context->getExecutionModel() == COM_EXECUTION_MODEL_FULL_FRAME) {
+      ResultCacheKey key;
+      const bool cacheable = ResultCache::hashNode(node->getbNode(), *m_context, key);
+      for (unsigned int op_index = operations_len; op_index < m_operations.size(); op_index++) {
+        m_operations[op_index]->setNodeCacheKey(key, cacheable);
+      }
+    }
   }
 
   m_current_node = NULL;
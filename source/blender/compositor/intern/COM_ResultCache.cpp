@@ -0,0 +1,363 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#include <algorithm>
+#include <map>
+#include <string.h>
+
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_ResultCache.h"
+
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+
+#include "DNA_color_types.h"
+#include "DNA_genfile.h"
+#include "DNA_image_types.h"
+#include "DNA_node_types.h"
+#include "DNA_sdna_types.h"
+
+#include "BKE_node.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "MEM_guardedalloc.h"
+
+/* -------------------------------------------------------------------- */
+/** \name Result Cache Key
+ * \{ */
+
+/* 64 bit FNV-1a of the data of the key. */
+#define RESULT_CACHE_HASH_INIT 0xcbf29ce484222325ULL
+#define RESULT_CACHE_HASH_PRIME 0x100000001b3ULL
+
+ResultCacheKey::ResultCacheKey() : m_hash(RESULT_CACHE_HASH_INIT)
+{
+}
+
+void ResultCacheKey::add(const void *data, size_t size)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+  uint64_t hash = this->m_hash;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * RESULT_CACHE_HASH_PRIME;
+  }
+  this->m_hash = hash;
+  this->m_data.insert(this->m_data.end(), bytes, bytes + size);
+}
+
+void ResultCacheKey::addString(const char *str)
+{
+  if (str) {
+    add(str, strlen(str) + 1);
+  }
+  else {
+    addInt(0);
+  }
+}
+
+void ResultCacheKey::addKey(const ResultCacheKey &key)
+{
+  const uint64_t size = key.m_data.size();
+  add(&size, sizeof(size));
+  if (size) {
+    add(&key.m_data[0], size);
+  }
+  if (!key.m_imbufs.empty()) {
+    /* Keep every buffer once, the same image can be read through many paths. */
+    this->m_imbufs.insert(this->m_imbufs.end(), key.m_imbufs.begin(), key.m_imbufs.end());
+    std::sort(this->m_imbufs.begin(), this->m_imbufs.end());
+    this->m_imbufs.erase(std::unique(this->m_imbufs.begin(), this->m_imbufs.end()),
+                         this->m_imbufs.end());
+  }
+}
+
+void ResultCacheKey::addImBuf(ImBuf *ibuf)
+{
+  addPointer(ibuf);
+  if (ibuf) {
+    /* Painting changes the pixels of the buffer in place. */
+    addInt(ibuf->changed_counter);
+    this->m_imbufs.push_back(ibuf);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Node Settings
+ * \{ */
+
+static void hash_mem(ResultCacheKey &key, const void *mem)
+{
+  if (mem) {
+    key.add(mem, MEM_allocN_len(mem));
+  }
+}
+
+/* Hash the values of a DNA struct. Other than strings, pointers in node storage reference
+ * run-time data or data-blocks which are added separately, their addresses are skipped. */
+static void hash_dna_struct(ResultCacheKey &key,
+                            const SDNA *sdna,
+                            const int struct_nr,
+                            const char *data)
+{
+  const short *sp = sdna->structs[struct_nr];
+  const int members_len = sp[1];
+  sp += 2;
+  for (int a = 0; a < members_len; a++, sp += 2) {
+    const short type = sp[0];
+    const short name_nr = sp[1];
+    const char *name = sdna->names[name_nr];
+    const int size = DNA_elem_size_nr(sdna, type, name_nr);
+    if (name[0] == '*' || (name[0] == '(' && name[1] == '*')) {
+      if (name[0] == '*' && name[1] != '*' && sdna->names_array_len[name_nr] == 1 &&
+          STREQ(sdna->types[type], "char")) {
+        key.addString(*(const char *const *)data);
+      }
+    }
+    else {
+      const int member_struct_nr = DNA_struct_find_nr(sdna, sdna->types[type]);
+      if (member_struct_nr != -1) {
+        for (int index = 0; index < sdna->names_array_len[name_nr]; index++) {
+          hash_dna_struct(key, sdna, member_struct_nr, data + index * sdna->types_size[type]);
+        }
+      }
+      else {
+        key.add(data, size);
+      }
+    }
+    data += size;
+  }
+}
+
+/* Curve points are edited in place, hash them instead of the pointers in the struct. */
+static void hash_curvemapping(ResultCacheKey &key, const CurveMapping *cumap)
+{
+  key.addInt(cumap->flag);
+  key.addInt(cumap->preset);
+  key.add(&cumap->clipr, sizeof(cumap->clipr));
+  key.add(cumap->black, sizeof(cumap->black));
+  key.add(cumap->white, sizeof(cumap->white));
+  key.addInt(cumap->tone);
+  for (int a = 0; a < CM_TOT; a++) {
+    const CurveMap *cuma = &cumap->cm[a];
+    key.addInt(cuma->totpoint);
+    key.add(cuma->ext_in, sizeof(cuma->ext_in));
+    key.add(cuma->ext_out, sizeof(cuma->ext_out));
+    if (cuma->curve) {
+      key.add(cuma->curve, sizeof(*cuma->curve) * cuma->totpoint);
+    }
+  }
+}
+
+static bool hash_node_id(ResultCacheKey &key, const bNode *node)
+{
+  if (node->id == NULL) {
+    return true;
+  }
+  /* Only images are cached, their buffers are added by the image operations. Other data-blocks
+   * (movie clips, masks, textures...) change with the frame and through other editors. */
+  if (GS(node->id->name) != ID_IM) {
+    return false;
+  }
+  const Image *image = (const Image *)node->id;
+  if (!ELEM(image->source, IMA_SRC_FILE, IMA_SRC_SEQUENCE, IMA_SRC_MOVIE) ||
+      !ELEM(image->type, IMA_TYPE_IMAGE, IMA_TYPE_MULTILAYER)) {
+    return false;
+  }
+  key.addPointer(image);
+  return true;
+}
+
+bool ResultCache::hashNode(const bNode *node,
+                           const CompositorContext &context,
+                           ResultCacheKey &key)
+{
+  if (node == NULL) {
+    return true;
+  }
+  switch (node->type) {
+    case CMP_NODE_R_LAYERS:
+    /* Uses the scene camera. */
+    case CMP_NODE_DEFOCUS:
+      return false;
+    case CMP_NODE_TIME:
+      key.addInt(context.getFramenumber());
+      break;
+  }
+  if (!hash_node_id(key, node)) {
+    return false;
+  }
+
+  key.addString(node->idname);
+  key.addInt(node->custom1);
+  key.addInt(node->custom2);
+  key.addFloat(node->custom3);
+  key.addFloat(node->custom4);
+  if (node->storage) {
+    if (STREQ(node->typeinfo->storagename, "CurveMapping")) {
+      hash_curvemapping(key, (const CurveMapping *)node->storage);
+    }
+    else {
+      const SDNA *sdna = DNA_sdna_current_get();
+      const int struct_nr = DNA_struct_find_nr(sdna, node->typeinfo->storagename);
+      if (struct_nr == -1) {
+        return false;
+      }
+      hash_dna_struct(key, sdna, struct_nr, (const char *)node->storage);
+    }
+  }
+  /* Nodes read the values of unlinked sockets when they are converted to operations. */
+  LISTBASE_FOREACH (const bNodeSocket *, sock, &node->inputs) {
+    hash_mem(key, sock->default_value);
+  }
+  LISTBASE_FOREACH (const bNodeSocket *, sock, &node->outputs) {
+    hash_mem(key, sock->default_value);
+  }
+  return true;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cache
+ * \{ */
+
+typedef struct ResultCacheEntry {
+  /** Data of the key, compared on lookup as different keys can have the same hash. */
+  std::vector<unsigned char> key_data;
+  MemoryBuffer *buffer;
+  size_t size;
+  /** References to the image buffers the result depends on. */
+  std::vector<ImBuf *> imbufs;
+  /** Executions using the result, it isn't freed while used. */
+  int users;
+  /** Last execution which used the result. */
+  unsigned int last_used;
+} ResultCacheEntry;
+
+typedef std::map<uint64_t, ResultCacheEntry> ResultCacheEntries;
+
+static ResultCacheEntries g_entries;
+static size_t g_memory_used = 0;
+static size_t g_memory_limit = 0;
+static unsigned int g_execution = 0;
+
+static size_t result_cache_buffer_size(MemoryBuffer *buffer)
+{
+  return sizeof(float) * buffer->getWidth() * buffer->getHeight() * buffer->get_num_channels();
+}
+
+static void result_cache_entry_free(ResultCacheEntry &entry)
+{
+  delete entry.buffer;
+  for (unsigned int index = 0; index < entry.imbufs.size(); index++) {
+    IMB_freeImBuf(entry.imbufs[index]);
+  }
+  g_memory_used -= entry.size;
+}
+
+void ResultCache::freeUnused(size_t limit)
+{
+  while (g_memory_used > limit) {
+    ResultCacheEntries::iterator oldest = g_entries.end();
+    for (ResultCacheEntries::iterator iter = g_entries.begin(); iter != g_entries.end(); ++iter) {
+      if (iter->second.users == 0 &&
+          (oldest == g_entries.end() || iter->second.last_used < oldest->second.last_used)) {
+        oldest = iter;
+      }
+    }
+    if (oldest == g_entries.end()) {
+      /* Everything is in use. */
+      return;
+    }
+    result_cache_entry_free(oldest->second);
+    g_entries.erase(oldest);
+  }
+}
+
+void ResultCache::beginExecution(size_t limit)
+{
+  g_execution++;
+  g_memory_limit = limit;
+  freeUnused(limit);
+}
+
+static ResultCacheEntries::iterator result_cache_find(const ResultCacheKey &key)
+{
+  ResultCacheEntries::iterator iter = g_entries.find(key.getHash());
+  if (iter == g_entries.end() || iter->second.key_data != key.getData()) {
+    return g_entries.end();
+  }
+  return iter;
+}
+
+MemoryBuffer *ResultCache::acquire(const ResultCacheKey &key)
+{
+  ResultCacheEntries::iterator iter = result_cache_find(key);
+  if (iter == g_entries.end()) {
+    return NULL;
+  }
+  iter->second.users++;
+  iter->second.last_used = g_execution;
+  return iter->second.buffer;
+}
+
+bool ResultCache::insert(const ResultCacheKey &key, MemoryBuffer *buffer)
+{
+  const size_t size = result_cache_buffer_size(buffer);
+  /* A colliding key keeps the entry already cached. */
+  if (size > g_memory_limit || g_entries.count(key.getHash())) {
+    return false;
+  }
+  freeUnused(g_memory_limit - size);
+
+  ResultCacheEntry &entry = g_entries[key.getHash()];
+  entry.key_data = key.getData();
+  entry.buffer = buffer;
+  entry.size = size;
+  entry.imbufs = key.getImBufs();
+  for (unsigned int index = 0; index < entry.imbufs.size(); index++) {
+    IMB_refImBuf(entry.imbufs[index]);
+  }
+  entry.users = 1;
+  entry.last_used = g_execution;
+  g_memory_used += size;
+  return true;
+}
+
+void ResultCache::release(const ResultCacheKey &key)
+{
+  ResultCacheEntries::iterator iter = result_cache_find(key);
+  BLI_assert(iter != g_entries.end() && iter->second.users > 0);
+  iter->second.users--;
+}
+
+void ResultCache::clear()
+{
+  for (ResultCacheEntries::iterator iter = g_entries.begin(); iter != g_entries.end(); ++iter) {
+    result_cache_entry_free(iter->second);
+  }
+  g_entries.clear();
+  BLI_assert(g_memory_used == 0);
+}
+
+/** \} */
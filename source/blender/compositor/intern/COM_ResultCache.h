@@ -0,0 +1,138 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#ifndef __COM_RESULTCACHE_H__
+#define __COM_RESULTCACHE_H__
+
+#include <stddef.h>
+#include <vector>
+
+#include "BLI_sys_types.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+class CompositorContext;
+class MemoryBuffer;
+struct ImBuf;
+struct bNode;
+
+/**
+ * \brief Identifies the result of an operation in the ResultCache.
+ *
+ * Everything the result depends on: the settings of the operation and the keys of its inputs.
+ * Results are looked up by hash and the data is compared to rule out collisions. Image buffers
+ * the result is calculated from are added by address and change counter, results keep a
+ * reference to them while cached so the address can't be reused by another buffer.
+ * \ingroup Memory
+ */
+class ResultCacheKey {
+ private:
+  uint64_t m_hash;
+  std::vector<unsigned char> m_data;
+  std::vector<ImBuf *> m_imbufs;
+
+ public:
+  ResultCacheKey();
+
+  void add(const void *data, size_t size);
+  void addInt(int value)
+  {
+    add(&value, sizeof(value));
+  }
+  void addFloat(float value)
+  {
+    add(&value, sizeof(value));
+  }
+  void addPointer(const void *pointer)
+  {
+    add(&pointer, sizeof(pointer));
+  }
+  void addString(const char *str);
+  void addKey(const ResultCacheKey &key);
+  /** \a ibuf can be NULL for images without buffer. */
+  void addImBuf(ImBuf *ibuf);
+
+  uint64_t getHash() const
+  {
+    return this->m_hash;
+  }
+  const std::vector<unsigned char> &getData() const
+  {
+    return this->m_data;
+  }
+  const std::vector<ImBuf *> &getImBufs() const
+  {
+    return this->m_imbufs;
+  }
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:ResultCacheKey")
+#endif
+};
+
+/**
+ * \brief Results of operations kept between executions of the compositor.
+ *
+ * Lets an execution reuse the results of unchanged parts of the node tree, for example
+ * everything before the node which is being tweaked, or still images over a frame range.
+ * Results used by the running execution are kept, others are freed least recently used first
+ * when the memory limit of the user preferences is exceeded.
+ *
+ * Only used by the full-frame execution model, calls are serialized by COM_execute.
+ * \ingroup Memory
+ */
+class ResultCache {
+ public:
+  /**
+   * \brief hash the settings of \a node into \a key
+   * \return false when operations of the node depend on data which is not part of the hash,
+   * their results can't be cached.
+   */
+  static bool hashNode(const bNode *node, const CompositorContext &context, ResultCacheKey &key);
+
+  /**
+   * \brief start of an execution, frees results until within \a limit bytes
+   */
+  static void beginExecution(size_t limit);
+
+  /**
+   * \brief get the cached result of \a key, the result is in use until #release
+   * \return NULL when there is no cached result
+   */
+  static MemoryBuffer *acquire(const ResultCacheKey &key);
+
+  /**
+   * \brief add the result of an operation, in use until #release
+   * \return false when the result doesn't fit in the cache, the caller keeps ownership.
+   */
+  static bool insert(const ResultCacheKey &key, MemoryBuffer *buffer);
+
+  static void release(const ResultCacheKey &key);
+
+  /**
+   * \brief free all results
+   */
+  static void clear();
+
+ private:
+  static void freeUnused(size_t limit);
+};
+
+#endif /* __COM_RESULTCACHE_H__ */
@@ -17,3 +17,35 @@
  */
 
 #include "COM_SocketReader.h"
+
+#include <vector>
+
+namespace {
+
+struct RowSpanScratchPool {
+  /* Buffers are only given out in nesting order, moving a level keeps its memory. */
+  std::vector<std::vector<float>> levels;
+  int depth = 0;
+};
+
+thread_local RowSpanScratchPool row_span_scratch_pool;
+
+}  // namespace
+
+RowSpanScratch::RowSpanScratch(int len)
+{
+  RowSpanScratchPool &pool = row_span_scratch_pool;
+  if (pool.depth == (int)pool.levels.size()) {
+    pool.levels.emplace_back();
+  }
+  std::vector<float> &level = pool.levels[pool.depth++];
+  if ((int)level.size() < len) {
+    level.resize(len);
+  }
+  this->m_data = level.data();
+}
+
+RowSpanScratch::~RowSpanScratch()
+{
+  row_span_scratch_pool.depth--;
+}
@@ -94,6 +94,25 @@ class SocketReader {
   {
   }
 
+  /**
+   * \brief calculate a row of pixels
+   * \note this method is called for non-complex, the default implementation calls
+   * executePixelSampled with COM_PS_NEAREST for every pixel of the row.
+   * Operations can override it to process the row at once, results must be the same.
+   * \param output: receives \a length pixels, \a stride floats apart
+   * \param x: the x-coordinate of the first pixel of the row in image space
+   * \param y: the y-coordinate of the row in image space
+   * \param length: number of pixels to calculate
+   * \param stride: number of floats between two pixels in \a output
+   */
+  virtual void executeRow(float *output, int x, int y, int length, int stride)
+  {
+    for (int i = 0; i < length; i++) {
+      executePixelSampled(output, x + i, y, COM_PS_NEAREST);
+      output += stride;
+    }
+  }
+
  public:
   inline void readSampled(float result[4], float x, float y, PixelSampler sampler)
   {
@@ -107,6 +126,10 @@ class SocketReader {
   {
     executePixelFiltered(result, x, y, dx, dy);
   }
+  inline void readRow(float *result, int x, int y, int length, int stride)
+  {
+    executeRow(result, x, y, length, stride);
+  }
 
   virtual void *initializeTileData(rcti * /*rect*/)
   {
@@ -139,4 +162,25 @@ class SocketReader {
 #endif
 };
 
+/**
+ * \brief Scratch memory for #SocketReader::executeRow implementations.
+ * Rows pull their inputs recursively, so span buffers on the call stack would add up with the
+ * depth of the node tree and can overflow the small stacks of worker threads. Buffers are taken
+ * from a per-thread pool with one buffer for every nesting level instead, and kept for reuse.
+ */
+class RowSpanScratch {
+ private:
+  float *m_data;
+
+ public:
+  /** Take a buffer of at least \a len floats, valid until this is destructed. */
+  RowSpanScratch(int len);
+  ~RowSpanScratch();
+
+  inline float *data()
+  {
+    return this->m_data;
+  }
+};
+
 #endif /* __COM_SOCKETREADER_H__ */
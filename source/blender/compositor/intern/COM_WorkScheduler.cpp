@@ -29,31 +29,51 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "PIL_time.h"
 
 #include "BKE_global.h"
 
+#include "atomic_ops.h"
+
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
 #  ifndef DEBUG /* test this so we dont get warnings in debug builds */
 #    warning COM_CURRENT_THREADING_MODEL COM_TM_NOTHREAD is activated. Use only for debugging.
 #  endif
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+/* do nothing */
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 /* do nothing - default */
 #else
 #  error COM_CURRENT_THREADING_MODEL No threading model selected
 #endif
 
-/// \brief list of all CPUDevices. for every hardware thread an instance of CPUDevice is created
+/// \brief list of the CPUDevices of the queue threads, one for every hardware thread
 static vector<CPUDevice *> g_cpudevices;
 static ThreadLocal(CPUDevice *) g_thread_device;
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+static bool g_cpuInitialized = false;
+/// \brief number of scheduled work packages which are not finished
+static unsigned int g_pendingWork = 0;
+static ThreadMutex g_pendingWorkMutex = BLI_MUTEX_INITIALIZER;
+static ThreadCondition g_pendingWorkCondition;
+/// \brief CPUDevices bound to threads on demand, at most one for every thread executing at once
+static vector<CPUDevice *> g_pooldevices;
+/// \brief devices of g_pooldevices which are not bound to a thread
+static vector<CPUDevice *> g_pooldevices_free;
+/// \brief protects g_pooldevices and g_pooldevices_free
+static ThreadMutex g_pooldevicesMutex = BLI_MUTEX_INITIALIZER;
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 /// \brief list of all thread for every CPUDevice in cpudevices a thread exists
 static ListBase g_cputhreads;
-static bool g_cpuInitialized = false;
 /// \brief all scheduled work for the cpu
 static ThreadQueue *g_cpuqueue;
+#  else
+/// \brief all scheduled work for the cpu, executed by the threads of the task scheduler
+static TaskPool *g_cpupool;
+#  endif
 static ThreadQueue *g_gpuqueue;
 #  ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -71,6 +91,17 @@ static bool g_openclInitialized = false;
 #  endif
 #endif
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+static void work_finished()
+{
+  if (atomic_sub_and_fetch_u(&g_pendingWork, 1) == 0) {
+    BLI_mutex_lock(&g_pendingWorkMutex);
+    BLI_condition_notify_all(&g_pendingWorkCondition);
+    BLI_mutex_unlock(&g_pendingWorkMutex);
+  }
+}
+#endif
+
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 void *WorkScheduler::thread_execute_cpu(void *data)
 {
@@ -80,11 +111,83 @@ void *WorkScheduler::thread_execute_cpu(void *data)
   while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
     device->execute(work);
     delete work;
+    work_finished();
   }
 
   return NULL;
 }
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+void WorkScheduler::task_execute_cpu(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  WorkPackage *work = (WorkPackage *)taskdata;
+  CPUDevice *acquired = acquire_thread_device();
+  CPUDevice *device = (CPUDevice *)BLI_thread_local_get(g_thread_device);
+  device->execute(work);
+  release_thread_device(acquired);
+  delete work;
+  work_finished();
+}
+#endif
+
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+static void free_pool_devices()
+{
+  BLI_assert(g_pooldevices_free.size() == g_pooldevices.size());
+  while (!g_pooldevices.empty()) {
+    Device *device = g_pooldevices.back();
+    g_pooldevices.pop_back();
+    device->deinitialize();
+    delete device;
+  }
+  g_pooldevices_free.clear();
+}
+#endif
+
+CPUDevice *WorkScheduler::acquire_thread_device()
+{
+#if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
+  return NULL;
+#else
+  if (BLI_thread_local_get(g_thread_device) != NULL) {
+    /* Nested execution on the same thread keeps using its device. */
+    return NULL;
+  }
+  CPUDevice *device;
+  BLI_mutex_lock(&g_pooldevicesMutex);
+  if (g_pooldevices_free.empty()) {
+    /* Thread ids follow the ids of the devices of the queue threads. */
+    const int thread_id = g_cpudevices.size() + g_pooldevices.size();
+    BLI_assert(thread_id < BLENDER_MAX_THREADS);
+    device = new CPUDevice(thread_id);
+    device->initialize();
+    g_pooldevices.push_back(device);
+  }
+  else {
+    device = g_pooldevices_free.back();
+    g_pooldevices_free.pop_back();
+  }
+  BLI_mutex_unlock(&g_pooldevicesMutex);
+  BLI_thread_local_set(g_thread_device, device);
+  return device;
+#endif
+}
+
+void WorkScheduler::release_thread_device(CPUDevice *device)
+{
+#if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
+  UNUSED_VARS(device);
+#else
+  if (device == NULL) {
+    return;
+  }
+  BLI_thread_local_set(g_thread_device, NULL);
+  BLI_mutex_lock(&g_pooldevicesMutex);
+  g_pooldevices_free.push_back(device);
+  BLI_mutex_unlock(&g_pooldevicesMutex);
+#endif
+}
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 void *WorkScheduler::thread_execute_gpu(void *data)
 {
   Device *device = (Device *)data;
@@ -93,6 +196,7 @@ void *WorkScheduler::thread_execute_gpu(void *data)
   while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
     device->execute(work);
     delete work;
+    work_finished();
   }
 
   return NULL;
@@ -106,30 +210,36 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
   CPUDevice device(0);
   device.execute(package);
   delete package;
-#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#else
+  atomic_add_and_fetch_u(&g_pendingWork, 1);
 #  ifdef COM_OPENCL_ENABLED
   if (group->isOpenCL() && g_openclActive) {
     BLI_thread_queue_push(g_gpuqueue, package);
+    return;
   }
-  else {
-    BLI_thread_queue_push(g_cpuqueue, package);
-  }
-#  else
+#  endif
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   BLI_thread_queue_push(g_cpuqueue, package);
+#  else
+  BLI_task_pool_push(g_cpupool, task_execute_cpu, package, false, NULL);
 #  endif
 #endif
 }
 
 void WorkScheduler::start(CompositorContext &context)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
   unsigned int index;
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   g_cpuqueue = BLI_thread_queue_init();
   BLI_threadpool_init(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
   for (index = 0; index < g_cpudevices.size(); index++) {
     Device *device = g_cpudevices[index];
     BLI_threadpool_insert(&g_cputhreads, device);
   }
+#  else
+  g_cpupool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+#  endif
 #  ifdef COM_OPENCL_ENABLED
   if (context.getHasActiveOpenCLDevices()) {
     g_gpuqueue = BLI_thread_queue_init();
@@ -148,27 +258,31 @@ void WorkScheduler::start(CompositorContext &context)
 }
 void WorkScheduler::finish()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-#  ifdef COM_OPENCL_ENABLED
-  if (g_openclActive) {
-    BLI_thread_queue_wait_finish(g_gpuqueue);
-    BLI_thread_queue_wait_finish(g_cpuqueue);
-  }
-  else {
-    BLI_thread_queue_wait_finish(g_cpuqueue);
-  }
-#  else
-  BLI_thread_queue_wait_finish(cpuqueue);
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  /* The calling thread helps executing the tasks. */
+  BLI_task_pool_work_and_wait(g_cpupool);
 #  endif
+  /* Finished work can schedule more work, wait until no work is left at all. */
+  BLI_mutex_lock(&g_pendingWorkMutex);
+  while (g_pendingWork != 0) {
+    BLI_condition_wait(&g_pendingWorkCondition, &g_pendingWorkMutex);
+  }
+  BLI_mutex_unlock(&g_pendingWorkMutex);
 #endif
 }
 void WorkScheduler::stop()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   BLI_thread_queue_nowait(g_cpuqueue);
   BLI_threadpool_end(&g_cputhreads);
   BLI_thread_queue_free(g_cpuqueue);
   g_cpuqueue = NULL;
+#  else
+  BLI_task_pool_free(g_cpupool);
+  g_cpupool = NULL;
+#  endif
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
     BLI_thread_queue_nowait(g_gpuqueue);
@@ -182,7 +296,7 @@ void WorkScheduler::stop()
 
 bool WorkScheduler::hasGPUDevices()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #  ifdef COM_OPENCL_ENABLED
   return !g_gpudevices.empty();
 #  else
@@ -193,7 +307,7 @@ bool WorkScheduler::hasGPUDevices()
 #endif
 }
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 static void CL_CALLBACK clContextError(const char *errinfo,
                                        const void * /*private_info*/,
                                        size_t /*cb*/,
@@ -205,11 +319,13 @@ static void CL_CALLBACK clContextError(const char *errinfo,
 
 void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+#  if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
   /* deinitialize if number of threads doesn't match */
   if (g_cpudevices.size() != num_cpu_threads) {
     Device *device;
 
+    free_pool_devices();
     while (!g_cpudevices.empty()) {
       device = g_cpudevices.back();
       g_cpudevices.pop_back();
@@ -218,6 +334,7 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
     }
     if (g_cpuInitialized) {
       BLI_thread_local_delete(g_thread_device);
+      BLI_condition_end(&g_pendingWorkCondition);
     }
     g_cpuInitialized = false;
   }
@@ -230,8 +347,18 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
       g_cpudevices.push_back(device);
     }
     BLI_thread_local_create(g_thread_device);
+    BLI_condition_init(&g_pendingWorkCondition);
+    g_cpuInitialized = true;
+  }
+#  else
+  /* The threads of the task scheduler are used, their CPUDevice's are created on demand. */
+  UNUSED_VARS(num_cpu_threads);
+  if (!g_cpuInitialized) {
+    BLI_thread_local_create(g_thread_device);
+    BLI_condition_init(&g_pendingWorkCondition);
     g_cpuInitialized = true;
   }
+#  endif
 
 #  ifdef COM_OPENCL_ENABLED
   /* deinitialize OpenCL GPU's */
@@ -327,10 +454,11 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 
 void WorkScheduler::deinitialize()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
   /* deinitialize CPU threads */
   if (g_cpuInitialized) {
     Device *device;
+    free_pool_devices();
     while (!g_cpudevices.empty()) {
       device = g_cpudevices.back();
       g_cpudevices.pop_back();
@@ -338,6 +466,7 @@ void WorkScheduler::deinitialize()
       delete device;
     }
     BLI_thread_local_delete(g_thread_device);
+    BLI_condition_end(&g_pendingWorkCondition);
     g_cpuInitialized = false;
   }
 
@@ -368,6 +497,11 @@ void WorkScheduler::deinitialize()
 
 int WorkScheduler::current_thread_id()
 {
+#if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
+  return 0;
+#else
   CPUDevice *device = (CPUDevice *)BLI_thread_local_get(g_thread_device);
+  BLI_assert(device != NULL);
   return device->thread_id();
+#endif
 }
@@ -27,6 +27,9 @@
 #include "COM_WorkPackage.h"
 #include "COM_defines.h"
 
+class CPUDevice;
+struct TaskPool;
+
 /** \brief the workscheduler
  * \ingroup execution
  */
@@ -43,7 +46,14 @@ class WorkScheduler {
    * inside this loop new work is queried and being executed
    */
   static void *thread_execute_cpu(void *data);
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  /**
+   * \brief task executing a WorkPackage on the CPUDevice of the thread
+   */
+  static void task_execute_cpu(TaskPool *__restrict pool, void *taskdata);
+#endif
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
   /**
    * \brief main thread loop for gpudevices
    * inside this loop new work is queried and being executed
@@ -98,7 +108,7 @@ class WorkScheduler {
   static void stop();
 
   /**
-   * \brief wait for all work to be completed.
+   * \brief wait for all work to be completed, including work scheduled by finished work.
    */
   static void finish();
 
@@ -110,6 +120,21 @@ class WorkScheduler {
    */
   static bool hasGPUDevices();
 
+  /**
+   * \brief bind a CPUDevice of the pool to the calling thread while it executes work outside of
+   * the queue threads. Devices are reused, so thread ids stay below the number of threads.
+   * \return the device to pass to release_thread_device, NULL when the thread already had one
+   */
+  static CPUDevice *acquire_thread_device();
+
+  /**
+   * \brief give a device of acquire_thread_device back to the pool
+   */
+  static void release_thread_device(CPUDevice *device);
+
+  /**
+   * \brief id of the device bound to the calling thread
+   */
   static int current_thread_id();
 
 #ifdef WITH_CXX_GUARDEDALLOC
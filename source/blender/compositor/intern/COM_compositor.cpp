@@ -16,15 +16,20 @@
  * Copyright 2011, Blender Foundation.
  */
 
+#include "BLI_fileops.h"
 #include "BLI_threads.h"
+#include "PIL_time.h"
 
 #include "BLT_translation.h"
 
 #include "BKE_node.h"
 #include "BKE_scene.h"
 
+#include "COM_ExecutionStatistics.h"
 #include "COM_ExecutionSystem.h"
+#include "COM_MemoryBufferPool.h"
 #include "COM_MovieDistortionOperation.h"
+#include "COM_ResultCache.h"
 #include "COM_WorkScheduler.h"
 #include "COM_compositor.h"
 #include "clew.h"
@@ -79,11 +84,17 @@ void COM_execute(RenderData *rd,
   /* initialize workscheduler, will check if already done. TODO deinitialize somewhere */
   bool use_opencl = (editingtree->flag & NTREE_COM_OPENCL) != 0;
   WorkScheduler::initialize(use_opencl, BKE_render_num_threads(rd));
+  MemoryBufferPool::initialize();
 
   /* set progress bar to 0% and status to init compositing */
   editingtree->progress(editingtree->prh, 0.0);
   editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing"));
 
+  /* Results are only cached by the full-frame execution. */
+  if (editingtree->execution_mode != NTREE_EXECUTION_MODE_FULL_FRAME) {
+    ResultCache::clear();
+  }
+
   bool twopass = (editingtree->flag & NTREE_TWO_PASS) && !rendering;
   /* initialize execution system */
   if (twopass) {
@@ -108,11 +119,42 @@ void COM_execute(RenderData *rd,
   BLI_mutex_unlock(&s_compositorMutex);
 }
 
+bool COM_benchmark(RenderData *rd,
+                   Scene *scene,
+                   bNodeTree *editingtree,
+                   int iterations,
+                   const ColorManagedViewSettings *viewSettings,
+                   const ColorManagedDisplaySettings *displaySettings,
+                   const char *viewName,
+                   const char *filepath)
+{
+  FILE *file = BLI_fopen(filepath, "w");
+  if (file == NULL) {
+    return false;
+  }
+
+  ExecutionStatistics::begin();
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    /* Measure complete executions, not the cached results of the previous one. */
+    ResultCache::clear();
+    const double start_time = PIL_check_seconds_timer();
+    COM_execute(rd, scene, editingtree, true, viewSettings, displaySettings, viewName);
+    ExecutionStatistics::iterationFinished(PIL_check_seconds_timer() - start_time);
+  }
+  ExecutionStatistics::end();
+
+  ExecutionStatistics::writeReport(file, rd, editingtree);
+  fclose(file);
+  return true;
+}
+
 void COM_deinitialize()
 {
   if (is_compositorMutex_init) {
     BLI_mutex_lock(&s_compositorMutex);
     WorkScheduler::deinitialize();
+    ResultCache::clear();
+    MemoryBufferPool::deinitialize();
     is_compositorMutex_init = false;
     BLI_mutex_unlock(&s_compositorMutex);
     BLI_mutex_end(&s_compositorMutex);
@@ -0,0 +1,92 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#include "COM_BufferOperation.h"
+
+BufferOperation::BufferOperation(MemoryBuffer *buffer,
+                                 DataType datatype,
+                                 unsigned int resolution[2])
+    : NodeOperation()
+{
+  this->addOutputSocket(datatype);
+  this->m_buffer = buffer;
+  this->m_single_value = (resolution[0] == 0 || resolution[1] == 0);
+  this->setResolution(resolution);
+}
+
+void *BufferOperation::initializeTileData(rcti * /*rect*/)
+{
+  return this->m_buffer;
+}
+
+void BufferOperation::executePixelSampled(float output[4],
+                                          float x,
+                                          float y,
+                                          PixelSampler sampler)
+{
+  if (this->m_single_value) {
+    this->m_buffer->read(output, 0, 0);
+  }
+  else if (sampler == COM_PS_NEAREST) {
+    this->m_buffer->read(output, x, y);
+  }
+  else {
+    this->m_buffer->readBilinear(output, x, y);
+  }
+}
+
+void BufferOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  if (this->m_single_value) {
+    NodeOperation::executeRow(output, x, y, length, stride);
+  }
+  else {
+    this->m_buffer->readRow(output, x, y, length, stride);
+  }
+}
+
+void BufferOperation::executePixelExtend(float output[4],
+                                         float x,
+                                         float y,
+                                         PixelSampler sampler,
+                                         MemoryBufferExtend extend_x,
+                                         MemoryBufferExtend extend_y)
+{
+  if (this->m_single_value) {
+    this->m_buffer->read(output, 0, 0);
+  }
+  else if (sampler == COM_PS_NEAREST) {
+    this->m_buffer->read(output, x, y, extend_x, extend_y);
+  }
+  else {
+    this->m_buffer->readBilinear(output, x, y, extend_x, extend_y);
+  }
+}
+
+void BufferOperation::executePixelFiltered(
+    float output[4], float x, float y, float dx[2], float dy[2])
+{
+  if (this->m_single_value) {
+    this->m_buffer->read(output, 0, 0);
+  }
+  else {
+    const float uv[2] = {x, y};
+    const float deriv[2][2] = {{dx[0], dx[1]}, {dy[0], dy[1]}};
+    this->m_buffer->readEWA(output, uv, deriv);
+  }
+}
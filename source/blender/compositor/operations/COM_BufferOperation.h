@@ -0,0 +1,57 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#ifndef __COM_BUFFEROPERATION_H__
+#define __COM_BUFFEROPERATION_H__
+
+#include "COM_MemoryBuffer.h"
+#include "COM_NodeOperation.h"
+
+/**
+ * \brief Reads from a MemoryBuffer of the full-frame execution model.
+ *
+ * Takes the place of an input operation while the operations reading from it are executed,
+ * so operations which are not written for full-frame execution can still be used.
+ * \see FullFrameExecutionModel
+ */
+class BufferOperation : public NodeOperation {
+ private:
+  MemoryBuffer *m_buffer;
+  /* Single value stored in the buffer at (0, 0), for inputs without resolution. */
+  bool m_single_value;
+
+ public:
+  /**
+   * \param resolution: resolution of the operation the buffer was calculated for,
+   * zero when it is a single value.
+   */
+  BufferOperation(MemoryBuffer *buffer, DataType datatype, unsigned int resolution[2]);
+
+  void *initializeTileData(rcti *rect);
+  void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executePixelExtend(float output[4],
+                          float x,
+                          float y,
+                          PixelSampler sampler,
+                          MemoryBufferExtend extend_x,
+                          MemoryBufferExtend extend_y);
+  void executePixelFiltered(float output[4], float x, float y, float dx[2], float dy[2]);
+  void executeRow(float *output, int x, int y, int length, int stride);
+};
+
+#endif
@@ -56,7 +56,33 @@ void ColorCorrectionOperation::executePixelSampled(float output[4],
   float inputMask[4];
   this->m_inputImage->readSampled(inputImageColor, x, y, sampler);
   this->m_inputMask->readSampled(inputMask, x, y, sampler);
+  correctPixel(output, inputImageColor, inputMask[0]);
+}
+
+void ColorCorrectionOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  /* Padded, value inputs may write a full pixel for the last one. */
+  RowSpanScratch scratch(COM_ROW_SPAN_LENGTH * 4 + COM_ROW_SPAN_LENGTH + 3);
+  float *inputImageColor = scratch.data();
+  float *inputMask = inputImageColor + COM_ROW_SPAN_LENGTH * 4;
+  float result[4];
+
+  for (int start = 0; start < length; start += COM_ROW_SPAN_LENGTH) {
+    const int span = min_ii(COM_ROW_SPAN_LENGTH, length - start);
+    this->m_inputImage->readRow(inputImageColor, x + start, y, span, 4);
+    this->m_inputMask->readRow(inputMask, x + start, y, span, 1);
+    float *span_output = &output[start * stride];
+    for (int i = 0; i < span; i++) {
+      correctPixel(result, &inputImageColor[i * 4], inputMask[i]);
+      memcpy(&span_output[i * stride], result, sizeof(float) * min_ii(stride, 4));
+    }
+  }
+}
 
+void ColorCorrectionOperation::correctPixel(float output[4],
+                                            const float inputImageColor[4],
+                                            float maskValue)
+{
   float level = (inputImageColor[0] + inputImageColor[1] + inputImageColor[2]) / 3.0f;
   float contrast = this->m_data->master.contrast;
   float saturation = this->m_data->master.saturation;
@@ -65,8 +91,7 @@ void ColorCorrectionOperation::executePixelSampled(float output[4],
   float lift = this->m_data->master.lift;
   float r, g, b;
 
-  float value = inputMask[0];
-  value = min(1.0f, value);
+  float value = min(1.0f, maskValue);
   const float mvalue = 1.0f - value;
 
   float levelShadows = 0.0;
@@ -33,6 +33,8 @@ class ColorCorrectionOperation : public NodeOperation {
   bool m_greenChannelEnabled;
   bool m_blueChannelEnabled;
 
+  void correctPixel(float output[4], const float inputImageColor[4], float maskValue);
+
  public:
   ColorCorrectionOperation();
 
@@ -40,6 +42,7 @@ class ColorCorrectionOperation : public NodeOperation {
    * the inner loop of this program
    */
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 
   /**
    * Initialize the execution
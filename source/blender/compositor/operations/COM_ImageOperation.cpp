@@ -102,6 +102,14 @@ void BaseImageOperation::deinitExecution()
   BKE_image_release_ibuf(this->m_image, this->m_buffer, NULL);
 }
 
+bool BaseImageOperation::getCacheState(ResultCacheKey &key)
+{
+  ImBuf *stackbuf = getImBuf();
+  key.addImBuf(stackbuf);
+  BKE_image_release_ibuf(this->m_image, stackbuf, NULL);
+  return true;
+}
+
 void BaseImageOperation::determineResolution(unsigned int resolution[2],
                                              unsigned int /*preferredResolution*/[2])
 {
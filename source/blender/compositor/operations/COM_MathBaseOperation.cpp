@@ -71,6 +71,31 @@ void MathBaseOperation::clampIfNeeded(float *color)
   }
 }
 
+void MathBaseOperation::executeRowSpans(
+    float *output, int x, int y, int length, int stride, MathSpanFunc func)
+{
+  /* Padded, inputs may write a full pixel for the last one. */
+  RowSpanScratch scratch(COM_ROW_SPAN_LENGTH * 3 + 6);
+  float *value1 = scratch.data();
+  float *value2 = value1 + COM_ROW_SPAN_LENGTH + 3;
+  float *result = value2 + COM_ROW_SPAN_LENGTH + 3;
+
+  for (int start = 0; start < length; start += COM_ROW_SPAN_LENGTH) {
+    const int span = min_ii(COM_ROW_SPAN_LENGTH, length - start);
+
+    this->m_inputValue1Operation->readRow(value1, x + start, y, span, 1);
+    this->m_inputValue2Operation->readRow(value2, x + start, y, span, 1);
+
+    func(result, value1, value2, span);
+
+    float *span_output = &output[start * stride];
+    for (int i = 0; i < span; i++) {
+      clampIfNeeded(&result[i]);
+      span_output[i * stride] = result[i];
+    }
+  }
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
   float inputValue1[4];
@@ -84,6 +109,24 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
   clampIfNeeded(output);
 }
 
+static void math_add_span(float *output, const float *value1, const float *value2, int length)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= length; i += 4) {
+    _mm_storeu_ps(&output[i], _mm_add_ps(_mm_loadu_ps(&value1[i]), _mm_loadu_ps(&value2[i])));
+  }
+#endif
+  for (; i < length; i++) {
+    output[i] = value1[i] + value2[i];
+  }
+}
+
+void MathAddOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, math_add_span);
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -100,6 +143,24 @@ void MathSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void math_subtract_span(float *output, const float *value1, const float *value2, int length)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= length; i += 4) {
+    _mm_storeu_ps(&output[i], _mm_sub_ps(_mm_loadu_ps(&value1[i]), _mm_loadu_ps(&value2[i])));
+  }
+#endif
+  for (; i < length; i++) {
+    output[i] = value1[i] - value2[i];
+  }
+}
+
+void MathSubtractOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, math_subtract_span);
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -116,6 +177,24 @@ void MathMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void math_multiply_span(float *output, const float *value1, const float *value2, int length)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= length; i += 4) {
+    _mm_storeu_ps(&output[i], _mm_mul_ps(_mm_loadu_ps(&value1[i]), _mm_loadu_ps(&value2[i])));
+  }
+#endif
+  for (; i < length; i++) {
+    output[i] = value1[i] * value2[i];
+  }
+}
+
+void MathMultiplyOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, math_multiply_span);
+}
+
 void MathDivideOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -137,6 +216,30 @@ void MathDivideOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void math_divide_span(float *output, const float *value1, const float *value2, int length)
+{
+  int i = 0;
+#ifdef __SSE2__
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (; i + 4 <= length; i += 4) {
+    const __m128 divisor = _mm_loadu_ps(&value2[i]);
+    const __m128 valid = _mm_cmpneq_ps(divisor, zero);
+    /* Divide zeros by one to not raise floating point exceptions, they are masked out. */
+    const __m128 safe_divisor = _mm_or_ps(_mm_and_ps(valid, divisor), _mm_andnot_ps(valid, one));
+    _mm_storeu_ps(&output[i], _mm_and_ps(valid, _mm_div_ps(_mm_loadu_ps(&value1[i]), safe_divisor)));
+  }
+#endif
+  for (; i < length; i++) {
+    output[i] = (value2[i] == 0) ? 0.0f : value1[i] / value2[i];
+  }
+}
+
+void MathDivideOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, math_divide_span);
+}
+
 void MathSineOperation::executePixelSampled(float output[4],
                                             float x,
                                             float y,
@@ -43,6 +43,18 @@ class MathBaseOperation : public NodeOperation {
 
   void clampIfNeeded(float color[4]);
 
+  /** Calculates \a length values of a span, all buffers are contiguous. */
+  typedef void (*MathSpanFunc)(float *output,
+                               const float *value1,
+                               const float *value2,
+                               int length);
+
+  /**
+   * Implementation of #executeRow for subclasses, reads the first two inputs in spans and
+   * calls \a func for each of them.
+   */
+  void executeRowSpans(float *output, int x, int y, int length, int stride, MathSpanFunc func);
+
  public:
   /**
    * the inner loop of this program
@@ -76,6 +88,7 @@ class MathAddOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 class MathSubtractOperation : public MathBaseOperation {
  public:
@@ -83,6 +96,7 @@ class MathSubtractOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 class MathMultiplyOperation : public MathBaseOperation {
  public:
@@ -90,6 +104,7 @@ class MathMultiplyOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 class MathDivideOperation : public MathBaseOperation {
  public:
@@ -97,6 +112,7 @@ class MathDivideOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 class MathSineOperation : public MathBaseOperation {
  public:
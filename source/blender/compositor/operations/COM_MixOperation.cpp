@@ -63,6 +63,44 @@ void MixBaseOperation::executePixelSampled(float output[4], float x, float y, Pi
   output[3] = inputColor1[3];
 }
 
+void MixBaseOperation::executeRowSpans(
+    float *output, int x, int y, int length, int stride, MixSpanFunc func)
+{
+  /* Padded, value inputs may write a full pixel for the last one. */
+  RowSpanScratch scratch(COM_ROW_SPAN_LENGTH * 4 * 3 + COM_ROW_SPAN_LENGTH + 3);
+  float *color1 = scratch.data();
+  float *color2 = color1 + COM_ROW_SPAN_LENGTH * 4;
+  float *result = color2 + COM_ROW_SPAN_LENGTH * 4;
+  float *value = result + COM_ROW_SPAN_LENGTH * 4;
+
+  for (int start = 0; start < length; start += COM_ROW_SPAN_LENGTH) {
+    const int span = min_ii(COM_ROW_SPAN_LENGTH, length - start);
+    float *span_output = (stride == 4) ? &output[start * 4] : result;
+
+    this->m_inputValueOperation->readRow(value, x + start, y, span, 1);
+    this->m_inputColor1Operation->readRow(color1, x + start, y, span, 4);
+    this->m_inputColor2Operation->readRow(color2, x + start, y, span, 4);
+    if (this->useValueAlphaMultiply()) {
+      for (int i = 0; i < span; i++) {
+        value[i] *= color2[i * 4 + 3];
+      }
+    }
+
+    func(span_output, value, color1, color2, span);
+
+    if (this->m_useClamp) {
+      for (int i = 0; i < span; i++) {
+        clamp_v4(&span_output[i * 4], 0.0f, 1.0f);
+      }
+    }
+    if (span_output == result) {
+      for (int i = 0; i < span; i++) {
+        memcpy(&output[(start + i) * stride], &result[i * 4], sizeof(float) * min_ii(stride, 4));
+      }
+    }
+  }
+}
+
 void MixBaseOperation::determineResolution(unsigned int resolution[2],
                                            unsigned int preferredResolution[2])
 {
@@ -124,6 +162,28 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
   clampIfNeeded(output);
 }
 
+static void mix_add_span(
+    float *output, const float *value, const float *color1, const float *color2, int length)
+{
+  for (int i = 0; i < length; i++, output += 4, color1 += 4, color2 += 4) {
+#ifdef __SSE2__
+    const __m128 v = _mm_set1_ps(value[i]);
+    _mm_storeu_ps(output,
+                  _mm_add_ps(_mm_loadu_ps(color1), _mm_mul_ps(v, _mm_loadu_ps(color2))));
+#else
+    output[0] = color1[0] + value[i] * color2[0];
+    output[1] = color1[1] + value[i] * color2[1];
+    output[2] = color1[2] + value[i] * color2[2];
+#endif
+    output[3] = color1[3];
+  }
+}
+
+void MixAddOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, mix_add_span);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -158,6 +218,31 @@ void MixBlendOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void mix_blend_span(
+    float *output, const float *value, const float *color1, const float *color2, int length)
+{
+  for (int i = 0; i < length; i++, output += 4, color1 += 4, color2 += 4) {
+#ifdef __SSE2__
+    const __m128 v = _mm_set1_ps(value[i]);
+    const __m128 vm = _mm_set1_ps(1.0f - value[i]);
+    _mm_storeu_ps(output,
+                  _mm_add_ps(_mm_mul_ps(vm, _mm_loadu_ps(color1)),
+                             _mm_mul_ps(v, _mm_loadu_ps(color2))));
+#else
+    const float valuem = 1.0f - value[i];
+    output[0] = valuem * color1[0] + value[i] * color2[0];
+    output[1] = valuem * color1[1] + value[i] * color2[1];
+    output[2] = valuem * color1[2] + value[i] * color2[2];
+#endif
+    output[3] = color1[3];
+  }
+}
+
+void MixBlendOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, mix_blend_span);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixColorBurnOperation::MixColorBurnOperation() : MixBaseOperation()
@@ -705,6 +790,31 @@ void MixMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void mix_multiply_span(
+    float *output, const float *value, const float *color1, const float *color2, int length)
+{
+  for (int i = 0; i < length; i++, output += 4, color1 += 4, color2 += 4) {
+#ifdef __SSE2__
+    const __m128 v = _mm_set1_ps(value[i]);
+    const __m128 vm = _mm_set1_ps(1.0f - value[i]);
+    _mm_storeu_ps(output,
+                  _mm_mul_ps(_mm_loadu_ps(color1),
+                             _mm_add_ps(vm, _mm_mul_ps(v, _mm_loadu_ps(color2)))));
+#else
+    const float valuem = 1.0f - value[i];
+    output[0] = color1[0] * (valuem + value[i] * color2[0]);
+    output[1] = color1[1] * (valuem + value[i] * color2[1]);
+    output[2] = color1[2] * (valuem + value[i] * color2[2]);
+#endif
+    output[3] = color1[3];
+  }
+}
+
+void MixMultiplyOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, mix_multiply_span);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -831,6 +941,34 @@ void MixScreenOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void mix_screen_span(
+    float *output, const float *value, const float *color1, const float *color2, int length)
+{
+#ifdef __SSE2__
+  const __m128 one = _mm_set1_ps(1.0f);
+#endif
+  for (int i = 0; i < length; i++, output += 4, color1 += 4, color2 += 4) {
+#ifdef __SSE2__
+    const __m128 v = _mm_set1_ps(value[i]);
+    const __m128 vm = _mm_set1_ps(1.0f - value[i]);
+    const __m128 factor = _mm_add_ps(vm, _mm_mul_ps(v, _mm_sub_ps(one, _mm_loadu_ps(color2))));
+    _mm_storeu_ps(output,
+                  _mm_sub_ps(one, _mm_mul_ps(factor, _mm_sub_ps(one, _mm_loadu_ps(color1)))));
+#else
+    const float valuem = 1.0f - value[i];
+    output[0] = 1.0f - (valuem + value[i] * (1.0f - color2[0])) * (1.0f - color1[0]);
+    output[1] = 1.0f - (valuem + value[i] * (1.0f - color2[1])) * (1.0f - color1[1]);
+    output[2] = 1.0f - (valuem + value[i] * (1.0f - color2[2])) * (1.0f - color1[2]);
+#endif
+    output[3] = color1[3];
+  }
+}
+
+void MixScreenOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, mix_screen_span);
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
@@ -909,6 +1047,28 @@ void MixSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void mix_subtract_span(
+    float *output, const float *value, const float *color1, const float *color2, int length)
+{
+  for (int i = 0; i < length; i++, output += 4, color1 += 4, color2 += 4) {
+#ifdef __SSE2__
+    const __m128 v = _mm_set1_ps(value[i]);
+    _mm_storeu_ps(output,
+                  _mm_sub_ps(_mm_loadu_ps(color1), _mm_mul_ps(v, _mm_loadu_ps(color2))));
+#else
+    output[0] = color1[0] - value[i] * color2[0];
+    output[1] = color1[1] - value[i] * color2[1];
+    output[2] = color1[2] - value[i] * color2[2];
+#endif
+    output[3] = color1[3];
+  }
+}
+
+void MixSubtractOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  executeRowSpans(output, x, y, length, stride, mix_subtract_span);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
@@ -43,6 +43,22 @@ class MixBaseOperation : public NodeOperation {
     }
   }
 
+  /**
+   * Calculates \a length pixels, all buffers have a stride of 4 floats except \a value.
+   * The alpha multiply of \a value is already applied.
+   */
+  typedef void (*MixSpanFunc)(float *output,
+                              const float *value,
+                              const float *color1,
+                              const float *color2,
+                              int length);
+
+  /**
+   * Implementation of #executeRow for subclasses, reads the inputs in spans and
+   * calls \a func for each of them.
+   */
+  void executeRowSpans(float *output, int x, int y, int length, int stride, MixSpanFunc func);
+
  public:
   /**
    * Default constructor
@@ -84,12 +100,14 @@ class MixAddOperation : public MixBaseOperation {
  public:
   MixAddOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 
 class MixBlendOperation : public MixBaseOperation {
  public:
   MixBlendOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 
 class MixColorBurnOperation : public MixBaseOperation {
@@ -156,6 +174,7 @@ class MixMultiplyOperation : public MixBaseOperation {
  public:
   MixMultiplyOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -174,6 +193,7 @@ class MixScreenOperation : public MixBaseOperation {
  public:
   MixScreenOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
@@ -186,6 +206,7 @@ class MixSubtractOperation : public MixBaseOperation {
  public:
   MixSubtractOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, int x, int y, int length, int stride);
 };
 
 class MixValueOperation : public MixBaseOperation {
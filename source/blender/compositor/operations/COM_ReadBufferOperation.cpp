@@ -74,6 +74,16 @@ void ReadBufferOperation::executePixelSampled(float output[4],
   }
 }
 
+void ReadBufferOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  if (m_single_value) {
+    NodeOperation::executeRow(output, x, y, length, stride);
+  }
+  else {
+    m_buffer->readRow(output, x, y, length, stride);
+  }
+}
+
 void ReadBufferOperation::executePixelExtend(float output[4],
                                              float x,
                                              float y,
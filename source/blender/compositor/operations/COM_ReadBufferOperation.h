@@ -51,6 +51,7 @@ class ReadBufferOperation : public NodeOperation {
                           MemoryBufferExtend extend_x,
                           MemoryBufferExtend extend_y);
   void executePixelFiltered(float output[4], float x, float y, float dx[2], float dy[2]);
+  void executeRow(float *output, int x, int y, int length, int stride);
   bool isReadBufferOperation() const
   {
     return true;
@@ -72,6 +73,14 @@ class ReadBufferOperation : public NodeOperation {
   }
   void readResolutionFromWriteBuffer();
   void updateMemoryBuffer();
+  /**
+   * Read from \a buffer instead of the buffer of the memory proxy,
+   * used by the full-frame execution model.
+   */
+  void setMemoryBuffer(MemoryBuffer *buffer)
+  {
+    this->m_buffer = buffer;
+  }
 };
 
 #endif
@@ -47,6 +47,28 @@ void SetAlphaOperation::executePixelSampled(float output[4],
   output[3] = alphaInput[0];
 }
 
+void SetAlphaOperation::executeRow(float *output, int x, int y, int length, int stride)
+{
+  if (stride < 4) {
+    NodeOperation::executeRow(output, x, y, length, stride);
+    return;
+  }
+
+  /* Padded, value inputs may write a full pixel for the last one. */
+  RowSpanScratch scratch(COM_ROW_SPAN_LENGTH + 3);
+  float *alphaInput = scratch.data();
+
+  this->m_inputColor->readRow(output, x, y, length, stride);
+  for (int start = 0; start < length; start += COM_ROW_SPAN_LENGTH) {
+    const int span = min_ii(COM_ROW_SPAN_LENGTH, length - start);
+    this->m_inputAlpha->readRow(alphaInput, x + start, y, span, 1);
+    float *span_output = &output[start * stride];
+    for (int i = 0; i < span; i++) {
+      span_output[i * stride + 3] = alphaInput[i];
+    }
+  }
+}
+
 void SetAlphaOperation::deinitExecution()
 {
   this->m_inputColor = NULL;
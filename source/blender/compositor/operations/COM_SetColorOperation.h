@@ -81,5 +81,11 @@ class SetColorOperation : public NodeOperation {
   {
     return true;
   }
+
+  bool getCacheState(ResultCacheKey &key)
+  {
+    key.add(this->m_color, sizeof(this->m_color));
+    return true;
+  }
 };
 #endif
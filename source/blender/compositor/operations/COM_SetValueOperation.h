@@ -53,5 +53,11 @@ class SetValueOperation : public NodeOperation {
   {
     return true;
   }
+
+  bool getCacheState(ResultCacheKey &key)
+  {
+    key.addFloat(this->m_value);
+    return true;
+  }
 };
 #endif
@@ -81,6 +81,15 @@ class SetVectorOperation : public NodeOperation {
     return true;
   }
 
+  bool getCacheState(ResultCacheKey &key)
+  {
+    key.addFloat(this->m_x);
+    key.addFloat(this->m_y);
+    key.addFloat(this->m_z);
+    key.addFloat(this->m_w);
+    return true;
+  }
+
   void setVector(const float vector[3])
   {
     setX(vector[0]);
@@ -91,23 +91,28 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   const int offsetadd4 = offsetadd * 4;
   int offset = (y1 * this->getWidth() + x1);
   int offset4 = offset * 4;
-  float alpha[4], depth[4];
+  /* Padded, value inputs may write a full pixel for the last one. */
+  float alpha[COM_ROW_SPAN_LENGTH + 3], depth[COM_ROW_SPAN_LENGTH + 3];
   int x;
   int y;
   bool breaked = false;
 
   for (y = y1; y < y2 && (!breaked); y++) {
-    for (x = x1; x < x2; x++) {
-      this->m_imageInput->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
+    for (x = x1; x < x2; x += COM_ROW_SPAN_LENGTH) {
+      const int length = min_ii(COM_ROW_SPAN_LENGTH, x2 - x);
+      float *row = &buffer[offset4];
+      this->m_imageInput->readRow(row, x, y, length, 4);
       if (this->m_useAlphaInput) {
-        this->m_alphaInput->readSampled(alpha, x, y, COM_PS_NEAREST);
-        buffer[offset4 + 3] = alpha[0];
+        this->m_alphaInput->readRow(alpha, x, y, length, 1);
+        for (int i = 0; i < length; i++) {
+          row[i * 4 + 3] = alpha[i];
+        }
       }
-      this->m_depthInput->readSampled(depth, x, y, COM_PS_NEAREST);
-      depthbuffer[offset] = depth[0];
+      this->m_depthInput->readRow(depth, x, y, length, 1);
+      memcpy(&depthbuffer[offset], depth, sizeof(float) * length);
 
-      offset++;
-      offset4 += 4;
+      offset += length;
+      offset4 += length * 4;
     }
     if (isBraked()) {
       breaked = true;
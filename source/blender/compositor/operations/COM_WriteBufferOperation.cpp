@@ -91,15 +91,11 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
     int x2 = rect->xmax;
     int y2 = rect->ymax;
 
-    int x;
     int y;
     bool breaked = false;
     for (y = y1; y < y2 && (!breaked); y++) {
       int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
-      for (x = x1; x < x2; x++) {
-        this->m_input->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
-        offset4 += num_channels;
-      }
+      this->m_input->readRow(&(buffer[offset4]), x1, y, x2 - x1, num_channels);
       if (isBraked()) {
         breaked = true;
       }
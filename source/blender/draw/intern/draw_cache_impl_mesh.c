@@ -592,6 +592,37 @@ static void mesh_batch_cache_discard_uvedit(MeshBatchCache *cache)
   cache->batch_ready &= ~MBC_SURFACE;
 }
 
+/**
+ * Keep index buffers around, they only depend on topology (see #BKE_MESH_BATCH_DIRTY_DEFORM),
+ * except the paint mask and UV editing ones which also depend on selection.
+ */
+static void mesh_batch_cache_discard_deform(MeshBatchCache *cache)
+{
+  FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
+    GPUVertBuf **vbos = (GPUVertBuf **)&mbufcache->vbo;
+    for (int i = 0; i < sizeof(mbufcache->vbo) / sizeof(void *); i++) {
+      GPU_VERTBUF_DISCARD_SAFE(vbos[i]);
+    }
+    GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.lines_paint_mask);
+    GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.edituv_tris);
+    GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.edituv_lines);
+    GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.edituv_points);
+    GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.edituv_fdots);
+  }
+  for (int i = 0; i < sizeof(cache->batch) / sizeof(void *); i++) {
+    GPUBatch **batch = (GPUBatch **)&cache->batch;
+    GPU_BATCH_DISCARD_SAFE(batch[i]);
+  }
+  mesh_batch_cache_discard_shaded_batches(cache);
+  mesh_cd_layers_type_clear(&cache->cd_used);
+  drw_mesh_weight_state_clear(&cache->weight_state);
+
+  cache->tot_area = 0.0f;
+  cache->tot_uv_area = 0.0f;
+
+  cache->batch_ready = 0;
+}
+
 static void mesh_batch_cache_discard_uvedit_select(MeshBatchCache *cache)
 {
   FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
@@ -681,6 +712,9 @@ void DRW_mesh_batch_cache_dirty_tag(Mesh *me, int mode)
       GPU_BATCH_DISCARD_SAFE(cache->batch.edituv_fdots);
       cache->batch_ready &= ~MBC_EDITUV;
       break;
+    case BKE_MESH_BATCH_DIRTY_DEFORM:
+      mesh_batch_cache_discard_deform(cache);
+      break;
     default:
       BLI_assert(0);
   }
@@ -170,6 +170,8 @@ void imapaint_image_update(
   if (imapaintpartial.x1 != imapaintpartial.x2 && imapaintpartial.y1 != imapaintpartial.y2) {
     IMB_partial_display_buffer_update_delayed(
         ibuf, imapaintpartial.x1, imapaintpartial.y1, imapaintpartial.x2, imapaintpartial.y2);
+    /* Pixels are written after the tiles are marked dirty, tell users the buffer changed again. */
+    BKE_image_mark_dirty(image, ibuf);
   }
 
   if (ibuf->mipmap[0]) {
@@ -895,7 +895,8 @@ static void prefetch_task_func(TaskPool *__restrict pool, void *task_data)
   while ((mem = prefetch_thread_next_frame(queue, clip, &size, &current_frame))) {
     ImBuf *ibuf;
     MovieClipUser user = {0};
-    int flag = IB_rect | IB_multilayer | IB_alphamode_detect | IB_metadata;
+    int flag = IB_rect | IB_multilayer | IB_multilayer_deferred | IB_alphamode_detect |
+               IB_metadata;
     int result;
     char *colorspace_name = NULL;
     const bool use_proxy = (clip->flag & MCLIP_USE_PROXY) &&
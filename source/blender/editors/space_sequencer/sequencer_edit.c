@@ -30,9 +30,12 @@
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
 #include "BLI_math.h"
+#include "BLI_threads.h"
 #include "BLI_timecode.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
 #include "BLT_translation.h"
 
 #include "DNA_scene_types.h"
@@ -143,23 +146,111 @@ static void proxy_freejob(void *pjv)
   MEM_freeN(pj);
 }
 
+typedef struct ProxyMovieBuild {
+  struct SeqIndexBuildContext *context;
+  short *stop;
+  short *do_update;
+  float progress;
+  bool done, removed;
+} ProxyMovieBuild;
+
+static void *proxy_build_movie_thread(void *build_v)
+{
+  ProxyMovieBuild *build = build_v;
+
+  BKE_sequencer_proxy_rebuild(build->context, build->stop, build->do_update, &build->progress);
+  build->done = true;
+
+  return NULL;
+}
+
+/* Build the proxies of several movie strips at once. Each one already keeps a few threads busy
+ * decoding and encoding its proxy sizes, so only a part of the cores get a movie. */
+static void proxy_build_movies(ProxyJob *pj, short *stop, short *do_update, float *progress)
+{
+  const int num_contexts = BLI_listbase_count(&pj->queue);
+  const int max_threads = max_ii(1, BLI_system_thread_count() / 4);
+  ProxyMovieBuild *builds;
+  ListBase threads;
+  LinkData *link;
+  int num_builds = 0, num_started = 0;
+
+  builds = MEM_callocN(sizeof(*builds) * max_ii(num_contexts, 1), "proxy movie builds");
+  for (link = pj->queue.first; link; link = link->next) {
+    if (BKE_sequencer_proxy_rebuild_is_movie(link->data)) {
+      builds[num_builds].context = link->data;
+      builds[num_builds].stop = stop;
+      builds[num_builds].do_update = do_update;
+      num_builds++;
+    }
+  }
+
+  if (num_builds == 0) {
+    MEM_freeN(builds);
+    return;
+  }
+
+  BLI_threadpool_init(&threads, proxy_build_movie_thread, max_threads);
+
+  for (;;) {
+    bool running = false;
+    float progress_sum = 0.0f;
+
+    while (num_started < num_builds && !*stop && BLI_available_threads(&threads)) {
+      BLI_threadpool_insert(&threads, &builds[num_started++]);
+    }
+
+    for (int i = 0; i < num_started; i++) {
+      ProxyMovieBuild *build = &builds[i];
+
+      if (build->done) {
+        if (!build->removed) {
+          BLI_threadpool_remove(&threads, build);
+          build->removed = true;
+        }
+        progress_sum += 1.0f;
+      }
+      else {
+        progress_sum += build->progress;
+        running = true;
+      }
+    }
+
+    *progress = progress_sum / num_contexts;
+    *do_update = true;
+
+    if (!running && (num_started == num_builds || *stop)) {
+      break;
+    }
+
+    PIL_sleep_ms(50);
+  }
+
+  BLI_threadpool_end(&threads);
+  MEM_freeN(builds);
+}
+
 /* Only this runs inside thread. */
 static void proxy_startjob(void *pjv, short *stop, short *do_update, float *progress)
 {
   ProxyJob *pj = pjv;
   LinkData *link;
 
-  for (link = pj->queue.first; link; link = link->next) {
-    struct SeqIndexBuildContext *context = link->data;
+  proxy_build_movies(pj, stop, do_update, progress);
 
-    BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
+  /* Other strips render their proxies through the sequencer, one after another. */
+  for (link = pj->queue.first; link && !*stop; link = link->next) {
+    struct SeqIndexBuildContext *context = link->data;
 
-    if (*stop) {
-      pj->stop = 1;
-      fprintf(stderr, "Canceling proxy rebuild on users request...\n");
-      break;
+    if (!BKE_sequencer_proxy_rebuild_is_movie(context)) {
+      BKE_sequencer_proxy_rebuild(context, stop, do_update, progress);
     }
   }
+
+  if (*stop) {
+    pj->stop = 1;
+    fprintf(stderr, "Canceling proxy rebuild on users request...\n");
+  }
 }
 
 static void proxy_endjob(void *pjv)
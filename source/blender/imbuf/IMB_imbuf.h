@@ -445,6 +445,23 @@ struct ImBuf *IMB_onehalf(struct ImBuf *ibuf1);
  */
 bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+typedef enum IMB_Resample_Filter {
+  /** Averages covered pixels when scaling down, interpolates linearly when scaling up. */
+  IMB_RESAMPLE_BOX = 0,
+  IMB_RESAMPLE_BILINEAR = 1,
+  IMB_RESAMPLE_MITCHELL = 2,
+  IMB_RESAMPLE_LANCZOS = 3,
+} IMB_Resample_Filter;
+
+/**
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_resampleImBuf(struct ImBuf *ibuf,
+                       unsigned int newx,
+                       unsigned int newy,
+                       IMB_Resample_Filter filter);
+
 /**
  *
  * \attention Defined in scaling.c
@@ -170,6 +170,8 @@ typedef enum eImBufFlags {
   IB_thumbnail = 1 << 16,
   IB_multiview = 1 << 17,
   IB_halffloat = 1 << 18,
+  /** read the passes of multilayer files later on with IMB_exr_read_passes(), not when loading */
+  IB_multilayer_deferred = 1 << 19,
 } eImBufFlags;
 
 /** \} */
@@ -237,6 +239,8 @@ typedef struct ImBuf {
   int index;
   /** used to set imbuf to dirty and other stuff */
   int userflags;
+  /** incremented when the pixels are changed in place, see #BKE_image_mark_dirty */
+  unsigned int changed_counter;
   /** image metadata */
   struct IDProperty *metadata;
   /** temporary storage */
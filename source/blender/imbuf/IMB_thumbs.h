@@ -83,6 +83,13 @@ struct ImBuf *IMB_thumb_load_blend(const char *blen_path,
                                    const char *blen_id);
 void IMB_thumb_overlay_blend(unsigned int *thumb, int width, int height, float aspect);
 
+/* load an image for thumbnail creation, reduced in size while decoding when the format allows */
+struct ImBuf *IMB_thumb_load_image(const char *filepath,
+                                   size_t max_thumb_size,
+                                   char *colorspace,
+                                   size_t *r_width,
+                                   size_t *r_height);
+
 /* special function for previewing fonts */
 struct ImBuf *IMB_thumb_load_font(const char *filename, unsigned int x, unsigned int y);
 bool IMB_thumb_load_font_get_hash(char *r_hash);
@@ -30,9 +30,6 @@ extern "C" {
 
 struct ImBuf;
 
-void imb_refcounter_lock_init(void);
-void imb_refcounter_lock_exit(void);
-
 #ifdef WIN32
 void imb_mmap_lock_init(void);
 void imb_mmap_lock_exit(void);
@@ -82,7 +82,9 @@
 #define MAXNUMSTREAMS 50
 
 struct IDProperty;
+struct TaskPool;
 struct _AviMovie;
+struct anim_gop_frame;
 struct anim_index;
 
 struct anim {
@@ -137,6 +139,13 @@ struct anim {
   int64_t last_pts;
   int64_t next_pts;
   AVPacket next_packet;
+
+  /* Decodes the frame following the fetched one in the background. */
+  struct TaskPool *read_ahead_pool;
+  /* Frames decoded since the last seek, oldest first, so stepping back does not seek. Allocated
+   * on the first backward step. */
+  struct anim_gop_frame *gop_cache;
+  int gop_cache_start, gop_cache_len, gop_cache_size;
 #endif
 
   char index_dir[768];
@@ -41,6 +41,15 @@ typedef struct ImFileType {
                         int flags,
                         char colorspace[IM_MAX_SPACE]);
   struct ImBuf *(*load_filepath)(const char *name, int flags, char colorspace[IM_MAX_SPACE]);
+  /** Load a reduced resolution version of the image, at least `max_thumb_size` on its largest
+   * side when possible, returning the dimensions of the full image in `r_width` and `r_height`. */
+  struct ImBuf *(*load_thumbnail)(const unsigned char *mem,
+                                  size_t size,
+                                  int flags,
+                                  size_t max_thumb_size,
+                                  char colorspace[IM_MAX_SPACE],
+                                  size_t *r_width,
+                                  size_t *r_height);
   int (*save)(struct ImBuf *ibuf, const char *name, int flags);
   void (*load_tile)(struct ImBuf *ibuf,
                     const unsigned char *mem,
@@ -108,6 +117,13 @@ struct ImBuf *imb_load_jpeg(const unsigned char *buffer,
                             size_t size,
                             int flags,
                             char colorspace[IM_MAX_SPACE]);
+struct ImBuf *imb_thumbnail_jpeg(const unsigned char *mem,
+                                 size_t size,
+                                 int flags,
+                                 size_t max_thumb_size,
+                                 char colorspace[IM_MAX_SPACE],
+                                 size_t *r_width,
+                                 size_t *r_height);
 
 /* bmp */
 int imb_is_a_bmp(const unsigned char *buf);
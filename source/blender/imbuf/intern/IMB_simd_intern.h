@@ -0,0 +1,58 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#ifndef __IMB_SIMD_INTERN_H__
+#define __IMB_SIMD_INTERN_H__
+
+/** \file
+ * \ingroup imbuf
+ *
+ * Pixel kernels that have an SSE2 and a scalar implementation. The SSE2 one is used when
+ * \a use_simd is set and it is available, so tests can compare both.
+ */
+
+#include "IMB_imbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Defined in divers.c */
+void imb_rgba_float_to_uchar_row(
+    unsigned char *to, const float *from, int width, bool predivide, bool use_simd);
+void imb_rgba_uchar_to_float_row(float *to, const unsigned char *from, int width, bool use_simd);
+void imb_premul_to_straight_row(float *fp, int width, bool use_simd);
+void imb_straight_to_premul_row(float *fp, int width, bool use_simd);
+
+/* Defined in scaling.c, returns a new buffer of newx by newy pixels, or NULL when the size does
+ * not change. */
+void *imb_resample_buffer(const void *in,
+                          bool is_float,
+                          int channels,
+                          int x,
+                          int y,
+                          int newx,
+                          int newy,
+                          IMB_Resample_Filter filter,
+                          bool use_simd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IMB_SIMD_INTERN_H__ */
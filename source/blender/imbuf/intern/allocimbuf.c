@@ -38,21 +38,11 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
-static SpinLock refcounter_spin;
-
-void imb_refcounter_lock_init(void)
-{
-  BLI_spin_init(&refcounter_spin);
-}
-
-void imb_refcounter_lock_exit(void)
-{
-  BLI_spin_end(&refcounter_spin);
-}
-
 #ifdef WIN32
 static SpinLock mmap_spin;
 
@@ -211,16 +201,8 @@ void imb_freerectImbuf_all(ImBuf *ibuf)
 void IMB_freeImBuf(ImBuf *ibuf)
 {
   if (ibuf) {
-    bool needs_free = false;
-
-    BLI_spin_lock(&refcounter_spin);
-    if (ibuf->refcounter > 0) {
-      ibuf->refcounter--;
-    }
-    else {
-      needs_free = true;
-    }
-    BLI_spin_unlock(&refcounter_spin);
+    /* Only the last user sees the counter drop below zero. */
+    const bool needs_free = atomic_sub_and_fetch_int32(&ibuf->refcounter, 1) < 0;
 
     if (needs_free) {
       imb_freerectImbuf_all(ibuf);
@@ -238,9 +220,7 @@ void IMB_freeImBuf(ImBuf *ibuf)
 
 void IMB_refImBuf(ImBuf *ibuf)
 {
-  BLI_spin_lock(&refcounter_spin);
-  ibuf->refcounter++;
-  BLI_spin_unlock(&refcounter_spin);
+  atomic_add_and_fetch_int32(&ibuf->refcounter, 1);
 }
 
 ImBuf *IMB_makeSingleUser(ImBuf *ibuf)
@@ -248,10 +228,7 @@ ImBuf *IMB_makeSingleUser(ImBuf *ibuf)
   ImBuf *rval;
 
   if (ibuf) {
-    bool is_single;
-    BLI_spin_lock(&refcounter_spin);
-    is_single = (ibuf->refcounter == 0);
-    BLI_spin_unlock(&refcounter_spin);
+    const bool is_single = (ibuf->refcounter == 0);
     if (is_single) {
       return ibuf;
     }
@@ -53,10 +53,14 @@
 #  include <io.h>
 #endif
 
+#include "BLI_math_base.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
+#include "MEM_CacheLimiterC-Api.h"
 #include "MEM_guardedalloc.h"
 
 #ifdef WITH_AVI
@@ -250,6 +254,7 @@ struct IDProperty *IMB_anim_load_metadata(struct anim *anim)
       AVDictionaryEntry *entry = NULL;
 
       BLI_assert(anim->pFormatCtx != NULL);
+      BLI_task_pool_work_and_wait(anim->read_ahead_pool);
       av_log(anim->pFormatCtx, AV_LOG_DEBUG, "METADATA FETCH\n");
 
       while (true) {
@@ -500,11 +505,108 @@ static ImBuf *avi_fetchibuf(struct anim *anim, int position)
 
 #ifdef WITH_FFMPEG
 
+/* Decoded frames of the GOP cache of one movie may use this fraction of the memory cache
+ * limit, they are kept besides the frames of the movie cache. */
+#  define FFMPEG_GOP_CACHE_MEM_DIV 16
+#  define FFMPEG_GOP_CACHE_MAX_FRAMES 64
+/* FFmpeg advises against more threads, decoders gain little from them. */
+#  define FFMPEG_DECODE_MAX_THREADS 16
+
+struct anim_gop_frame {
+  AVFrame *frame;
+  int64_t pts;
+};
+
 BLI_INLINE bool need_aligned_ffmpeg_buffer(struct anim *anim)
 {
   return (anim->x & 31) != 0;
 }
 
+static void ffmpeg_gop_cache_clear(struct anim *anim)
+{
+  for (int i = 0; i < anim->gop_cache_len; i++) {
+    struct anim_gop_frame *gop_frame =
+        &anim->gop_cache[(anim->gop_cache_start + i) % anim->gop_cache_size];
+    av_frame_free(&gop_frame->frame);
+  }
+  anim->gop_cache_start = 0;
+  anim->gop_cache_len = 0;
+}
+
+/* Allocate the GOP cache, only done once seeking backwards since playing forward never finds
+ * frames in it. */
+static void ffmpeg_gop_cache_ensure(struct anim *anim)
+{
+  const size_t mem = MEM_CacheLimiter_get_maximum() / FFMPEG_GOP_CACHE_MEM_DIV;
+  int frame_size;
+
+  if (anim->gop_cache) {
+    return;
+  }
+
+  frame_size = avpicture_get_size(
+      anim->pCodecCtx->pix_fmt, anim->pCodecCtx->width, anim->pCodecCtx->height);
+  if (frame_size <= 0) {
+    return;
+  }
+
+  /* Without a memory cache limit only the number of frames is limited. */
+  anim->gop_cache_size = (mem != 0) ? (int)min_zz(mem / frame_size, FFMPEG_GOP_CACHE_MAX_FRAMES) :
+                                      FFMPEG_GOP_CACHE_MAX_FRAMES;
+  if (anim->gop_cache_size < 2) {
+    /* At least one frame besides the one the decoder continues from. */
+    anim->gop_cache_size = 0;
+    return;
+  }
+
+  anim->gop_cache = MEM_callocN(sizeof(*anim->gop_cache) * anim->gop_cache_size,
+                                "ffmpeg gop cache");
+  anim->gop_cache_start = 0;
+  anim->gop_cache_len = 0;
+}
+
+/* Keep a reference to a decoded frame, dropping the oldest one when the cache is full. */
+static void ffmpeg_gop_cache_add(struct anim *anim, AVFrame *frame, int64_t pts)
+{
+  struct anim_gop_frame *gop_frame;
+
+  if (anim->gop_cache_size == 0) {
+    return;
+  }
+
+  if (anim->gop_cache_len == anim->gop_cache_size) {
+    gop_frame = &anim->gop_cache[anim->gop_cache_start];
+    av_frame_free(&gop_frame->frame);
+    anim->gop_cache_start = (anim->gop_cache_start + 1) % anim->gop_cache_size;
+    anim->gop_cache_len--;
+  }
+
+  gop_frame = &anim->gop_cache[(anim->gop_cache_start + anim->gop_cache_len) %
+                               anim->gop_cache_size];
+  gop_frame->frame = av_frame_clone(frame);
+  gop_frame->pts = pts;
+  if (gop_frame->frame) {
+    anim->gop_cache_len++;
+  }
+}
+
+/* Find the cached frame shown at pts. The newest frame is skipped, it is the one the decoder
+ * continues from and gets returned through the regular path. */
+static AVFrame *ffmpeg_gop_cache_lookup(struct anim *anim, int64_t pts)
+{
+  for (int i = 0; i + 1 < anim->gop_cache_len; i++) {
+    struct anim_gop_frame *gop_frame =
+        &anim->gop_cache[(anim->gop_cache_start + i) % anim->gop_cache_size];
+    struct anim_gop_frame *gop_frame_next =
+        &anim->gop_cache[(anim->gop_cache_start + i + 1) % anim->gop_cache_size];
+
+    if (gop_frame->pts <= pts && pts < gop_frame_next->pts) {
+      return gop_frame->frame;
+    }
+  }
+  return NULL;
+}
+
 static int startffmpeg(struct anim *anim)
 {
   int i, video_stream_index;
@@ -572,6 +674,10 @@ static int startffmpeg(struct anim *anim)
   }
 
   pCodecCtx->workaround_bugs = 1;
+  pCodecCtx->thread_count = min_ii(BLI_system_thread_count(), FFMPEG_DECODE_MAX_THREADS);
+  pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+  /* Decoded frames are kept in the GOP cache by reference. */
+  pCodecCtx->refcounted_frames = 1;
 
   if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
     avformat_close_input(&pFormatCtx);
@@ -743,25 +849,21 @@ static int startffmpeg(struct anim *anim)
   }
 #  endif
 
+  anim->read_ahead_pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+
   return (0);
 }
 
-/* postprocess the image in anim->pFrame and do color conversion
- * and deinterlacing stuff.
+/* postprocess the image in input, a frame decoded by anim->pCodecCtx,
+ * and do color conversion and deinterlacing stuff.
  *
- * Output is anim->last_frame
+ * Output is ibuf
  */
 
-static void ffmpeg_postprocess(struct anim *anim)
+static void ffmpeg_postprocess(struct anim *anim, AVFrame *input, ImBuf *ibuf)
 {
-  AVFrame *input = anim->pFrame;
-  ImBuf *ibuf = anim->last_frame;
   int filter_y = 0;
 
-  if (!anim->pFrameComplete) {
-    return;
-  }
-
   /* This means the data wasn't read properly,
    * this check stops crashing */
   if (input->data[0] == 0 && input->data[1] == 0 && input->data[2] == 0 && input->data[3] == 0) {
@@ -781,7 +883,7 @@ static void ffmpeg_postprocess(struct anim *anim)
 
   if (anim->ib_flags & IB_animdeinterlace) {
     if (avpicture_deinterlace((AVPicture *)anim->pFrameDeinterlaced,
-                              (const AVPicture *)anim->pFrame,
+                              (const AVPicture *)input,
                               anim->pCodecCtx->pix_fmt,
                               anim->pCodecCtx->width,
                               anim->pCodecCtx->height) < 0) {
@@ -908,6 +1010,7 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
 
       if (anim->pFrameComplete) {
         anim->next_pts = av_get_pts_from_frame(anim->pFormatCtx, anim->pFrame);
+        ffmpeg_gop_cache_add(anim, anim->pFrame, anim->next_pts);
 
         av_log(anim->pFormatCtx,
                AV_LOG_DEBUG,
@@ -943,6 +1046,7 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
 
     if (anim->pFrameComplete) {
       anim->next_pts = av_get_pts_from_frame(anim->pFormatCtx, anim->pFrame);
+      ffmpeg_gop_cache_add(anim, anim->pFrame, anim->next_pts);
 
       av_log(anim->pFormatCtx,
              AV_LOG_DEBUG,
@@ -1048,6 +1152,11 @@ static int ffmpeg_seek_by_byte(AVFormatContext *pFormatCtx)
   return false;
 }
 
+static void ffmpeg_decode_next_frame_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  ffmpeg_decode_video_frame((struct anim *)taskdata);
+}
+
 static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Type tc)
 {
   int64_t pts_to_search = 0;
@@ -1058,11 +1167,15 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
   AVStream *v_st;
   int new_frame_index = 0; /* To quiet gcc barking... */
   int old_frame_index = 0; /* To quiet gcc barking... */
+  AVFrame *gop_frame;
 
   if (anim == NULL) {
     return (0);
   }
 
+  /* Decoding of the frame following the previously fetched one may still be running. */
+  BLI_task_pool_work_and_wait(anim->read_ahead_pool);
+
   av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: pos=%d\n", position);
 
   if (tc != IMB_TC_NONE) {
@@ -1109,6 +1222,22 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
     return anim->last_frame;
   }
 
+  if (position < anim->curposition) {
+    ffmpeg_gop_cache_ensure(anim);
+  }
+
+  gop_frame = ffmpeg_gop_cache_lookup(anim, pts_to_search);
+  if (gop_frame) {
+    /* The decoder stays where it is, so playback continues from there without seeking. */
+    ImBuf *ibuf = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
+    ibuf->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
+
+    av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: frame from GOP cache\n");
+
+    ffmpeg_postprocess(anim, gop_frame, ibuf);
+    return ibuf;
+  }
+
   if (position > anim->curposition + 1 && anim->preseek && !tc_index &&
       position - (anim->curposition + 1) < anim->preseek) {
     av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: within preseek interval (no index)\n");
@@ -1182,6 +1311,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
     }
 
     avcodec_flush_buffers(anim->pCodecCtx);
+    ffmpeg_gop_cache_clear(anim);
 
     anim->next_pts = -1;
 
@@ -1208,11 +1338,14 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
   anim->last_frame = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
   anim->last_frame->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
 
-  ffmpeg_postprocess(anim);
+  if (anim->pFrameComplete) {
+    ffmpeg_postprocess(anim, anim->pFrame, anim->last_frame);
+  }
 
   anim->last_pts = anim->next_pts;
 
-  ffmpeg_decode_video_frame(anim);
+  /* Decode the next frame while the caller works on this one. */
+  BLI_task_pool_push(anim->read_ahead_pool, ffmpeg_decode_next_frame_task, anim, false, NULL);
 
   anim->curposition = position;
 
@@ -1228,16 +1361,19 @@ static void free_anim_ffmpeg(struct anim *anim)
   }
 
   if (anim->pCodecCtx) {
+    BLI_task_pool_work_and_wait(anim->read_ahead_pool);
+    BLI_task_pool_free(anim->read_ahead_pool);
+    anim->read_ahead_pool = NULL;
+
+    ffmpeg_gop_cache_clear(anim);
+    MEM_SAFE_FREE(anim->gop_cache);
+    anim->gop_cache_size = 0;
+
     avcodec_close(anim->pCodecCtx);
     avformat_close_input(&anim->pFormatCtx);
 
-    /* Special case here: pFrame could share pointers with codec,
-     * so in order to avoid double-free we don't use av_frame_free()
-     * to free the frame.
-     *
-     * Could it be a bug in FFmpeg?
-     */
-    av_free(anim->pFrame);
+    /* Decoded frames are reference counted, the frame holds its own reference to the data. */
+    av_frame_free(&anim->pFrame);
 
     if (!need_aligned_ffmpeg_buffer(anim)) {
       /* If there's no need for own aligned buffer it means that FFmpeg's
@@ -1407,10 +1543,8 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
 #endif
 #ifdef WITH_FFMPEG
     case ANIM_FFMPEG:
+      /* Sets anim->curposition itself, frames from the GOP cache leave it untouched. */
       ibuf = ffmpeg_fetchibuf(anim, position, tc);
-      if (ibuf) {
-        anim->curposition = position;
-      }
       filter_y = 0; /* done internally */
       break;
 #endif
@@ -1420,7 +1554,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
     if (filter_y) {
       IMB_filtery(ibuf);
     }
-    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, anim->curposition + 1);
+    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, position + 1);
   }
   return (ibuf);
 }
@@ -22,6 +22,7 @@
 
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_memarena.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
@@ -420,14 +421,14 @@ void IMB_tiles_to_rect(ImBuf *ibuf)
   ImBuf *mipbuf;
   ImGlobalTile *gtile;
   unsigned int *to, *from;
-  int a, tx, ty, y, w, h;
+  int a, tx, ty, y, w, y0, y1, tile_ymin, yoffset;
 
   for (a = 0; a < ibuf->miptot; a++) {
     mipbuf = IMB_getmipmap(ibuf, a);
 
     /* don't call imb_addrectImBuf, it frees all mipmaps */
     if (!mipbuf->rect) {
-      if ((mipbuf->rect = MEM_callocN(ibuf->x * ibuf->y * sizeof(unsigned int),
+      if ((mipbuf->rect = MEM_callocN(mipbuf->x * mipbuf->y * sizeof(unsigned int),
                                       "imb_addrectImBuf"))) {
         mipbuf->mall |= IB_rect;
         mipbuf->flags |= IB_rect;
@@ -437,21 +438,28 @@ void IMB_tiles_to_rect(ImBuf *ibuf)
       }
     }
 
+    /* tiles are anchored at the top as in tiled files, the bottom row of tiles starts below the
+     * first row of pixels when the height is not a multiple of the tile height */
+    yoffset = mipbuf->ytiles * mipbuf->tiley - mipbuf->y;
+
     for (ty = 0; ty < mipbuf->ytiles; ty++) {
+      tile_ymin = ty * mipbuf->tiley - yoffset;
+      y0 = max_ii(tile_ymin, 0);
+      y1 = min_ii(tile_ymin + mipbuf->tiley, mipbuf->y);
+
       for (tx = 0; tx < mipbuf->xtiles; tx++) {
         /* acquire tile through cache, this assumes cache is initialized,
          * which it is always now but it's a weak assumption ... */
         gtile = imb_global_cache_get_tile(mipbuf, tx, ty, NULL);
 
         /* setup pointers */
-        from = mipbuf->tiles[mipbuf->xtiles * ty + tx];
-        to = mipbuf->rect + mipbuf->x * ty * mipbuf->tiley + tx * mipbuf->tilex;
+        from = mipbuf->tiles[mipbuf->xtiles * ty + tx] + (y0 - tile_ymin) * mipbuf->tilex;
+        to = mipbuf->rect + mipbuf->x * y0 + tx * mipbuf->tilex;
 
-        /* exception in tile width/height for tiles at end of image */
+        /* exception in tile width for tiles at end of image */
         w = (tx == mipbuf->xtiles - 1) ? mipbuf->x - tx * mipbuf->tilex : mipbuf->tilex;
-        h = (ty == mipbuf->ytiles - 1) ? mipbuf->y - ty * mipbuf->tiley : mipbuf->tiley;
 
-        for (y = 0; y < h; y++) {
+        for (y = y0; y < y1; y++) {
           memcpy(to, from, sizeof(unsigned int) * w);
           from += mipbuf->tilex;
           to += mipbuf->x;
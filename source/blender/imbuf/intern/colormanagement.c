@@ -27,11 +27,16 @@
 #include <math.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "DNA_color_types.h"
 #include "DNA_image_types.h"
 #include "DNA_movieclip_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_space_types.h"
+#include "DNA_userdef_types.h"
 
 #include "IMB_filetype.h"
 #include "IMB_filter.h"
@@ -45,13 +50,16 @@
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_math_color.h"
+#include "BLI_rand.h"
 #include "BLI_rect.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_appdir.h"
 #include "BKE_colortools.h"
 #include "BKE_context.h"
+#include "BKE_global.h"
 #include "BKE_image.h"
 #include "BKE_main.h"
 #include "BKE_sequencer.h"
@@ -101,6 +109,10 @@ typedef struct ColormanageProcessor {
   OCIO_ConstProcessorRcPtr *processor;
   CurveMapping *curve_mapping;
   bool is_data_result;
+  /* Baked version of the processor, used for buffers when set. */
+  struct ColormanageLUT *lut;
+  /* Exposure gain applied before the LUT lookup. */
+  float lut_gain;
 } ColormanageProcessor;
 
 static struct global_glsl_state {
@@ -135,6 +147,24 @@ static struct global_color_picking_state {
   bool failed;
 } global_color_picking_state = {NULL};
 
+static void colormanage_lut_free_all(void);
+static void colormanagement_transform_ex(unsigned char *byte_buffer,
+                                         float *float_buffer,
+                                         int width,
+                                         int height,
+                                         int channels,
+                                         const char *from_colorspace,
+                                         const char *to_colorspace,
+                                         bool predivide,
+                                         bool do_threaded,
+                                         bool use_lut);
+
+/* Whether previews use baked LUTs instead of the exact OCIO processors. */
+static bool colormanage_use_lut(void)
+{
+  return (U.flag & USER_BAKED_DISPLAY_TRANSFORM) && !G.is_rendering;
+}
+
 /*********************** Color managed cache *************************/
 
 /* Cache Implementation Notes
@@ -209,6 +239,7 @@ typedef struct ColormanageCacheViewSettings {
   float gamma;
   float dither;
   CurveMapping *curve_mapping;
+  bool use_lut;
 } ColormanageCacheViewSettings;
 
 typedef struct ColormanageCacheDisplaySettings {
@@ -228,6 +259,7 @@ typedef struct ColormanageCacheData {
   float dither;                /* dither value cached buffer is calculated with */
   CurveMapping *curve_mapping; /* curve mapping used for cached buffer */
   int curve_mapping_timestamp; /* time stamp of curve mapping used for cached buffer */
+  bool use_lut;                /* whether the buffer is calculated with a baked LUT */
 } ColormanageCacheData;
 
 typedef struct ColormanageCache {
@@ -314,6 +346,7 @@ static void colormanage_view_settings_to_cache(ImBuf *ibuf,
   cache_view_settings->dither = ibuf->dither;
   cache_view_settings->flag = view_settings->flag;
   cache_view_settings->curve_mapping = view_settings->curve_mapping;
+  cache_view_settings->use_lut = colormanage_use_lut();
 }
 
 static void colormanage_display_settings_to_cache(
@@ -394,7 +427,8 @@ static unsigned char *colormanage_cache_get(
         cache_data->exposure != view_settings->exposure ||
         cache_data->gamma != view_settings->gamma || cache_data->dither != view_settings->dither ||
         cache_data->flag != view_settings->flag || cache_data->curve_mapping != curve_mapping ||
-        cache_data->curve_mapping_timestamp != curve_mapping_timestamp) {
+        cache_data->curve_mapping_timestamp != curve_mapping_timestamp ||
+        cache_data->use_lut != view_settings->use_lut) {
       *cache_handle = NULL;
 
       IMB_freeImBuf(cache_ibuf);
@@ -444,6 +478,7 @@ static void colormanage_cache_put(ImBuf *ibuf,
   cache_data->flag = view_settings->flag;
   cache_data->curve_mapping = curve_mapping;
   cache_data->curve_mapping_timestamp = curve_mapping_timestamp;
+  cache_data->use_lut = view_settings->use_lut;
 
   colormanage_cachedata_set(cache_ibuf, cache_data);
 
@@ -746,6 +781,8 @@ void colormanagement_exit(void)
   memset(&global_glsl_state, 0, sizeof(global_glsl_state));
   memset(&global_color_picking_state, 0, sizeof(global_color_picking_state));
 
+  colormanage_lut_free_all();
+
   colormanage_free_config();
 }
 
@@ -1032,6 +1069,505 @@ static OCIO_ConstProcessorRcPtr *display_to_scene_linear_processor(ColorManagedD
   return (OCIO_ConstProcessorRcPtr *)display->to_scene_linear;
 }
 
+/*********************** Baked LUT processors *************************/
+
+/* Display transforms of previews can be baked into a 3D LUT, which is a lot cheaper to apply
+ * than running every pixel through OCIO. This is opt-in with the USER_BAKED_DISPLAY_TRANSFORM
+ * preference and only used for display buffers and sequencer previews, never while rendering.
+ * Color space conversions of buffers and images which are written or rendered always go through
+ * the exact processor.
+ *
+ * Inputs go through a shaper first: values from 0 to LUT_LINEAR_MIN are mapped linearly to the
+ * first grid cell, values up to LUT_LINEAR_MAX are spaced logarithmically over the other cells.
+ * Pixels outside of that range are passed to the exact processor instead.
+ *
+ * LUTs are validated against the exact processor after baking, transforms which can't be
+ * baked accurately enough (or which change alpha) keep using the exact processor. */
+
+/* Chosen so 1.0 is a grid point, display transforms usually clip there. */
+#define LUT_SIZE 66
+#define LUT_LOG2_MIN -10.0f
+#define LUT_LOG2_MAX 10.0f
+#define LUT_LINEAR_MIN (1.0f / 1024.0f)
+#define LUT_LINEAR_MAX 1024.0f
+#define LUT_CELLS_PER_LOG2 ((float)(LUT_SIZE - 2) / (LUT_LOG2_MAX - LUT_LOG2_MIN))
+
+/* Largest error allowed, one step of 8 bit displays, relative for values above one. */
+#define LUT_TOLERANCE (1.0f / 255.0f)
+#define LUT_VALIDATE_SAMPLES 4096
+/* Number of LUTs kept around, each takes LUT_SIZE^3 * 16 bytes. */
+#define LUT_CACHE_SIZE 4
+
+typedef struct ColormanageLUTKey {
+  char look[MAX_COLORSPACE_NAME];
+  char view[MAX_COLORSPACE_NAME];
+  char display[MAX_COLORSPACE_NAME];
+  char from_colorspace[MAX_COLORSPACE_NAME];
+  char to_colorspace[MAX_COLORSPACE_NAME];
+  float gamma;
+} ColormanageLUTKey;
+
+typedef struct ColormanageLUT {
+  struct ColormanageLUT *next, *prev;
+  ColormanageLUTKey key;
+  /* Processors using this LUT, and the thread baking it. */
+  int users;
+  /* Set while the table is being baked, without holding lut_lock. */
+  bool is_baking;
+  /* False when the transform could not be baked accurately. */
+  bool is_valid;
+  /* RGB of every grid point, padded to 4 floats. Red changes fastest. */
+  float *table;
+} ColormanageLUT;
+
+/* Baked LUTs, most recently used first. */
+static ListBase global_luts = {NULL, NULL};
+static ThreadMutex lut_lock = BLI_MUTEX_INITIALIZER;
+
+typedef union LUTFloatBits {
+  float f;
+  int i;
+} LUTFloatBits;
+
+/* Input value of grid coordinate \a s, inverse of the shaper. */
+static float lut_shaper_inverse(float s)
+{
+  if (s < 1.0f) {
+    return s * LUT_LINEAR_MIN;
+  }
+  return exp2f(LUT_LOG2_MIN + (s - 1.0f) / LUT_CELLS_PER_LOG2);
+}
+
+/* Polynomial approximation of log2() for normal floats, monotonic and accurate to 1e-4, which
+ * only shifts lookups a tiny fraction of a grid cell. Mirrored by lut_lookup_sse2(). */
+BLI_INLINE float lut_log2(float value)
+{
+  LUTFloatBits bits;
+
+  bits.f = value;
+  const float exponent = (float)((bits.i >> 23) - 127);
+  bits.i = (bits.i & 0x007fffff) | 0x3f800000;
+
+  const float m = bits.f;
+  const float ln_m = -1.7417939f +
+                     (2.8212026f + (-1.4699568f + (0.44717955f - 0.056570851f * m) * m) * m) * m;
+  return exponent + ln_m * (float)M_LOG2E;
+}
+
+/* Grid coordinate of an input value in [0, LUT_LINEAR_MAX). */
+BLI_INLINE float lut_shaper(float value)
+{
+  if (value < LUT_LINEAR_MIN) {
+    return value * (1.0f / LUT_LINEAR_MIN);
+  }
+  return 1.0f + (lut_log2(value) - LUT_LOG2_MIN) * LUT_CELLS_PER_LOG2;
+}
+
+BLI_INLINE bool lut_in_domain(const float rgb[3])
+{
+  /* Written so NaN is out of the domain. */
+  return (rgb[0] >= 0.0f && rgb[0] < LUT_LINEAR_MAX) &&
+         (rgb[1] >= 0.0f && rgb[1] < LUT_LINEAR_MAX) &&
+         (rgb[2] >= 0.0f && rgb[2] < LUT_LINEAR_MAX);
+}
+
+/* Tetrahedral interpolation: offsets of the two inner corners of the tetrahedron which contains
+ * the fractional coordinates \a f, and the weights of the four corners. */
+BLI_INLINE void lut_tetrahedron(const float f[3],
+                                int *r_offset1,
+                                int *r_offset2,
+                                float r_weights[4])
+{
+  const int dr = 4, dg = 4 * LUT_SIZE, db = 4 * LUT_SIZE * LUT_SIZE;
+  int axis[3];
+
+  if (f[0] > f[1]) {
+    if (f[1] > f[2]) {
+      ARRAY_SET_ITEMS(axis, 0, 1, 2);
+    }
+    else if (f[0] > f[2]) {
+      ARRAY_SET_ITEMS(axis, 0, 2, 1);
+    }
+    else {
+      ARRAY_SET_ITEMS(axis, 2, 0, 1);
+    }
+  }
+  else {
+    if (f[2] > f[1]) {
+      ARRAY_SET_ITEMS(axis, 2, 1, 0);
+    }
+    else if (f[2] > f[0]) {
+      ARRAY_SET_ITEMS(axis, 1, 2, 0);
+    }
+    else {
+      ARRAY_SET_ITEMS(axis, 1, 0, 2);
+    }
+  }
+
+  const int stride[3] = {dr, dg, db};
+  *r_offset1 = stride[axis[0]];
+  *r_offset2 = stride[axis[0]] + stride[axis[1]];
+  r_weights[0] = 1.0f - f[axis[0]];
+  r_weights[1] = f[axis[0]] - f[axis[1]];
+  r_weights[2] = f[axis[1]] - f[axis[2]];
+  r_weights[3] = f[axis[2]];
+}
+
+/* Look up an in-domain \a rgb, scalar version also used to validate LUTs. */
+static void lut_lookup(const float *table, const float rgb[3], float r_rgb[3])
+{
+  float f[3], weights[4];
+  int index[3], offset1, offset2;
+
+  for (int i = 0; i < 3; i++) {
+    const float s = lut_shaper(rgb[i]);
+    index[i] = min_ii((int)s, LUT_SIZE - 2);
+    f[i] = s - (float)index[i];
+  }
+
+  lut_tetrahedron(f, &offset1, &offset2, weights);
+
+  const float *c0 = table + 4 * ((index[2] * LUT_SIZE + index[1]) * LUT_SIZE + index[0]);
+  const float *c1 = c0 + offset1;
+  const float *c2 = c0 + offset2;
+  const float *c3 = c0 + 4 * (1 + LUT_SIZE + LUT_SIZE * LUT_SIZE);
+
+  for (int i = 0; i < 3; i++) {
+    r_rgb[i] = weights[0] * c0[i] + weights[1] * c1[i] + weights[2] * c2[i] + weights[3] * c3[i];
+  }
+}
+
+#ifdef __SSE2__
+/* Same as lut_lookup(), with the shaper and the corners blended for all channels at once.
+ * Returns false when the pixel is out of the domain of the LUT. */
+BLI_INLINE bool lut_lookup_sse2(const float *table, __m128 rgb, float r_rgb[3])
+{
+  const __m128 min = _mm_set1_ps(LUT_LINEAR_MIN);
+  const __m128 in_domain = _mm_and_ps(_mm_cmpge_ps(rgb, _mm_setzero_ps()),
+                                      _mm_cmplt_ps(rgb, _mm_set1_ps(LUT_LINEAR_MAX)));
+  if ((_mm_movemask_ps(in_domain) & 7) != 7) {
+    return false;
+  }
+
+  /* Shaper, see lut_shaper() and lut_log2(). */
+  const __m128i bits = _mm_castps_si128(rgb);
+  const __m128 exponent = _mm_cvtepi32_ps(
+      _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+  const __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                                 _mm_set1_epi32(0x3f800000)));
+  __m128 ln_m = _mm_sub_ps(_mm_set1_ps(0.44717955f), _mm_mul_ps(_mm_set1_ps(0.056570851f), m));
+  ln_m = _mm_add_ps(_mm_set1_ps(-1.4699568f), _mm_mul_ps(ln_m, m));
+  ln_m = _mm_add_ps(_mm_set1_ps(2.8212026f), _mm_mul_ps(ln_m, m));
+  ln_m = _mm_add_ps(_mm_set1_ps(-1.7417939f), _mm_mul_ps(ln_m, m));
+  const __m128 log2_v = _mm_add_ps(exponent, _mm_mul_ps(ln_m, _mm_set1_ps((float)M_LOG2E)));
+  const __m128 s_log = _mm_add_ps(
+      _mm_mul_ps(_mm_sub_ps(log2_v, _mm_set1_ps(LUT_LOG2_MIN)), _mm_set1_ps(LUT_CELLS_PER_LOG2)),
+      _mm_set1_ps(1.0f));
+  const __m128 s_linear = _mm_mul_ps(rgb, _mm_set1_ps(1.0f / LUT_LINEAR_MIN));
+  const __m128 is_linear = _mm_cmplt_ps(rgb, min);
+  const __m128 s = _mm_or_ps(_mm_and_ps(is_linear, s_linear), _mm_andnot_ps(is_linear, s_log));
+
+  /* Values right below LUT_LINEAR_MAX can round up to the last grid point. */
+  __m128i index_v = _mm_cvttps_epi32(s);
+  index_v = _mm_add_epi32(index_v, _mm_cmpgt_epi32(index_v, _mm_set1_epi32(LUT_SIZE - 2)));
+  const __m128 f_v = _mm_sub_ps(s, _mm_cvtepi32_ps(index_v));
+
+  int index[4];
+  float f[4], weights[4];
+  int offset1, offset2;
+  _mm_storeu_si128((__m128i *)index, index_v);
+  _mm_storeu_ps(f, f_v);
+
+  lut_tetrahedron(f, &offset1, &offset2, weights);
+
+  const float *c0 = table + 4 * ((index[2] * LUT_SIZE + index[1]) * LUT_SIZE + index[0]);
+  __m128 result = _mm_mul_ps(_mm_load_ps(c0), _mm_set1_ps(weights[0]));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(c0 + offset1), _mm_set1_ps(weights[1])));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(c0 + offset2), _mm_set1_ps(weights[2])));
+  result = _mm_add_ps(
+      result,
+      _mm_mul_ps(_mm_load_ps(c0 + 4 * (1 + LUT_SIZE + LUT_SIZE * LUT_SIZE)),
+                 _mm_set1_ps(weights[3])));
+
+  float out[4];
+  _mm_storeu_ps(out, result);
+  copy_v3_v3(r_rgb, out);
+  return true;
+}
+#endif
+
+/* Apply the baked processor to a pixel of 3 or 4 channels, out of domain pixels go through the
+ * exact processor. */
+BLI_INLINE void lut_apply_pixel(const ColormanageProcessor *cm_processor,
+                                float *pixel,
+                                int channels,
+                                bool predivide)
+{
+  const float *table = cm_processor->lut->table;
+  float alpha = 1.0f, rgb[3];
+
+  if (predivide && channels == 4 && pixel[3] != 1.0f && pixel[3] != 0.0f) {
+    alpha = pixel[3];
+  }
+
+  mul_v3_v3fl(rgb, pixel, cm_processor->lut_gain / alpha);
+
+#ifdef __SSE2__
+  const bool is_baked = lut_lookup_sse2(table, _mm_set_ps(0.0f, rgb[2], rgb[1], rgb[0]), rgb);
+#else
+  const bool is_baked = lut_in_domain(rgb);
+  if (is_baked) {
+    lut_lookup(table, rgb, rgb);
+  }
+#endif
+
+  if (is_baked) {
+    mul_v3_v3fl(pixel, rgb, alpha);
+  }
+  else if (channels == 4) {
+    if (predivide) {
+      OCIO_processorApplyRGBA_predivide(cm_processor->processor, pixel);
+    }
+    else {
+      OCIO_processorApplyRGBA(cm_processor->processor, pixel);
+    }
+  }
+  else {
+    OCIO_processorApplyRGB(cm_processor->processor, pixel);
+  }
+}
+
+typedef struct LUTBakeData {
+  OCIO_ConstProcessorRcPtr *processor;
+  float *table;
+} LUTBakeData;
+
+static void lut_bake_slice(void *__restrict userdata,
+                           const int b,
+                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LUTBakeData *data = userdata;
+  float *slice = data->table + 4 * b * LUT_SIZE * LUT_SIZE;
+  float *pixel = slice;
+
+  for (int g = 0; g < LUT_SIZE; g++) {
+    for (int r = 0; r < LUT_SIZE; r++, pixel += 4) {
+      pixel[0] = lut_shaper_inverse(r);
+      pixel[1] = lut_shaper_inverse(g);
+      pixel[2] = lut_shaper_inverse(b);
+      pixel[3] = 1.0f;
+    }
+  }
+
+  OCIO_PackedImageDesc *img = OCIO_createOCIO_PackedImageDesc(slice,
+                                                               LUT_SIZE,
+                                                               LUT_SIZE,
+                                                               4,
+                                                               sizeof(float),
+                                                               4 * sizeof(float),
+                                                               4 * sizeof(float) * LUT_SIZE);
+  OCIO_processorApply(data->processor, img);
+  OCIO_PackedImageDescRelease(img);
+}
+
+/* Compare the LUT with the exact processor at random points between the grid points. */
+static bool lut_validate(const float *table, OCIO_ConstProcessorRcPtr *processor)
+{
+  RNG *rng = BLI_rng_new(0);
+  bool is_valid = true;
+
+  for (int i = 0; i < LUT_VALIDATE_SAMPLES && is_valid; i++) {
+    float rgb[3], exact[3], baked[3];
+
+    for (int j = 0; j < 3; j++) {
+      rgb[j] = lut_shaper_inverse(BLI_rng_get_float(rng) * (LUT_SIZE - 1));
+    }
+    copy_v3_v3(exact, rgb);
+    OCIO_processorApplyRGB(processor, exact);
+    lut_lookup(table, rgb, baked);
+
+    for (int j = 0; j < 3; j++) {
+      /* Transforms producing NaN are not baked. */
+      if (!(fabsf(baked[j] - exact[j]) <= LUT_TOLERANCE * max_ff(1.0f, fabsf(exact[j])))) {
+        is_valid = false;
+      }
+    }
+  }
+
+  BLI_rng_free(rng);
+
+  /* Alpha has to be passed through unchanged, which the LUT does. */
+  float pixel[4] = {0.18f, 0.18f, 0.18f, 0.5f};
+  OCIO_processorApplyRGBA(processor, pixel);
+  if (pixel[3] != 0.5f) {
+    is_valid = false;
+  }
+
+  return is_valid;
+}
+
+static void lut_bake(ColormanageLUT *lut)
+{
+  const ColormanageLUTKey *key = &lut->key;
+  OCIO_ConstProcessorRcPtr *processor;
+
+  if (key->view[0] != '\0') {
+    /* Exposure is applied to the input of the LUT, so one LUT is enough for all exposures. */
+    processor = create_display_buffer_processor(key->look,
+                                                key->view,
+                                                key->display,
+                                                0.0f,
+                                                key->gamma,
+                                                key->from_colorspace,
+                                                false);
+  }
+  else {
+    processor = create_colorspace_transform_processor(key->from_colorspace, key->to_colorspace);
+  }
+
+  if (processor == NULL) {
+    return;
+  }
+
+  LUTBakeData data;
+  data.processor = processor;
+  data.table = MEM_mallocN_aligned(
+      sizeof(float[4]) * LUT_SIZE * LUT_SIZE * LUT_SIZE, 16, "colormanage LUT");
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, LUT_SIZE, &data, lut_bake_slice, &settings);
+
+  lut->is_valid = lut_validate(data.table, processor);
+  if (lut->is_valid) {
+    lut->table = data.table;
+  }
+  else {
+    MEM_freeN(data.table);
+  }
+
+  OCIO_processorRelease(processor);
+}
+
+static void lut_free(ColormanageLUT *lut)
+{
+  BLI_assert(lut->users == 0);
+  MEM_SAFE_FREE(lut->table);
+  MEM_freeN(lut);
+}
+
+/* Get the baked LUT of \a key, baking it when needed. Returns NULL when the transform can't be
+ * baked or is being baked by another thread, in that case the exact processor is to be used. */
+static ColormanageLUT *colormanage_lut_acquire(const ColormanageLUTKey *key)
+{
+  ColormanageLUT *lut;
+
+  BLI_mutex_lock(&lut_lock);
+
+  for (lut = global_luts.first; lut; lut = lut->next) {
+    if (memcmp(&lut->key, key, sizeof(ColormanageLUTKey)) == 0) {
+      break;
+    }
+  }
+
+  if (lut) {
+    BLI_remlink(&global_luts, lut);
+    BLI_addhead(&global_luts, lut);
+  }
+  else {
+    lut = MEM_callocN(sizeof(ColormanageLUT), "colormanage LUT entry");
+    lut->key = *key;
+    lut->is_baking = true;
+    lut->users = 1;
+    BLI_addhead(&global_luts, lut);
+
+    /* Forget least recently used LUTs which are not in use. */
+    int count = 0;
+    LISTBASE_FOREACH_MUTABLE (ColormanageLUT *, iter, &global_luts) {
+      if (++count > LUT_CACHE_SIZE && iter->users == 0) {
+        BLI_remlink(&global_luts, iter);
+        lut_free(iter);
+      }
+    }
+
+    /* Bake with the lock released, other threads use the exact processor meanwhile. */
+    BLI_mutex_unlock(&lut_lock);
+    lut_bake(lut);
+    BLI_mutex_lock(&lut_lock);
+
+    lut->is_baking = false;
+    lut->users--;
+  }
+
+  if (!lut->is_baking && lut->is_valid) {
+    lut->users++;
+  }
+  else {
+    lut = NULL;
+  }
+
+  BLI_mutex_unlock(&lut_lock);
+
+  return lut;
+}
+
+static void colormanage_lut_release(ColormanageLUT *lut)
+{
+  BLI_mutex_lock(&lut_lock);
+  BLI_assert(lut->users > 0);
+  lut->users--;
+  BLI_mutex_unlock(&lut_lock);
+}
+
+static void colormanage_lut_free_all(void)
+{
+  LISTBASE_FOREACH_MUTABLE (ColormanageLUT *, lut, &global_luts) {
+    lut_free(lut);
+  }
+  BLI_listbase_clear(&global_luts);
+}
+
+static void colormanage_processor_use_display_lut(
+    ColormanageProcessor *cm_processor,
+    const ColorManagedViewSettings *view_settings,
+    const ColorManagedDisplaySettings *display_settings)
+{
+  ColormanageLUTKey key;
+
+  if (cm_processor->processor == NULL) {
+    return;
+  }
+
+  memset(&key, 0, sizeof(key));
+  BLI_strncpy(key.look, view_settings->look, sizeof(key.look));
+  BLI_strncpy(key.view, view_settings->view_transform, sizeof(key.view));
+  BLI_strncpy(key.display, display_settings->display_device, sizeof(key.display));
+  BLI_strncpy(key.from_colorspace, global_role_scene_linear, sizeof(key.from_colorspace));
+  key.gamma = view_settings->gamma;
+
+  cm_processor->lut = colormanage_lut_acquire(&key);
+  cm_processor->lut_gain = powf(2.0f, view_settings->exposure);
+}
+
+static void colormanage_processor_use_colorspace_lut(ColormanageProcessor *cm_processor,
+                                                     const char *from_colorspace,
+                                                     const char *to_colorspace)
+{
+  ColormanageLUTKey key;
+
+  if (cm_processor->processor == NULL) {
+    return;
+  }
+
+  memset(&key, 0, sizeof(key));
+  BLI_strncpy(key.from_colorspace, from_colorspace, sizeof(key.from_colorspace));
+  BLI_strncpy(key.to_colorspace, to_colorspace, sizeof(key.to_colorspace));
+  key.gamma = 1.0f;
+
+  cm_processor->lut = colormanage_lut_acquire(&key);
+  cm_processor->lut_gain = 1.0f;
+}
+
 void IMB_colormanagement_init_default_view_settings(
     ColorManagedViewSettings *view_settings, const ColorManagedDisplaySettings *display_settings)
 {
@@ -1563,6 +2099,8 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
   bool is_data = handle->is_data;
   bool is_data_display = handle->cm_processor->is_data_result;
   bool predivide = handle->predivide;
+  /* Bake the conversion to linear as well when the display transform is baked. */
+  bool use_lut = handle->cm_processor->lut != NULL;
 
   if (!handle->buffer) {
     unsigned char *byte_buffer = handle->byte_buffer;
@@ -1591,8 +2129,16 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
 
     if (!is_data && !is_data_display) {
       /* convert float buffer to scene linear space */
-      IMB_colormanagement_transform(
-          linear_buffer, width, height, channels, from_colorspace, to_colorspace, false);
+      colormanagement_transform_ex(NULL,
+                                   linear_buffer,
+                                   width,
+                                   height,
+                                   channels,
+                                   from_colorspace,
+                                   to_colorspace,
+                                   false,
+                                   false,
+                                   use_lut);
     }
 
     *is_straight_alpha = true;
@@ -1610,8 +2156,16 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
     memcpy(linear_buffer, handle->buffer, buffer_size * sizeof(float));
 
     if (!is_data && !is_data_display) {
-      IMB_colormanagement_transform(
-          linear_buffer, width, height, channels, from_colorspace, to_colorspace, predivide);
+      colormanagement_transform_ex(NULL,
+                                   linear_buffer,
+                                   width,
+                                   height,
+                                   channels,
+                                   from_colorspace,
+                                   to_colorspace,
+                                   predivide,
+                                   false,
+                                   use_lut);
     }
 
     *is_straight_alpha = false;
@@ -1790,7 +2344,8 @@ static void colormanage_display_buffer_process_ex(
     float *display_buffer,
     unsigned char *display_buffer_byte,
     const ColorManagedViewSettings *view_settings,
-    const ColorManagedDisplaySettings *display_settings)
+    const ColorManagedDisplaySettings *display_settings,
+    const bool use_lut)
 {
   ColormanageProcessor *cm_processor = NULL;
   bool skip_transform = false;
@@ -1806,6 +2361,10 @@ static void colormanage_display_buffer_process_ex(
 
   if (skip_transform == false) {
     cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+
+    if (use_lut) {
+      colormanage_processor_use_display_lut(cm_processor, view_settings, display_settings);
+    }
   }
 
   display_buffer_apply_threaded(ibuf,
@@ -1826,7 +2385,7 @@ static void colormanage_display_buffer_process(ImBuf *ibuf,
                                                const ColorManagedDisplaySettings *display_settings)
 {
   colormanage_display_buffer_process_ex(
-      ibuf, NULL, display_buffer, view_settings, display_settings);
+      ibuf, NULL, display_buffer, view_settings, display_settings, colormanage_use_lut());
 }
 
 /*********************** Threaded processor transform routines *************************/
@@ -1969,7 +2528,8 @@ static void colormanagement_transform_ex(unsigned char *byte_buffer,
                                          const char *from_colorspace,
                                          const char *to_colorspace,
                                          bool predivide,
-                                         bool do_threaded)
+                                         bool do_threaded,
+                                         bool use_lut)
 {
   ColormanageProcessor *cm_processor;
 
@@ -1986,6 +2546,10 @@ static void colormanagement_transform_ex(unsigned char *byte_buffer,
 
   cm_processor = IMB_colormanagement_colorspace_processor_new(from_colorspace, to_colorspace);
 
+  if (use_lut) {
+    colormanage_processor_use_colorspace_lut(cm_processor, from_colorspace, to_colorspace);
+  }
+
   if (do_threaded) {
     processor_transform_apply_threaded(
         byte_buffer, float_buffer, width, height, channels, cm_processor, predivide, false);
@@ -2012,8 +2576,16 @@ void IMB_colormanagement_transform(float *buffer,
                                    const char *to_colorspace,
                                    bool predivide)
 {
-  colormanagement_transform_ex(
-      NULL, buffer, width, height, channels, from_colorspace, to_colorspace, predivide, false);
+  colormanagement_transform_ex(NULL,
+                               buffer,
+                               width,
+                               height,
+                               channels,
+                               from_colorspace,
+                               to_colorspace,
+                               predivide,
+                               false,
+                               false);
 }
 
 /* convert the whole buffer from specified by name color space to another
@@ -2027,8 +2599,16 @@ void IMB_colormanagement_transform_threaded(float *buffer,
                                             const char *to_colorspace,
                                             bool predivide)
 {
-  colormanagement_transform_ex(
-      NULL, buffer, width, height, channels, from_colorspace, to_colorspace, predivide, true);
+  colormanagement_transform_ex(NULL,
+                               buffer,
+                               width,
+                               height,
+                               channels,
+                               from_colorspace,
+                               to_colorspace,
+                               predivide,
+                               true,
+                               false);
 }
 
 /* Similar to functions above, but operates on byte buffer. */
@@ -2040,7 +2620,7 @@ void IMB_colormanagement_transform_byte(unsigned char *buffer,
                                         const char *to_colorspace)
 {
   colormanagement_transform_ex(
-      buffer, NULL, width, height, channels, from_colorspace, to_colorspace, false, false);
+      buffer, NULL, width, height, channels, from_colorspace, to_colorspace, false, false, false);
 }
 void IMB_colormanagement_transform_byte_threaded(unsigned char *buffer,
                                                  int width,
@@ -2049,8 +2629,16 @@ void IMB_colormanagement_transform_byte_threaded(unsigned char *buffer,
                                                  const char *from_colorspace,
                                                  const char *to_colorspace)
 {
-  colormanagement_transform_ex(
-      buffer, NULL, width, height, channels, from_colorspace, to_colorspace, false, true);
+  colormanagement_transform_ex(buffer,
+                               NULL,
+                               width,
+                               height,
+                               channels,
+                               from_colorspace,
+                               to_colorspace,
+                               false,
+                               true,
+                               false);
 }
 
 /* Similar to above, but gets float buffer from display one. */
@@ -2481,14 +3069,19 @@ static void colormanagement_imbuf_make_display_space(
     ImBuf *ibuf,
     const ColorManagedViewSettings *view_settings,
     const ColorManagedDisplaySettings *display_settings,
-    bool make_byte)
+    bool make_byte,
+    bool use_lut)
 {
   if (!ibuf->rect && make_byte) {
     imb_addrectImBuf(ibuf);
   }
 
-  colormanage_display_buffer_process_ex(
-      ibuf, ibuf->rect_float, (unsigned char *)ibuf->rect, view_settings, display_settings);
+  colormanage_display_buffer_process_ex(ibuf,
+                                        ibuf->rect_float,
+                                        (unsigned char *)ibuf->rect,
+                                        view_settings,
+                                        display_settings,
+                                        use_lut);
 }
 
 void IMB_colormanagement_imbuf_make_display_space(
@@ -2496,7 +3089,8 @@ void IMB_colormanagement_imbuf_make_display_space(
     const ColorManagedViewSettings *view_settings,
     const ColorManagedDisplaySettings *display_settings)
 {
-  colormanagement_imbuf_make_display_space(ibuf, view_settings, display_settings, false);
+  colormanagement_imbuf_make_display_space(
+      ibuf, view_settings, display_settings, false, colormanage_use_lut());
 }
 
 /* prepare image buffer to be saved on disk, applying color management if needed
@@ -2609,9 +3203,9 @@ ImBuf *IMB_colormanagement_imbuf_for_write(ImBuf *ibuf,
       }
     }
 
-    /* perform color space conversions */
+    /* perform color space conversions, saved images always use the exact transform */
     colormanagement_imbuf_make_display_space(
-        colormanaged_ibuf, view_settings, display_settings, make_byte);
+        colormanaged_ibuf, view_settings, display_settings, make_byte, false);
 
     if (colormanaged_ibuf->rect_float) {
       /* float buffer isn't linear anymore,
@@ -3885,7 +4479,15 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
     }
   }
 
-  if (cm_processor->processor && channels >= 3) {
+  if (cm_processor->lut && channels >= 3) {
+    const size_t i_last = ((size_t)width) * height;
+    float *pixel = buffer;
+
+    for (size_t i = 0; i < i_last; i++, pixel += channels) {
+      lut_apply_pixel(cm_processor, pixel, channels, predivide);
+    }
+  }
+  else if (cm_processor->processor && channels >= 3) {
     OCIO_PackedImageDesc *img;
 
     /* apply OCIO processor */
@@ -3920,7 +4522,15 @@ void IMB_colormanagement_processor_apply_byte(
     for (int x = 0; x < width; x++) {
       size_t offset = channels * (((size_t)y) * width + x);
       rgba_uchar_to_float(pixel, buffer + offset);
-      IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
+      if (cm_processor->lut) {
+        if (cm_processor->curve_mapping) {
+          BKE_curvemapping_evaluate_premulRGBF(cm_processor->curve_mapping, pixel, pixel);
+        }
+        lut_apply_pixel(cm_processor, pixel, 4, false);
+      }
+      else {
+        IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
+      }
       rgba_float_to_uchar(buffer + offset, pixel);
     }
   }
@@ -3934,6 +4544,9 @@ void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
   if (cm_processor->processor) {
     OCIO_processorRelease(cm_processor->processor);
   }
+  if (cm_processor->lut) {
+    colormanage_lut_release(cm_processor->lut);
+  }
 
   MEM_freeN(cm_processor);
 }
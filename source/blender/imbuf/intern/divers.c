@@ -23,6 +23,7 @@
  */
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "IMB_filter.h"
@@ -32,9 +33,17 @@
 
 #include "IMB_colormanagement.h"
 #include "IMB_colormanagement_intern.h"
+#include "IMB_simd_intern.h"
 
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+/* Rows of buffers larger than this are converted in parallel. */
+#define CONVERT_THREADED_MIN_PIXELS (64 * 64)
+
 /************************* Floyd-Steinberg dithering *************************/
 
 typedef struct DitherContext {
@@ -96,176 +105,315 @@ MINLINE void float_to_byte_dither_v4(
   b[3] = unit_float_to_uchar_clamp(f[3]);
 }
 
+#ifdef __SSE2__
+
+/* Mask of the alpha channel of a pixel. */
+MALWAYS_INLINE __m128 alpha_mask_simd(void)
+{
+  return _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+}
+
+MALWAYS_INLINE __m128 select_simd(const __m128 mask, const __m128 a, const __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/* Same result as premul_to_straight_v4_v4(). */
+MALWAYS_INLINE __m128 premul_to_straight_simd(const __m128 premul)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 alpha = _mm_shuffle_ps(premul, premul, _MM_SHUFFLE(3, 3, 3, 3));
+  const __m128 keep = _mm_or_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()), alpha_mask_simd());
+  return _mm_mul_ps(premul, select_simd(keep, one, _mm_div_ps(one, alpha)));
+}
+
+/* Same result as straight_to_premul_v4_v4(). */
+MALWAYS_INLINE __m128 straight_to_premul_simd(const __m128 straight)
+{
+  const __m128 alpha = _mm_shuffle_ps(straight, straight, _MM_SHUFFLE(3, 3, 3, 3));
+  return _mm_mul_ps(straight, select_simd(alpha_mask_simd(), _mm_set1_ps(1.0f), alpha));
+}
+
+/* Same rounding as unit_float_to_uchar_clamp(), results are in 32 bit lanes. */
+MALWAYS_INLINE __m128i unit_float_to_uchar_clamp_simd(const __m128 f)
+{
+  const __m128 clamped = _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+#endif /* __SSE2__ */
+
+/* RGBA float pixels to bytes, four pixels at a time when possible. */
+void imb_rgba_float_to_uchar_row(
+    uchar *to, const float *from, int width, bool predivide, bool use_simd)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  for (; use_simd && x + 4 <= width; x += 4, from += 16, to += 16) {
+    __m128i pixel[4];
+    for (int i = 0; i < 4; i++) {
+      __m128 color = _mm_loadu_ps(from + 4 * i);
+      if (predivide) {
+        color = premul_to_straight_simd(color);
+      }
+      pixel[i] = unit_float_to_uchar_clamp_simd(color);
+    }
+    const __m128i lo = _mm_packs_epi32(pixel[0], pixel[1]);
+    const __m128i hi = _mm_packs_epi32(pixel[2], pixel[3]);
+    _mm_storeu_si128((__m128i *)to, _mm_packus_epi16(lo, hi));
+  }
+#else
+  UNUSED_VARS(use_simd);
+#endif
+
+  for (; x < width; x++, from += 4, to += 4) {
+    if (predivide) {
+      float straight[4];
+      premul_to_straight_v4_v4(straight, from);
+      rgba_float_to_uchar(to, straight);
+    }
+    else {
+      rgba_float_to_uchar(to, from);
+    }
+  }
+}
+
+/* RGBA byte pixels to floats, four pixels at a time when possible. */
+void imb_rgba_uchar_to_float_row(float *to, const uchar *from, int width, bool use_simd)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+  for (; use_simd && x + 4 <= width; x += 4, from += 16, to += 16) {
+    const __m128i bytes = _mm_loadu_si128((const __m128i *)from);
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_ps(to, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+    _mm_storeu_ps(to + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+    _mm_storeu_ps(to + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+    _mm_storeu_ps(to + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+  }
+#else
+  UNUSED_VARS(use_simd);
+#endif
+
+  for (; x < width; x++, from += 4, to += 4) {
+    rgba_uchar_to_float(to, from);
+  }
+}
+
+static void parallel_rows_settings(TaskParallelSettings *settings, int width, int height)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = ((size_t)width * height > CONVERT_THREADED_MIN_PIXELS);
+  settings->min_iter_per_thread = 8;
+}
+
 /* Test if colorspace conversions of pixels in buffer need to take into account alpha. */
 bool IMB_alpha_affects_rgb(const ImBuf *ibuf)
 {
   return (ibuf->flags & IB_alphamode_channel_packed) == 0;
 }
 
-/* float to byte pixels, output 4-channel RGBA */
-void IMB_buffer_byte_from_float(uchar *rect_to,
-                                const float *rect_from,
-                                int channels_from,
-                                float dither,
-                                int profile_to,
-                                int profile_from,
-                                bool predivide,
-                                int width,
-                                int height,
-                                int stride_to,
-                                int stride_from)
+typedef struct ByteFromFloatThreadData {
+  uchar *rect_to;
+  const float *rect_from;
+  int channels_from;
+  float dither;
+  DitherContext *di;
+  int profile_to;
+  int profile_from;
+  bool predivide;
+  int width;
+  float inv_width;
+  float inv_height;
+  int stride_to;
+  int stride_from;
+} ByteFromFloatThreadData;
+
+static void imb_buffer_byte_from_float_row(void *__restrict data_v,
+                                           const int y,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
 {
+  const ByteFromFloatThreadData *data = data_v;
+  const int channels_from = data->channels_from;
+  const int profile_to = data->profile_to;
+  const int profile_from = data->profile_from;
+  const float dither = data->dither;
+  const bool predivide = data->predivide;
+  const int width = data->width;
+  const float inv_width = data->inv_width;
+  const float t = y * data->inv_height;
+  DitherContext *di = data->di;
   float tmp[4];
-  int x, y;
-  DitherContext *di = NULL;
-  float inv_width = 1.0f / width;
-  float inv_height = 1.0f / height;
+  int x;
 
-  /* we need valid profiles */
-  BLI_assert(profile_to != IB_PROFILE_NONE);
-  BLI_assert(profile_from != IB_PROFILE_NONE);
+  if (channels_from == 1) {
+    /* single channel input */
+    const float *from = data->rect_from + ((size_t)data->stride_from) * y;
+    uchar *to = data->rect_to + ((size_t)data->stride_to) * y * 4;
 
-  if (dither) {
-    di = create_dither_context(dither);
+    for (x = 0; x < width; x++, from++, to += 4) {
+      to[0] = to[1] = to[2] = to[3] = unit_float_to_uchar_clamp(from[0]);
+    }
   }
+  else if (channels_from == 3) {
+    /* RGB input */
+    const float *from = data->rect_from + ((size_t)data->stride_from) * y * 3;
+    uchar *to = data->rect_to + ((size_t)data->stride_to) * y * 4;
 
-  for (y = 0; y < height; y++) {
-    float t = y * inv_height;
-
-    if (channels_from == 1) {
-      /* single channel input */
-      const float *from = rect_from + ((size_t)stride_from) * y;
-      uchar *to = rect_to + ((size_t)stride_to) * y * 4;
-
-      for (x = 0; x < width; x++, from++, to += 4) {
-        to[0] = to[1] = to[2] = to[3] = unit_float_to_uchar_clamp(from[0]);
+    if (profile_to == profile_from) {
+      /* no color space conversion */
+      for (x = 0; x < width; x++, from += 3, to += 4) {
+        rgb_float_to_uchar(to, from);
+        to[3] = 255;
       }
     }
-    else if (channels_from == 3) {
-      /* RGB input */
-      const float *from = rect_from + ((size_t)stride_from) * y * 3;
-      uchar *to = rect_to + ((size_t)stride_to) * y * 4;
-
-      if (profile_to == profile_from) {
-        /* no color space conversion */
-        for (x = 0; x < width; x++, from += 3, to += 4) {
-          rgb_float_to_uchar(to, from);
-          to[3] = 255;
-        }
-      }
-      else if (profile_to == IB_PROFILE_SRGB) {
-        /* convert from linear to sRGB */
-        for (x = 0; x < width; x++, from += 3, to += 4) {
-          linearrgb_to_srgb_v3_v3(tmp, from);
-          rgb_float_to_uchar(to, tmp);
-          to[3] = 255;
-        }
+    else if (profile_to == IB_PROFILE_SRGB) {
+      /* convert from linear to sRGB */
+      for (x = 0; x < width; x++, from += 3, to += 4) {
+        linearrgb_to_srgb_v3_v3(tmp, from);
+        rgb_float_to_uchar(to, tmp);
+        to[3] = 255;
       }
-      else if (profile_to == IB_PROFILE_LINEAR_RGB) {
-        /* convert from sRGB to linear */
-        for (x = 0; x < width; x++, from += 3, to += 4) {
-          srgb_to_linearrgb_v3_v3(tmp, from);
-          rgb_float_to_uchar(to, tmp);
-          to[3] = 255;
-        }
+    }
+    else if (profile_to == IB_PROFILE_LINEAR_RGB) {
+      /* convert from sRGB to linear */
+      for (x = 0; x < width; x++, from += 3, to += 4) {
+        srgb_to_linearrgb_v3_v3(tmp, from);
+        rgb_float_to_uchar(to, tmp);
+        to[3] = 255;
       }
     }
-    else if (channels_from == 4) {
-      /* RGBA input */
-      const float *from = rect_from + ((size_t)stride_from) * y * 4;
-      uchar *to = rect_to + ((size_t)stride_to) * y * 4;
+  }
+  else if (channels_from == 4) {
+    /* RGBA input */
+    const float *from = data->rect_from + ((size_t)data->stride_from) * y * 4;
+    uchar *to = data->rect_to + ((size_t)data->stride_to) * y * 4;
 
-      if (profile_to == profile_from) {
-        float straight[4];
+    if (profile_to == profile_from) {
+      float straight[4];
 
-        /* no color space conversion */
-        if (dither && predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            premul_to_straight_v4_v4(straight, from);
-            float_to_byte_dither_v4(to, straight, di, (float)x * inv_width, t);
-          }
-        }
-        else if (dither) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            float_to_byte_dither_v4(to, from, di, (float)x * inv_width, t);
-          }
-        }
-        else if (predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            premul_to_straight_v4_v4(straight, from);
-            rgba_float_to_uchar(to, straight);
-          }
+      /* no color space conversion */
+      if (dither && predivide) {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          premul_to_straight_v4_v4(straight, from);
+          float_to_byte_dither_v4(to, straight, di, (float)x * inv_width, t);
         }
-        else {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            rgba_float_to_uchar(to, from);
-          }
+      }
+      else if (dither) {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          float_to_byte_dither_v4(to, from, di, (float)x * inv_width, t);
         }
       }
-      else if (profile_to == IB_PROFILE_SRGB) {
-        /* convert from linear to sRGB */
-        unsigned short us[4];
-        float straight[4];
+      else {
+        imb_rgba_float_to_uchar_row(to, from, width, predivide, true);
+      }
+    }
+    else if (profile_to == IB_PROFILE_SRGB) {
+      /* convert from linear to sRGB, using the lookup table */
+      unsigned short us[4];
+      float straight[4];
 
-        if (dither && predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            premul_to_straight_v4_v4(straight, from);
-            linearrgb_to_srgb_ushort4(us, from);
-            ushort_to_byte_dither_v4(to, us, di, (float)x * inv_width, t);
-          }
+      if (dither && predivide) {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          premul_to_straight_v4_v4(straight, from);
+          linearrgb_to_srgb_ushort4(us, straight);
+          ushort_to_byte_dither_v4(to, us, di, (float)x * inv_width, t);
         }
-        else if (dither) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            linearrgb_to_srgb_ushort4(us, from);
-            ushort_to_byte_dither_v4(to, us, di, (float)x * inv_width, t);
-          }
+      }
+      else if (dither) {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          linearrgb_to_srgb_ushort4(us, from);
+          ushort_to_byte_dither_v4(to, us, di, (float)x * inv_width, t);
         }
-        else if (predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            premul_to_straight_v4_v4(straight, from);
-            linearrgb_to_srgb_ushort4(us, from);
-            ushort_to_byte_v4(to, us);
-          }
+      }
+      else if (predivide) {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          premul_to_straight_v4_v4(straight, from);
+          linearrgb_to_srgb_ushort4(us, straight);
+          ushort_to_byte_v4(to, us);
         }
-        else {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            linearrgb_to_srgb_ushort4(us, from);
-            ushort_to_byte_v4(to, us);
-          }
+      }
+      else {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          linearrgb_to_srgb_ushort4(us, from);
+          ushort_to_byte_v4(to, us);
         }
       }
-      else if (profile_to == IB_PROFILE_LINEAR_RGB) {
-        /* convert from sRGB to linear */
-        if (dither && predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            srgb_to_linearrgb_predivide_v4(tmp, from);
-            float_to_byte_dither_v4(to, tmp, di, (float)x * inv_width, t);
-          }
+    }
+    else if (profile_to == IB_PROFILE_LINEAR_RGB) {
+      /* convert from sRGB to linear */
+      if (dither && predivide) {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          srgb_to_linearrgb_predivide_v4(tmp, from);
+          float_to_byte_dither_v4(to, tmp, di, (float)x * inv_width, t);
         }
-        else if (dither) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            srgb_to_linearrgb_v4(tmp, from);
-            float_to_byte_dither_v4(to, tmp, di, (float)x * inv_width, t);
-          }
+      }
+      else if (dither) {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          srgb_to_linearrgb_v4(tmp, from);
+          float_to_byte_dither_v4(to, tmp, di, (float)x * inv_width, t);
         }
-        else if (predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            srgb_to_linearrgb_predivide_v4(tmp, from);
-            rgba_float_to_uchar(to, tmp);
-          }
+      }
+      else if (predivide) {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          srgb_to_linearrgb_predivide_v4(tmp, from);
+          rgba_float_to_uchar(to, tmp);
         }
-        else {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            srgb_to_linearrgb_v4(tmp, from);
-            rgba_float_to_uchar(to, tmp);
-          }
+      }
+      else {
+        for (x = 0; x < width; x++, from += 4, to += 4) {
+          srgb_to_linearrgb_v4(tmp, from);
+          rgba_float_to_uchar(to, tmp);
         }
       }
     }
   }
+}
+
+/* float to byte pixels, output 4-channel RGBA */
+void IMB_buffer_byte_from_float(uchar *rect_to,
+                                const float *rect_from,
+                                int channels_from,
+                                float dither,
+                                int profile_to,
+                                int profile_from,
+                                bool predivide,
+                                int width,
+                                int height,
+                                int stride_to,
+                                int stride_from)
+{
+  ByteFromFloatThreadData data;
+  TaskParallelSettings settings;
+
+  /* we need valid profiles */
+  BLI_assert(profile_to != IB_PROFILE_NONE);
+  BLI_assert(profile_from != IB_PROFILE_NONE);
+
+  data.rect_to = rect_to;
+  data.rect_from = rect_from;
+  data.channels_from = channels_from;
+  data.dither = dither;
+  data.di = (dither) ? create_dither_context(dither) : NULL;
+  data.profile_to = profile_to;
+  data.profile_from = profile_from;
+  data.predivide = predivide;
+  data.width = width;
+  data.inv_width = 1.0f / width;
+  data.inv_height = 1.0f / height;
+  data.stride_to = stride_to;
+  data.stride_from = stride_from;
+
+  parallel_rows_settings(&settings, width, height);
+  BLI_task_parallel_range(0, height, &data, imb_buffer_byte_from_float_row, &settings);
 
   if (dither) {
-    clear_dither_context(di);
+    clear_dither_context(data.di);
   }
 }
 
@@ -360,6 +508,62 @@ void IMB_buffer_byte_from_float_mask(uchar *rect_to,
   }
 }
 
+typedef struct FloatFromByteThreadData {
+  float *rect_to;
+  const uchar *rect_from;
+  int profile_to;
+  int profile_from;
+  bool predivide;
+  int width;
+  int stride_to;
+  int stride_from;
+} FloatFromByteThreadData;
+
+static void imb_buffer_float_from_byte_row(void *__restrict data_v,
+                                           const int y,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const FloatFromByteThreadData *data = data_v;
+  const uchar *from = data->rect_from + ((size_t)data->stride_from) * y * 4;
+  float *to = data->rect_to + ((size_t)data->stride_to) * y * 4;
+  const int width = data->width;
+  float tmp[4];
+  int x;
+
+  if (data->profile_to == data->profile_from) {
+    /* no color space conversion */
+    imb_rgba_uchar_to_float_row(to, from, width, true);
+  }
+  else if (data->profile_to == IB_PROFILE_LINEAR_RGB) {
+    /* convert sRGB to linear, using the lookup table */
+    if (data->predivide) {
+      for (x = 0; x < width; x++, from += 4, to += 4) {
+        srgb_to_linearrgb_uchar4_predivide(to, from);
+      }
+    }
+    else {
+      for (x = 0; x < width; x++, from += 4, to += 4) {
+        srgb_to_linearrgb_uchar4(to, from);
+      }
+    }
+  }
+  else if (data->profile_to == IB_PROFILE_SRGB) {
+    /* convert linear to sRGB */
+    if (data->predivide) {
+      for (x = 0; x < width; x++, from += 4, to += 4) {
+        rgba_uchar_to_float(tmp, from);
+        linearrgb_to_srgb_predivide_v4(to, tmp);
+      }
+    }
+    else {
+      for (x = 0; x < width; x++, from += 4, to += 4) {
+        rgba_uchar_to_float(tmp, from);
+        linearrgb_to_srgb_v4(to, tmp);
+      }
+    }
+  }
+}
+
 /* byte to float pixels, input and output 4-channel RGBA  */
 void IMB_buffer_float_from_byte(float *rect_to,
                                 const uchar *rect_from,
@@ -371,53 +575,24 @@ void IMB_buffer_float_from_byte(float *rect_to,
                                 int stride_to,
                                 int stride_from)
 {
-  float tmp[4];
-  int x, y;
+  FloatFromByteThreadData data;
+  TaskParallelSettings settings;
 
   /* we need valid profiles */
   BLI_assert(profile_to != IB_PROFILE_NONE);
   BLI_assert(profile_from != IB_PROFILE_NONE);
 
-  /* RGBA input */
-  for (y = 0; y < height; y++) {
-    const uchar *from = rect_from + stride_from * y * 4;
-    float *to = rect_to + ((size_t)stride_to) * y * 4;
-
-    if (profile_to == profile_from) {
-      /* no color space conversion */
-      for (x = 0; x < width; x++, from += 4, to += 4) {
-        rgba_uchar_to_float(to, from);
-      }
-    }
-    else if (profile_to == IB_PROFILE_LINEAR_RGB) {
-      /* convert sRGB to linear */
-      if (predivide) {
-        for (x = 0; x < width; x++, from += 4, to += 4) {
-          srgb_to_linearrgb_uchar4_predivide(to, from);
-        }
-      }
-      else {
-        for (x = 0; x < width; x++, from += 4, to += 4) {
-          srgb_to_linearrgb_uchar4(to, from);
-        }
-      }
-    }
-    else if (profile_to == IB_PROFILE_SRGB) {
-      /* convert linear to sRGB */
-      if (predivide) {
-        for (x = 0; x < width; x++, from += 4, to += 4) {
-          rgba_uchar_to_float(tmp, from);
-          linearrgb_to_srgb_predivide_v4(to, tmp);
-        }
-      }
-      else {
-        for (x = 0; x < width; x++, from += 4, to += 4) {
-          rgba_uchar_to_float(tmp, from);
-          linearrgb_to_srgb_v4(to, tmp);
-        }
-      }
-    }
-  }
+  data.rect_to = rect_to;
+  data.rect_from = rect_from;
+  data.profile_to = profile_to;
+  data.profile_from = profile_from;
+  data.predivide = predivide;
+  data.width = width;
+  data.stride_to = stride_to;
+  data.stride_from = stride_from;
+
+  parallel_rows_settings(&settings, width, height);
+  BLI_task_parallel_range(0, height, &data, imb_buffer_float_from_byte_row, &settings);
 }
 
 /* float to float pixels, output 4-channel RGBA */
@@ -743,19 +918,14 @@ void IMB_rect_from_float(ImBuf *ibuf)
                                 ibuf->rect_colorspace->name,
                                 predivide);
 
-  /* convert from float's premul alpha to byte's straight alpha */
-  if (IMB_alpha_affects_rgb(ibuf)) {
-    IMB_unpremultiply_rect_float(buffer, ibuf->channels, ibuf->x, ibuf->y);
-  }
-
-  /* convert float to byte */
+  /* convert float to byte, and from float's premul alpha to byte's straight alpha */
   IMB_buffer_byte_from_float((unsigned char *)ibuf->rect,
                              buffer,
                              ibuf->channels,
                              ibuf->dither,
                              IB_PROFILE_SRGB,
                              IB_PROFILE_SRGB,
-                             false,
+                             predivide,
                              ibuf->x,
                              ibuf->y,
                              ibuf->x,
@@ -844,26 +1014,79 @@ void IMB_color_to_bw(ImBuf *ibuf)
   }
 }
 
-void IMB_buffer_float_unpremultiply(float *buf, int width, int height)
+void imb_premul_to_straight_row(float *fp, int width, bool use_simd)
 {
-  size_t total = ((size_t)width) * height;
-  float *fp = buf;
-  while (total--) {
+  int x = 0;
+
+#ifdef __SSE2__
+  for (; use_simd && x < width; x++, fp += 4) {
+    _mm_storeu_ps(fp, premul_to_straight_simd(_mm_loadu_ps(fp)));
+  }
+#else
+  UNUSED_VARS(use_simd);
+#endif
+
+  for (; x < width; x++, fp += 4) {
     premul_to_straight_v4(fp);
-    fp += 4;
   }
 }
 
-void IMB_buffer_float_premultiply(float *buf, int width, int height)
+void imb_straight_to_premul_row(float *fp, int width, bool use_simd)
 {
-  size_t total = ((size_t)width) * height;
-  float *fp = buf;
-  while (total--) {
+  int x = 0;
+
+#ifdef __SSE2__
+  for (; use_simd && x < width; x++, fp += 4) {
+    _mm_storeu_ps(fp, straight_to_premul_simd(_mm_loadu_ps(fp)));
+  }
+#else
+  UNUSED_VARS(use_simd);
+#endif
+
+  for (; x < width; x++, fp += 4) {
     straight_to_premul_v4(fp);
-    fp += 4;
   }
 }
 
+typedef struct PremultiplyThreadData {
+  float *buf;
+  int width;
+} PremultiplyThreadData;
+
+static void imb_buffer_float_unpremultiply_row(void *__restrict data_v,
+                                               const int y,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const PremultiplyThreadData *data = data_v;
+  imb_premul_to_straight_row(data->buf + ((size_t)data->width) * y * 4, data->width, true);
+}
+
+static void imb_buffer_float_premultiply_row(void *__restrict data_v,
+                                             const int y,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const PremultiplyThreadData *data = data_v;
+  imb_straight_to_premul_row(data->buf + ((size_t)data->width) * y * 4, data->width, true);
+}
+
+void IMB_buffer_float_unpremultiply(float *buf, int width, int height)
+{
+  PremultiplyThreadData data = {buf, width};
+  TaskParallelSettings settings;
+
+  parallel_rows_settings(&settings, width, height);
+  BLI_task_parallel_range(0, height, &data, imb_buffer_float_unpremultiply_row, &settings);
+}
+
+void IMB_buffer_float_premultiply(float *buf, int width, int height)
+{
+  PremultiplyThreadData data = {buf, width};
+  TaskParallelSettings settings;
+
+  parallel_rows_settings(&settings, width, height);
+  BLI_task_parallel_range(0, height, &data, imb_buffer_float_premultiply_row, &settings);
+}
+
 /**************************** alter saturation *****************************/
 
 void IMB_saturation(ImBuf *ibuf, float sat)
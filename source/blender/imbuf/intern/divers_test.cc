@@ -0,0 +1,176 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+extern "C" {
+#include "BLI_math_color.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "IMB_simd_intern.h"
+}
+
+namespace blender::imbuf::tests {
+
+/* Odd size, so the vector loops leave pixels to the scalar code. */
+static const int WIDTH = 37;
+
+/* Random colors, with alpha 0, alpha 1, NaN and values outside of [0, 1] mixed in. */
+static void fill_float(RNG *rng, std::vector<float> &rect)
+{
+  static const float special[] = {
+      0.0f,
+      1.0f,
+      -0.5f,
+      1.5f,
+      1e30f,
+      -1e30f,
+      std::numeric_limits<float>::quiet_NaN(),
+  };
+  const int special_len = sizeof(special) / sizeof(*special);
+
+  for (size_t i = 0; i < rect.size(); i++) {
+    rect[i] = BLI_rng_get_float(rng) * 1.2f - 0.1f;
+  }
+  for (size_t i = 0; i < rect.size(); i += 3) {
+    rect[i] = special[BLI_rng_get_uint(rng) % special_len];
+  }
+}
+
+static void fill_byte(RNG *rng, std::vector<unsigned char> &rect)
+{
+  for (size_t i = 0; i < rect.size(); i++) {
+    rect[i] = (unsigned char)BLI_rng_get_uint(rng);
+  }
+}
+
+static void expect_float_eq(const std::vector<float> &a, const std::vector<float> &b)
+{
+  for (size_t i = 0; i < a.size(); i++) {
+    if (std::isnan(a[i])) {
+      EXPECT_TRUE(std::isnan(b[i])) << "index " << i;
+    }
+    else {
+      EXPECT_EQ(a[i], b[i]) << "index " << i;
+    }
+  }
+}
+
+TEST(imbuf_divers, FloatToByteRow)
+{
+  RNG *rng = BLI_rng_new(0);
+  std::vector<float> from(WIDTH * 4);
+  std::vector<unsigned char> to_scalar(WIDTH * 4), to_simd(WIDTH * 4);
+
+  for (int iter = 0; iter < 8; iter++) {
+    fill_float(rng, from);
+    for (bool predivide : {false, true}) {
+      imb_rgba_float_to_uchar_row(&to_scalar[0], &from[0], WIDTH, predivide, false);
+      imb_rgba_float_to_uchar_row(&to_simd[0], &from[0], WIDTH, predivide, true);
+
+      for (size_t i = 0; i < to_scalar.size(); i++) {
+        EXPECT_EQ(to_scalar[i], to_simd[i])
+            << "predivide " << predivide << ", index " << i << ", value " << from[i];
+      }
+    }
+  }
+
+  BLI_rng_free(rng);
+}
+
+TEST(imbuf_divers, ByteToFloatRow)
+{
+  RNG *rng = BLI_rng_new(0);
+  std::vector<unsigned char> from(WIDTH * 4);
+  std::vector<float> to_scalar(WIDTH * 4), to_simd(WIDTH * 4);
+
+  for (int iter = 0; iter < 8; iter++) {
+    fill_byte(rng, from);
+    imb_rgba_uchar_to_float_row(&to_scalar[0], &from[0], WIDTH, false);
+    imb_rgba_uchar_to_float_row(&to_simd[0], &from[0], WIDTH, true);
+    expect_float_eq(to_scalar, to_simd);
+  }
+
+  BLI_rng_free(rng);
+}
+
+TEST(imbuf_divers, PremultiplyRow)
+{
+  RNG *rng = BLI_rng_new(0);
+  std::vector<float> rect_scalar(WIDTH * 4), rect_simd(WIDTH * 4);
+
+  for (int iter = 0; iter < 8; iter++) {
+    fill_float(rng, rect_scalar);
+    rect_simd = rect_scalar;
+    imb_premul_to_straight_row(&rect_scalar[0], WIDTH, false);
+    imb_premul_to_straight_row(&rect_simd[0], WIDTH, true);
+    expect_float_eq(rect_scalar, rect_simd);
+
+    fill_float(rng, rect_scalar);
+    rect_simd = rect_scalar;
+    imb_straight_to_premul_row(&rect_scalar[0], WIDTH, false);
+    imb_straight_to_premul_row(&rect_simd[0], WIDTH, true);
+    expect_float_eq(rect_scalar, rect_simd);
+  }
+
+  BLI_rng_free(rng);
+}
+
+/* Linear to sRGB with predivide looks up the straight color, not the premultiplied one. */
+TEST(imbuf_divers, LinearToSRGBPredivide)
+{
+  const float from[3][4] = {
+      {0.25f, 0.125f, 0.0f, 0.5f},
+      {0.5f, 0.5f, 0.5f, 1.0f},
+      {0.0f, 0.0f, 0.0f, 0.0f},
+  };
+  const unsigned char expected[3][4] = {
+      {188, 137, 0, 128},
+      {188, 188, 188, 255},
+      {0, 0, 0, 0},
+  };
+  unsigned char to[3][4];
+
+  BLI_init_srgb_conversion();
+  IMB_buffer_byte_from_float(&to[0][0],
+                             &from[0][0],
+                             4,
+                             0.0f,
+                             IB_PROFILE_SRGB,
+                             IB_PROFILE_LINEAR_RGB,
+                             true,
+                             3,
+                             1,
+                             3,
+                             3);
+
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      EXPECT_EQ(expected[i][j], to[i][j]) << "pixel " << i << ", channel " << j;
+    }
+  }
+}
+
+}  // namespace blender::imbuf::tests
@@ -29,6 +29,7 @@
 #include "BLI_ghash.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 #ifdef _WIN32
 #  include "BLI_winstuff.h"
@@ -445,6 +446,9 @@ typedef struct IndexBuildContext {
 
 #ifdef WITH_FFMPEG
 
+/* Decoded frames a proxy size may lag behind the decoder. */
+#define PROXY_QUEUE_LEN 4
+
 struct proxy_output_ctx {
   AVFormatContext *of;
   AVStream *st;
@@ -456,6 +460,13 @@ struct proxy_output_ctx {
   int proxy_size;
   int orig_height;
   struct anim *anim;
+
+  /* Frames waiting to be scaled and encoded by the thread of this size. */
+  AVFrame *queue[PROXY_QUEUE_LEN];
+  int queue_start, queue_len;
+  bool queue_done;
+  ThreadMutex queue_mutex;
+  ThreadCondition queue_cond;
 };
 
 // work around stupid swscaler 16 bytes alignment bug...
@@ -480,6 +491,9 @@ static struct proxy_output_ctx *alloc_proxy_output_ffmpeg(
   rv->proxy_size = proxy_size;
   rv->anim = anim;
 
+  BLI_mutex_init(&rv->queue_mutex);
+  BLI_condition_init(&rv->queue_cond);
+
   get_proxy_filename(rv->anim, rv->proxy_size, fname, true);
   BLI_make_existing_file(fname);
 
@@ -638,6 +652,63 @@ static int add_to_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, AVFrame *fra
   }
 }
 
+/* Pass a reference to the decoded frame on to the thread of the proxy size. Blocks while its
+ * queue is full, so decoding does not run ahead of the slowest size. */
+static void proxy_output_push_ffmpeg(struct proxy_output_ctx *ctx, AVFrame *frame)
+{
+  AVFrame *frame_ref = av_frame_clone(frame);
+
+  if (!frame_ref) {
+    return;
+  }
+
+  BLI_mutex_lock(&ctx->queue_mutex);
+  while (ctx->queue_len == PROXY_QUEUE_LEN) {
+    BLI_condition_wait(&ctx->queue_cond, &ctx->queue_mutex);
+  }
+  ctx->queue[(ctx->queue_start + ctx->queue_len) % PROXY_QUEUE_LEN] = frame_ref;
+  ctx->queue_len++;
+  BLI_condition_notify_all(&ctx->queue_cond);
+  BLI_mutex_unlock(&ctx->queue_mutex);
+}
+
+static void proxy_output_done_ffmpeg(struct proxy_output_ctx *ctx)
+{
+  BLI_mutex_lock(&ctx->queue_mutex);
+  ctx->queue_done = true;
+  BLI_condition_notify_all(&ctx->queue_cond);
+  BLI_mutex_unlock(&ctx->queue_mutex);
+}
+
+/* Scales and encodes the queued frames of one proxy size. */
+static void *proxy_output_thread_ffmpeg(void *ctx_v)
+{
+  struct proxy_output_ctx *ctx = ctx_v;
+
+  for (;;) {
+    AVFrame *frame;
+
+    BLI_mutex_lock(&ctx->queue_mutex);
+    while (ctx->queue_len == 0 && !ctx->queue_done) {
+      BLI_condition_wait(&ctx->queue_cond, &ctx->queue_mutex);
+    }
+    if (ctx->queue_len == 0) {
+      BLI_mutex_unlock(&ctx->queue_mutex);
+      break;
+    }
+    frame = ctx->queue[ctx->queue_start];
+    ctx->queue_start = (ctx->queue_start + 1) % PROXY_QUEUE_LEN;
+    ctx->queue_len--;
+    BLI_condition_notify_all(&ctx->queue_cond);
+    BLI_mutex_unlock(&ctx->queue_mutex);
+
+    add_to_proxy_output_ffmpeg(ctx, frame);
+    av_frame_free(&frame);
+  }
+
+  return NULL;
+}
+
 static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, int rollback)
 {
   char fname[FILE_MAX];
@@ -683,6 +754,9 @@ static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, int rollback)
     BLI_rename(fname_tmp, fname);
   }
 
+  BLI_condition_end(&ctx->queue_cond);
+  BLI_mutex_end(&ctx->queue_mutex);
+
   MEM_freeN(ctx);
 }
 
@@ -779,6 +853,8 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim,
   }
 
   context->iCodecCtx->workaround_bugs = 1;
+  /* Decoded frames are shared with the proxy threads by reference. */
+  context->iCodecCtx->refcounted_frames = 1;
 
   if (avcodec_open2(context->iCodecCtx, context->iCodec, NULL) < 0) {
     avformat_close_input(&context->iFormatCtx);
@@ -849,7 +925,9 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
 
   for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+    if (context->proxy_ctx[i]) {
+      proxy_output_push_ffmpeg(context->proxy_ctx[i], in_frame);
+    }
   }
 
   if (!context->start_pts_set) {
@@ -901,11 +979,28 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
   AVFrame *in_frame = 0;
   AVPacket next_packet;
   uint64_t stream_size;
+  ListBase threads;
+  int i, num_threads = 0;
 
   memset(&next_packet, 0, sizeof(AVPacket));
 
   in_frame = av_frame_alloc();
 
+  /* Every proxy size is scaled and encoded on its own thread while decoding continues. */
+  for (i = 0; i < context->num_proxy_sizes; i++) {
+    if (context->proxy_ctx[i]) {
+      num_threads++;
+    }
+  }
+  if (num_threads) {
+    BLI_threadpool_init(&threads, proxy_output_thread_ffmpeg, num_threads);
+    for (i = 0; i < context->num_proxy_sizes; i++) {
+      if (context->proxy_ctx[i]) {
+        BLI_threadpool_insert(&threads, context->proxy_ctx[i]);
+      }
+    }
+  }
+
   stream_size = avio_size(context->iFormatCtx->pb);
 
   context->frame_rate = av_q2d(av_guess_frame_rate(context->iFormatCtx, context->iStream, NULL));
@@ -940,6 +1035,7 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 
     if (frame_finished) {
       index_rebuild_ffmpeg_proc_decoded_frame(context, &next_packet, in_frame);
+      av_frame_unref(in_frame);
     }
     av_free_packet(&next_packet);
   }
@@ -962,11 +1058,21 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
 
       if (frame_finished) {
         index_rebuild_ffmpeg_proc_decoded_frame(context, &next_packet, in_frame);
+        av_frame_unref(in_frame);
       }
     } while (frame_finished);
   }
 
-  av_free(in_frame);
+  if (num_threads) {
+    for (i = 0; i < context->num_proxy_sizes; i++) {
+      if (context->proxy_ctx[i]) {
+        proxy_output_done_ffmpeg(context->proxy_ctx[i]);
+      }
+    }
+    BLI_threadpool_end(&threads);
+  }
+
+  av_frame_free(&in_frame);
 
   return 1;
 }
@@ -52,7 +52,11 @@ static void skip_input_data(j_decompress_ptr cinfo, long num_bytes);
 static void term_source(j_decompress_ptr cinfo);
 static void memory_source(j_decompress_ptr cinfo, const unsigned char *buffer, size_t size);
 static boolean handle_app1(j_decompress_ptr cinfo);
-static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int flags);
+static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo,
+                                   int flags,
+                                   int max_size,
+                                   size_t *r_width,
+                                   size_t *r_height);
 
 static const uchar jpeg_default_quality = 75;
 static uchar ibuf_quality;
@@ -258,7 +262,11 @@ static boolean handle_app1(j_decompress_ptr cinfo)
   return true;
 }
 
-static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int flags)
+static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo,
+                                   int flags,
+                                   int max_size,
+                                   size_t *r_width,
+                                   size_t *r_height)
 {
   JSAMPARRAY row_pointer;
   JSAMPLE *buffer = NULL;
@@ -276,16 +284,38 @@ static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int fla
   jpeg_save_markers(cinfo, JPEG_COM, 0xffff);
 
   if (jpeg_read_header(cinfo, false) == JPEG_HEADER_OK) {
-    x = cinfo->image_width;
-    y = cinfo->image_height;
     depth = cinfo->num_components;
 
+    if (r_width) {
+      *r_width = cinfo->image_width;
+    }
+    if (r_height) {
+      *r_height = cinfo->image_height;
+    }
+
     if (cinfo->jpeg_color_space == JCS_YCCK) {
       cinfo->out_color_space = JCS_CMYK;
     }
 
+    if (max_size > 0) {
+      /* Let the decoder skip DCT coefficients, it can scale down by up to 8 for free. */
+      const int max_side = (int)MAX2(cinfo->image_width, cinfo->image_height);
+      int scale = 8;
+
+      while (scale > 1 && max_side / scale < max_size) {
+        scale /= 2;
+      }
+      cinfo->scale_num = 1;
+      cinfo->scale_denom = scale;
+      cinfo->dct_method = JDCT_IFAST;
+      cinfo->do_fancy_upsampling = false;
+    }
+
     jpeg_start_decompress(cinfo);
 
+    x = cinfo->output_width;
+    y = cinfo->output_height;
+
     if (flags & IB_test) {
       jpeg_abort_decompress(cinfo);
       ibuf = IMB_allocImBuf(x, y, 8 * depth, 0);
@@ -420,10 +450,13 @@ static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int fla
   return (ibuf);
 }
 
-ImBuf *imb_load_jpeg(const unsigned char *buffer,
-                     size_t size,
-                     int flags,
-                     char colorspace[IM_MAX_SPACE])
+static ImBuf *imb_load_jpeg_ex(const unsigned char *buffer,
+                                size_t size,
+                                int flags,
+                                int max_size,
+                                char colorspace[IM_MAX_SPACE],
+                                size_t *r_width,
+                                size_t *r_height)
 {
   struct jpeg_decompress_struct _cinfo, *cinfo = &_cinfo;
   struct my_error_mgr jerr;
@@ -450,11 +483,32 @@ ImBuf *imb_load_jpeg(const unsigned char *buffer,
   jpeg_create_decompress(cinfo);
   memory_source(cinfo, buffer, size);
 
-  ibuf = ibJpegImageFromCinfo(cinfo, flags);
+  ibuf = ibJpegImageFromCinfo(cinfo, flags, max_size, r_width, r_height);
 
   return (ibuf);
 }
 
+ImBuf *imb_load_jpeg(const unsigned char *buffer,
+                     size_t size,
+                     int flags,
+                     char colorspace[IM_MAX_SPACE])
+{
+  return imb_load_jpeg_ex(buffer, size, flags, 0, colorspace, NULL, NULL);
+}
+
+/* Decode the image at a reduced size using the DCT scaling of libjpeg, much cheaper than
+ * decoding it fully and scaling it afterwards. */
+ImBuf *imb_thumbnail_jpeg(const unsigned char *mem,
+                          size_t size,
+                          int flags,
+                          size_t max_thumb_size,
+                          char colorspace[IM_MAX_SPACE],
+                          size_t *r_width,
+                          size_t *r_height)
+{
+  return imb_load_jpeg_ex(mem, size, flags, (int)max_thumb_size, colorspace, r_width, r_height);
+}
+
 static void write_jpeg(struct jpeg_compress_struct *cinfo, struct ImBuf *ibuf)
 {
   JSAMPLE *buffer = NULL;
@@ -29,7 +29,6 @@
 
 void IMB_init(void)
 {
-  imb_refcounter_lock_init();
   imb_mmap_lock_init();
   imb_filetypes_init();
   imb_tile_cache_init();
@@ -42,5 +41,4 @@ void IMB_exit(void)
   imb_filetypes_exit();
   colormanagement_exit();
   imb_mmap_lock_exit();
-  imb_refcounter_lock_exit();
 }
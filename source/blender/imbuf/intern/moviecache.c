@@ -23,12 +23,15 @@
 
 #undef DEBUG_MESSAGES
 
+#include <limits.h>
 #include <memory.h>
 #include <stdlib.h> /* for qsort */
 
 #include "MEM_CacheLimiterC-Api.h"
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_ghash.h"
 #include "BLI_mempool.h"
 #include "BLI_string.h"
@@ -51,7 +54,14 @@
 #endif
 
 static MEM_CacheLimiterC *limitor = NULL;
-static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
+/* Inserting items is thread safe in the limiter and only needs read access. Enforcing limits
+ * takes write access, so items being inserted are not destroyed before they are referenced.
+ * Unmanaging doesn't need the lock, the limiter destroys items of all caches without holding
+ * its own locks and unmanaging an item waits while it is being destroyed. */
+static ThreadRWMutex limitor_lock = BLI_RWLOCK_INITIALIZER;
+/* Incremented on every put, items store the epoch they were last used in. Lookups only read it,
+ * so they don't need limitor_lock, the limiter evicts least recently used items first. */
+static unsigned int limitor_epoch = 0;
 
 typedef struct MovieCache {
   char name[64];
@@ -71,6 +81,10 @@ typedef struct MovieCache {
 
   int keysize;
 
+  /* Guards the buffers and limiter handles of items against the limiter destroying them, which
+   * can happen from a put into any other cache. */
+  SpinLock ibuf_lock;
+
   void *last_userkey;
 
   int totseg, *points, proxy, render_flags; /* for visual statistics optimization */
@@ -87,6 +101,7 @@ typedef struct MovieCacheItem {
   ImBuf *ibuf;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+  unsigned int last_used;
 } MovieCacheItem;
 
 static unsigned int moviecache_hashhash(const void *keyv)
@@ -117,12 +132,27 @@ static void moviecache_valfree(void *val)
 {
   MovieCacheItem *item = (MovieCacheItem *)val;
   MovieCache *cache = item->cache_owner;
+  MEM_CacheLimiterHandleC *c_handle;
+  ImBuf *ibuf;
 
   PRINT("%s: cache '%s' free item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
-  if (item->ibuf) {
-    MEM_CacheLimiter_unmanage(item->c_handle);
-    IMB_freeImBuf(item->ibuf);
+  /* Freeing buffers can free other caches from inside the destructor of the limiter, which is
+   * why the limiter lock isn't taken here. The handle stays set until the destructor is done
+   * with the item, unmanaging waits for it then. */
+  BLI_spin_lock(&cache->ibuf_lock);
+  ibuf = item->ibuf;
+  c_handle = item->c_handle;
+  item->ibuf = NULL;
+  item->c_handle = NULL;
+  BLI_spin_unlock(&cache->ibuf_lock);
+
+  if (c_handle) {
+    MEM_CacheLimiter_unmanage(c_handle);
+  }
+
+  if (ibuf) {
+    IMB_freeImBuf(ibuf);
   }
 
   if (item->priority_data && cache->prioritydeleterfp) {
@@ -168,21 +198,32 @@ static void IMB_moviecache_destructor(void *p)
 {
   MovieCacheItem *item = (MovieCacheItem *)p;
 
-  if (item && item->ibuf) {
+  if (item) {
     MovieCache *cache = item->cache_owner;
+    ImBuf *ibuf;
 
     PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
-    IMB_freeImBuf(item->ibuf);
-
+    BLI_spin_lock(&cache->ibuf_lock);
+    ibuf = item->ibuf;
     item->ibuf = NULL;
-    item->c_handle = NULL;
+    BLI_spin_unlock(&cache->ibuf_lock);
 
-    /* force cached segments to be updated */
-    if (cache->points) {
-      MEM_freeN(cache->points);
-      cache->points = NULL;
+    /* The buffer is gone when the item is being freed meanwhile, which waits for this. */
+    if (ibuf) {
+      IMB_freeImBuf(ibuf);
+
+      /* force cached segments to be updated */
+      if (cache->points) {
+        MEM_freeN(cache->points);
+        cache->points = NULL;
+      }
     }
+
+    /* Last access to the item, it can be freed once its handle is cleared. */
+    BLI_spin_lock(&cache->ibuf_lock);
+    item->c_handle = NULL;
+    BLI_spin_unlock(&cache->ibuf_lock);
   }
 }
 
@@ -200,9 +241,11 @@ static size_t get_item_size(void *p)
 {
   size_t size = sizeof(MovieCacheItem);
   MovieCacheItem *item = (MovieCacheItem *)p;
+  /* Can be cleared by a concurrent free, which frees the buffer after unmanaging the item. */
+  ImBuf *ibuf = item->ibuf;
 
-  if (item->ibuf) {
-    size += get_size_in_memory(item->ibuf);
+  if (ibuf) {
+    size += get_size_in_memory(ibuf);
   }
 
   return size;
@@ -215,13 +258,12 @@ static int get_item_priority(void *item_v, int default_priority)
   int priority;
 
   if (!cache->getitempriorityfp) {
-    PRINT("%s: cache '%s' item %p use default priority %d\n",
-          __func__,
-          cache->name,
-          item,
-          default_priority);
+    /* Least recently used first, the limiter keeps insertion order for items of the same age. */
+    priority = -(int)MIN2(limitor_epoch - item->last_used, (unsigned int)INT_MAX);
+
+    PRINT("%s: cache '%s' item %p use age priority %d\n", __func__, cache->name, item, priority);
 
-    return default_priority;
+    return priority;
   }
 
   priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
@@ -234,12 +276,13 @@ static int get_item_priority(void *item_v, int default_priority)
 static bool get_item_destroyable(void *item_v)
 {
   MovieCacheItem *item = (MovieCacheItem *)item_v;
+  ImBuf *ibuf = item->ibuf;
   /* IB_BITMAPDIRTY means image was modified from inside blender and
    * changes are not saved to disk.
    *
    * Such buffers are never to be freed.
    */
-  if ((item->ibuf->userflags & IB_BITMAPDIRTY) || (item->ibuf->userflags & IB_PERSISTENT)) {
+  if (ibuf == NULL || (ibuf->userflags & IB_BITMAPDIRTY) || (ibuf->userflags & IB_PERSISTENT)) {
     return false;
   }
   return true;
@@ -276,6 +319,7 @@ MovieCache *IMB_moviecache_create(const char *name,
   cache->keys_pool = BLI_mempool_create(sizeof(MovieCacheKey), 0, 64, BLI_MEMPOOL_NOP);
   cache->items_pool = BLI_mempool_create(sizeof(MovieCacheItem), 0, 64, BLI_MEMPOOL_NOP);
   cache->userkeys_pool = BLI_mempool_create(keysize, 0, 64, BLI_MEMPOOL_NOP);
+  BLI_spin_init(&cache->ibuf_lock);
   cache->hash = BLI_ghash_new(
       moviecache_hashhash, moviecache_hashcmp, "MovieClip ImBuf cache hash");
 
@@ -304,14 +348,11 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
   cache->prioritydeleterfp = prioritydeleterfp;
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
   MovieCacheKey *key;
   MovieCacheItem *item;
-
-  if (!limitor) {
-    IMB_moviecache_init();
-  }
+  bool need_enforce;
 
   IMB_refImBuf(ibuf);
 
@@ -328,6 +369,7 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   item->cache_owner = cache;
   item->c_handle = NULL;
   item->priority_data = NULL;
+  item->last_used = 0;
 
   if (cache->getprioritydatafp) {
     item->priority_data = cache->getprioritydatafp(userkey);
@@ -339,18 +381,32 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     memcpy(cache->last_userkey, userkey, cache->keysize);
   }
 
-  if (need_lock) {
-    BLI_mutex_lock(&limitor_lock);
+  if (!limitor) {
+    BLI_rw_mutex_lock(&limitor_lock, THREAD_LOCK_WRITE);
+    if (!limitor) {
+      IMB_moviecache_init();
+    }
+    BLI_rw_mutex_unlock(&limitor_lock);
   }
 
+  BLI_rw_mutex_lock(&limitor_lock, THREAD_LOCK_READ);
+
+  item->last_used = atomic_add_and_fetch_uint32(&limitor_epoch, 1);
   item->c_handle = MEM_CacheLimiter_insert(limitor, item);
 
-  MEM_CacheLimiter_ref(item->c_handle);
-  MEM_CacheLimiter_enforce_limits(limitor);
-  MEM_CacheLimiter_unref(item->c_handle);
+  /* Only checks the accounted memory, most puts don't need exclusive access. */
+  need_enforce = MEM_CacheLimiter_is_over_limit(limitor);
+  if (need_enforce) {
+    MEM_CacheLimiter_ref(item->c_handle);
+  }
+
+  BLI_rw_mutex_unlock(&limitor_lock);
 
-  if (need_lock) {
-    BLI_mutex_unlock(&limitor_lock);
+  if (need_enforce) {
+    BLI_rw_mutex_lock(&limitor_lock, THREAD_LOCK_WRITE);
+    MEM_CacheLimiter_enforce_limits(limitor);
+    MEM_CacheLimiter_unref(item->c_handle);
+    BLI_rw_mutex_unlock(&limitor_lock);
   }
 
   /* cache limiter can't remove unused keys which points to destroyed values */
@@ -362,11 +418,6 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   }
 }
 
-void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
-{
-  do_moviecache_put(cache, userkey, ibuf, true);
-}
-
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
   size_t mem_in_use, mem_limit, elem_size;
@@ -375,16 +426,17 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
   elem_size = get_size_in_memory(ibuf);
   mem_limit = MEM_CacheLimiter_get_maximum();
 
-  BLI_mutex_lock(&limitor_lock);
-  mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+  BLI_rw_mutex_lock(&limitor_lock, THREAD_LOCK_READ);
+  mem_in_use = limitor ? MEM_CacheLimiter_get_memory_in_use(limitor) : 0;
+  BLI_rw_mutex_unlock(&limitor_lock);
 
+  /* Putting frees replaced items, which takes the lock again. Concurrent puts may slightly
+   * overshoot the limit, the put itself still enforces it. */
   if (mem_in_use + elem_size <= mem_limit) {
-    do_moviecache_put(cache, userkey, ibuf, false);
+    IMB_moviecache_put(cache, userkey, ibuf);
     result = true;
   }
 
-  BLI_mutex_unlock(&limitor_lock);
-
   return result;
 }
 
@@ -406,15 +458,24 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
   item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
 
   if (item) {
-    if (item->ibuf) {
-      BLI_mutex_lock(&limitor_lock);
-      MEM_CacheLimiter_touch(item->c_handle);
-      BLI_mutex_unlock(&limitor_lock);
-
-      IMB_refImBuf(item->ibuf);
+    ImBuf *ibuf;
+    const unsigned int epoch = limitor_epoch;
+
+    /* Only record the use, the limiter takes it into account the next time it enforces limits.
+     * Avoid writing when nothing changed, so threads reading the same item don't share a dirty
+     * cache line. */
+    if (item->last_used != epoch) {
+      item->last_used = epoch;
+    }
 
-      return item->ibuf;
+    BLI_spin_lock(&cache->ibuf_lock);
+    ibuf = item->ibuf;
+    if (ibuf) {
+      IMB_refImBuf(ibuf);
     }
+    BLI_spin_unlock(&cache->ibuf_lock);
+
+    return ibuf;
   }
 
   return NULL;
@@ -441,6 +502,7 @@ void IMB_moviecache_free(MovieCache *cache)
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
   BLI_mempool_destroy(cache->userkeys_pool);
+  BLI_spin_end(&cache->ibuf_lock);
 
   if (cache->points) {
     MEM_freeN(cache->points);
@@ -42,6 +42,7 @@
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
 #include <ImfPixelType.h>
+#include <ImfPreviewImage.h>
 #include <ImfStandardAttributes.h>
 #include <ImfStringAttribute.h>
 #include <ImfVersion.h>
@@ -55,6 +56,7 @@
 #include <ImfOutputPart.h>
 #include <ImfPartHelper.h>
 #include <ImfPartType.h>
+#include <ImfTiledInputPart.h>
 #include <ImfTiledOutputPart.h>
 
 #include "DNA_scene_types.h" /* For OpenEXR compression constants */
@@ -77,7 +79,10 @@ _CRTIMP void __cdecl _invalid_parameter_noinfo(void)
 #endif
 }
 #include "BLI_blenlib.h"
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
+#include "BLI_math_vector.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_idprop.h"
@@ -98,6 +103,7 @@ using namespace Imath;
 extern "C" {
 /* prototype */
 static struct ExrPass *imb_exr_get_pass(ListBase *lb, char *passname);
+static void imb_exr_pass_alloc(struct ExrHandle *data, struct ExrPass *pass);
 static bool exr_has_multiview(MultiPartInputFile &file);
 static bool exr_has_multipart_file(MultiPartInputFile &file);
 static bool exr_has_alpha(MultiPartInputFile &file);
@@ -136,6 +142,22 @@ class IMemStream : public Imf::IStream {
     }
   }
 
+  /* Compressed chunks are decoded straight from the buffer, without a copy. */
+  virtual bool isMemoryMapped() const
+  {
+    return true;
+  }
+
+  virtual char *readMemoryMapped(int n)
+  {
+    if (n + _exrpos > _exrsize) {
+      throw Iex::InputExc("Unexpected end of file.");
+    }
+    char *data = (char *)&_exrbuf[_exrpos];
+    _exrpos += n;
+    return data;
+  }
+
   virtual Int64 tellg()
   {
     return _exrpos;
@@ -150,6 +172,14 @@ class IMemStream : public Imf::IStream {
   {
   }
 
+  /* Continue reading from another buffer with the same contents, positions stay valid.
+   * Without a buffer reads fail. */
+  void set_buffer(unsigned char *exrbuf, size_t exrsize)
+  {
+    _exrbuf = exrbuf;
+    _exrsize = exrsize;
+  }
+
  private:
   Int64 _exrpos;
   Int64 _exrsize;
@@ -626,6 +656,13 @@ typedef struct ExrHandle {
   IStream *ifile_stream;
   MultiPartInputFile *ifile;
 
+  /* The file when read from memory, parts can be decoded in parallel from it. Owned by the
+   * handle when passes are read after loading, only set while reading otherwise. */
+  unsigned char *mem;
+  size_t mem_size;
+  /* Set once IMB_exr_read_passes() allocated and read the requested passes. */
+  bool passes_read;
+
   OFileStream *ofile_stream;
   MultiPartOutputFile *mpofile;
   OutputFile *ofile;
@@ -654,6 +691,7 @@ typedef struct ExrChannel {
   struct MultiViewChannelName *m; /* struct to store all multipart channel info */
   int xstride, ystride;           /* step to next pixel, to next scanline */
   float *rect;                    /* first pointer to write in */
+  int pass_offset;                /* offset in the interleaved pass rect, when reading passes */
   char chan_id;                   /* quick lookup of channel char */
   int view_id;                    /* quick lookup of channel view */
   bool use_half_float;            /* when saving use half float for file storage */
@@ -1204,6 +1242,49 @@ void IMB_exrtile_write_channels(
   }
 }
 
+/* Parts of a handle read from memory, decoded in parallel. */
+typedef struct ExrReadPartsData {
+  ExrHandle *data;
+  const std::vector<int> *parts;
+  const std::vector<FrameBuffer> *frame_buffers;
+} ExrReadPartsData;
+
+static bool exr_read_part_pixels(MultiPartInputFile &file, int part, const FrameBuffer &frameBuffer)
+{
+  try {
+    InputPart in(file, part);
+    Box2i dw = in.header().dataWindow();
+    in.setFrameBuffer(frameBuffer);
+    exr_printf("readPixels:readPixels[%d]: min.y: %d, max.y: %d\n", part, dw.min.y, dw.max.y);
+    in.readPixels(dw.min.y, dw.max.y);
+  }
+  catch (const std::exception &exc) {
+    std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void exr_read_part_cb(void *__restrict userdata,
+                             const int index,
+                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ExrReadPartsData *read_data = (ExrReadPartsData *)userdata;
+  ExrHandle *data = read_data->data;
+  const int part = (*read_data->parts)[index];
+
+  /* The parts of one file share a stream lock, so every task opens the file on its own stream.
+   * Scanline blocks within the part are still decoded by the OpenEXR thread pool. */
+  try {
+    IMemStream stream(data->mem, data->mem_size);
+    MultiPartInputFile file(stream);
+    exr_read_part_pixels(file, part, (*read_data->frame_buffers)[part]);
+  }
+  catch (const std::exception &exc) {
+    std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+  }
+}
+
 void IMB_exr_read_channels(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
@@ -1224,15 +1305,16 @@ void IMB_exr_read_channels(void *handle)
       "name",
       "internal_name");
 
-  for (int i = 0; i < numparts; i++) {
-    /* Read part header. */
-    InputPart in(*data->ifile, i);
-    Header header = in.header();
-    Box2i dw = header.dataWindow();
+  /* Insert all matching channels into the frame buffer of their part, channels without a rect
+   * are not converted, parts without any channel are not decoded at all. */
+  std::vector<FrameBuffer> frameBuffers(numparts);
+  std::vector<int> parts;
 
-    /* Insert all matching channel into framebuffer. */
-    FrameBuffer frameBuffer;
+  for (int i = 0; i < numparts; i++) {
+    Box2i dw = data->ifile->header(i).dataWindow();
+    FrameBuffer &frameBuffer = frameBuffers[i];
     ExrChannel *echan;
+    int totchan = 0;
 
     for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
       if (echan->m->part_number != i) {
@@ -1264,23 +1346,62 @@ void IMB_exr_read_channels(void *handle)
 
         frameBuffer.insert(echan->m->internal_name,
                            Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
+        totchan++;
       }
-      else {
+      else if (!data->passes_read) {
         printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
       }
     }
 
-    /* Read pixels. */
-    try {
-      in.setFrameBuffer(frameBuffer);
-      exr_printf("readPixels:readPixels[%d]: min.y: %d, max.y: %d\n", i, dw.min.y, dw.max.y);
-      in.readPixels(dw.min.y, dw.max.y);
+    if (totchan) {
+      parts.push_back(i);
     }
-    catch (const std::exception &exc) {
-      std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
-      break;
+  }
+
+  /* Read pixels. */
+  if (data->mem && parts.size() > 1) {
+    ExrReadPartsData read_data = {data, &parts, &frameBuffers};
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(0, (int)parts.size(), &read_data, exr_read_part_cb, &settings);
+  }
+  else {
+    for (size_t i = 0; i < parts.size(); i++) {
+      if (!exr_read_part_pixels(*data->ifile, parts[i], frameBuffers[parts[i]])) {
+        break;
+      }
+    }
+  }
+}
+
+void IMB_exr_read_passes(void *handle,
+                         bool (*filter)(void *userdata,
+                                        const char *layname,
+                                        const char *passname,
+                                        const char *chan_id,
+                                        const char *view),
+                         void *userdata)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+  ExrLayer *lay;
+  ExrPass *pass;
+
+  if (data->passes_read) {
+    return;
+  }
+
+  for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
+    for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
+      if (filter == NULL ||
+          filter(userdata, lay->name, pass->internal_name, pass->chan_id, pass->view)) {
+        imb_exr_pass_alloc(data, pass);
+      }
     }
   }
+  data->passes_read = true;
+
+  IMB_exr_read_channels(handle);
 }
 
 void IMB_exr_multilayer_convert(void *handle,
@@ -1316,10 +1437,18 @@ void IMB_exr_multilayer_convert(void *handle,
     return;
   }
 
+  if (!data->passes_read) {
+    IMB_exr_read_passes(handle, NULL, NULL);
+  }
+
   for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
     void *laybase = addlayer(base, lay->name);
     if (laybase) {
       for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
+        if (pass->rect == NULL) {
+          /* Not requested by IMB_exr_read_passes(). */
+          continue;
+        }
         addpass(base,
                 laybase,
                 pass->internal_name,
@@ -1353,6 +1482,8 @@ void IMB_exr_close(void *handle)
   data->mpofile = NULL;
   data->ofile_stream = NULL;
 
+  MEM_SAFE_FREE(data->mem);
+
   for (chan = (ExrChannel *)data->channels.first; chan; chan = chan->next) {
     delete chan->m;
   }
@@ -1524,21 +1655,98 @@ static ExrPass *imb_exr_get_pass(ListBase *lb, char *passname)
   return pass;
 }
 
-/* creates channels, makes a hierarchy and assigns memory to channels */
-static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
-                                         MultiPartInputFile &file,
+/* with some heuristics, try to merge the channels of a pass in one interleaved buffer */
+static void imb_exr_pass_layout(ExrPass *pass, int width)
+{
+  ExrChannel *echan;
+  int a;
+
+  if (pass->totchan == 1) {
+    echan = pass->chan[0];
+    echan->pass_offset = 0;
+    echan->xstride = 1;
+    echan->ystride = width;
+    pass->chan_id[0] = echan->chan_id;
+  }
+  else {
+    char lookup[256];
+
+    memset(lookup, 0, sizeof(lookup));
+
+    /* we can have RGB(A), XYZ(W), UVA */
+    if (pass->totchan == 3 || pass->totchan == 4) {
+      if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
+          pass->chan[2]->chan_id == 'B') {
+        lookup[(unsigned int)'R'] = 0;
+        lookup[(unsigned int)'G'] = 1;
+        lookup[(unsigned int)'B'] = 2;
+        lookup[(unsigned int)'A'] = 3;
+      }
+      else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
+               pass->chan[2]->chan_id == 'Y') {
+        lookup[(unsigned int)'X'] = 0;
+        lookup[(unsigned int)'Y'] = 1;
+        lookup[(unsigned int)'Z'] = 2;
+        lookup[(unsigned int)'W'] = 3;
+      }
+      else {
+        lookup[(unsigned int)'U'] = 0;
+        lookup[(unsigned int)'V'] = 1;
+        lookup[(unsigned int)'A'] = 2;
+      }
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->pass_offset = lookup[(unsigned int)echan->chan_id];
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
+      }
+    }
+    else { /* unknown */
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->pass_offset = a;
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[a] = echan->chan_id;
+      }
+    }
+  }
+}
+
+/* assigns memory to the channels of a pass, so they get read */
+static void imb_exr_pass_alloc(ExrHandle *data, ExrPass *pass)
+{
+  if (pass->rect || pass->totchan == 0) {
+    return;
+  }
+
+  pass->rect = (float *)MEM_callocN(
+      sizeof(float) * data->width * data->height * pass->totchan, "pass rect");
+  for (int a = 0; a < pass->totchan; a++) {
+    pass->chan[a]->rect = pass->rect + pass->chan[a]->pass_offset;
+  }
+}
+
+/* creates channels and makes a hierarchy, takes ownership of the file and its stream.
+ * All passes are read when not deferred, otherwise memory is assigned to the channels of the
+ * passes requested by IMB_exr_read_passes() */
+static ExrHandle *imb_exr_begin_read_mem(IMemStream *file_stream,
+                                         MultiPartInputFile *file,
+                                         const unsigned char *mem,
+                                         size_t size,
                                          int width,
-                                         int height)
+                                         int height,
+                                         bool deferred)
 {
   ExrLayer *lay;
   ExrPass *pass;
   ExrChannel *echan;
   ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
-  int a;
   char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
 
-  data->ifile_stream = &file_stream;
-  data->ifile = &file;
+  data->ifile_stream = file_stream;
+  data->ifile = file;
 
   data->width = width;
   data->height = height;
@@ -1595,67 +1803,30 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
     return NULL;
   }
 
-  /* with some heuristics, try to merge the channels in buffers */
   for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
     for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
       if (pass->totchan) {
-        pass->rect = (float *)MEM_callocN(width * height * pass->totchan * sizeof(float),
-                                          "pass rect");
-        if (pass->totchan == 1) {
-          echan = pass->chan[0];
-          echan->rect = pass->rect;
-          echan->xstride = 1;
-          echan->ystride = width;
-          pass->chan_id[0] = echan->chan_id;
-        }
-        else {
-          char lookup[256];
-
-          memset(lookup, 0, sizeof(lookup));
-
-          /* we can have RGB(A), XYZ(W), UVA */
-          if (pass->totchan == 3 || pass->totchan == 4) {
-            if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
-                pass->chan[2]->chan_id == 'B') {
-              lookup[(unsigned int)'R'] = 0;
-              lookup[(unsigned int)'G'] = 1;
-              lookup[(unsigned int)'B'] = 2;
-              lookup[(unsigned int)'A'] = 3;
-            }
-            else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
-                     pass->chan[2]->chan_id == 'Y') {
-              lookup[(unsigned int)'X'] = 0;
-              lookup[(unsigned int)'Y'] = 1;
-              lookup[(unsigned int)'Z'] = 2;
-              lookup[(unsigned int)'W'] = 3;
-            }
-            else {
-              lookup[(unsigned int)'U'] = 0;
-              lookup[(unsigned int)'V'] = 1;
-              lookup[(unsigned int)'A'] = 2;
-            }
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + lookup[(unsigned int)echan->chan_id];
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
-            }
-          }
-          else { /* unknown */
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + a;
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[a] = echan->chan_id;
-            }
-          }
-        }
+        imb_exr_pass_layout(pass, width);
       }
     }
   }
 
+  if (deferred) {
+    /* The passes are read after the caller released the file memory. */
+    data->mem = (unsigned char *)MEM_mallocN(size, "exr file");
+    data->mem_size = size;
+    memcpy(data->mem, mem, size);
+    file_stream->set_buffer(data->mem, size);
+  }
+  else {
+    data->mem = (unsigned char *)mem;
+    data->mem_size = size;
+    IMB_exr_read_passes(data, NULL, NULL);
+    data->mem = NULL;
+    data->mem_size = 0;
+    file_stream->set_buffer(NULL, 0);
+  }
+
   return data;
 }
 
@@ -1870,6 +2041,61 @@ static bool imb_exr_is_multi(MultiPartInputFile &file)
   return false;
 }
 
+/* Insert slices reading the color channels of the first part as RGBA floats into frameBuffer.
+ * Luma and chroma are read into the RGB slots, see exr_rgba_luma_to_rgb(). */
+static void exr_rgba_framebuffer_insert(
+    MultiPartInputFile &file, FrameBuffer &frameBuffer, float *first, int xstride, int ystride)
+{
+  if (exr_has_rgb(file)) {
+    frameBuffer.insert(exr_rgba_channelname(file, "R"),
+                       Slice(Imf::FLOAT, (char *)first, xstride, ystride));
+    frameBuffer.insert(exr_rgba_channelname(file, "G"),
+                       Slice(Imf::FLOAT, (char *)(first + 1), xstride, ystride));
+    frameBuffer.insert(exr_rgba_channelname(file, "B"),
+                       Slice(Imf::FLOAT, (char *)(first + 2), xstride, ystride));
+  }
+  else if (exr_has_luma(file)) {
+    frameBuffer.insert(exr_rgba_channelname(file, "Y"),
+                       Slice(Imf::FLOAT, (char *)first, xstride, ystride));
+    frameBuffer.insert(exr_rgba_channelname(file, "BY"),
+                       Slice(Imf::FLOAT, (char *)(first + 1), xstride, ystride, 1, 1, 0.5f));
+    frameBuffer.insert(exr_rgba_channelname(file, "RY"),
+                       Slice(Imf::FLOAT, (char *)(first + 2), xstride, ystride, 1, 1, 0.5f));
+  }
+
+  /* 1.0 is fill value, this still needs to be assigned even when (is_alpha == 0) */
+  frameBuffer.insert(exr_rgba_channelname(file, "A"),
+                     Slice(Imf::FLOAT, (char *)(first + 3), xstride, ystride, 1, 1, 1.0f));
+}
+
+static void exr_rgba_luma_to_rgb(MultiPartInputFile &file, float *rect, size_t totpixel)
+{
+  size_t a;
+
+  if (exr_has_rgb(file) || !exr_has_luma(file)) {
+    return;
+  }
+
+  if (exr_has_chroma(file)) {
+    for (a = 0; a < totpixel; a++) {
+      float *color = rect + a * 4;
+      ycc_to_rgb(color[0] * 255.0f,
+                 color[1] * 255.0f,
+                 color[2] * 255.0f,
+                 &color[0],
+                 &color[1],
+                 &color[2],
+                 BLI_YCC_ITU_BT709);
+    }
+  }
+  else {
+    for (a = 0; a < totpixel; a++) {
+      float *color = rect + a * 4;
+      color[1] = color[2] = color[0];
+    }
+  }
+}
+
 bool IMB_exr_has_multilayer(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
@@ -1949,16 +2175,18 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
 
         /* Only enters with IB_multilayer flag set. */
         if (is_multi && ((flags & IB_thumbnail) == 0)) {
-          /* constructs channels for reading, allocates memory in channels */
-          ExrHandle *handle = imb_exr_begin_read_mem(*membuf, *file, width, height);
+          /* Constructs channels for reading and reads them, unless the caller asks for passes
+           * later on, see IMB_exr_read_passes(). */
+          ExrHandle *handle = imb_exr_begin_read_mem(
+              membuf, file, mem, size, width, height, (flags & IB_multilayer_deferred) != 0);
           if (handle) {
-            IMB_exr_read_channels(handle);
             ibuf->userdata = handle; /* potential danger, the caller has to check for this! */
           }
+          /* The handle owns the file, also when it failed. */
+          file = NULL;
+          membuf = NULL;
         }
         else {
-          const bool has_rgb = exr_has_rgb(*file);
-          const bool has_luma = exr_has_luma(*file);
           FrameBuffer frameBuffer;
           float *first;
           int xstride = sizeof(float) * 4;
@@ -1972,28 +2200,7 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
           /* but, since we read y-flipped (negative y stride) we move to last scanline */
           first += 4 * (height - 1) * width;
 
-          if (has_rgb) {
-            frameBuffer.insert(exr_rgba_channelname(*file, "R"),
-                               Slice(Imf::FLOAT, (char *)first, xstride, ystride));
-            frameBuffer.insert(exr_rgba_channelname(*file, "G"),
-                               Slice(Imf::FLOAT, (char *)(first + 1), xstride, ystride));
-            frameBuffer.insert(exr_rgba_channelname(*file, "B"),
-                               Slice(Imf::FLOAT, (char *)(first + 2), xstride, ystride));
-          }
-          else if (has_luma) {
-            frameBuffer.insert(exr_rgba_channelname(*file, "Y"),
-                               Slice(Imf::FLOAT, (char *)first, xstride, ystride));
-            frameBuffer.insert(
-                exr_rgba_channelname(*file, "BY"),
-                Slice(Imf::FLOAT, (char *)(first + 1), xstride, ystride, 1, 1, 0.5f));
-            frameBuffer.insert(
-                exr_rgba_channelname(*file, "RY"),
-                Slice(Imf::FLOAT, (char *)(first + 2), xstride, ystride, 1, 1, 0.5f));
-          }
-
-          /* 1.0 is fill value, this still needs to be assigned even when (is_alpha == 0) */
-          frameBuffer.insert(exr_rgba_channelname(*file, "A"),
-                             Slice(Imf::FLOAT, (char *)(first + 3), xstride, ystride, 1, 1, 1.0f));
+          exr_rgba_framebuffer_insert(*file, frameBuffer, first, xstride, ystride);
 
           if (exr_has_zbuffer(*file)) {
             float *firstz;
@@ -2021,27 +2228,7 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
           //     IMB_rect_from_float(ibuf);
           // }
 
-          if (!has_rgb && has_luma) {
-            size_t a;
-            if (exr_has_chroma(*file)) {
-              for (a = 0; a < (size_t)ibuf->x * ibuf->y; a++) {
-                float *color = ibuf->rect_float + a * 4;
-                ycc_to_rgb(color[0] * 255.0f,
-                           color[1] * 255.0f,
-                           color[2] * 255.0f,
-                           &color[0],
-                           &color[1],
-                           &color[2],
-                           BLI_YCC_ITU_BT709);
-              }
-            }
-            else {
-              for (a = 0; a < (size_t)ibuf->x * ibuf->y; a++) {
-                float *color = ibuf->rect_float + a * 4;
-                color[1] = color[2] = color[0];
-              }
-            }
-          }
+          exr_rgba_luma_to_rgb(*file, ibuf->rect_float, (size_t)ibuf->x * ibuf->y);
 
           /* file is no longer needed */
           delete membuf;
@@ -2071,6 +2258,179 @@ struct ImBuf *imb_load_openexr(const unsigned char *mem,
   }
 }
 
+/* Read the smallest mipmap level that is still at least max_size, into a float buffer. */
+static ImBuf *exr_thumbnail_from_mipmap(MultiPartInputFile &file, size_t max_size)
+{
+  TiledInputPart in(file, 0);
+  int level = 0;
+
+  while (level + 1 < in.numLevels() &&
+         (size_t)max_ii(in.levelWidth(level + 1), in.levelHeight(level + 1)) >= max_size) {
+    level++;
+  }
+
+  Box2i dw = in.dataWindowForLevel(level);
+  const int width = dw.max.x - dw.min.x + 1;
+  const int height = dw.max.y - dw.min.y + 1;
+  ImBuf *ibuf = IMB_allocImBuf(width, height, 32, IB_rectfloat);
+  FrameBuffer frameBuffer;
+  int xstride = sizeof(float) * 4;
+  int ystride = -xstride * width;
+
+  if (ibuf == NULL) {
+    return NULL;
+  }
+
+  /* Flipped like in imb_load_openexr(). */
+  float *first = ibuf->rect_float - 4 * (dw.min.x - dw.min.y * width);
+  first += 4 * (height - 1) * width;
+
+  exr_rgba_framebuffer_insert(file, frameBuffer, first, xstride, ystride);
+
+  try {
+    in.setFrameBuffer(frameBuffer);
+    in.readTiles(0, in.numXTiles(level) - 1, 0, in.numYTiles(level) - 1, level);
+  }
+  catch (const std::exception &) {
+    IMB_freeImBuf(ibuf);
+    throw;
+  }
+
+  exr_rgba_luma_to_rgb(file, ibuf->rect_float, (size_t)width * height);
+
+  return ibuf;
+}
+
+/* Read only the scanlines and pixels that end up in a thumbnail of max_size, into a float
+ * buffer. Compressed lines are decoded in blocks, nearby lines come from the same block. */
+static ImBuf *exr_thumbnail_from_scanlines(MultiPartInputFile &file, size_t max_size)
+{
+  Box2i dw = file.header(0).dataWindow();
+  const int width = dw.max.x - dw.min.x + 1;
+  const int height = dw.max.y - dw.min.y + 1;
+  const float scale = min_ff(1.0f, (float)max_size / (float)max_ii(width, height));
+  const int thumb_width = max_ii((int)(width * scale), 1);
+  const int thumb_height = max_ii((int)(height * scale), 1);
+  ImBuf *ibuf = IMB_allocImBuf(thumb_width, thumb_height, 32, IB_rectfloat);
+  Imf::Array<float> line(4 * (size_t)width);
+  InputPart in(file, 0);
+  int xstride = sizeof(float) * 4;
+
+  if (ibuf == NULL) {
+    return NULL;
+  }
+
+  try {
+    for (int y = 0; y < thumb_height; y++) {
+      /* Top line of the file goes to the last line of the buffer. */
+      const int src_y = dw.min.y + min_ii((int)(y / scale), height - 1);
+      float *dst = ibuf->rect_float + 4 * (size_t)(thumb_height - 1 - y) * thumb_width;
+      FrameBuffer frameBuffer;
+
+      exr_rgba_framebuffer_insert(file,
+                                  frameBuffer,
+                                  &line[0] - 4 * (dw.min.x + (ptrdiff_t)src_y * width),
+                                  xstride,
+                                  xstride * width);
+      in.setFrameBuffer(frameBuffer);
+      in.readPixels(src_y);
+
+      for (int x = 0; x < thumb_width; x++) {
+        const int src_x = min_ii((int)(x / scale), width - 1);
+        copy_v4_v4(dst + 4 * x, &line[4 * src_x]);
+      }
+    }
+  }
+  catch (const std::exception &) {
+    IMB_freeImBuf(ibuf);
+    throw;
+  }
+
+  exr_rgba_luma_to_rgb(file, ibuf->rect_float, (size_t)thumb_width * thumb_height);
+
+  return ibuf;
+}
+
+struct ImBuf *imb_load_thumbnail_openexr(const unsigned char *mem,
+                                         size_t size,
+                                         int UNUSED(flags),
+                                         size_t max_thumb_size,
+                                         char colorspace[IM_MAX_SPACE],
+                                         size_t *r_width,
+                                         size_t *r_height)
+{
+  struct ImBuf *ibuf = NULL;
+  IMemStream *membuf = NULL;
+  MultiPartInputFile *file = NULL;
+
+  if (imb_is_a_openexr(mem) == 0) {
+    return (NULL);
+  }
+
+  try {
+    membuf = new IMemStream((unsigned char *)mem, size);
+    file = new MultiPartInputFile(*membuf);
+
+    const Header &header = file->header(0);
+    Box2i dw = header.dataWindow();
+
+    *r_width = dw.max.x - dw.min.x + 1;
+    *r_height = dw.max.y - dw.min.y + 1;
+
+    if (header.hasPreviewImage() &&
+        (size_t)max_ii(header.previewImage().width(), header.previewImage().height()) >=
+            max_thumb_size) {
+      /* The preview stored in the file is display referred 8 bit, top line first. */
+      const PreviewImage &preview = header.previewImage();
+      const PreviewRgba *src = preview.pixels();
+
+      colorspace_set_default_role(colorspace, IM_MAX_SPACE, COLOR_ROLE_DEFAULT_BYTE);
+      ibuf = IMB_allocImBuf(preview.width(), preview.height(), 32, IB_rect);
+
+      if (ibuf) {
+        for (int y = ibuf->y - 1; y >= 0; y--) {
+          unsigned char *dst = (unsigned char *)(ibuf->rect + (size_t)y * ibuf->x);
+          for (int x = 0; x < ibuf->x; x++, src++, dst += 4) {
+            dst[0] = src->r;
+            dst[1] = src->g;
+            dst[2] = src->b;
+            dst[3] = src->a;
+          }
+        }
+      }
+    }
+    else {
+      colorspace_set_default_role(colorspace, IM_MAX_SPACE, COLOR_ROLE_DEFAULT_FLOAT);
+
+      if (header.hasTileDescription() && header.tileDescription().mode == MIPMAP_LEVELS) {
+        ibuf = exr_thumbnail_from_mipmap(*file, max_thumb_size);
+      }
+      else {
+        ibuf = exr_thumbnail_from_scanlines(*file, max_thumb_size);
+      }
+    }
+
+    if (ibuf) {
+      ibuf->ftype = IMB_FTYPE_OPENEXR;
+    }
+
+    delete file;
+    delete membuf;
+
+    return (ibuf);
+  }
+  catch (const std::exception &exc) {
+    std::cerr << exc.what() << std::endl;
+    if (ibuf) {
+      IMB_freeImBuf(ibuf);
+    }
+    delete file;
+    delete membuf;
+
+    return (0);
+  }
+}
+
 void imb_initopenexr(void)
 {
   int num_threads = BLI_system_thread_count();
@@ -73,6 +73,17 @@ float *IMB_exr_channel_rect(void *handle,
                             const char *view);
 
 void IMB_exr_read_channels(void *handle);
+/* Allocate and read the passes of a multilayer handle accepted by filter (all passes when NULL),
+ * channels of other passes are not converted and parts without requested channels are not
+ * decoded. Called by IMB_exr_multilayer_convert() when not done before, which skips passes that
+ * were not read. Files loaded without IB_multilayer_deferred have all passes read already. */
+void IMB_exr_read_passes(void *handle,
+                         bool (*filter)(void *userdata,
+                                        const char *layname,
+                                        const char *passname,
+                                        const char *chan_id,
+                                        const char *view),
+                         void *userdata);
 void IMB_exr_write_channels(void *handle);
 void IMB_exrtile_write_channels(
     void *handle, int partx, int party, int level, const char *viewname, bool empty);
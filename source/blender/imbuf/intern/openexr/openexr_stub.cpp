@@ -88,6 +88,15 @@ float *IMB_exr_channel_rect(void * /*handle*/,
 void IMB_exr_read_channels(void * /*handle*/)
 {
 }
+void IMB_exr_read_passes(void * /*handle*/,
+                         bool (*/*filter*/)(void *userdata,
+                                            const char *layname,
+                                            const char *passname,
+                                            const char *chan_id,
+                                            const char *view),
+                         void * /*userdata*/)
+{
+}
 void IMB_exr_write_channels(void * /*handle*/)
 {
 }
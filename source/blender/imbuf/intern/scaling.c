@@ -22,8 +22,9 @@
  * \ingroup imbuf
  */
 
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
-#include "BLI_math_interp.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "MEM_guardedalloc.h"
 
@@ -32,9 +33,14 @@
 #include "imbuf.h"
 
 #include "IMB_filter.h"
+#include "IMB_simd_intern.h"
 
 #include "BLI_sys_types.h"  // for intptr_t support
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static void imb_half_x_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
 {
   uchar *p1, *_p1, *dest;
@@ -906,648 +912,463 @@ static bool q_scale_linear_interpolation(struct ImBuf *ibuf, int newx, int newy)
   return true;
 }
 
-static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
-{
-  const int do_rect = (ibuf->rect != NULL);
-  const int do_float = (ibuf->rect_float != NULL);
-  const size_t rect_size = ibuf->x * ibuf->y * 4;
+/* ******** resampling ******** */
 
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y;
+/* Images are resampled in two separable passes, horizontal and then vertical. For every output
+ * pixel of an axis, the filter weights of the input pixels it covers are computed once in a
+ * table, and the passes only do weighted sums of rows, in parallel. Byte buffers use fixed
+ * point weights, so byte passes can use integer SIMD. */
 
-  rectf = _newrectf = newrectf = NULL;
-  rect = _newrect = newrect = NULL;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+/* Fixed point precision of the weights of byte buffers. */
+#define RESAMPLE_BYTE_PRECISION 14
 
-  if (!do_rect && !do_float) {
-    return (ibuf);
-  }
+typedef struct ResampleWeights {
+  /* First input pixel and number of input pixels of every output pixel. */
+  int *start;
+  int *len;
+  /* Weights of output pixel i start at i * taps. */
+  int taps;
+  float *weights;
+  short *weights_byte;
+} ResampleWeights;
 
-  if (do_rect) {
-    _newrect = MEM_mallocN(newx * ibuf->y * sizeof(uchar) * 4, "scaledownx");
-    if (_newrect == NULL) {
-      return (ibuf);
-    }
-  }
-  if (do_float) {
-    _newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaledownxf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return (ibuf);
-    }
-  }
-
-  add = (ibuf->x - 0.01) / newx;
+static float resample_filter_support(IMB_Resample_Filter filter)
+{
+  switch (filter) {
+    case IMB_RESAMPLE_BOX:
+      return 0.5f;
+    case IMB_RESAMPLE_BILINEAR:
+      return 1.0f;
+    case IMB_RESAMPLE_MITCHELL:
+      return 2.0f;
+    case IMB_RESAMPLE_LANCZOS:
+      return 3.0f;
+  }
+  return 1.0f;
+}
 
-  if (do_rect) {
-    rect = (uchar *)ibuf->rect;
-    newrect = _newrect;
-  }
-  if (do_float) {
-    rectf = ibuf->rect_float;
-    newrectf = _newrectf;
+static float resample_sinc(float x)
+{
+  if (x == 0.0f) {
+    return 1.0f;
   }
+  x *= (float)M_PI;
+  return sinf(x) / x;
+}
 
-  for (y = ibuf->y; y > 0; y--) {
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-    for (x = newx; x > 0; x--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
-      }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
-      }
-
-      sample += add;
-
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += 4;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += 4;
-        }
-      }
-
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += 4;
-
-        newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-        newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-        newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-        newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-
-        newrect += 4;
+static float resample_filter(IMB_Resample_Filter filter, float x)
+{
+  x = fabsf(x);
+
+  switch (filter) {
+    case IMB_RESAMPLE_BOX:
+      return (x < 0.5f) ? 1.0f : 0.0f;
+    case IMB_RESAMPLE_BILINEAR:
+      return (x < 1.0f) ? 1.0f - x : 0.0f;
+    case IMB_RESAMPLE_MITCHELL: {
+      /* Mitchell-Netravali with B = C = 1/3. */
+      const float b = 1.0f / 3.0f, c = 1.0f / 3.0f;
+      if (x < 1.0f) {
+        return ((12.0f - 9.0f * b - 6.0f * c) * x * x * x +
+                (-18.0f + 12.0f * b + 6.0f * c) * x * x + (6.0f - 2.0f * b)) /
+               6.0f;
       }
-      if (do_float) {
-
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += 4;
-
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-
-        newrectf += 4;
+      if (x < 2.0f) {
+        return ((-b - 6.0f * c) * x * x * x + (6.0f * b + 30.0f * c) * x * x +
+                (-12.0f * b - 48.0f * c) * x + (8.0f * b + 24.0f * c)) /
+               6.0f;
       }
-
-      sample -= 1.0f;
+      return 0.0f;
     }
+    case IMB_RESAMPLE_LANCZOS:
+      return (x < 3.0f) ? resample_sinc(x) * resample_sinc(x / 3.0f) : 0.0f;
   }
-
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-    BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-    BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = _newrectf;
-  }
-  (void)rect_size; /* UNUSED in release builds */
-
-  ibuf->x = newx;
-  return (ibuf);
+  return 0.0f;
 }
 
-static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+static void resample_weights_init(ResampleWeights *table,
+                                  int in_size,
+                                  int out_size,
+                                  IMB_Resample_Filter filter)
 {
-  const int do_rect = (ibuf->rect != NULL);
-  const int do_float = (ibuf->rect_float != NULL);
-  const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y, skipx;
-
-  rectf = _newrectf = newrectf = NULL;
-  rect = _newrect = newrect = NULL;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
-
-  if (!do_rect && !do_float) {
-    return (ibuf);
-  }
-
-  if (do_rect) {
-    _newrect = MEM_mallocN(newy * ibuf->x * sizeof(uchar) * 4, "scaledowny");
-    if (_newrect == NULL) {
-      return (ibuf);
-    }
-  }
-  if (do_float) {
-    _newrectf = MEM_mallocN(newy * ibuf->x * sizeof(float) * 4, "scaledownyf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
+  const float scale = (float)in_size / out_size;
+  /* Filters are widened when downscaling, so all input pixels contribute. */
+  const float filter_scale = max_ff(scale, 1.0f);
+  const float support = resample_filter_support(filter) * filter_scale;
+
+  table->taps = (int)ceilf(support) * 2 + 1;
+  table->start = MEM_mallocN(sizeof(int) * out_size, __func__);
+  table->len = MEM_mallocN(sizeof(int) * out_size, __func__);
+  table->weights = MEM_callocN(sizeof(float) * out_size * table->taps, __func__);
+  table->weights_byte = MEM_callocN(sizeof(short) * out_size * table->taps, __func__);
+
+  for (int i = 0; i < out_size; i++) {
+    const float center = (i + 0.5f) * scale;
+    int start = max_ii(0, (int)floorf(center - support));
+    int end = min_ii(in_size, (int)ceilf(center + support));
+    float *weights = table->weights + i * table->taps;
+    float sum = 0.0f;
+
+    end = min_ii(end, start + table->taps);
+
+    for (int k = start; k < end; k++) {
+      float weight;
+      if (filter == IMB_RESAMPLE_BOX) {
+        /* Exact area of the pixel covered by the box, averages the covered pixels when
+         * downscaling and interpolates linearly when upscaling. */
+        const float lo = center - 0.5f * filter_scale, hi = center + 0.5f * filter_scale;
+        weight = max_ff(0.0f, min_ff(k + 1.0f, hi) - max_ff((float)k, lo));
+      }
+      else {
+        weight = resample_filter(filter, (k + 0.5f - center) / filter_scale);
       }
-      return (ibuf);
+      weights[k - start] = weight;
+      sum += weight;
     }
-  }
-
-  add = (ibuf->y - 0.01) / newy;
-  skipx = 4 * ibuf->x;
 
-  for (x = skipx - 4; x >= 0; x -= 4) {
-    if (do_rect) {
-      rect = ((uchar *)ibuf->rect) + x;
-      newrect = _newrect + x;
+    /* Skip pixels which don't contribute. */
+    while (end > start + 1 && weights[end - start - 1] == 0.0f) {
+      end--;
     }
-    if (do_float) {
-      rectf = ibuf->rect_float + x;
-      newrectf = _newrectf + x;
+    while (end > start + 1 && weights[0] == 0.0f) {
+      memmove(weights, weights + 1, sizeof(float) * (end - start - 1));
+      weights[end - start - 1] = 0.0f;
+      start++;
     }
 
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-    for (y = newy; y > 0; y--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
-      }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
+    short *weights_byte = table->weights_byte + i * table->taps;
+    for (int k = 0; k < end - start; k++) {
+      if (sum != 0.0f) {
+        weights[k] /= sum;
       }
+      weights_byte[k] = (short)roundf(weights[k] * (1 << RESAMPLE_BYTE_PRECISION));
+    }
 
-      sample += add;
-
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += skipx;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += skipx;
-        }
-      }
+    table->start[i] = start;
+    table->len[i] = end - start;
+  }
+}
 
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += skipx;
-
-        newrect[0] = ((nval[0] + sample * val[0]) / add + 0.5f);
-        newrect[1] = ((nval[1] + sample * val[1]) / add + 0.5f);
-        newrect[2] = ((nval[2] + sample * val[2]) / add + 0.5f);
-        newrect[3] = ((nval[3] + sample * val[3]) / add + 0.5f);
-
-        newrect += skipx;
-      }
-      if (do_float) {
+static void resample_weights_free(ResampleWeights *table)
+{
+  MEM_freeN(table->start);
+  MEM_freeN(table->len);
+  MEM_freeN(table->weights);
+  MEM_freeN(table->weights_byte);
+}
 
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += skipx;
+/* Two weights in the 16 bit lanes of a 32 bit integer, for multiplying and adding pairs. */
+BLI_INLINE int resample_weight_pair(short a, short b)
+{
+  return (int)((unsigned int)(unsigned short)a | ((unsigned int)(unsigned short)b << 16));
+}
 
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
+BLI_INLINE unsigned char resample_byte_round(int value)
+{
+  value = (value + (1 << (RESAMPLE_BYTE_PRECISION - 1))) >> RESAMPLE_BYTE_PRECISION;
+  return (unsigned char)clamp_i(value, 0, 255);
+}
 
-        newrectf += skipx;
+typedef struct ResampleData {
+  const ResampleWeights *table;
+  /* Size of the output of the pass. */
+  int width;
+  int channels;
+  /* Input row length in pixels. */
+  int in_width;
+
+  const unsigned char *in_byte;
+  unsigned char *out_byte;
+  const float *in_float;
+  float *out_float;
+
+  bool use_simd;
+} ResampleData;
+
+static void resample_horizontal_byte(void *__restrict userdata,
+                                     const int y,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ResampleData *data = userdata;
+  const ResampleWeights *table = data->table;
+  const unsigned char *in = data->in_byte + (size_t)y * data->in_width * 4;
+  unsigned char *out = data->out_byte + (size_t)y * data->width * 4;
+
+  for (int x = 0; x < data->width; x++, out += 4) {
+    const unsigned char *src = in + table->start[x] * 4;
+    const short *weights = table->weights_byte + x * table->taps;
+    const int len = table->len[x];
+    int k = 0;
+
+#ifdef __SSE2__
+    if (data->use_simd) {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i sum = _mm_set1_epi32(1 << (RESAMPLE_BYTE_PRECISION - 1));
+      /* Two pixels per step, interleaved so channels of both are multiplied and added at once. */
+      for (; k + 1 < len; k += 2) {
+        __m128i pix = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int *)(src + k * 4)),
+                                        _mm_cvtsi32_si128(*(const int *)(src + k * 4 + 4)));
+        pix = _mm_unpacklo_epi8(pix, zero);
+        const __m128i weight = _mm_set1_epi32(resample_weight_pair(weights[k], weights[k + 1]));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(pix, weight));
       }
-
-      sample -= 1.0f;
+      if (k < len) {
+        __m128i pix = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int *)(src + k * 4)), zero);
+        pix = _mm_unpacklo_epi8(pix, zero);
+        const __m128i weight = _mm_set1_epi32(resample_weight_pair(weights[k], 0));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(pix, weight));
+      }
+      sum = _mm_srai_epi32(sum, RESAMPLE_BYTE_PRECISION);
+      sum = _mm_packs_epi32(sum, sum);
+      sum = _mm_packus_epi16(sum, sum);
+      *(int *)out = _mm_cvtsi128_si32(sum);
+      continue;
     }
+#endif
+
+    int sum[4] = {0, 0, 0, 0};
+    for (; k < len; k++) {
+      sum[0] += src[k * 4 + 0] * weights[k];
+      sum[1] += src[k * 4 + 1] * weights[k];
+      sum[2] += src[k * 4 + 2] * weights[k];
+      sum[3] += src[k * 4 + 3] * weights[k];
+    }
+    out[0] = resample_byte_round(sum[0]);
+    out[1] = resample_byte_round(sum[1]);
+    out[2] = resample_byte_round(sum[2]);
+    out[3] = resample_byte_round(sum[3]);
   }
-
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-    BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug [#26502] */
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-    BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug [#26502] */
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
-  }
-  (void)rect_size; /* UNUSED in release builds */
-
-  ibuf->y = newy;
-  return (ibuf);
 }
 
-static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+static void resample_vertical_byte(void *__restrict userdata,
+                                   const int y,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  uchar *rect, *_newrect = NULL, *newrect;
-  float *rectf, *_newrectf = NULL, *newrectf;
-  float sample, add;
-  float val_a, nval_a, diff_a;
-  float val_b, nval_b, diff_b;
-  float val_g, nval_g, diff_g;
-  float val_r, nval_r, diff_r;
-  float val_af, nval_af, diff_af;
-  float val_bf, nval_bf, diff_bf;
-  float val_gf, nval_gf, diff_gf;
-  float val_rf, nval_rf, diff_rf;
-  int x, y;
-  bool do_rect = false, do_float = false;
+  const ResampleData *data = userdata;
+  const ResampleWeights *table = data->table;
+  const size_t row_len = (size_t)data->width * 4;
+  const unsigned char *in = data->in_byte + table->start[y] * row_len;
+  unsigned char *out = data->out_byte + y * row_len;
+  const short *weights = table->weights_byte + y * table->taps;
+  const int len = table->len[y];
+  size_t i = 0;
+
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  /* 16 channels per step, rows are interleaved so two rows are multiplied and added at once. */
+  for (; data->use_simd && i + 16 <= row_len; i += 16) {
+    __m128i sum[4];
+    sum[0] = sum[1] = sum[2] = sum[3] = _mm_set1_epi32(1 << (RESAMPLE_BYTE_PRECISION - 1));
+
+    for (int k = 0; k < len; k += 2) {
+      const __m128i row_a = _mm_loadu_si128((const __m128i *)(in + k * row_len + i));
+      const __m128i row_b = (k + 1 < len) ?
+                                _mm_loadu_si128((const __m128i *)(in + (k + 1) * row_len + i)) :
+                                zero;
+      const __m128i weight = _mm_set1_epi32(
+          resample_weight_pair(weights[k], (k + 1 < len) ? weights[k + 1] : 0));
+      const __m128i lo = _mm_unpacklo_epi8(row_a, row_b);
+      const __m128i hi = _mm_unpackhi_epi8(row_a, row_b);
+      sum[0] = _mm_add_epi32(sum[0], _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weight));
+      sum[1] = _mm_add_epi32(sum[1], _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weight));
+      sum[2] = _mm_add_epi32(sum[2], _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weight));
+      sum[3] = _mm_add_epi32(sum[3], _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weight));
+    }
 
-  val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-  val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-  val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-  val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-  if (ibuf == NULL) {
-    return (NULL);
-  }
-  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
-    return (ibuf);
+    const __m128i result_lo = _mm_packs_epi32(_mm_srai_epi32(sum[0], RESAMPLE_BYTE_PRECISION),
+                                              _mm_srai_epi32(sum[1], RESAMPLE_BYTE_PRECISION));
+    const __m128i result_hi = _mm_packs_epi32(_mm_srai_epi32(sum[2], RESAMPLE_BYTE_PRECISION),
+                                              _mm_srai_epi32(sum[3], RESAMPLE_BYTE_PRECISION));
+    _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(result_lo, result_hi));
   }
+#endif
 
-  if (ibuf->rect) {
-    do_rect = true;
-    _newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
-    if (_newrect == NULL) {
-      return (ibuf);
-    }
-  }
-  if (ibuf->rect_float) {
-    do_float = true;
-    _newrectf = MEM_mallocN(newx * ibuf->y * sizeof(float) * 4, "scaleupxf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return (ibuf);
+  for (; i < row_len; i++) {
+    int sum = 0;
+    for (int k = 0; k < len; k++) {
+      sum += in[k * row_len + i] * weights[k];
     }
+    out[i] = resample_byte_round(sum);
   }
+}
 
-  add = (ibuf->x - 1.001) / (newx - 1.0);
-
-  rect = (uchar *)ibuf->rect;
-  rectf = (float *)ibuf->rect_float;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  for (y = ibuf->y; y > 0; y--) {
-
-    sample = 0;
-
-    if (do_rect) {
-      val_a = rect[0];
-      nval_a = rect[4];
-      diff_a = nval_a - val_a;
-      val_a += 0.5f;
-
-      val_b = rect[1];
-      nval_b = rect[5];
-      diff_b = nval_b - val_b;
-      val_b += 0.5f;
-
-      val_g = rect[2];
-      nval_g = rect[6];
-      diff_g = nval_g - val_g;
-      val_g += 0.5f;
-
-      val_r = rect[3];
-      nval_r = rect[7];
-      diff_r = nval_r - val_r;
-      val_r += 0.5f;
-
-      rect += 8;
+static void resample_horizontal_float(void *__restrict userdata,
+                                      const int y,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ResampleData *data = userdata;
+  const ResampleWeights *table = data->table;
+  const int channels = data->channels;
+  const float *in = data->in_float + (size_t)y * data->in_width * channels;
+  float *out = data->out_float + (size_t)y * data->width * channels;
+
+  for (int x = 0; x < data->width; x++, out += channels) {
+    const float *src = in + table->start[x] * channels;
+    const float *weights = table->weights + x * table->taps;
+    const int len = table->len[x];
+
+#ifdef __SSE2__
+    if (data->use_simd && channels == 4) {
+      __m128 sum = _mm_setzero_ps();
+      for (int k = 0; k < len; k++) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + k * 4), _mm_set1_ps(weights[k])));
+      }
+      _mm_storeu_ps(out, sum);
+      continue;
     }
-    if (do_float) {
-      val_af = rectf[0];
-      nval_af = rectf[4];
-      diff_af = nval_af - val_af;
-
-      val_bf = rectf[1];
-      nval_bf = rectf[5];
-      diff_bf = nval_bf - val_bf;
-
-      val_gf = rectf[2];
-      nval_gf = rectf[6];
-      diff_gf = nval_gf - val_gf;
+#endif
 
-      val_rf = rectf[3];
-      nval_rf = rectf[7];
-      diff_rf = nval_rf - val_rf;
-
-      rectf += 8;
-    }
-    for (x = newx; x > 0; x--) {
-      if (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          val_a = nval_a;
-          nval_a = rect[0];
-          diff_a = nval_a - val_a;
-          val_a += 0.5f;
-
-          val_b = nval_b;
-          nval_b = rect[1];
-          diff_b = nval_b - val_b;
-          val_b += 0.5f;
-
-          val_g = nval_g;
-          nval_g = rect[2];
-          diff_g = nval_g - val_g;
-          val_g += 0.5f;
-
-          val_r = nval_r;
-          nval_r = rect[3];
-          diff_r = nval_r - val_r;
-          val_r += 0.5f;
-          rect += 4;
-        }
-        if (do_float) {
-          val_af = nval_af;
-          nval_af = rectf[0];
-          diff_af = nval_af - val_af;
-
-          val_bf = nval_bf;
-          nval_bf = rectf[1];
-          diff_bf = nval_bf - val_bf;
-
-          val_gf = nval_gf;
-          nval_gf = rectf[2];
-          diff_gf = nval_gf - val_gf;
-
-          val_rf = nval_rf;
-          nval_rf = rectf[3];
-          diff_rf = nval_rf - val_rf;
-          rectf += 4;
-        }
+    for (int c = 0; c < channels; c++) {
+      float sum = 0.0f;
+      for (int k = 0; k < len; k++) {
+        sum += src[k * channels + c] * weights[k];
       }
-      if (do_rect) {
-        newrect[0] = val_a + sample * diff_a;
-        newrect[1] = val_b + sample * diff_b;
-        newrect[2] = val_g + sample * diff_g;
-        newrect[3] = val_r + sample * diff_r;
-        newrect += 4;
-      }
-      if (do_float) {
-        newrectf[0] = val_af + sample * diff_af;
-        newrectf[1] = val_bf + sample * diff_bf;
-        newrectf[2] = val_gf + sample * diff_gf;
-        newrectf[3] = val_rf + sample * diff_rf;
-        newrectf += 4;
-      }
-      sample += add;
+      out[c] = sum;
     }
   }
+}
 
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
+static void resample_vertical_float(void *__restrict userdata,
+                                    const int y,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ResampleData *data = userdata;
+  const ResampleWeights *table = data->table;
+  const size_t row_len = (size_t)data->width * data->channels;
+  const float *in = data->in_float + table->start[y] * row_len;
+  float *out = data->out_float + y * row_len;
+  const float *weights = table->weights + y * table->taps;
+  const int len = table->len[y];
+  size_t i = 0;
+
+#ifdef __SSE2__
+  for (; data->use_simd && i + 4 <= row_len; i += 4) {
+    __m128 sum = _mm_setzero_ps();
+    for (int k = 0; k < len; k++) {
+      sum = _mm_add_ps(sum,
+                       _mm_mul_ps(_mm_loadu_ps(in + k * row_len + i), _mm_set1_ps(weights[k])));
+    }
+    _mm_storeu_ps(out + i, sum);
   }
+#endif
 
-  ibuf->x = newx;
-  return (ibuf);
+  for (; i < row_len; i++) {
+    float sum = 0.0f;
+    for (int k = 0; k < len; k++) {
+      sum += in[k * row_len + i] * weights[k];
+    }
+    out[i] = sum;
+  }
 }
 
-static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
+/* Resample rows of x pixels to newx pixels, or columns of y pixels to newy pixels. */
+static void resample_pass(const void *in,
+                          void *out,
+                          bool is_float,
+                          int channels,
+                          int x,
+                          int y,
+                          int newx,
+                          int newy,
+                          IMB_Resample_Filter filter,
+                          bool use_simd)
 {
-  uchar *rect, *_newrect = NULL, *newrect;
-  float *rectf, *_newrectf = NULL, *newrectf;
-  float sample, add;
-  float val_a, nval_a, diff_a;
-  float val_b, nval_b, diff_b;
-  float val_g, nval_g, diff_g;
-  float val_r, nval_r, diff_r;
-  float val_af, nval_af, diff_af;
-  float val_bf, nval_bf, diff_bf;
-  float val_gf, nval_gf, diff_gf;
-  float val_rf, nval_rf, diff_rf;
-  int x, y, skipx;
-  bool do_rect = false, do_float = false;
-
-  val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-  val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-  val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-  val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-  if (ibuf == NULL) {
-    return (NULL);
+  const bool is_horizontal = (x != newx);
+  ResampleWeights table;
+  ResampleData data = {NULL};
+
+  BLI_assert(is_horizontal ? (y == newy) : (x == newx));
+  resample_weights_init(&table, is_horizontal ? x : y, is_horizontal ? newx : newy, filter);
+
+  data.table = &table;
+  data.width = newx;
+  data.channels = channels;
+  data.in_width = x;
+  data.use_simd = use_simd;
+  if (is_float) {
+    data.in_float = in;
+    data.out_float = out;
   }
-  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
-    return (ibuf);
+  else {
+    data.in_byte = in;
+    data.out_byte = out;
   }
 
-  if (ibuf->rect) {
-    do_rect = true;
-    _newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
-    if (_newrect == NULL) {
-      return (ibuf);
-    }
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = ((size_t)newx * newy > 64 * 64);
+  settings.min_iter_per_thread = 8;
+
+  if (is_horizontal) {
+    BLI_task_parallel_range(
+        0, newy, &data, is_float ? resample_horizontal_float : resample_horizontal_byte, &settings);
   }
-  if (ibuf->rect_float) {
-    do_float = true;
-    _newrectf = MEM_mallocN(ibuf->x * newy * sizeof(float) * 4, "scaleupyf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return (ibuf);
-    }
+  else {
+    BLI_task_parallel_range(
+        0, newy, &data, is_float ? resample_vertical_float : resample_vertical_byte, &settings);
   }
 
-  add = (ibuf->y - 1.001) / (newy - 1.0);
-  skipx = 4 * ibuf->x;
-
-  rect = (uchar *)ibuf->rect;
-  rectf = (float *)ibuf->rect_float;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  for (x = ibuf->x; x > 0; x--) {
-
-    sample = 0;
-    if (do_rect) {
-      rect = ((uchar *)ibuf->rect) + 4 * (x - 1);
-      newrect = _newrect + 4 * (x - 1);
-
-      val_a = rect[0];
-      nval_a = rect[skipx];
-      diff_a = nval_a - val_a;
-      val_a += 0.5f;
-
-      val_b = rect[1];
-      nval_b = rect[skipx + 1];
-      diff_b = nval_b - val_b;
-      val_b += 0.5f;
-
-      val_g = rect[2];
-      nval_g = rect[skipx + 2];
-      diff_g = nval_g - val_g;
-      val_g += 0.5f;
-
-      val_r = rect[3];
-      nval_r = rect[skipx + 3];
-      diff_r = nval_r - val_r;
-      val_r += 0.5f;
-
-      rect += 2 * skipx;
-    }
-    if (do_float) {
-      rectf = ibuf->rect_float + 4 * (x - 1);
-      newrectf = _newrectf + 4 * (x - 1);
-
-      val_af = rectf[0];
-      nval_af = rectf[skipx];
-      diff_af = nval_af - val_af;
-
-      val_bf = rectf[1];
-      nval_bf = rectf[skipx + 1];
-      diff_bf = nval_bf - val_bf;
+  resample_weights_free(&table);
+}
 
-      val_gf = rectf[2];
-      nval_gf = rectf[skipx + 2];
-      diff_gf = nval_gf - val_gf;
+void *imb_resample_buffer(const void *in,
+                          bool is_float,
+                          int channels,
+                          int x,
+                          int y,
+                          int newx,
+                          int newy,
+                          IMB_Resample_Filter filter,
+                          bool use_simd)
+{
+  const size_t pixel_size = is_float ? sizeof(float) * channels : sizeof(unsigned char) * 4;
+  void *out = NULL;
 
-      val_rf = rectf[3];
-      nval_rf = rectf[skipx + 3];
-      diff_rf = nval_rf - val_rf;
+  if (newx != x) {
+    out = MEM_mallocN(pixel_size * newx * y, "resample horizontal");
+    resample_pass(in, out, is_float, channels, x, y, newx, y, filter, use_simd);
+  }
+  if (newy != y) {
+    void *out_vertical = MEM_mallocN(pixel_size * newx * newy, "resample vertical");
+    resample_pass(
+        out ? out : in, out_vertical, is_float, channels, newx, y, newx, newy, filter, use_simd);
+    MEM_SAFE_FREE(out);
+    out = out_vertical;
+  }
 
-      rectf += 2 * skipx;
-    }
+  return out;
+}
 
-    for (y = newy; y > 0; y--) {
-      if (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          val_a = nval_a;
-          nval_a = rect[0];
-          diff_a = nval_a - val_a;
-          val_a += 0.5f;
-
-          val_b = nval_b;
-          nval_b = rect[1];
-          diff_b = nval_b - val_b;
-          val_b += 0.5f;
-
-          val_g = nval_g;
-          nval_g = rect[2];
-          diff_g = nval_g - val_g;
-          val_g += 0.5f;
-
-          val_r = nval_r;
-          nval_r = rect[3];
-          diff_r = nval_r - val_r;
-          val_r += 0.5f;
-          rect += skipx;
-        }
-        if (do_float) {
-          val_af = nval_af;
-          nval_af = rectf[0];
-          diff_af = nval_af - val_af;
-
-          val_bf = nval_bf;
-          nval_bf = rectf[1];
-          diff_bf = nval_bf - val_bf;
-
-          val_gf = nval_gf;
-          nval_gf = rectf[2];
-          diff_gf = nval_gf - val_gf;
-
-          val_rf = nval_rf;
-          nval_rf = rectf[3];
-          diff_rf = nval_rf - val_rf;
-          rectf += skipx;
-        }
-      }
-      if (do_rect) {
-        newrect[0] = val_a + sample * diff_a;
-        newrect[1] = val_b + sample * diff_b;
-        newrect[2] = val_g + sample * diff_g;
-        newrect[3] = val_r + sample * diff_r;
-        newrect += skipx;
-      }
-      if (do_float) {
-        newrectf[0] = val_af + sample * diff_af;
-        newrectf[1] = val_bf + sample * diff_bf;
-        newrectf[2] = val_gf + sample * diff_gf;
-        newrectf[3] = val_rf + sample * diff_rf;
-        newrectf += skipx;
-      }
-      sample += add;
-    }
+static void imb_resample_rect(struct ImBuf *ibuf,
+                              unsigned int newx,
+                              unsigned int newy,
+                              IMB_Resample_Filter filter)
+{
+  if (newx == ibuf->x && newy == ibuf->y) {
+    return;
   }
 
-  if (do_rect) {
+  if (ibuf->rect) {
+    unsigned int *rect = imb_resample_buffer(
+        ibuf->rect, false, 4, ibuf->x, ibuf->y, newx, newy, filter, true);
     imb_freerectImBuf(ibuf);
     ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
+    ibuf->rect = rect;
   }
-  if (do_float) {
+  if (ibuf->rect_float) {
+    float *rect_float = imb_resample_buffer(
+        ibuf->rect_float, true, ibuf->channels, ibuf->x, ibuf->y, newx, newy, filter, true);
     imb_freerectfloatImBuf(ibuf);
     ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
+    ibuf->rect_float = rect_float;
   }
 
+  ibuf->x = newx;
   ibuf->y = newy;
-  return (ibuf);
 }
 
+#undef RESAMPLE_BYTE_PRECISION
+
 static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
 {
   int *zbuf, *newzbuf, *_newzbuf = NULL;
@@ -1639,19 +1460,36 @@ bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
     return true;
   }
 
-  if (newx && (newx < ibuf->x)) {
-    scaledownx(ibuf, newx);
+  /* Box filter averages pixels when scaling down and interpolates linearly when scaling up. */
+  imb_resample_rect(ibuf, newx ? newx : ibuf->x, newy ? newy : ibuf->y, IMB_RESAMPLE_BOX);
+
+  return true;
+}
+
+/**
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_resampleImBuf(struct ImBuf *ibuf,
+                       unsigned int newx,
+                       unsigned int newy,
+                       IMB_Resample_Filter filter)
+{
+  if (ibuf == NULL) {
+    return false;
   }
-  if (newy && (newy < ibuf->y)) {
-    scaledowny(ibuf, newy);
+  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
+    return false;
   }
-  if (newx && (newx > ibuf->x)) {
-    scaleupx(ibuf, newx);
+  if (newx == 0 || newy == 0) {
+    return false;
   }
-  if (newy && (newy > ibuf->y)) {
-    scaleupy(ibuf, newy);
+  if (newx == ibuf->x && newy == ibuf->y) {
+    return false;
   }
 
+  scalefast_Z_ImBuf(ibuf, newx, newy);
+  imb_resample_rect(ibuf, newx, newy, filter);
+
   return true;
 }
 
@@ -1758,119 +1596,8 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
   return true;
 }
 
-/* ******** threaded scaling ******** */
-
-typedef struct ScaleTreadInitData {
-  ImBuf *ibuf;
-
-  unsigned int newx;
-  unsigned int newy;
-
-  unsigned char *byte_buffer;
-  float *float_buffer;
-} ScaleTreadInitData;
-
-typedef struct ScaleThreadData {
-  ImBuf *ibuf;
-
-  unsigned int newx;
-  unsigned int newy;
-
-  int start_line;
-  int tot_line;
-
-  unsigned char *byte_buffer;
-  float *float_buffer;
-} ScaleThreadData;
-
-static void scale_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
-{
-  ScaleThreadData *data = (ScaleThreadData *)data_v;
-  ScaleTreadInitData *init_data = (ScaleTreadInitData *)init_data_v;
-
-  data->ibuf = init_data->ibuf;
-
-  data->newx = init_data->newx;
-  data->newy = init_data->newy;
-
-  data->start_line = start_line;
-  data->tot_line = tot_line;
-
-  data->byte_buffer = init_data->byte_buffer;
-  data->float_buffer = init_data->float_buffer;
-}
-
-static void *do_scale_thread(void *data_v)
-{
-  ScaleThreadData *data = (ScaleThreadData *)data_v;
-  ImBuf *ibuf = data->ibuf;
-  int i;
-  float factor_x = (float)ibuf->x / data->newx;
-  float factor_y = (float)ibuf->y / data->newy;
-
-  for (i = 0; i < data->tot_line; i++) {
-    int y = data->start_line + i;
-    int x;
-
-    for (x = 0; x < data->newx; x++) {
-      float u = (float)x * factor_x;
-      float v = (float)y * factor_y;
-      int offset = y * data->newx + x;
-
-      if (data->byte_buffer) {
-        unsigned char *pixel = data->byte_buffer + 4 * offset;
-        BLI_bilinear_interpolation_char(
-            (unsigned char *)ibuf->rect, pixel, ibuf->x, ibuf->y, 4, u, v);
-      }
-
-      if (data->float_buffer) {
-        float *pixel = data->float_buffer + ibuf->channels * offset;
-        BLI_bilinear_interpolation_fl(
-            ibuf->rect_float, pixel, ibuf->x, ibuf->y, ibuf->channels, u, v);
-      }
-    }
-  }
-
-  return NULL;
-}
-
 void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
-  ScaleTreadInitData init_data = {NULL};
-
-  /* prepare initialization data */
-  init_data.ibuf = ibuf;
-
-  init_data.newx = newx;
-  init_data.newy = newy;
-
-  if (ibuf->rect) {
-    init_data.byte_buffer = MEM_mallocN(4 * newx * newy * sizeof(char),
-                                        "threaded scale byte buffer");
-  }
-
-  if (ibuf->rect_float) {
-    init_data.float_buffer = MEM_mallocN(ibuf->channels * newx * newy * sizeof(float),
-                                         "threaded scale float buffer");
-  }
-
-  /* actual scaling threads */
-  IMB_processor_apply_threaded(
-      newy, sizeof(ScaleThreadData), &init_data, scale_thread_init, do_scale_thread);
-
-  /* alter image buffer */
-  ibuf->x = newx;
-  ibuf->y = newy;
-
-  if (ibuf->rect) {
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)init_data.byte_buffer;
-  }
-
-  if (ibuf->rect_float) {
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = init_data.float_buffer;
-  }
+  /* Resampling is threaded already. */
+  IMB_resampleImBuf(ibuf, newx, newy, IMB_RESAMPLE_BILINEAR);
 }
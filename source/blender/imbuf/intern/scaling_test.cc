@@ -0,0 +1,117 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf.h"
+
+#include "IMB_simd_intern.h"
+}
+
+namespace blender::imbuf::tests {
+
+/* Odd sizes, so the vector loops leave pixels to the scalar code. */
+static const int WIDTH = 37;
+static const int HEIGHT = 23;
+
+static const IMB_Resample_Filter FILTERS[] = {
+    IMB_RESAMPLE_BOX,
+    IMB_RESAMPLE_BILINEAR,
+    IMB_RESAMPLE_MITCHELL,
+    IMB_RESAMPLE_LANCZOS,
+};
+
+/* Target sizes, scaling down and up in one or both directions. */
+static const int SIZES[][2] = {
+    {WIDTH / 3, HEIGHT},
+    {WIDTH, HEIGHT / 2},
+    {WIDTH / 2, HEIGHT / 3},
+    {WIDTH * 2 + 1, HEIGHT},
+    {WIDTH, HEIGHT * 3},
+    {WIDTH * 3, HEIGHT / 2},
+    {1, 1},
+};
+
+TEST(imbuf_scaling, ResampleByte)
+{
+  RNG *rng = BLI_rng_new(0);
+  std::vector<unsigned char> in(WIDTH * HEIGHT * 4);
+  for (size_t i = 0; i < in.size(); i++) {
+    in[i] = (unsigned char)BLI_rng_get_uint(rng);
+  }
+
+  for (IMB_Resample_Filter filter : FILTERS) {
+    for (const int *size : SIZES) {
+      unsigned char *out_scalar = (unsigned char *)imb_resample_buffer(
+          &in[0], false, 4, WIDTH, HEIGHT, size[0], size[1], filter, false);
+      unsigned char *out_simd = (unsigned char *)imb_resample_buffer(
+          &in[0], false, 4, WIDTH, HEIGHT, size[0], size[1], filter, true);
+
+      for (int i = 0; i < size[0] * size[1] * 4; i++) {
+        EXPECT_EQ(out_scalar[i], out_simd[i])
+            << "filter " << filter << ", size " << size[0] << "x" << size[1] << ", index " << i;
+      }
+
+      MEM_freeN(out_scalar);
+      MEM_freeN(out_simd);
+    }
+  }
+
+  BLI_rng_free(rng);
+}
+
+TEST(imbuf_scaling, ResampleFloat)
+{
+  RNG *rng = BLI_rng_new(0);
+
+  for (int channels : {1, 3, 4}) {
+    std::vector<float> in(WIDTH * HEIGHT * channels);
+    for (size_t i = 0; i < in.size(); i++) {
+      in[i] = BLI_rng_get_float(rng) * 1.2f - 0.1f;
+    }
+
+    for (IMB_Resample_Filter filter : FILTERS) {
+      for (const int *size : SIZES) {
+        float *out_scalar = (float *)imb_resample_buffer(
+            &in[0], true, channels, WIDTH, HEIGHT, size[0], size[1], filter, false);
+        float *out_simd = (float *)imb_resample_buffer(
+            &in[0], true, channels, WIDTH, HEIGHT, size[0], size[1], filter, true);
+
+        for (int i = 0; i < size[0] * size[1] * channels; i++) {
+          EXPECT_FLOAT_EQ(out_scalar[i], out_simd[i])
+              << "channels " << channels << ", filter " << filter << ", size " << size[0] << "x"
+              << size[1] << ", index " << i;
+        }
+
+        MEM_freeN(out_scalar);
+        MEM_freeN(out_simd);
+      }
+    }
+  }
+
+  BLI_rng_free(rng);
+}
+
+}  // namespace blender::imbuf::tests
@@ -337,6 +337,7 @@ static ImBuf *thumb_create_ex(const char *file_path,
   char mtime[40] = "0";  /* in case we can't stat the file */
   char cwidth[40] = "0"; /* in case images have no data */
   char cheight[40] = "0";
+  size_t image_width = 0, image_height = 0;
   short tsize = 128;
   short ex, ey;
   float scaledx, scaledy;
@@ -384,7 +385,7 @@ static ImBuf *thumb_create_ex(const char *file_path,
         if (img == NULL) {
           switch (source) {
             case THB_SOURCE_IMAGE:
-              img = IMB_loadiffname(file_path, IB_rect | IB_metadata, NULL);
+              img = IMB_thumb_load_image(file_path, tsize, NULL, &image_width, &image_height);
               break;
             case THB_SOURCE_BLEND:
               img = IMB_thumb_load_blend(file_path, blen_group, blen_id);
@@ -401,8 +402,15 @@ static ImBuf *thumb_create_ex(const char *file_path,
           if (BLI_stat(file_path, &info) != -1) {
             BLI_snprintf(mtime, sizeof(mtime), "%ld", (long int)info.st_mtime);
           }
-          BLI_snprintf(cwidth, sizeof(cwidth), "%d", img->x);
-          BLI_snprintf(cheight, sizeof(cheight), "%d", img->y);
+          if (source == THB_SOURCE_IMAGE && image_width != 0) {
+            /* The image may have been loaded at a reduced size. */
+            BLI_snprintf(cwidth, sizeof(cwidth), "%zu", image_width);
+            BLI_snprintf(cheight, sizeof(cheight), "%zu", image_height);
+          }
+          else {
+            BLI_snprintf(cwidth, sizeof(cwidth), "%d", img->x);
+            BLI_snprintf(cheight, sizeof(cheight), "%d", img->y);
+          }
         }
       }
       else if (THB_SOURCE_MOVIE == source) {
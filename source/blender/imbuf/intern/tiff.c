@@ -625,7 +625,8 @@ ImBuf *imb_loadtiff(const unsigned char *mem,
     TIFFGetField(image, TIFFTAG_PIXAR_TEXTUREFORMAT, &format);
 
     if (format && STREQ(format, "Plain Texture") && TIFFIsTiled(image)) {
-      int numlevel = TIFFNumberOfDirectories(image);
+      /* Level buffers beyond the first are stored in the mipmap array. */
+      int numlevel = min_ii(TIFFNumberOfDirectories(image), IMB_MIPMAP_LEVELS + 1);
 
       /* create empty mipmap levels in advance */
       for (level = 0; level < numlevel; level++) {
@@ -695,16 +696,11 @@ void imb_loadtiletiff(
 
     if (width == ibuf->x && height == ibuf->y) {
       if (rect) {
-        /* tiff pixels are bottom to top, tiles are top to bottom */
+        /* tiff pixels are bottom to top, tiles are top to bottom. Tiles are anchored at the top
+         * of the image, rows of bottom tiles below the image stay at the start of the tile, see
+         * imb_tiles_read_region. */
         if (TIFFReadRGBATile(
-                image, tx * ibuf->tilex, (ibuf->ytiles - 1 - ty) * ibuf->tiley, rect) == 1) {
-          if (ibuf->tiley > ibuf->y) {
-            memmove(rect,
-                    rect + ibuf->tilex * (ibuf->tiley - ibuf->y),
-                    sizeof(int) * ibuf->tilex * ibuf->y);
-          }
-        }
-        else {
+                image, tx * ibuf->tilex, (ibuf->ytiles - 1 - ty) * ibuf->tiley, rect) != 1) {
           printf("imb_loadtiff: failed to read tiff tile at mipmap level %d\n", ibuf->miplevel);
         }
       }
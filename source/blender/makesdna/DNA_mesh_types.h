@@ -99,6 +99,12 @@ typedef struct Mesh_Runtime {
   int64_t cd_dirty_loop;
   int64_t cd_dirty_poly;
 
+  /**
+   * Hash of the topology, material indices and hidden state, zero when not computed yet.
+   * Used to carry topology-only caches over to the next evaluation of an object.
+   */
+  uint64_t topology_hash;
+
   struct MLoopTri_Store looptris;
 
   /** `BVHCache` defined in 'BKE_bvhutil.c' */
@@ -107,6 +113,18 @@ typedef struct Mesh_Runtime {
   /** Non-manifold boundary data for Shrinkwrap Target Project. */
   struct ShrinkwrapBoundaryData *shrinkwrap_data;
 
+  /** `MeshTopologyMaps` defined in 'mesh_runtime.c', lazily built adjacency maps. */
+  struct MeshTopologyMaps *topology_maps;
+
+  /** Vertex group weights in a compact layout, see #BKE_mesh_runtime_deform_weights_ensure. */
+  struct MeshDeformWeights *deform_weights;
+
+  /**
+   * Results of modifier stacks shared between objects using this mesh,
+   * see #BKE_mesh_runtime_eval_shared_acquire.
+   */
+  struct MeshEvalShared *eval_shared;
+
   /** Set by modifier stack if only deformed from original. */
   char deformed_only;
   /**
@@ -188,7 +188,13 @@ typedef struct Object_Runtime {
   struct CurveCache *curve_cache;
 
   unsigned short local_collections_bits;
-  short _pad2[3];
+  short _pad2;
+
+  /**
+   * Identifier of the shared modifier stack result used as `data_eval`, zero when the result is
+   * not shared. See #BKE_mesh_runtime_eval_shared_acquire.
+   */
+  unsigned int eval_shared_id;
 } Object_Runtime;
 
 typedef struct Object {
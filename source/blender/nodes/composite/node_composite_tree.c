@@ -254,6 +254,69 @@ void ntreeCompositExecTree(Scene *scene,
   UNUSED_VARS(do_preview);
 }
 
+#ifdef WITH_COMPOSITOR
+static int benchmark_test_break(void *UNUSED(handle))
+{
+  return 0;
+}
+
+static void benchmark_progress(void *UNUSED(handle), float UNUSED(progress))
+{
+}
+
+static void benchmark_stats_draw(void *UNUSED(handle), const char *UNUSED(str))
+{
+}
+#endif
+
+/* Execute the compositing node tree of the scene without rendering, and write the timing of
+ * the executions to filepath. A chunk_size of zero keeps the chunk size of the tree. */
+bool ntreeCompositBenchmark(
+    Scene *scene, int iterations, int width, int height, int chunk_size, const char *filepath)
+{
+#ifdef WITH_COMPOSITOR
+  bNodeTree *ntree = scene->nodetree;
+  if (ntree == NULL) {
+    return false;
+  }
+
+  RenderData rd = scene->r;
+  rd.xsch = width;
+  rd.ysch = height;
+  rd.size = 100;
+
+  /* Callbacks are only set by the editors and the render pipeline. */
+  int (*test_break)(void *) = ntree->test_break;
+  void (*progress)(void *, float) = ntree->progress;
+  void (*stats_draw)(void *, const char *) = ntree->stats_draw;
+  const int prev_chunk_size = ntree->chunksize;
+  ntree->test_break = benchmark_test_break;
+  ntree->progress = benchmark_progress;
+  ntree->stats_draw = benchmark_stats_draw;
+  if (chunk_size > 0) {
+    ntree->chunksize = chunk_size;
+  }
+
+  const bool success = COM_benchmark(&rd,
+                                     scene,
+                                     ntree,
+                                     iterations,
+                                     &scene->view_settings,
+                                     &scene->display_settings,
+                                     "",
+                                     filepath);
+
+  ntree->test_break = test_break;
+  ntree->progress = progress;
+  ntree->stats_draw = stats_draw;
+  ntree->chunksize = prev_chunk_size;
+  return success;
+#else
+  UNUSED_VARS(scene, iterations, width, height, chunk_size, filepath);
+  return false;
+#endif
+}
+
 /* *********************************************** */
 
 /* Update the outputs of the render layer nodes.
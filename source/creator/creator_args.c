@@ -52,6 +52,7 @@
 #  include "BKE_image.h"
 #  include "BKE_lib_id.h"
 #  include "BKE_main.h"
+#  include "BKE_node.h"
 #  include "BKE_report.h"
 #  include "BKE_scene.h"
 #  include "BKE_sound.h"
@@ -524,6 +525,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_argsPrintArgDoc(ba, "--frame-end");
   BLI_argsPrintArgDoc(ba, "--frame-jump");
   BLI_argsPrintArgDoc(ba, "--render-output");
+  BLI_argsPrintArgDoc(ba, "--compositor-benchmark");
   BLI_argsPrintArgDoc(ba, "--engine");
   BLI_argsPrintArgDoc(ba, "--threads");
 
@@ -1630,6 +1632,49 @@ static int arg_handle_render_animation(int UNUSED(argc), const char **UNUSED(arg
   return 0;
 }
 
+static const char arg_handle_compositor_benchmark_doc[] =
+    "<iterations> <width> <height> <chunk-size> <filepath>\n"
+    "\tExecute the compositing nodes of the scene <iterations> times at a resolution of <width>\n"
+    "\tby <height> without rendering, and write the time of every execution, execution group\n"
+    "\tand operation and the buffer memory used as JSON to <filepath>.\n"
+    "\n"
+    "\t* A <chunk-size> of 0 keeps the chunk size of the node tree.\n"
+    "\t* Operation times are only measured with the full-frame execution mode.\n"
+    "\t* Render Layers nodes have no render result to read.\n";
+static int arg_handle_compositor_benchmark(int argc, const char **argv, void *data)
+{
+  const char *arg_id = "--compositor-benchmark";
+  bContext *C = data;
+  Scene *scene = CTX_data_scene(C);
+  int params[4], i;
+
+  if (argc < 6) {
+    printf("\nError: requires five arguments '%s'.\n", arg_id);
+    return 0;
+  }
+  if (scene == NULL) {
+    printf("\nError: no blend loaded. cannot use '%s'.\n", arg_id);
+    return 5;
+  }
+
+  for (i = 0; i < 4; i++) {
+    const char *err_msg = NULL;
+    if (!parse_int(argv[i + 1], NULL, &params[i], &err_msg)) {
+      printf("\nError: %s '%s %s'.\n", err_msg, arg_id, argv[i + 1]);
+      return 5;
+    }
+  }
+  if (params[0] < 1 || params[1] < 1 || params[2] < 1 || params[3] < 0) {
+    printf("\nError: invalid arguments '%s'.\n", arg_id);
+    return 5;
+  }
+
+  if (!ntreeCompositBenchmark(scene, UNPACK4(params), argv[5])) {
+    printf("\nError: no compositing nodes or '%s' can't be written.\n", argv[5]);
+  }
+  return 5;
+}
+
 static const char arg_handle_scene_set_doc[] =
     "<name>\n"
     "\tSet the active scene <name> for rendering.";
@@ -2242,6 +2287,7 @@ void main_args_setup(bContext *C, bArgs *ba)
   /* fourth pass: processing arguments */
   BLI_argsAdd(ba, 4, "-f", "--render-frame", CB(arg_handle_render_frame), C);
   BLI_argsAdd(ba, 4, "-a", "--render-anim", CB(arg_handle_render_animation), C);
+  BLI_argsAdd(ba, 4, NULL, "--compositor-benchmark", CB(arg_handle_compositor_benchmark), C);
   BLI_argsAdd(ba, 4, "-S", "--scene", CB(arg_handle_scene_set), C);
   BLI_argsAdd(ba, 4, "-s", "--frame-start", CB(arg_handle_frame_start_set), C);
   BLI_argsAdd(ba, 4, "-e", "--frame-end", CB(arg_handle_frame_end_set), C);
@@ -0,0 +1,198 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <thread>
+#include <vector>
+
+#include "MEM_CacheLimiterC-Api.h"
+#include "MEM_guardedalloc.h"
+
+namespace {
+
+struct CacheItem {
+  size_t size;
+  int priority;
+  bool destroyed;
+  bool destroyable;
+  MEM_CacheLimiterHandleC *handle;
+  /* Item unmanaged by the destructor, like caches freeing related items. */
+  CacheItem *linked;
+};
+
+void item_destruct(void *item_v)
+{
+  CacheItem *item = (CacheItem *)item_v;
+  item->destroyed = true;
+  item->handle = NULL;
+
+  if (item->linked != NULL && item->linked->handle != NULL) {
+    MEM_CacheLimiter_unmanage(item->linked->handle);
+    item->linked->handle = NULL;
+  }
+}
+
+size_t item_size(void *item_v)
+{
+  return ((CacheItem *)item_v)->size;
+}
+
+int item_priority(void *item_v, int /*default_priority*/)
+{
+  return ((CacheItem *)item_v)->priority;
+}
+
+bool item_destroyable(void *item_v)
+{
+  return ((CacheItem *)item_v)->destroyable;
+}
+
+class CacheLimiterTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    old_maximum = MEM_CacheLimiter_get_maximum();
+    MEM_CacheLimiter_set_maximum(32 * 1024);
+    blocks_in_use = MEM_get_memory_blocks_in_use();
+    limiter = new_MEM_CacheLimiter(item_destruct, item_size);
+  }
+
+  void TearDown() override
+  {
+    delete_MEM_CacheLimiter(limiter);
+    MEM_CacheLimiter_set_maximum(old_maximum);
+    /* Handles of unmanaged and destroyed items are freed. */
+    EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use);
+  }
+
+  void insert(std::vector<CacheItem> &items)
+  {
+    for (CacheItem &item : items) {
+      item.handle = MEM_CacheLimiter_insert(limiter, &item);
+    }
+  }
+
+  size_t old_maximum;
+  unsigned int blocks_in_use;
+  MEM_CacheLimiterC *limiter;
+};
+
+CacheItem make_item(size_t size, int priority = 0)
+{
+  CacheItem item = {size, priority, false, true, NULL, NULL};
+  return item;
+}
+
+}  // namespace
+
+TEST_F(CacheLimiterTest, MemoryInUse)
+{
+  std::vector<CacheItem> items = {make_item(100), make_item(200), make_item(300)};
+  insert(items);
+  EXPECT_EQ(MEM_CacheLimiter_get_memory_in_use(limiter), 600);
+
+  MEM_CacheLimiter_unmanage(items[1].handle);
+  EXPECT_EQ(MEM_CacheLimiter_get_memory_in_use(limiter), 400);
+  EXPECT_FALSE(MEM_CacheLimiter_is_over_limit(limiter));
+}
+
+TEST_F(CacheLimiterTest, EvictLeastRecentlyUsed)
+{
+  std::vector<CacheItem> items(8, make_item(8 * 1024));
+  insert(items);
+  MEM_CacheLimiter_touch(items[0].handle);
+  MEM_CacheLimiter_ref(items[1].handle);
+
+  EXPECT_TRUE(MEM_CacheLimiter_is_over_limit(limiter));
+  MEM_CacheLimiter_enforce_limits(limiter);
+  EXPECT_FALSE(MEM_CacheLimiter_is_over_limit(limiter));
+
+  /* Referenced and most recently used items stay. */
+  EXPECT_FALSE(items[0].destroyed);
+  EXPECT_FALSE(items[1].destroyed);
+  EXPECT_FALSE(items[7].destroyed);
+  EXPECT_TRUE(items[2].destroyed);
+  EXPECT_TRUE(items[6].destroyed);
+  EXPECT_EQ(MEM_CacheLimiter_get_memory_in_use(limiter), 3 * 8 * 1024);
+
+  MEM_CacheLimiter_unref(items[1].handle);
+}
+
+TEST_F(CacheLimiterTest, EvictByPriority)
+{
+  std::vector<CacheItem> items;
+  for (int i = 0; i < 8; i++) {
+    items.push_back(make_item(8 * 1024, (i % 2) ? -i : i));
+  }
+  items[5].destroyable = false;
+  insert(items);
+  MEM_CacheLimiter_ItemPriority_Func_set(limiter, item_priority);
+  MEM_CacheLimiter_ItemDestroyable_Func_set(limiter, item_destroyable);
+
+  MEM_CacheLimiter_enforce_limits(limiter);
+
+  /* Odd items have the lowest priorities, item 5 can't be destroyed so item 0 and 2 go too. */
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(items[i].destroyed, i != 4 && i != 5 && i != 6) << "item " << i;
+  }
+}
+
+TEST_F(CacheLimiterTest, ItemGrowth)
+{
+  std::vector<CacheItem> items(4, make_item(4 * 1024));
+  insert(items);
+  EXPECT_FALSE(MEM_CacheLimiter_is_over_limit(limiter));
+
+  /* Items are measured again while inserting others. */
+  items[2].size = 64 * 1024;
+  std::vector<CacheItem> more_items(64, make_item(1));
+  insert(more_items);
+  EXPECT_TRUE(MEM_CacheLimiter_is_over_limit(limiter));
+
+  MEM_CacheLimiter_enforce_limits(limiter);
+  EXPECT_TRUE(items[2].destroyed);
+  EXPECT_FALSE(MEM_CacheLimiter_is_over_limit(limiter));
+}
+
+TEST_F(CacheLimiterTest, UnmanageFromDestructor)
+{
+  std::vector<CacheItem> items(8, make_item(8 * 1024));
+  /* Unmanage an item which stays, and one which is evicted in the same pass. */
+  items[0].linked = &items[7];
+  items[1].linked = &items[2];
+  insert(items);
+
+  MEM_CacheLimiter_enforce_limits(limiter);
+
+  EXPECT_TRUE(items[0].destroyed);
+  EXPECT_TRUE(items[1].destroyed);
+  /* Unmanaged items are left to the caller. */
+  EXPECT_FALSE(items[2].destroyed);
+  EXPECT_FALSE(items[7].destroyed);
+  EXPECT_EQ(items[7].handle, nullptr);
+  EXPECT_FALSE(MEM_CacheLimiter_is_over_limit(limiter));
+  EXPECT_EQ(MEM_CacheLimiter_get_memory_in_use(limiter), 2 * 8 * 1024);
+}
+
+TEST_F(CacheLimiterTest, ConcurrentInsert)
+{
+  const int num_threads = 4, num_items = 1000;
+  std::vector<std::vector<CacheItem>> items(num_threads,
+                                            std::vector<CacheItem>(num_items, make_item(1)));
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < num_threads; i++) {
+    threads.push_back(std::thread([&, i]() {
+      insert(items[i]);
+      /* Remove every other item again. */
+      for (int j = 0; j < num_items; j += 2) {
+        MEM_CacheLimiter_unmanage(items[i][j].handle);
+      }
+    }));
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(MEM_CacheLimiter_get_memory_in_use(limiter), num_threads * num_items / 2);
+}